@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "aaf-jitter-buffer.h"
+
+#define MAX_CAPACITY            128
+
+static inline jitter_entry_t* get_entry(jitter_buffer_t* jb, uint64_t seq)
+{
+    return (jitter_entry_t*)(jb->entries + (seq & (jb->capacity - 1)) * jb->stride);
+}
+
+int jitter_buffer_init(jitter_buffer_t* jb, uint32_t capacity,
+                       uint32_t max_data_len)
+{
+    memset(jb, 0, sizeof(*jb));
+
+    if (capacity == 0 || capacity > MAX_CAPACITY ||
+            (capacity & (capacity - 1)) != 0) {
+        return -1;
+    }
+
+    jb->capacity = capacity;
+    jb->max_data_len = max_data_len;
+    jb->stride = (sizeof(jitter_entry_t) + max_data_len + JITTER_BUFFER_ALIGN - 1) &
+                 ~(size_t)(JITTER_BUFFER_ALIGN - 1);
+    if (posix_memalign((void**)&jb->entries, JITTER_BUFFER_ALIGN,
+                       jb->stride * capacity) != 0) {
+        jb->entries = NULL;
+    }
+    jb->out = malloc((size_t)max_data_len * capacity);
+    if (jb->entries == NULL || jb->out == NULL) {
+        jitter_buffer_close(jb);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < capacity; i++) {
+        get_entry(jb, i)->valid = 0;
+    }
+
+    return 0;
+}
+
+void jitter_buffer_close(jitter_buffer_t* jb)
+{
+    free(jb->entries);
+    free(jb->out);
+    jb->entries = NULL;
+    jb->out = NULL;
+}
+
+/* Restart the read position at a sequence number, e.g. when the talker was
+ * restarted. The buffer must be empty.
+ */
+static void resync(jitter_buffer_t* jb, uint64_t seq)
+{
+    jb->read_seq = seq;
+    jb->end_seq = seq;
+    jb->started = 1;
+}
+
+jitter_entry_t* jitter_buffer_reserve(jitter_buffer_t* jb, uint8_t seq_num,
+                                      uint64_t ptime)
+{
+    int empty = jb->read_seq == jb->end_seq;
+    int8_t diff;
+    uint64_t seq;
+    jitter_entry_t* entry;
+
+    jb->received++;
+
+    if (!jb->started) {
+        resync(jb, seq_num);
+    }
+
+    // Extend the 8-bit sequence number around the read position
+    diff = (int8_t)(seq_num - (uint8_t)jb->read_seq);
+    seq = jb->read_seq + diff;
+
+    if (diff < 0) {
+        /* A PDU presented after everything already output cannot be an old
+         * one: the stream restarted.
+         */
+        if (!empty || ptime <= jb->last_ptime) {
+            jb->late++;
+            return NULL;
+        }
+        resync(jb, seq);
+    } else if (diff >= (int)jb->capacity) {
+        if (!empty) {
+            jb->early++;
+            return NULL;
+        }
+        resync(jb, seq);
+    }
+
+    entry = get_entry(jb, seq);
+    if (entry->valid) {
+        jb->duplicates++;
+        return NULL;
+    }
+
+    if (seq >= jb->end_seq) {
+        jb->end_seq = seq + 1;
+    }
+    entry->ptime = ptime;
+    entry->len = 0;
+
+    return entry;
+}
+
+void jitter_buffer_commit(jitter_buffer_t* jb, jitter_entry_t* entry)
+{
+    entry->valid = 1;
+}
+
+int jitter_buffer_next_time(jitter_buffer_t* jb, uint64_t* ptime)
+{
+    for (uint64_t seq = jb->read_seq; seq != jb->end_seq; seq++) {
+        jitter_entry_t* entry = get_entry(jb, seq);
+
+        if (entry->valid) {
+            *ptime = entry->ptime;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+size_t jitter_buffer_pop(jitter_buffer_t* jb, uint64_t now, uint8_t** data)
+{
+    size_t len = 0;
+    uint64_t ptime;
+
+    // The next valid entry decides whether missing entries before it are lost
+    while (jitter_buffer_next_time(jb, &ptime) == 0 && ptime <= now) {
+        jitter_entry_t* entry = get_entry(jb, jb->read_seq);
+
+        if (!entry->valid) {
+            jb->lost++;
+            jb->read_seq++;
+            continue;
+        }
+
+        memcpy(jb->out + len, entry->data, entry->len);
+        len += entry->len;
+        jb->last_ptime = entry->ptime;
+        entry->valid = 0;
+        jb->read_seq++;
+        jb->presented++;
+    }
+
+    *data = jb->out;
+    return len;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JITTER_BUFFER_ALIGN             64
+
+/* Received PDU waiting for its presentation time */
+typedef struct {
+    uint64_t ptime;             /* Presentation time in ns */
+    uint32_t len;               /* Length of data in bytes */
+    uint32_t valid;
+    uint8_t data[];
+} jitter_entry_t;
+
+/* Fixed-capacity jitter buffer of AAF PDUs. Entries are indexed by sequence
+ * number, so out-of-order PDUs are put back in order without searching and
+ * all memory is allocated once. Each entry starts on its own cache line.
+ */
+typedef struct {
+    uint8_t* entries;
+    size_t stride;              /* Distance between two entries in bytes */
+    uint32_t capacity;          /* Power of 2, at most 128 */
+    uint32_t max_data_len;
+    int started;
+    uint64_t read_seq;          /* Extended sequence number of next entry */
+    uint64_t end_seq;           /* One past the newest entry */
+    uint64_t last_ptime;        /* Presentation time of last entry output */
+    uint8_t* out;               /* Contiguous output of jitter_buffer_pop */
+
+    /* Statistics */
+    uint64_t received;
+    uint64_t presented;
+    uint64_t late;              /* Arrived after its slot was output */
+    uint64_t early;             /* Too far ahead of the read position */
+    uint64_t duplicates;
+    uint64_t lost;              /* Skipped because they never arrived */
+} jitter_buffer_t;
+
+/* Initialize a jitter buffer.
+ * @jb: Jitter buffer to be initialized.
+ * @capacity: Number of PDUs. Must be a power of 2, at most 128.
+ * @max_data_len: Largest amount of data stored per PDU.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Invalid capacity or out of memory.
+ */
+int jitter_buffer_init(jitter_buffer_t* jb, uint32_t capacity,
+                       uint32_t max_data_len);
+
+/* Free the memory of a jitter buffer. */
+void jitter_buffer_close(jitter_buffer_t* jb);
+
+/* Reserve the entry of a received PDU. The caller fills data and len and
+ * then calls jitter_buffer_commit().
+ * @jb: Jitter buffer.
+ * @seq_num: Sequence number of the PDU.
+ * @ptime: Presentation time of the PDU in ns.
+ *
+ * Returns:
+ *    Entry for the PDU, or NULL if the PDU is late, too early or a
+ *    duplicate. The matching statistics counter is incremented.
+ */
+jitter_entry_t* jitter_buffer_reserve(jitter_buffer_t* jb, uint8_t seq_num,
+                                      uint64_t ptime);
+
+/* Make a reserved entry available for output. */
+void jitter_buffer_commit(jitter_buffer_t* jb, jitter_entry_t* entry);
+
+/* Get the presentation time of the next entry.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: The jitter buffer is empty.
+ */
+int jitter_buffer_next_time(jitter_buffer_t* jb, uint64_t* ptime);
+
+/* Remove all entries due at a given time, in sequence order. Entries that
+ * never arrived are skipped once a later entry is due.
+ * @jb: Jitter buffer.
+ * @now: Current time in ns.
+ * @data: Pointer to store the start of the data of all removed entries,
+ * concatenated. Valid until the next call.
+ *
+ * Returns:
+ *    Length of the data in bytes, 0 if no entry is due.
+ */
+size_t jitter_buffer_pop(jitter_buffer_t* jb, uint64_t now, uint8_t** data);
@@ -33,10 +33,12 @@
  *
  * For simplicity, the example accepts only AAF packets with the following
  * specification:
- *    - Sample format: 16-bit little endian
+ *    - Sample format: 16-bit (written to stdout as little endian)
  *    - Sample rate: 48 kHz
  *    - Number of channels: 2 (stereo)
  *
+ * Each packet may carry any number of frames up to MAX_PDU_FRAMES.
+ *
  * TSN stream parameters such as destination mac address are passed via
  * command-line arguments. Run 'aaf-listener --help' for more information.
  *
@@ -54,47 +56,49 @@
  * $ aaf-listener <args> | aplay -f dat -t raw -D <playback-device>
  */
 
-#include <assert.h>
 #include <argp.h>
 #include <arpa/inet.h>
+#include <errno.h>
 #include <linux/if.h>
 #include <linux/if_ether.h>
 #include <linux/if_packet.h>
 #include <poll.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/queue.h>
 #include <sys/timerfd.h>
+#include <time.h>
 #include <unistd.h>
 #include <inttypes.h>
 
 #include "avtp/aaf/Pcm.h"
+#include "avtp/aaf/PcmSamples.h"
 #include "common/common.h"
 #include "avtp/CommonHeader.h"
+#include "aaf-jitter-buffer.h"
 
 #define STREAM_ID		0xAABBCCDDEEFF0001
 #define SAMPLE_SIZE		2 /* Sample size in bytes. */
 #define NUM_CHANNELS		2
-#define DATA_LEN		(SAMPLE_SIZE * NUM_CHANNELS)
-#define PDU_SIZE		(sizeof(struct avtp_stream_pdu) + DATA_LEN)
+#define FRAME_SIZE		(SAMPLE_SIZE * NUM_CHANNELS)
+#define MAX_PDU_FRAMES		64
+#define MAX_DATA_LEN		(FRAME_SIZE * MAX_PDU_FRAMES)
+#define MAX_PDU_SIZE		(sizeof(struct avtp_stream_pdu) + MAX_DATA_LEN)
 #define NSEC_PER_SEC		1000000000ULL
 
-struct sample_entry {
-    STAILQ_ENTRY(sample_entry) entries;
-
-    struct timespec tspec;
-    uint8_t pcm_sample[DATA_LEN];
-};
-
-static STAILQ_HEAD(sample_queue, sample_entry) samples;
+static jitter_buffer_t jitter_buffer;
+static uint64_t armed_time;     /* Expiry of the timer, 0 if disarmed */
+static uint8_t pdu_buf[MAX_PDU_SIZE];
 static char ifname[IFNAMSIZ];
 static uint8_t macaddr[ETH_ALEN];
-static uint8_t expected_seq;
+static int jb_capacity = 128;
+static volatile sig_atomic_t stop;
 
 static struct argp_option options[] = {
     {"dst-addr", 'd', "MACADDR", 0, "Stream Destination MAC address" },
     {"ifname", 'i', "IFNAME", 0, "Network Interface" },
+    {"jitter-buffer", 'j', "NUM", 0, "Jitter buffer capacity in PDUs, power of 2 up to 128 (default 128)" },
     { 0 }
 };
 
@@ -116,6 +120,9 @@ static error_t parser(int key, char *arg, struct argp_state *state)
     case 'i':
         strncpy(ifname, arg, sizeof(ifname) - 1);
         break;
+    case 'j':
+        jb_capacity = atoi(arg);
+        break;
     }
 
     return 0;
@@ -123,41 +130,50 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 
 static struct argp argp = { options, parser };
 
-/* Schedule 'pcm_sample' to be presented at time specified by 'tspec'. */
-static int schedule_sample(int fd, struct timespec *tspec, uint8_t *pcm_sample)
+static uint64_t timespec_to_ns(const struct timespec *tspec)
+{
+    return (uint64_t)tspec->tv_sec * NSEC_PER_SEC + tspec->tv_nsec;
+}
+
+/* Arm the timer for 'ptime' unless it already expires earlier. */
+static int arm_timer_ns(int fd, uint64_t ptime)
 {
-    struct sample_entry *entry;
+    struct timespec tspec;
 
-    entry = malloc(sizeof(*entry));
-    if (!entry) {
-        fprintf(stderr, "Failed to allocate memory\n");
+    if (armed_time != 0 && armed_time <= ptime)
+        return 0;
+
+    tspec.tv_sec = ptime / NSEC_PER_SEC;
+    tspec.tv_nsec = ptime % NSEC_PER_SEC;
+    if (arm_timer(fd, &tspec) < 0)
         return -1;
-    }
 
-    entry->tspec.tv_sec = tspec->tv_sec;
-    entry->tspec.tv_nsec = tspec->tv_nsec;
-    memcpy(entry->pcm_sample, pcm_sample, DATA_LEN);
+    armed_time = ptime;
+    return 0;
+}
 
-    STAILQ_INSERT_TAIL(&samples, entry, entries);
+/* Store the 'frames' frames of 'payload' in the jitter buffer, to be
+ * presented at time specified by 'tspec'.
+ */
+static int schedule_sample(int fd, struct timespec *tspec, uint8_t seq_num,
+                           uint8_t *payload, size_t frames)
+{
+    uint64_t ptime = timespec_to_ns(tspec);
+    jitter_entry_t *entry;
 
-    /* If this was the first entry inserted onto the queue, we need to arm
-     * the timer.
-     */
-    if (STAILQ_FIRST(&samples) == entry) {
-        int res;
+    entry = jitter_buffer_reserve(&jitter_buffer, seq_num, ptime);
+    if (!entry)
+        return 0;
 
-        res = arm_timer(fd, tspec);
-        if (res < 0) {
-            STAILQ_REMOVE(&samples, entry, sample_entry, entries);
-            free(entry);
-            return -1;
-        }
-    }
+    entry->len = Avtp_PcmSamples_UnpackInterleaved(entry->data,
+                        AVTP_PCM_SAMPLE_INT16, payload,
+                        AVTP_AAF_FORMAT_INT_16BIT, NUM_CHANNELS, frames);
+    jitter_buffer_commit(&jitter_buffer, entry);
 
-    return 0;
+    return arm_timer_ns(fd, ptime);
 }
 
-static bool is_valid_packet(struct avtp_stream_pdu *pdu)
+static bool is_valid_packet(struct avtp_stream_pdu *pdu, size_t len)
 {
     struct avtp_common_pdu *common = (struct avtp_common_pdu *) pdu;
     uint64_t val64;
@@ -219,24 +235,6 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
         return false;
     }
 
-    res = avtp_aaf_pdu_get(pdu, AVTP_AAF_FIELD_SEQ_NUM, &val64);
-    if (res < 0) {
-        fprintf(stderr, "Failed to get sequence num field: %d\n", res);
-        return false;
-    }
-
-    if (val64 != expected_seq) {
-        /* If we have a sequence number mismatch, we simply log the
-         * issue and continue to process the packet. We don't want to
-         * invalidate it since it is a valid packet after all.
-         */
-        fprintf(stderr, "Sequence number mismatch: expected %u, got %" PRIu64 "\n",
-                            expected_seq, val64);
-        expected_seq = val64;
-    }
-
-    expected_seq++;
-
     res = avtp_aaf_pdu_get(pdu, AVTP_AAF_FIELD_FORMAT, &val64);
     if (res < 0) {
         fprintf(stderr, "Failed to get format field: %d\n", res);
@@ -286,9 +284,10 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
         fprintf(stderr, "Failed to get data_len field: %d\n", res);
         return false;
     }
-    if (val64 != DATA_LEN) {
-        fprintf(stderr, "Data len mismatch: expected %u, got %" PRIu64 "\n",
-                            DATA_LEN, val64);
+    if (val64 == 0 || val64 % FRAME_SIZE != 0 || val64 > MAX_DATA_LEN ||
+            sizeof(*pdu) + val64 > len) {
+        fprintf(stderr, "Invalid data len %" PRIu64 " for a %zu byte packet\n",
+                            val64, len);
         return false;
     }
 
@@ -299,19 +298,17 @@ static int new_packet(int sk_fd, int timer_fd)
 {
     int res;
     ssize_t n;
-    uint64_t avtp_time;
+    uint64_t avtp_time, data_len, seq_num;
     struct timespec tspec;
-    struct avtp_stream_pdu *pdu = alloca(PDU_SIZE);
-
-    memset(pdu, 0, PDU_SIZE);
+    struct avtp_stream_pdu *pdu = (struct avtp_stream_pdu *) pdu_buf;
 
-    n = recv(sk_fd, pdu, PDU_SIZE, 0);
-    if (n < 0 || n != PDU_SIZE) {
+    n = recv(sk_fd, pdu, MAX_PDU_SIZE, 0);
+    if (n < 0) {
         perror("Failed to receive data");
         return -1;
     }
 
-    if (!is_valid_packet(pdu)) {
+    if (n < sizeof(*pdu) || !is_valid_packet(pdu, n)) {
         fprintf(stderr, "Dropping packet\n");
         return 0;
     }
@@ -326,19 +323,27 @@ static int new_packet(int sk_fd, int timer_fd)
     if (res < 0)
         return -1;
 
-    res = schedule_sample(timer_fd, &tspec, pdu->avtp_payload);
+    avtp_aaf_pdu_get(pdu, AVTP_AAF_FIELD_SEQ_NUM, &seq_num);
+    avtp_aaf_pdu_get(pdu, AVTP_AAF_FIELD_STREAM_DATA_LEN, &data_len);
+    res = schedule_sample(timer_fd, &tspec, seq_num, pdu->avtp_payload,
+                          data_len / FRAME_SIZE);
     if (res < 0)
         return -1;
 
     return 0;
 }
 
+/* Write all samples whose presentation time is reached with one write()
+ * and re-arm the timer for the next ones.
+ */
 static int timeout(int fd)
 {
     int res;
     ssize_t n;
-    uint64_t expirations;
-    struct sample_entry *entry;
+    uint64_t expirations, now, ptime;
+    struct timespec tspec;
+    uint8_t *data;
+    size_t len;
 
     n = read(fd, &expirations, sizeof(uint64_t));
     if (n < 0) {
@@ -346,29 +351,43 @@ static int timeout(int fd)
         return -1;
     }
 
-    assert(expirations == 1);
+    armed_time = 0;
 
-    entry = STAILQ_FIRST(&samples);
-    assert(entry != NULL);
-
-    res = present_data(entry->pcm_sample, DATA_LEN);
-    if (res < 0)
+    res = clock_gettime(CLOCK_REALTIME, &tspec);
+    if (res < 0) {
+        perror("Failed to get time");
         return -1;
+    }
+    now = timespec_to_ns(&tspec);
 
-    STAILQ_REMOVE_HEAD(&samples, entries);
-    free(entry);
-
-    if (!STAILQ_EMPTY(&samples)) {
-        entry = STAILQ_FIRST(&samples);
-
-        res = arm_timer(fd, &entry->tspec);
+    len = jitter_buffer_pop(&jitter_buffer, now, &data);
+    if (len > 0) {
+        res = present_data(data, len);
         if (res < 0)
             return -1;
     }
 
+    if (jitter_buffer_next_time(&jitter_buffer, &ptime) == 0)
+        return arm_timer_ns(fd, ptime);
+
     return 0;
 }
 
+static void print_stats(void)
+{
+    jitter_buffer_t *jb = &jitter_buffer;
+
+    fprintf(stderr, "received %" PRIu64 " presented %" PRIu64 " late %" PRIu64
+            " early %" PRIu64 " duplicates %" PRIu64 " lost %" PRIu64 "\n",
+            jb->received, jb->presented, jb->late, jb->early,
+            jb->duplicates, jb->lost);
+}
+
+static void handle_signal(int sig)
+{
+    stop = 1;
+}
+
 int main(int argc, char *argv[])
 {
     int sk_fd, timer_fd, res;
@@ -376,7 +395,14 @@ int main(int argc, char *argv[])
 
     argp_parse(&argp, argc, argv, 0, NULL, NULL);
 
-    STAILQ_INIT(&samples);
+    res = jitter_buffer_init(&jitter_buffer, jb_capacity, MAX_DATA_LEN);
+    if (res < 0) {
+        fprintf(stderr, "Invalid jitter buffer capacity\n");
+        return 1;
+    }
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
 
     sk_fd = create_listener_socket(ifname, macaddr, ETH_P_TSN);
     if (sk_fd < 0)
@@ -393,8 +419,10 @@ int main(int argc, char *argv[])
     fds[1].fd = timer_fd;
     fds[1].events = POLLIN;
 
-    while (1) {
+    while (!stop) {
         res = poll(fds, 2, -1);
+        if (res < 0 && errno == EINTR)
+            continue;
         if (res < 0) {
             perror("Failed to poll() fds");
             goto err;
@@ -413,9 +441,14 @@ int main(int argc, char *argv[])
         }
     }
 
+    print_stats();
+    jitter_buffer_close(&jitter_buffer);
+    close(sk_fd);
+    close(timer_fd);
     return 0;
 
 err:
+    jitter_buffer_close(&jitter_buffer);
     close(sk_fd);
     close(timer_fd);
     return 1;
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "aaf-packetizer.h"
+
+#define NSEC_PER_SEC            1000000000ULL
+
+uint32_t aaf_nsr_to_hz(Avtp_AafNsr_t nsr)
+{
+    switch (nsr) {
+    case AVTP_AAF_PCM_NSR_8KHZ:
+        return 8000;
+    case AVTP_AAF_PCM_NSR_16KHZ:
+        return 16000;
+    case AVTP_AAF_PCM_NSR_24KHZ:
+        return 24000;
+    case AVTP_AAF_PCM_NSR_32KHZ:
+        return 32000;
+    case AVTP_AAF_PCM_NSR_44_1KHZ:
+        return 44100;
+    case AVTP_AAF_PCM_NSR_48KHZ:
+        return 48000;
+    case AVTP_AAF_PCM_NSR_88_2KHZ:
+        return 88200;
+    case AVTP_AAF_PCM_NSR_96KHZ:
+        return 96000;
+    case AVTP_AAF_PCM_NSR_176_4KHZ:
+        return 176400;
+    case AVTP_AAF_PCM_NSR_192KHZ:
+        return 192000;
+    default:
+        return 0;
+    }
+}
+
+int aaf_packetizer_init(aaf_packetizer_t* pkt, const aaf_packetizer_config_t* cfg)
+{
+    uint8_t sample_size = Avtp_PcmSamples_GetSampleSize(cfg->format);
+    Avtp_Pcm_t* header;
+    uint64_t frames, duration;
+
+    memset(pkt, 0, sizeof(*pkt));
+    pkt->cfg = *cfg;
+
+    pkt->sample_rate = aaf_nsr_to_hz(cfg->nsr);
+    if (pkt->sample_rate == 0 || sample_size == 0 || cfg->channels == 0 ||
+            cfg->class_interval_ns == 0) {
+        return -1;
+    }
+
+    frames = ((uint64_t)pkt->sample_rate * cfg->class_interval_ns +
+              NSEC_PER_SEC - 1) / NSEC_PER_SEC;
+    if (frames * cfg->channels * sample_size > UINT16_MAX) {
+        return -1;
+    }
+    pkt->frames_per_pdu = frames;
+    pkt->data_len = frames * cfg->channels * sample_size;
+    pkt->pdu_size = AVTP_PCM_HEADER_LEN + pkt->data_len;
+
+    // One PDU lasts frames / rate seconds, split into ns and remainder
+    duration = frames * NSEC_PER_SEC;
+    pkt->step_ns = duration / pkt->sample_rate;
+    pkt->step_rem = duration % pkt->sample_rate;
+
+    // Packing zero frames only validates the format and bit depth
+    if (Avtp_PcmSamples_PackInterleaved(pkt->header, cfg->format,
+            cfg->bit_depth, pkt->header, cfg->sample_type, 1, 0) < 0) {
+        return -1;
+    }
+
+    header = (Avtp_Pcm_t*)pkt->header;
+    Avtp_Pcm_Init(header);
+    Avtp_Pcm_EnableTv(header);
+    Avtp_Pcm_SetStreamId(header, cfg->stream_id);
+    Avtp_Pcm_SetFormat(header, cfg->format);
+    Avtp_Pcm_SetNsr(header, cfg->nsr);
+    Avtp_Pcm_SetChannelsPerFrame(header, cfg->channels);
+    Avtp_Pcm_SetBitDepth(header, cfg->bit_depth);
+    Avtp_Pcm_SetStreamDataLength(header, pkt->data_len);
+    Avtp_Pcm_DisableSp(header);
+
+    return 0;
+}
+
+void aaf_packetizer_start(aaf_packetizer_t* pkt, uint64_t time_ns)
+{
+    pkt->time_ns = time_ns;
+    pkt->time_rem = 0;
+}
+
+uint64_t aaf_packetizer_next_time(aaf_packetizer_t* pkt)
+{
+    return pkt->time_ns;
+}
+
+/* Pack frames from the ring into a payload, following the wrap around of the
+ * ring if needed.
+ */
+static void pack_frames(aaf_packetizer_t* pkt, pcm_ring_t* ring,
+                        uint8_t* payload, uint32_t frames)
+{
+    while (frames > 0) {
+        uint8_t* src;
+        uint32_t n = pcm_ring_read_region(ring, &src);
+
+        if (n > frames) {
+            n = frames;
+        }
+        payload += Avtp_PcmSamples_PackInterleaved(payload, pkt->cfg.format,
+                        pkt->cfg.bit_depth, src, pkt->cfg.sample_type,
+                        pkt->cfg.channels, n);
+        pcm_ring_consume(ring, n);
+        frames -= n;
+    }
+}
+
+int aaf_packetizer_fill(aaf_packetizer_t* pkt, pcm_ring_t* ring, uint8_t* pdus,
+                        size_t stride, int max_pdus)
+{
+    int count = pcm_ring_readable(ring) / pkt->frames_per_pdu;
+
+    if (count > max_pdus) {
+        count = max_pdus;
+    }
+
+    for (int i = 0; i < count; i++) {
+        Avtp_Pcm_t* pdu = (Avtp_Pcm_t*)(pdus + i * stride);
+
+        memcpy(pdu->header, pkt->header, AVTP_PCM_HEADER_LEN);
+        Avtp_Pcm_SetSequenceNum(pdu, pkt->seq_num++);
+        Avtp_Pcm_SetAvtpTimestamp(pdu, (uint32_t)pkt->time_ns);
+        pack_frames(pkt, ring, pdu->payload, pkt->frames_per_pdu);
+
+        pkt->time_ns += pkt->step_ns;
+        pkt->time_rem += pkt->step_rem;
+        if (pkt->time_rem >= pkt->sample_rate) {
+            pkt->time_rem -= pkt->sample_rate;
+            pkt->time_ns++;
+        }
+        pkt->frames += pkt->frames_per_pdu;
+    }
+
+    return count;
+}
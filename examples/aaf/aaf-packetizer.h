@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "avtp/aaf/Pcm.h"
+#include "avtp/aaf/PcmSamples.h"
+#include "aaf-pcm-ring.h"
+
+/* Class measurement intervals of SR classes A and B */
+#define AAF_CLASS_A_INTERVAL_NS         125000
+#define AAF_CLASS_B_INTERVAL_NS         250000
+
+typedef struct {
+    uint64_t stream_id;
+    Avtp_AafFormat_t format;
+    uint8_t bit_depth;
+    Avtp_AafNsr_t nsr;
+    uint16_t channels;
+    Avtp_PcmSampleType_t sample_type;   /* Type of the samples in the ring */
+    uint32_t class_interval_ns;
+} aaf_packetizer_config_t;
+
+/* Cuts a continuous stream of interleaved samples into AAF PDUs carrying one
+ * class interval worth of frames each. Presentation times are derived from
+ * the index of the first frame of each PDU, so they follow the media clock
+ * exactly instead of the time the samples were read. The time is kept as
+ * nanoseconds plus a remainder in units of 1/sample_rate ns, so no error
+ * accumulates for rates that do not divide 1 s evenly.
+ */
+typedef struct {
+    aaf_packetizer_config_t cfg;
+    uint8_t header[AVTP_PCM_HEADER_LEN];        /* Header template */
+    uint32_t sample_rate;
+    uint16_t frames_per_pdu;
+    uint16_t data_len;
+    size_t pdu_size;
+    uint8_t seq_num;
+
+    uint64_t time_ns;                   /* Presentation time of next PDU */
+    uint32_t time_rem;
+    uint64_t step_ns;                   /* Duration of one PDU */
+    uint32_t step_rem;
+
+    uint64_t frames;                    /* Frames packetized so far */
+} aaf_packetizer_t;
+
+/* Get the sample rate of a nominal sample rate value.
+ *
+ * Returns:
+ *    Sample rate in Hz, 0 for AVTP_AAF_PCM_NSR_USER or unknown values.
+ */
+uint32_t aaf_nsr_to_hz(Avtp_AafNsr_t nsr);
+
+/* Initialize a packetizer. The number of frames per PDU is the number of
+ * frames in one class interval, rounded up.
+ * @pkt: Packetizer to be initialized.
+ * @cfg: Stream parameters.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Invalid parameters.
+ */
+int aaf_packetizer_init(aaf_packetizer_t* pkt, const aaf_packetizer_config_t* cfg);
+
+/* Set the presentation time of the next frame. Must be called before the
+ * first PDU is produced, and again to resynchronize after an underrun.
+ * @pkt: Packetizer.
+ * @time_ns: Presentation time in ns, in the gPTP time base.
+ */
+void aaf_packetizer_start(aaf_packetizer_t* pkt, uint64_t time_ns);
+
+/* Get the presentation time of the next PDU in ns. */
+uint64_t aaf_packetizer_next_time(aaf_packetizer_t* pkt);
+
+/* Produce as many complete PDUs as the ring holds, up to a limit.
+ * @pkt: Packetizer.
+ * @ring: Ring of interleaved frames of the configured sample type.
+ * @pdus: Buffer for the PDUs.
+ * @stride: Distance between two PDUs in the buffer, at least pdu_size.
+ * @max_pdus: Maximum number of PDUs to produce.
+ *
+ * Returns:
+ *    Number of PDUs written to @pdus.
+ */
+int aaf_packetizer_fill(aaf_packetizer_t* pkt, pcm_ring_t* ring, uint8_t* pdus,
+                        size_t stride, int max_pdus);
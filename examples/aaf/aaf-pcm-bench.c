@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* AAF PCM conversion benchmark.
+ *
+ * Measures the throughput of the PCM sample conversion kernels for every
+ * instruction set supported by the CPU, at 8, 32 and 64 channels and for all
+ * AAF PCM formats. Each call converts one packet worth of frames, so the
+ * results include the per-call overhead seen by a talker or listener.
+ *
+ * $ aaf-pcm-bench --type float --frames 48
+ */
+
+#include <argp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "avtp/aaf/PcmSamples.h"
+
+#define MAX_CHANNELS		64
+#define MAX_FRAMES		1024
+#define NSEC_PER_SEC		1000000000ULL
+
+static Avtp_PcmSampleType_t sample_type = AVTP_PCM_SAMPLE_FLOAT;
+static int frames = 48;
+static int duration_ms = 200;
+
+static const char* isa_names[] = {
+    [AVTP_PCM_ISA_SCALAR] = "scalar",
+    [AVTP_PCM_ISA_SSSE3] = "ssse3",
+    [AVTP_PCM_ISA_AVX2] = "avx2",
+    [AVTP_PCM_ISA_NEON] = "neon",
+};
+
+static const struct {
+    Avtp_AafFormat_t format;
+    uint8_t bit_depth;
+    const char* name;
+} formats[] = {
+    { AVTP_AAF_FORMAT_INT_16BIT, 16, "int16" },
+    { AVTP_AAF_FORMAT_INT_24BIT, 24, "int24" },
+    { AVTP_AAF_FORMAT_INT_32BIT, 32, "int32" },
+    { AVTP_AAF_FORMAT_FLOAT_32BIT, 32, "float32" },
+};
+
+static const uint16_t channel_counts[] = { 8, 32, 64 };
+
+enum layout {
+    LAYOUT_INTERLEAVED,
+    LAYOUT_PLANAR,
+    LAYOUT_SPARSE,
+};
+
+static const char* layout_names[] = {
+    [LAYOUT_INTERLEAVED] = "interleaved",
+    [LAYOUT_PLANAR] = "planar",
+    [LAYOUT_SPARSE] = "sparse",
+};
+
+// Channels selected from the stream in the sparse layout
+#define SPARSE_CHANNELS		4
+
+static struct argp_option options[] = {
+    {"type", 't', "int16|int32|float", 0, "Host sample type (default float)" },
+    {"frames", 'f', "NUM", 0, "Frames converted per call (default 48)" },
+    {"duration", 'd', "MSEC", 0, "Duration of each measurement (default 200)" },
+    { 0 }
+};
+
+static error_t parser(int key, char *arg, struct argp_state *state)
+{
+    switch (key) {
+    case 't':
+        if (!strcmp(arg, "int16")) {
+            sample_type = AVTP_PCM_SAMPLE_INT16;
+        } else if (!strcmp(arg, "int32")) {
+            sample_type = AVTP_PCM_SAMPLE_INT32;
+        } else if (!strcmp(arg, "float")) {
+            sample_type = AVTP_PCM_SAMPLE_FLOAT;
+        } else {
+            argp_error(state, "Invalid sample type %s", arg);
+        }
+        break;
+    case 'f':
+        frames = atoi(arg);
+        if (frames < 1 || frames > MAX_FRAMES) {
+            argp_error(state, "Frames must be between 1 and %d", MAX_FRAMES);
+        }
+        break;
+    case 'd':
+        duration_ms = atoi(arg);
+        break;
+    }
+
+    return 0;
+}
+
+static struct argp argp = { options, parser };
+
+static uint64_t get_time_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
+
+static float host[MAX_CHANNELS * MAX_FRAMES];
+static float planes[MAX_CHANNELS][MAX_FRAMES];
+static uint8_t payload[MAX_CHANNELS * MAX_FRAMES * 4];
+
+/* Runs one conversion repeatedly and returns the throughput in Msamples/s
+ * of host samples.
+ */
+static double measure(int pack, enum layout layout, int fmt, uint16_t channels)
+{
+    const void* src_planes[MAX_CHANNELS];
+    void* dst_planes[MAX_CHANNELS];
+    uint16_t map[SPARSE_CHANNELS];
+    uint64_t start, end, deadline, calls = 0;
+
+    for (int c = 0; c < channels; c++) {
+        src_planes[c] = planes[c];
+        dst_planes[c] = planes[c];
+    }
+    // Spread the selected channels over the whole frame
+    for (int i = 0; i < SPARSE_CHANNELS; i++) {
+        map[i] = (2 * i + 1) * channels / (2 * SPARSE_CHANNELS);
+    }
+
+    start = get_time_ns();
+    deadline = start + (uint64_t)duration_ms * 1000000ULL;
+    do {
+        // Check the clock only every 64 calls to keep its cost out
+        for (int i = 0; i < 64; i++) {
+            if (pack && layout == LAYOUT_SPARSE) {
+                Avtp_PcmSamples_PackChannels(payload, formats[fmt].format,
+                        formats[fmt].bit_depth, src_planes, sample_type,
+                        channels, map, SPARSE_CHANNELS, frames);
+            } else if (layout == LAYOUT_SPARSE) {
+                Avtp_PcmSamples_UnpackChannels(dst_planes, sample_type, payload,
+                        formats[fmt].format, channels, map, SPARSE_CHANNELS,
+                        frames);
+            } else if (pack && layout == LAYOUT_PLANAR) {
+                Avtp_PcmSamples_PackPlanar(payload, formats[fmt].format,
+                        formats[fmt].bit_depth, src_planes, sample_type,
+                        channels, frames);
+            } else if (pack) {
+                Avtp_PcmSamples_PackInterleaved(payload, formats[fmt].format,
+                        formats[fmt].bit_depth, host, sample_type,
+                        channels, frames);
+            } else if (layout == LAYOUT_PLANAR) {
+                Avtp_PcmSamples_UnpackPlanar(dst_planes, sample_type, payload,
+                        formats[fmt].format, channels, frames);
+            } else {
+                Avtp_PcmSamples_UnpackInterleaved(host, sample_type, payload,
+                        formats[fmt].format, channels, frames);
+            }
+        }
+        calls += 64;
+        end = get_time_ns();
+    } while (end < deadline);
+
+    if (layout == LAYOUT_SPARSE) {
+        channels = SPARSE_CHANNELS;
+    }
+    return (double)calls * frames * channels * 1000.0 / (end - start);
+}
+
+int main(int argc, char *argv[])
+{
+    argp_parse(&argp, argc, argv, 0, NULL, NULL);
+
+    // Small non-zero values, valid for every host sample type
+    memset(host, 0x11, sizeof(host));
+    memset(planes, 0x11, sizeof(planes));
+
+    printf("%-7s %4s %-8s %-12s %12s %12s\n", "ISA", "ch", "format", "layout",
+           "pack MS/s", "unpack MS/s");
+
+    for (int isa = AVTP_PCM_ISA_SCALAR; isa <= AVTP_PCM_ISA_NEON; isa++) {
+        if (Avtp_PcmSamples_SelectIsa(isa) < 0) {
+            continue;
+        }
+        for (size_t c = 0; c < sizeof(channel_counts) / sizeof(channel_counts[0]); c++) {
+            for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+                for (int l = LAYOUT_INTERLEAVED; l <= LAYOUT_SPARSE; l++) {
+                    double pack = measure(1, l, f, channel_counts[c]);
+                    double unpack = measure(0, l, f, channel_counts[c]);
+                    printf("%-7s %4u %-8s %-12s %12.1f %12.1f\n", isa_names[isa],
+                           channel_counts[c], formats[f].name, layout_names[l],
+                           pack, unpack);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
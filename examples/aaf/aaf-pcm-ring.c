@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdlib.h>
+
+#include "aaf-pcm-ring.h"
+
+int pcm_ring_init(pcm_ring_t* ring, uint32_t frame_size, uint32_t capacity)
+{
+    if (frame_size == 0 || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return -1;
+    }
+
+    ring->buf = malloc((size_t)frame_size * capacity);
+    if (ring->buf == NULL) {
+        return -1;
+    }
+    ring->frame_size = frame_size;
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->tail = 0;
+
+    return 0;
+}
+
+void pcm_ring_close(pcm_ring_t* ring)
+{
+    free(ring->buf);
+    ring->buf = NULL;
+}
+
+uint32_t pcm_ring_write_region(pcm_ring_t* ring, uint8_t** ptr)
+{
+    uint64_t head = ring->head;
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t offset = head & (ring->capacity - 1);
+    uint32_t free_frames = ring->capacity - (uint32_t)(head - tail);
+    uint32_t to_end = ring->capacity - offset;
+
+    *ptr = ring->buf + (size_t)offset * ring->frame_size;
+    return free_frames < to_end ? free_frames : to_end;
+}
+
+void pcm_ring_produce(pcm_ring_t* ring, uint32_t frames)
+{
+    __atomic_store_n(&ring->head, ring->head + frames, __ATOMIC_RELEASE);
+}
+
+uint32_t pcm_ring_readable(pcm_ring_t* ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - ring->tail;
+}
+
+uint32_t pcm_ring_read_region(pcm_ring_t* ring, uint8_t** ptr)
+{
+    uint64_t tail = ring->tail;
+    uint32_t offset = tail & (ring->capacity - 1);
+    uint32_t avail = pcm_ring_readable(ring);
+    uint32_t to_end = ring->capacity - offset;
+
+    *ptr = ring->buf + (size_t)offset * ring->frame_size;
+    return avail < to_end ? avail : to_end;
+}
+
+void pcm_ring_consume(pcm_ring_t* ring, uint32_t frames)
+{
+    __atomic_store_n(&ring->tail, ring->tail + frames, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Single-producer single-consumer ring of interleaved PCM frames. One thread
+ * may write frames while another one reads them, without locks. The ring only
+ * hands out whole frames; a producer that receives partial frames keeps the
+ * extra bytes in the write region until the frame is complete.
+ */
+typedef struct {
+    uint8_t* buf;
+    uint32_t frame_size;        /* Bytes per frame */
+    uint32_t capacity;          /* Capacity in frames, power of 2 */
+    uint64_t head;              /* Frames written, updated by the producer */
+    uint64_t tail;              /* Frames read, updated by the consumer */
+} pcm_ring_t;
+
+/* Initialize a ring.
+ * @ring: Ring to be initialized.
+ * @frame_size: Size of one interleaved frame in bytes.
+ * @capacity: Capacity in frames. Must be a power of 2.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Invalid capacity or out of memory.
+ */
+int pcm_ring_init(pcm_ring_t* ring, uint32_t frame_size, uint32_t capacity);
+
+/* Free the memory of a ring. */
+void pcm_ring_close(pcm_ring_t* ring);
+
+/* Get the contiguous free region of the ring. Producer only.
+ * @ring: Ring.
+ * @ptr: Pointer to store the start of the region.
+ *
+ * Returns:
+ *    Number of frames that fit in the region.
+ */
+uint32_t pcm_ring_write_region(pcm_ring_t* ring, uint8_t** ptr);
+
+/* Publish frames written to the free region. Producer only. */
+void pcm_ring_produce(pcm_ring_t* ring, uint32_t frames);
+
+/* Get the number of frames ready to be read. Consumer only. */
+uint32_t pcm_ring_readable(pcm_ring_t* ring);
+
+/* Get the contiguous region of frames ready to be read. Consumer only.
+ * @ring: Ring.
+ * @ptr: Pointer to store the start of the region.
+ *
+ * Returns:
+ *    Number of frames in the region. Frames past the end of the buffer are
+ *    returned by the next call, after they have been consumed.
+ */
+uint32_t pcm_ring_read_region(pcm_ring_t* ring, uint8_t** ptr);
+
+/* Release frames that have been read. Consumer only. */
+void pcm_ring_consume(pcm_ring_t* ring, uint32_t frames);
@@ -36,6 +36,12 @@
  *    - Sample rate: 48 kHz
  *    - Number of channels: 2 (stereo)
  *
+ * A reader thread copies stdin into a lock-free ring. The sender thread cuts
+ * the ring into PDUs of one SR class interval each (6 frames for class A) and
+ * derives their AVTP timestamps from the frame count, so the timestamps follow
+ * the sample clock rather than the time the data was read. The --burst option
+ * sends several PDUs per system call.
+ *
  * TSN stream parameters (e.g. destination mac address, traffic priority) are
  * passed via command-line arguments. Run 'aaf-talker --help' for more
  * information.
@@ -55,24 +61,36 @@
  * $ arecord -f dat -t raw -D <capture-device> | aaf-talker <args>
  */
 
+#define _GNU_SOURCE
+
 #include <argp.h>
 #include <arpa/inet.h>
+#include <errno.h>
 #include <linux/if.h>
 #include <linux/if_ether.h>
 #include <linux/if_packet.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "avtp/aaf/Pcm.h"
 #include "common/common.h"
 #include "avtp/CommonHeader.h"
+#include "aaf-packetizer.h"
+#include "aaf-pcm-ring.h"
 
 #define STREAM_ID		0xAABBCCDDEEFF0001
 #define SAMPLE_SIZE		2 /* Sample size in bytes. */
 #define NUM_CHANNELS		2
-#define DATA_LEN		(SAMPLE_SIZE * NUM_CHANNELS)
-#define PDU_SIZE		(sizeof(struct avtp_stream_pdu) + DATA_LEN)
+#define FRAME_SIZE		(SAMPLE_SIZE * NUM_CHANNELS)
+#define RING_FRAMES		8192
+#define MAX_BURST		64
+/* Input stall after which the time base is taken from the clock again */
+#define RESYNC_THRESHOLD	(20 * NSEC_PER_MSEC)
 #define NSEC_PER_SEC		1000000000ULL
 #define NSEC_PER_MSEC		1000000ULL
 
@@ -80,8 +98,16 @@ static char ifname[IFNAMSIZ];
 static uint8_t macaddr[ETH_ALEN];
 static int priority = -1;
 static int max_transit_time;
+static int burst = 1;
+static uint32_t class_interval = AAF_CLASS_A_INTERVAL_NS;
+
+static pcm_ring_t ring;
+static int data_fd;
+static int input_done;
 
 static struct argp_option options[] = {
+    {"burst", 'b', "NUM", 0, "Number of PDUs sent per system call (default 1)" },
+    {"class", 'c', "A|B", 0, "SR class defining the packet interval (default A)" },
     {"dst-addr", 'd', "MACADDR", 0, "Stream Destination MAC address" },
     {"ifname", 'i', "IFNAME", 0, "Network Interface" },
     {"max-transit-time", 'm', "MSEC", 0, "Maximum Transit Time in ms" },
@@ -94,6 +120,21 @@ static error_t parser(int key, char *arg, struct argp_state *state)
     int res;
 
     switch (key) {
+    case 'b':
+        burst = atoi(arg);
+        if (burst < 1 || burst > MAX_BURST) {
+            argp_error(state, "Burst must be between 1 and %d", MAX_BURST);
+        }
+        break;
+    case 'c':
+        if (!strcmp(arg, "A") || !strcmp(arg, "a")) {
+            class_interval = AAF_CLASS_A_INTERVAL_NS;
+        } else if (!strcmp(arg, "B") || !strcmp(arg, "b")) {
+            class_interval = AAF_CLASS_B_INTERVAL_NS;
+        } else {
+            argp_error(state, "Invalid SR class %s", arg);
+        }
+        break;
     case 'd':
         res = sscanf(arg, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
                     &macaddr[0], &macaddr[1], &macaddr[2],
@@ -120,48 +161,104 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 
 static struct argp argp = { options, parser };
 
-static int init_pdu(struct avtp_stream_pdu *pdu)
+static uint64_t get_time_ns(void)
 {
-    int res;
+    struct timespec now;
 
-    res = avtp_aaf_pdu_init(pdu);
-    if (res < 0)
-        return -1;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
 
-    res = avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_TV, 1);
-    if (res < 0)
-        return -1;
+/* Notify the sender thread that frames are ready or the input ended. */
+static void notify_sender(void)
+{
+    uint64_t one = 1;
 
-    res = avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_STREAM_ID, STREAM_ID);
-    if (res < 0)
-        return -1;
+    if (write(data_fd, &one, sizeof(one)) < 0) {
+        perror("Failed to write eventfd");
+    }
+}
 
-    res = avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_FORMAT,
-                        AVTP_AAF_FORMAT_INT_16BIT);
-    if (res < 0)
-        return -1;
+/* Reader thread: copies the PCM stream from stdin into the ring. A read may
+ * end in the middle of a frame; the bytes of the partial frame are kept aside
+ * and completed by the next read.
+ */
+static void *read_input(void *arg)
+{
+    uint8_t partial[FRAME_SIZE];
+    size_t pending = 0;
 
-    res = avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_NSR,
-                        AVTP_AAF_PCM_NSR_48KHZ);
-    if (res < 0)
-        return -1;
+    while (1) {
+        uint8_t *ptr;
+        uint32_t frames = pcm_ring_write_region(&ring, &ptr);
+        size_t total;
+        ssize_t n;
 
-    res = avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_CHAN_PER_FRAME,
-                                NUM_CHANNELS);
-    if (res < 0)
-        return -1;
+        if (frames == 0) {
+            // Ring full, wait for the sender to catch up
+            struct timespec ts = { 0, class_interval };
+            nanosleep(&ts, NULL);
+            continue;
+        }
 
-    res = avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_BIT_DEPTH, 16);
-    if (res < 0)
-        return -1;
+        memcpy(ptr, partial, pending);
+        n = read(STDIN_FILENO, ptr + pending,
+                 (size_t)frames * FRAME_SIZE - pending);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
 
-    res = avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_STREAM_DATA_LEN, DATA_LEN);
-    if (res < 0)
-        return -1;
+        total = pending + n;
+        pending = total % FRAME_SIZE;
+        memcpy(partial, ptr + total - pending, pending);
+        if (total >= FRAME_SIZE) {
+            pcm_ring_produce(&ring, total / FRAME_SIZE);
+            notify_sender();
+        }
+    }
 
-    res = avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_SP, AVTP_AAF_PCM_SP_NORMAL);
-    if (res < 0)
-        return -1;
+    __atomic_store_n(&input_done, 1, __ATOMIC_RELEASE);
+    notify_sender();
+    return NULL;
+}
+
+/* Send PDUs with one system call.
+ * @fd: Socket.
+ * @pdus: PDUs to be sent, @stride bytes apart.
+ * @count: Number of PDUs.
+ * @pdu_size: Size of one PDU.
+ * @sk_addr: Destination.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Failed to send.
+ */
+static int send_pdus(int fd, uint8_t *pdus, int count, size_t pdu_size,
+                     struct sockaddr_ll *sk_addr)
+{
+    struct mmsghdr msgs[MAX_BURST];
+    struct iovec iovs[MAX_BURST];
+    int sent = 0;
+
+    for (int i = 0; i < count; i++) {
+        iovs[i].iov_base = pdus + i * pdu_size;
+        iovs[i].iov_len = pdu_size;
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_name = sk_addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(*sk_addr);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (sent < count) {
+        int n = sendmmsg(fd, msgs + sent, count - sent, 0);
+        if (n < 0) {
+            perror("Failed to send data");
+            return -1;
+        }
+        sent += n;
+    }
 
     return 0;
 }
@@ -170,11 +267,31 @@ int main(int argc, char *argv[])
 {
     int fd, res;
     struct sockaddr_ll sk_addr;
-    struct avtp_stream_pdu *pdu = alloca(PDU_SIZE);
-    uint8_t seq_num = 0;
+    aaf_packetizer_t pkt;
+    aaf_packetizer_config_t cfg = {
+        .stream_id = STREAM_ID,
+        .format = AVTP_AAF_FORMAT_INT_16BIT,
+        .bit_depth = 16,
+        .nsr = AVTP_AAF_PCM_NSR_48KHZ,
+        .channels = NUM_CHANNELS,
+        .sample_type = AVTP_PCM_SAMPLE_INT16,
+    };
+    uint64_t transit_ns;
+    uint8_t *pdus = NULL;
+    pthread_t reader;
+    int started = 0;
 
     argp_parse(&argp, argc, argv, 0, NULL, NULL);
 
+    cfg.class_interval_ns = class_interval;
+    transit_ns = max_transit_time * NSEC_PER_MSEC;
+
+    res = aaf_packetizer_init(&pkt, &cfg);
+    if (res < 0) {
+        fprintf(stderr, "Invalid stream parameters\n");
+        return 1;
+    }
+
     fd = create_talker_socket(priority);
     if (fd < 0)
         return 1;
@@ -183,57 +300,73 @@ int main(int argc, char *argv[])
     if (res < 0)
         goto err;
 
-    res = init_pdu(pdu);
-    if (res < 0)
+    pdus = malloc(pkt.pdu_size * MAX_BURST);
+    data_fd = eventfd(0, 0);
+    if (pdus == NULL || data_fd < 0 ||
+            pcm_ring_init(&ring, FRAME_SIZE, RING_FRAMES) < 0) {
+        fprintf(stderr, "Failed to allocate buffers\n");
         goto err;
+    }
 
-    while (1) {
-        ssize_t n;
-        uint32_t avtp_time;
-
-        memset(pdu->avtp_payload, 0, DATA_LEN);
+    res = pthread_create(&reader, NULL, read_input, NULL);
+    if (res != 0) {
+        fprintf(stderr, "Failed to create reader thread\n");
+        goto err;
+    }
 
-        n = read(STDIN_FILENO, pdu->avtp_payload, DATA_LEN);
-        if (n == 0)
-            break;
+    while (1) {
+        uint64_t events, launch, now;
+        struct timespec ts;
+        int count;
+
+        if (pcm_ring_readable(&ring) < pkt.frames_per_pdu) {
+            if (__atomic_load_n(&input_done, __ATOMIC_ACQUIRE) &&
+                    pcm_ring_readable(&ring) < pkt.frames_per_pdu) {
+                // Frames that do not fill a PDU are dropped
+                break;
+            }
+            if (read(data_fd, &events, sizeof(events)) < 0) {
+                perror("Failed to read eventfd");
+                goto err;
+            }
+            continue;
+        }
 
-        if (n != DATA_LEN) {
-            fprintf(stderr, "read %zd bytes, expected %d\n",
-                                n, DATA_LEN);
+        /* The time base is set once from the system clock and then
+         * advanced by the number of frames sent. It is only reset when the
+         * input stalled and PDUs would be presented well in the past.
+         */
+        now = get_time_ns();
+        if (!started ||
+                aaf_packetizer_next_time(&pkt) + RESYNC_THRESHOLD < now) {
+            aaf_packetizer_start(&pkt, now + transit_ns);
+            started = 1;
         }
 
-        res = calculate_avtp_time(&avtp_time, max_transit_time);
-        if (res < 0) {
-            fprintf(stderr, "Failed to calculate avtp time\n");
-            goto err;
+        // Send no earlier than max_transit_time before presentation
+        launch = aaf_packetizer_next_time(&pkt) - transit_ns;
+        if (launch > now) {
+            ts.tv_sec = launch / NSEC_PER_SEC;
+            ts.tv_nsec = launch % NSEC_PER_SEC;
+            clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &ts, NULL);
         }
 
-        res = avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_TIMESTAMP,
-                                avtp_time);
-        if (res < 0)
-            goto err;
+        count = aaf_packetizer_fill(&pkt, &ring, pdus, pkt.pdu_size, burst);
 
-        res = avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_SEQ_NUM, seq_num++);
+        res = send_pdus(fd, pdus, count, pkt.pdu_size, &sk_addr);
         if (res < 0)
             goto err;
-
-        n = sendto(fd, pdu, PDU_SIZE, 0,
-                (struct sockaddr *) &sk_addr, sizeof(sk_addr));
-        if (n < 0) {
-            perror("Failed to send data");
-            goto err;
-        }
-
-        if (n != PDU_SIZE) {
-            fprintf(stderr, "wrote %zd bytes, expected %zd\n",
-                                n, PDU_SIZE);
-        }
     }
 
+    pthread_join(reader, NULL);
+    pcm_ring_close(&ring);
+    free(pdus);
+    close(data_fd);
     close(fd);
     return 0;
 
 err:
+    free(pdus);
     close(fd);
     return 1;
-}
\ No newline at end of file
+}
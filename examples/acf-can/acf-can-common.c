@@ -97,8 +97,34 @@ int setup_can_socket(const char* can_ifname,
 
     return can_socket;
 }
+
+int read_can_frame(int can_socket, frame_t* frame) {
+
+    ssize_t nbytes;
+
+    // CAN CC frames are returned with CAN_MTU even on CAN FD sockets
+    nbytes = read(can_socket, &frame->fd, sizeof(struct canfd_frame));
+    if (nbytes == CANFD_MTU) {
+        frame->fd.flags |= CAN_FRAME_FLAG_FDF;
+    } else if (nbytes == CAN_MTU) {
+        frame->fd.flags &= ~CAN_FRAME_FLAG_FDF;
+    } else {
+        perror("Error reading CAN frames");
+        return -1;
+    }
+
+    return 0;
+}
+
+size_t get_can_frame_size(frame_t* frame) {
+    return is_canfd_frame(frame) ? CANFD_MTU : CAN_MTU;
+}
 #endif
 
+int is_canfd_frame(frame_t* frame) {
+    return (frame->fd.flags & CAN_FRAME_FLAG_FDF) ? 1 : 0;
+}
+
 static int is_valid_acf_packet(uint8_t* acf_pdu)
 {
     Avtp_AcfCommon_t *pdu = (Avtp_AcfCommon_t*) acf_pdu;
@@ -144,13 +170,12 @@ static int update_cf_length(uint8_t* cf_pdu, uint64_t length, int use_tscf)
     return 0;
 }
 
-static int prepare_acf_packet(uint8_t* acf_pdu,
-                              frame_t* frame,
-                              Avtp_CanVariant_t can_variant) {
+static int prepare_acf_packet(uint8_t* acf_pdu, frame_t* frame) {
 
     struct timespec now;
     canid_t can_id;
     uint8_t can_payload_length;
+    int is_fd = is_canfd_frame(frame);
 
     // Clear bits
     Avtp_Can_t* pdu = (Avtp_Can_t*) acf_pdu;
@@ -164,11 +189,11 @@ static int prepare_acf_packet(uint8_t* acf_pdu,
 
     // Set required CAN Flags
 #ifdef __linux__
-    can_id = (can_variant == AVTP_CAN_FD) ? (*frame).fd.can_id : (*frame).cc.can_id;
-    can_payload_length = (can_variant == AVTP_CAN_FD) ? (*frame).fd.len : (*frame).cc.len;
+    can_id = is_fd ? (*frame).fd.can_id : (*frame).cc.can_id;
+    can_payload_length = is_fd ? (*frame).fd.len : (*frame).cc.len;
 #elif defined(__ZEPHYR__)
-    can_id = (can_variant == AVTP_CAN_FD) ? (*frame).fd.id : (*frame).cc.id;
-    can_payload_length = (can_variant == AVTP_CAN_FD) ? (*frame).fd.dlc : (*frame).cc.dlc;
+    can_id = is_fd ? (*frame).fd.id : (*frame).cc.id;
+    can_payload_length = is_fd ? (*frame).fd.dlc : (*frame).cc.dlc;
 #endif
     if (can_id & CAN_EFF_FLAG) {
         Avtp_Can_EnableEff(pdu);
@@ -177,32 +202,30 @@ static int prepare_acf_packet(uint8_t* acf_pdu,
         Avtp_Can_EnableRtr(pdu);
     }
 
-    if (can_variant == AVTP_CAN_FD) {
+    if (is_fd) {
         if (frame->fd.flags & CANFD_BRS) {
             Avtp_Can_EnableBrs(pdu);
         }
-        if (frame->fd.flags & CANFD_FDF) {
-            Avtp_Can_EnableFdf(pdu);
-        }
         if (frame->fd.flags & CANFD_ESI) {
             Avtp_Can_EnableEsi(pdu);
         }
     }
 
-    // Copy payload to ACF CAN PDU
-    if(can_variant == AVTP_CAN_FD)
+    // Copy payload to ACF CAN PDU. The ACF message is only as long as
+    // the payload of the frame, so CAN CC frames take up 8 bytes at most.
+    if (is_fd)
         Avtp_Can_CreateAcfMessage(pdu, can_id & CAN_EFF_MASK, frame->fd.data,
-                                         can_payload_length, can_variant);
+                                         can_payload_length, AVTP_CAN_FD);
     else
         Avtp_Can_CreateAcfMessage(pdu, can_id & CAN_EFF_MASK, frame->cc.data,
-                                         can_payload_length, can_variant);
+                                         can_payload_length, AVTP_CAN_CLASSIC);
 
     return Avtp_Can_GetAcfMsgLength(pdu)*4;
 }
 
-int can_to_avtp(frame_t* can_frames, Avtp_CanVariant_t can_variant, uint8_t* pdu,
-                     int use_udp, int use_tscf, uint64_t stream_id,
-                     uint8_t num_acf_msgs, uint8_t cf_seq_num, uint32_t udp_seq_num) {
+int can_to_avtp(frame_t* can_frames, uint8_t* pdu, int use_udp,
+                     int use_tscf, uint64_t stream_id, uint8_t num_acf_msgs,
+                     uint8_t cf_seq_num, uint32_t udp_seq_num) {
 
     // Pack into control formats
     uint8_t *cf_pdu;
@@ -226,7 +249,7 @@ int can_to_avtp(frame_t* can_frames, Avtp_CanVariant_t can_variant, uint8_t* pdu
     int i = 0;
     while (i < num_acf_msgs) {
         uint8_t* acf_pdu = pdu + pdu_length;
-        res = prepare_acf_packet(acf_pdu, &(can_frames[i]), can_variant);
+        res = prepare_acf_packet(acf_pdu, &(can_frames[i]));
         pdu_length += res;
         cf_length += res;
         i++;
@@ -239,6 +262,32 @@ int can_to_avtp(frame_t* can_frames, Avtp_CanVariant_t can_variant, uint8_t* pdu
 
 }
 
+int send_can_frames(int eth_socket, struct sockaddr* dest_addr,
+                    frame_t* can_frames, uint8_t num_frames, int use_udp,
+                    int use_tscf, uint64_t stream_id, uint8_t* cf_seq_num,
+                    uint32_t* udp_seq_num) {
+
+    uint8_t pdu[MAX_ETH_PDU_SIZE];
+    uint16_t pdu_length;
+    int res;
+
+    pdu_length = can_to_avtp(can_frames, pdu, use_udp, use_tscf,
+                                stream_id, num_frames, (*cf_seq_num)++, (*udp_seq_num)++);
+
+    if (use_udp) {
+        res = sendto(eth_socket, pdu, pdu_length, 0,
+                dest_addr, sizeof(struct sockaddr_in));
+    } else {
+        res = sendto(eth_socket, pdu, pdu_length, 0,
+                     dest_addr, sizeof(struct sockaddr_ll));
+    }
+    if (res < 0) {
+        perror("Failed to send data");
+    }
+
+    return res;
+}
+
 int avtp_to_can(uint8_t* pdu, frame_t* can_frames, Avtp_CanVariant_t can_variant,
                 int use_udp, uint64_t stream_id, uint8_t* exp_cf_seqnum,
                 uint32_t* exp_udp_seqnum) {
@@ -305,6 +354,12 @@ int avtp_to_can(uint8_t* pdu, frame_t* can_frames, Avtp_CanVariant_t can_variant
         uint16_t acf_msg_length = Avtp_Can_GetAcfMsgLength((Avtp_Can_t*)acf_pdu)*4;
         uint16_t can_payload_length = Avtp_Can_GetCanPayloadLength((Avtp_Can_t*)acf_pdu);
         proc_bytes += acf_msg_length;
+
+        // CAN FD frames can only be put on a CAN FD capable bus
+        if (Avtp_Can_GetFdf((Avtp_Can_t*)acf_pdu) && can_variant != AVTP_CAN_FD) {
+            printf("Error: CAN FD frame received but CAN FD is not enabled.\n");
+            continue;
+        }
         frame_t* frame = &(can_frames[i++]);
 
         // Handle EFF Flag
@@ -320,13 +375,11 @@ int avtp_to_can(uint8_t* pdu, frame_t* can_frames, Avtp_CanVariant_t can_variant
             can_id |= CAN_RTR_FLAG;
         }
 
-        if (can_variant == AVTP_CAN_FD) {
+        if (Avtp_Can_GetFdf((Avtp_Can_t*)acf_pdu)) {
+            frame->fd.flags = CAN_FRAME_FLAG_FDF;
             if (Avtp_Can_GetBrs((Avtp_Can_t*)acf_pdu)) {
                 frame->fd.flags |= CANFD_BRS;
             }
-            if (Avtp_Can_GetFdf((Avtp_Can_t*)acf_pdu)) {
-                frame->fd.flags |= CANFD_FDF;
-            }
             if (Avtp_Can_GetEsi((Avtp_Can_t*)acf_pdu)) {
                 frame->fd.flags |= CANFD_ESI;
             }
@@ -339,6 +392,7 @@ int avtp_to_can(uint8_t* pdu, frame_t* can_frames, Avtp_CanVariant_t can_variant
 #endif
             memcpy(frame->fd.data, can_payload, can_payload_length);
         } else {
+            frame->fd.flags = 0;
 #ifdef __linux__
             frame->cc.can_id = can_id;
             frame->cc.len = can_payload_length;
@@ -351,4 +405,50 @@ int avtp_to_can(uint8_t* pdu, frame_t* can_frames, Avtp_CanVariant_t can_variant
     }
 
     return i;
-}
\ No newline at end of file
+}
+
+int get_avtp_timestamp(uint8_t* pdu, int use_udp, uint32_t* avtp_time) {
+
+    Avtp_Tscf_t* tscf_pdu;
+
+    if (use_udp) {
+        tscf_pdu = (Avtp_Tscf_t*) (pdu + AVTP_UDP_HEADER_LEN);
+    } else {
+        tscf_pdu = (Avtp_Tscf_t*) pdu;
+    }
+
+    // Only TSCF carries a presentation time
+    if (Avtp_CommonHeader_GetSubtype((Avtp_CommonHeader_t*)tscf_pdu) != AVTP_SUBTYPE_TSCF) {
+        return 0;
+    }
+    if (!Avtp_Tscf_GetTv(tscf_pdu)) {
+        return 0;
+    }
+
+    *avtp_time = Avtp_Tscf_GetAvtpTimestamp(tscf_pdu);
+    return 1;
+}
+
+int is_prio_can_frame(const can_prio_config_t* prio, frame_t* frame) {
+
+    canid_t can_id;
+    uint8_t i;
+
+#ifdef __linux__
+    can_id = frame->cc.can_id & CAN_EFF_MASK;
+#elif defined(__ZEPHYR__)
+    can_id = frame->cc.id & CAN_EFF_MASK;
+#endif
+
+    if (can_id < prio->id_threshold) {
+        return 1;
+    }
+
+    for (i = 0; i < prio->num_ids; i++) {
+        if (prio->ids[i] == can_id) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
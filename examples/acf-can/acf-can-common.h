@@ -27,6 +27,8 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
+#pragma once
+
 #ifdef __linux__
 #include <linux/can.h>
 #elif defined(__ZEPHYR__)
@@ -44,41 +46,82 @@
 
 #define MAX_ETH_PDU_SIZE                1500
 #define MAX_CAN_FRAMES_IN_ACF           15
+#define MAX_PRIO_CAN_IDS                16
 
 #ifdef __linux__
 typedef struct can_frame can_frame_t;
 typedef struct canfd_frame canfd_frame_t;
+#define CAN_FRAME_FLAG_FDF CANFD_FDF
 #elif defined (__ZEPHYR__)
 typedef struct can_frame can_frame_t;
 typedef struct can_frame canfd_frame_t;
+#define CAN_FRAME_FLAG_FDF CAN_FRAME_FDF
 #endif
 
 /* CAN CC/FD frame union */
 /* This is needed because the data structures for CAN and CAN-FD in Linux
     are slightly different. However, in Zephyr same data structure is used for both.
+    The type of each frame is tagged by CAN_FRAME_FLAG_FDF in fd.flags, which
+    overlaps with padding in Linux CAN CC frames.
 */
 typedef union {
     can_frame_t cc;
     canfd_frame_t fd;
 } frame_t;
 
+/* High priority CAN IDs */
+/* Frames matching this configuration bypass the aggregation of multiple CAN
+    frames into one AVTP frame and are sent out immediately.
+*/
+typedef struct {
+    uint32_t id_threshold;              /* IDs below are prioritized, 0: disabled */
+    uint32_t ids[MAX_PRIO_CAN_IDS];     /* Additional prioritized IDs */
+    uint8_t num_ids;
+} can_prio_config_t;
+
 #ifdef __linux__
 /**
  * Creates a CAN socket.
  *
  * @param can_ifname Pointer to the first bit of an 1722 AVTP PDU.
- * @param can_variant CAN or CAN-FD
+ * @param can_variant CAN or CAN-FD. With CAN-FD, the socket carries both
+ *                    CAN CC and CAN FD frames.
  * @returns CAN socket on success else the error
  */
 int setup_can_socket(const char* can_ifname, Avtp_CanVariant_t can_variant);
+
+/**
+ * Reads a CAN CC or CAN FD frame from a CAN socket and tags its type.
+ *
+ * @param can_socket CAN socket
+ * @param frame Frame to be read
+ * @returns 0 on success, -1 on error
+ */
+int read_can_frame(int can_socket, frame_t* frame);
+
+/**
+ * Returns the size of a frame as read from or written to a CAN socket.
+ *
+ * @param frame CAN frame
+ * @returns CANFD_MTU for CAN FD frames, CAN_MTU otherwise
+ */
+size_t get_can_frame_size(frame_t* frame);
 #endif
 
+/**
+ * Checks if a frame is a CAN FD frame.
+ *
+ * @param frame CAN frame
+ * @returns 1 for CAN FD frames, 0 for CAN CC frames
+ */
+int is_canfd_frame(frame_t* frame);
+
 /**
  * Function that converts AVTP Frames to CAN
  *
  * @param pdu: Start of the AVTP Frame
  * @param can_frames: Array of CAM Frames to be recovered from AVTP Frames
- * @param can_variant: AVTP_CAN_CLASSIC or AVTP_CAN_FD
+ * @param can_variant: AVTP_CAN_FD if CAN FD frames can be sent, else AVTP_CAN_CLASSIC
  * @param use_udp 1: UDP encapsulation, 0: Ethernet
  * @param stream_id: AVTP stream ID of interest
  * @param exp_cf_seqnum: Expected Control format sequence num.
@@ -93,7 +136,6 @@ int avtp_to_can(uint8_t* pdu, frame_t* can_frames, Avtp_CanVariant_t can_variant
  * Function that converts AVTP Frames to CAN
  *
  * @param can_frames: Array of CAM Frames to be translated to AVTP Frames
- * @param can_variant: AVTP_CAN_CLASSIC or AVTP_CAN_FD
  * @param pdu: Start of AVTP Frame
  * @param use_udp 1: UDP encapsulation, 0: Ethernet
  * @param use_tscf 1: TSCF, 0: NTSCF
@@ -103,6 +145,45 @@ int avtp_to_can(uint8_t* pdu, frame_t* can_frames, Avtp_CanVariant_t can_variant
  * @param udp_seq_num: UDP Encapsulation sequence num.
  * @return Length of the PDU
  */
-int can_to_avtp(frame_t* can_frames, Avtp_CanVariant_t can_variant, uint8_t* pdu,
-                     int use_udp, int use_tscf, uint64_t stream_id,
-                     uint8_t num_acf_msgs, uint8_t cf_seq_num, uint32_t udp_seq_num);
\ No newline at end of file
+int can_to_avtp(frame_t* can_frames, uint8_t* pdu, int use_udp,
+                     int use_tscf, uint64_t stream_id, uint8_t num_acf_msgs, uint8_t cf_seq_num, uint32_t udp_seq_num);
+
+struct sockaddr;
+
+/**
+ * Function that packs CAN frames into an AVTP frame and sends it out
+ *
+ * @param eth_socket: Ethernet or UDP socket to send the AVTP frame on
+ * @param dest_addr: Destination address, sockaddr_in for UDP, else sockaddr_ll
+ * @param can_frames: Array of CAN Frames to be translated to AVTP Frames
+ * @param num_frames: No. of CAN frames to aggregate into the AVTP frame
+ * @param use_udp 1: UDP encapsulation, 0: Ethernet
+ * @param use_tscf 1: TSCF, 0: NTSCF
+ * @param stream_id: AVTP stream ID of the talker stream
+ * @param cf_seq_num: Control format sequence num., incremented on each call
+ * @param udp_seq_num: UDP Encapsulation sequence num., incremented on each call
+ * @return Number of bytes sent, negative on error
+ */
+int send_can_frames(int eth_socket, struct sockaddr* dest_addr,
+                    frame_t* can_frames, uint8_t num_frames, int use_udp,
+                    int use_tscf, uint64_t stream_id, uint8_t* cf_seq_num,
+                    uint32_t* udp_seq_num);
+
+/**
+ * Function that retrieves the AVTP presentation time of a control format frame
+ *
+ * @param pdu: Start of the AVTP Frame
+ * @param use_udp 1: UDP encapsulation, 0: Ethernet
+ * @param avtp_time: Location to store the 32-bit AVTP timestamp
+ * @return 1 if the frame is a TSCF frame with the tv bit set, 0 otherwise
+ */
+int get_avtp_timestamp(uint8_t* pdu, int use_udp, uint32_t* avtp_time);
+
+/**
+ * Function that checks if a CAN frame has a high priority ID
+ *
+ * @param prio: Configuration of high priority CAN IDs
+ * @param frame: CAN frame to be classified
+ * @return 1 if the frame should bypass aggregation, 0 otherwise
+ */
+int is_prio_can_frame(const can_prio_config_t* prio, frame_t* frame);
@@ -40,7 +40,10 @@
 #include <inttypes.h>
 #include <sys/ioctl.h>
 #include <arpa/inet.h>
+#include <poll.h>
 #include <pthread.h>
+#include <signal.h>
+#include <errno.h>
 
 #include "common/common.h"
 #include "avtp/Udp.h"
@@ -50,11 +53,16 @@
 #include "avtp/acf/Can.h"
 #include "avtp/CommonHeader.h"
 #include "acf-can-common.h"
+#include "acf-can-release-queue.h"
+#include "acf-can-tx-queue.h"
 
 #define ARGPARSE_CAN_FD_OPTION      500
 #define ARGPARSE_CAN_IF_OPTION      501
 #define ARGPARSE_TALKER_ID_OPTION      502
 #define ARGPARSE_LISTENER_ID_OPTION     503
+#define ARGPARSE_PRIO_THRESHOLD_OPTION  504
+#define ARGPARSE_PRIO_ID_OPTION         505
+#define ARGPARSE_DROP_POLICY_OPTION     506
 #define TALKER_STREAM_ID            0xAABBCCDDEEFF0001
 #define LISTENER_STREAM_ID  	    0xAABBCCDDEEFF0001
 
@@ -72,9 +80,14 @@ static char can_ifname[IFNAMSIZ];
 static uint64_t talker_stream_id = TALKER_STREAM_ID;
 static uint64_t listener_stream_id = LISTENER_STREAM_ID;
 static char ip_addr_str[100];
+static can_prio_config_t prio_config;
 
 int eth_socket, can_socket;
 struct sockaddr* dest_addr;
+static can_release_queue_t release_queue;
+static can_tx_queue_t tx_queue;
+static can_tx_drop_policy_t drop_policy = CAN_TX_DROP_OLDEST;
+static volatile sig_atomic_t stop;
 
 static char doc[] =
         "\nacf-can-bridge -- a program for bridging a CAN interface with an Ethernet interface using IEEE 1722.\
@@ -96,6 +109,9 @@ static struct argp_option options[] = {
     {"udp-port", 'p', "UDP_PORT", 0, "UDP Port to listen on (if UDP)"},
     {"listener-stream-id", ARGPARSE_LISTENER_ID_OPTION, "STREAM_ID", 0, "Stream ID for listener stream"},
     {"talker-stream-id", ARGPARSE_TALKER_ID_OPTION, "STREAM_ID", 0, "Stream ID for talker stream"},
+    {"prio-threshold", ARGPARSE_PRIO_THRESHOLD_OPTION, "CAN_ID", 0, "Send CAN frames with an ID below CAN_ID (hex) immediately without aggregation"},
+    {"prio-id", ARGPARSE_PRIO_ID_OPTION, "CAN_ID", 0, "Send CAN frames with ID CAN_ID (hex) immediately without aggregation. Can be repeated."},
+    {"drop-policy", ARGPARSE_DROP_POLICY_OPTION, "POLICY", 0, "CAN frame to drop if the CAN TX queue is full: oldest (default), newest or prio"},
     { 0 }
 };
 
@@ -164,6 +180,32 @@ static error_t parser(int key, char *arg, struct argp_state *state)
             exit(EXIT_FAILURE);
         }
         break;
+    case ARGPARSE_PRIO_THRESHOLD_OPTION:
+        res = sscanf(arg, "%x", &prio_config.id_threshold);
+        if (res != 1) {
+            fprintf(stderr, "Invalid priority CAN ID threshold\n");
+            exit(EXIT_FAILURE);
+        }
+        break;
+    case ARGPARSE_PRIO_ID_OPTION:
+        if (prio_config.num_ids >= MAX_PRIO_CAN_IDS) {
+            fprintf(stderr, "Too many priority CAN IDs.\n");
+            exit(EXIT_FAILURE);
+        }
+        res = sscanf(arg, "%x", &prio_config.ids[prio_config.num_ids]);
+        if (res != 1) {
+            fprintf(stderr, "Invalid priority CAN ID\n");
+            exit(EXIT_FAILURE);
+        }
+        prio_config.num_ids++;
+        break;
+    case ARGPARSE_DROP_POLICY_OPTION:
+        res = can_tx_parse_drop_policy(arg, &drop_policy);
+        if (res < 0) {
+            fprintf(stderr, "Invalid drop policy\n");
+            exit(EXIT_FAILURE);
+        }
+        break;
     }
 
     return 0;
@@ -171,13 +213,15 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 
 static struct argp argp = { options, parser, NULL, doc};
 
+static void handle_signal(int sig)
+{
+    stop = 1;
+}
+
 void* can_to_avtp_runnable(void* args) {
 
     uint8_t cf_seq_num = 0;
     uint32_t udp_seq_num = 0;
-
-    uint8_t pdu[MAX_ETH_PDU_SIZE];
-    uint16_t pdu_length = 0;
     frame_t can_frames[num_acf_msgs];
     int res;
 
@@ -189,33 +233,24 @@ void* can_to_avtp_runnable(void* args) {
         while (i < num_acf_msgs) {
             // Get payload -- will 'spin' here until we get the requested number
             //                of CAN frames.
-            if(can_variant == AVTP_CAN_FD){
-                res = read(can_socket, &(can_frames[i].fd), sizeof(struct canfd_frame));
-            } else {
-                res = read(can_socket, &(can_frames[i].cc), sizeof(struct can_frame));
+            res = read_can_frame(can_socket, &can_frames[i]);
+            if (res < 0) {
+                continue;
             }
-            if (!res) {
-                perror("Error reading CAN frames");
+
+            // High priority frames are not held back by the aggregation
+            if (num_acf_msgs > 1 &&
+                is_prio_can_frame(&prio_config, &can_frames[i])) {
+                send_can_frames(eth_socket, dest_addr, &can_frames[i], 1, use_udp, use_tscf,
+                                talker_stream_id, &cf_seq_num, &udp_seq_num);
                 continue;
             }
             i++;
         }
 
-        // Pack all the read frames into an AVTP frame
-        pdu_length = can_to_avtp(can_frames, can_variant, pdu, use_udp, use_tscf,
-                                    talker_stream_id, num_acf_msgs, cf_seq_num++, udp_seq_num++);
-
-        // Send the packed frame out
-        if (use_udp) {
-            res = sendto(eth_socket, pdu, pdu_length, 0,
-                    (struct sockaddr *) dest_addr, sizeof(struct sockaddr_in));
-        } else {
-            res = sendto(eth_socket, pdu, pdu_length, 0,
-                         (struct sockaddr *) dest_addr, sizeof(struct sockaddr_ll));
-        }
-        if (res < 0) {
-            perror("Failed to send data");
-        }
+        // Pack all the read frames into an AVTP frame and send it out
+        send_can_frames(eth_socket, dest_addr, can_frames, num_acf_msgs, use_udp, use_tscf,
+                        talker_stream_id, &cf_seq_num, &udp_seq_num);
     }
 
     return NULL;
@@ -227,11 +262,61 @@ void* avtp_to_can_runnable(void* args) {
     int8_t num_can_msgs = 0;
     uint8_t exp_cf_seqnum = 0;
     uint32_t exp_udp_seqnum = 0;
+    uint32_t avtp_time;
     uint8_t pdu[MAX_ETH_PDU_SIZE];
     frame_t can_frames[MAX_CAN_FRAMES_IN_ACF];
+    struct pollfd fds[3];
+    sigset_t sigs;
+    int res;
 
-    // Start an infinite loop to keep converting AVTP frames to CAN frames
-    for(;;) {
+    // Signals are only delivered to this thread to interrupt poll()
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_UNBLOCK, &sigs, NULL);
+
+    // Frames of TSCF streams with valid timestamps are held back until
+    // their presentation time
+    can_tx_queue_init(&tx_queue, can_socket, drop_policy);
+    res = can_release_queue_init(&release_queue, &tx_queue);
+    if (res < 0) {
+        return NULL;
+    }
+
+    fds[0].fd = eth_socket;
+    fds[0].events = POLLIN;
+    fds[1].fd = release_queue.timer_fd;
+    fds[1].events = POLLIN;
+    fds[2].fd = can_socket;
+
+    // Keep converting AVTP frames to CAN frames until interrupted
+    while (!stop) {
+
+        // Wait for the CAN socket only if frames are pending
+        fds[2].events = can_tx_queue_poll_events(&tx_queue);
+        res = poll(fds, 3, can_tx_queue_poll_timeout(&tx_queue));
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res < 0) {
+            perror("Failed to poll() fds");
+            break;
+        }
+
+        // Other fds may keep poll() from timing out, so check the retry
+        // deadline whatever poll() returned
+        if ((fds[2].revents & POLLOUT) || can_tx_queue_retry_due(&tx_queue)) {
+            can_tx_queue_flush(&tx_queue);
+        }
+
+        if (fds[1].revents & POLLIN) {
+            res = can_release_queue_timeout(&release_queue);
+            if (res < 0) break;
+        }
+
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
 
         pdu_length = recv(eth_socket, pdu, MAX_ETH_PDU_SIZE, 0);
         if (pdu_length < 0 || pdu_length > MAX_ETH_PDU_SIZE) {
@@ -247,20 +332,21 @@ void* avtp_to_can_runnable(void* args) {
         exp_cf_seqnum++;
         exp_udp_seqnum++;
 
-        for (int8_t i = 0; i < num_can_msgs; i++) {
-            int res;
-            if (can_variant == AVTP_CAN_FD)
-                res = write(can_socket, &can_frames[i].fd, sizeof(struct canfd_frame));
-            else if (can_variant == AVTP_CAN_CLASSIC)
-                res = write(can_socket, &can_frames[i].cc, sizeof(struct can_frame));
+        if (get_avtp_timestamp(pdu, use_udp, &avtp_time)) {
+            res = can_release_queue_push(&release_queue, can_frames,
+                                         num_can_msgs, avtp_time);
+            if (res < 0) break;
+            continue;
+        }
 
-            if(res < 0)
-            {
-                perror("Failed to write to CAN bus");
-            }
+        for (int i = 0; i < num_can_msgs; i++) {
+            can_tx_queue_write(&tx_queue, &can_frames[i]);
         }
     }
 
+    can_release_queue_print_stats(&release_queue);
+    can_tx_queue_print_stats(&tx_queue);
+    can_release_queue_close(&release_queue);
     return NULL;
 }
 
@@ -294,6 +380,10 @@ int main(int argc, char *argv[])
     }
     printf("\tListener Stream ID: 0x%lx, Talker Stream ID: 0x%lx\n", listener_stream_id, talker_stream_id);
     printf("\tNumber of ACF messages per AVTP frame in talker stream: %d\n", num_acf_msgs);
+    if (prio_config.id_threshold || prio_config.num_ids) {
+        printf("\tPriority CAN IDs: below 0x%x and %d additional IDs\n",
+                prio_config.id_threshold, prio_config.num_ids);
+    }
 
     // Create an appropriate sockets: UDP or Ethernet raw
     // Setup the socket for sending to the destination
@@ -321,14 +411,29 @@ int main(int argc, char *argv[])
     if (can_socket < 0) return 1;
 
     pthread_t can_to_avtp_thread, avtp_to_can_thread;
+    sigset_t sigs;
+
+    // Block SIGINT and SIGTERM in all threads but the AVTP to CAN thread,
+    // which stops on them and prints the statistics of its queues
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
 
     // Start the threads for the bridge
     pthread_create(&can_to_avtp_thread, NULL, can_to_avtp_runnable, NULL);
     pthread_create(&avtp_to_can_thread, NULL, avtp_to_can_runnable, NULL);
 
-    // Wait for the threads to complete
-    pthread_join(can_to_avtp_thread, NULL);
+    // The CAN to AVTP thread blocks in read() and is cancelled once the
+    // AVTP to CAN thread is done
     pthread_join(avtp_to_can_thread, NULL);
+    pthread_cancel(can_to_avtp_thread);
+    pthread_join(can_to_avtp_thread, NULL);
+
+    close(can_socket);
+    close(eth_socket);
 
-    return 1;
+    return stop ? 0 : 1;
 }
\ No newline at end of file
@@ -37,6 +37,9 @@
 #include <unistd.h>
 #include <inttypes.h>
 #include <linux/can/raw.h>
+#include <poll.h>
+#include <signal.h>
+#include <errno.h>
 #include <sys/ioctl.h>
 
 #include "common/common.h"
@@ -47,10 +50,13 @@
 #include "avtp/acf/Can.h"
 #include "avtp/CommonHeader.h"
 #include "acf-can-common.h"
+#include "acf-can-release-queue.h"
+#include "acf-can-tx-queue.h"
 
 #define ARGPARSE_CAN_FD_OPTION          500
 #define ARGPARSE_CAN_IF_OPTION          501
 #define ARGPARSE_LISTENER_ID_OPTION     503
+#define ARGPARSE_DROP_POLICY_OPTION     504
 #define STREAM_ID                       0xAABBCCDDEEFF0001
 
 static char ifname[IFNAMSIZ];
@@ -60,6 +66,10 @@ static uint32_t udp_port = 17220;
 static Avtp_CanVariant_t can_variant = AVTP_CAN_CLASSIC;
 static char can_ifname[IFNAMSIZ];
 static uint64_t listener_stream_id = STREAM_ID;
+static can_release_queue_t release_queue;
+static can_tx_queue_t tx_queue;
+static can_tx_drop_policy_t drop_policy = CAN_TX_DROP_OLDEST;
+static volatile sig_atomic_t stop;
 
 static char doc[] =
         "\nacf-can-listener -- a program to receive CAN messages from a remote CAN bus over Ethernet using Open1722.\
@@ -77,6 +87,7 @@ static struct argp_option options[] = {
     {"dst-addr", 'd', "MACADDR", 0, "Stream destination MAC address (If Ethernet)"},
     {"udp-port", 'p', "UDP_PORT", 0, "UDP Port to listen on (if UDP)"},
     {"stream-id", ARGPARSE_LISTENER_ID_OPTION, "STREAM_ID", 0, "Stream ID for listener stream"},
+    {"drop-policy", ARGPARSE_DROP_POLICY_OPTION, "POLICY", 0, "CAN frame to drop if the CAN TX queue is full: oldest (default), newest or prio"},
     { 0 }
 };
 
@@ -116,6 +127,13 @@ static error_t parser(int key, char *arg, struct argp_state *state)
             exit(EXIT_FAILURE);
         }
         break;
+    case ARGPARSE_DROP_POLICY_OPTION:
+        res = can_tx_parse_drop_policy(arg, &drop_policy);
+        if (res < 0) {
+            fprintf(stderr, "Invalid drop policy\n");
+            exit(EXIT_FAILURE);
+        }
+        break;
     }
 
     return 0;
@@ -123,6 +141,17 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 
 static struct argp argp = { options, parser, NULL, doc};
 
+static void print_stats(void)
+{
+    can_release_queue_print_stats(&release_queue);
+    can_tx_queue_print_stats(&tx_queue);
+}
+
+static void handle_signal(int sig)
+{
+    stop = 1;
+}
+
 int main(int argc, char *argv[])
 {
     int fd, res;
@@ -130,11 +159,13 @@ int main(int argc, char *argv[])
     struct sockaddr_can can_addr;
     struct ifreq ifr;
     uint16_t pdu_length = 0, cf_length = 0;
-    uint8_t num_can_msgs = 0;
+    int8_t num_can_msgs = 0;
     uint8_t exp_cf_seqnum = 0;
     uint32_t exp_udp_seqnum = 0;
+    uint32_t avtp_time;
     uint8_t pdu[MAX_ETH_PDU_SIZE];
     frame_t can_frames[MAX_CAN_FRAMES_IN_ACF];
+    struct pollfd fds[3];
 
     argp_parse(&argp, argc, argv, 0, NULL, NULL);
     // Print current configuration
@@ -152,6 +183,9 @@ int main(int argc, char *argv[])
     }
     printf("\tListener Stream ID: 0x%lx\n", listener_stream_id);
 
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
     // Configure an appropriate socket: UDP or Ethernet Raw
     if (use_udp) {
         fd = create_listener_socket_udp(udp_port);
@@ -166,8 +200,46 @@ int main(int argc, char *argv[])
     can_socket = setup_can_socket(can_ifname, can_variant);
     if (can_socket < 0) goto err;
 
-    // Start an infinite loop to keep converting AVTP frames to CAN frames
-    for(;;) {
+    // Frames of TSCF streams with valid timestamps are held back until
+    // their presentation time
+    can_tx_queue_init(&tx_queue, can_socket, drop_policy);
+    res = can_release_queue_init(&release_queue, &tx_queue);
+    if (res < 0) goto err;
+
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = release_queue.timer_fd;
+    fds[1].events = POLLIN;
+    fds[2].fd = can_socket;
+
+    // Keep converting AVTP frames to CAN frames until interrupted
+    while (!stop) {
+
+        // Wait for the CAN socket only if frames are pending
+        fds[2].events = can_tx_queue_poll_events(&tx_queue);
+        res = poll(fds, 3, can_tx_queue_poll_timeout(&tx_queue));
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res < 0) {
+            perror("Failed to poll() fds");
+            goto err;
+        }
+
+        // Other fds may keep poll() from timing out, so check the retry
+        // deadline whatever poll() returned
+        if ((fds[2].revents & POLLOUT) || can_tx_queue_retry_due(&tx_queue)) {
+            can_tx_queue_flush(&tx_queue);
+        }
+
+        if (fds[1].revents & POLLIN) {
+            res = can_release_queue_timeout(&release_queue);
+            if (res < 0) goto err;
+        }
+
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
 
         pdu_length = recv(fd, pdu, MAX_ETH_PDU_SIZE, 0);
         if (pdu_length < 0 || pdu_length > MAX_ETH_PDU_SIZE) {
@@ -177,27 +249,32 @@ int main(int argc, char *argv[])
 
         num_can_msgs = avtp_to_can(pdu, can_frames, can_variant, use_udp,
                              listener_stream_id, &exp_cf_seqnum, &exp_udp_seqnum);
+        if (num_can_msgs <= 0) {
+            continue;
+        }
         exp_cf_seqnum++;
         exp_udp_seqnum++;
 
+        if (get_avtp_timestamp(pdu, use_udp, &avtp_time)) {
+            res = can_release_queue_push(&release_queue, can_frames,
+                                         num_can_msgs, avtp_time);
+            if (res < 0) goto err;
+            continue;
+        }
+
         for (int i = 0; i < num_can_msgs; i++) {
-            int res;
-            if (can_variant == AVTP_CAN_FD)
-                res = write(can_socket, &can_frames[i].fd, sizeof(struct canfd_frame));
-            else if (can_variant == AVTP_CAN_CLASSIC)
-                res = write(can_socket, &can_frames[i].cc, sizeof(struct can_frame));
-
-            if(res < 0)
-            {
-                perror("Failed to write to CAN bus");
-                continue;
-            }
+            can_tx_queue_write(&tx_queue, &can_frames[i]);
         }
     }
 
+    print_stats();
+    can_release_queue_close(&release_queue);
+    close(can_socket);
+    close(fd);
     return 0;
 
 err:
+    print_stats();
     close(fd);
     return 1;
 
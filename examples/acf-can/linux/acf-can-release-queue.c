@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include <linux/if_packet.h>
+
+#include "avtp/Utils.h"
+#include "common/common.h"
+#include "acf-can-release-queue.h"
+
+#define NSEC_PER_SEC                    1000000000ULL
+#define CAN_RELEASE_QUEUE_MASK          (CAN_RELEASE_QUEUE_SIZE - 1)
+
+static int get_time_ns(uint64_t* now)
+{
+    struct timespec tspec;
+
+    if (clock_gettime(CLOCK_REALTIME, &tspec) < 0) {
+        perror("Failed to get time");
+        return -1;
+    }
+
+    *now = (tspec.tv_sec * NSEC_PER_SEC) + tspec.tv_nsec;
+    return 0;
+}
+
+static int arm_release_timer(can_release_queue_t* queue)
+{
+    struct timespec tspec;
+    uint64_t ptime = queue->entries[queue->head].ptime;
+
+    tspec.tv_sec = ptime / NSEC_PER_SEC;
+    tspec.tv_nsec = ptime % NSEC_PER_SEC;
+
+    return arm_timer(queue->timer_fd, &tspec);
+}
+
+static void release_frame(can_release_queue_t* queue, frame_t* frame)
+{
+    can_tx_queue_write(queue->tx_queue, frame);
+    queue->released++;
+}
+
+static void release_head(can_release_queue_t* queue)
+{
+    can_release_entry_t* entry = &queue->entries[queue->head];
+
+    release_frame(queue, &entry->frame);
+    queue->head = (queue->head + 1) & CAN_RELEASE_QUEUE_MASK;
+    queue->count--;
+}
+
+static void insert_frame(can_release_queue_t* queue, frame_t* frame,
+                         uint64_t ptime)
+{
+    uint32_t pos = queue->count;
+
+    // Frames usually arrive in order, so search for the slot from the tail
+    while (pos > 0) {
+        can_release_entry_t* prev =
+            &queue->entries[(queue->head + pos - 1) & CAN_RELEASE_QUEUE_MASK];
+        if (prev->ptime <= ptime) {
+            break;
+        }
+        queue->entries[(queue->head + pos) & CAN_RELEASE_QUEUE_MASK] = *prev;
+        pos--;
+    }
+
+    can_release_entry_t* entry =
+        &queue->entries[(queue->head + pos) & CAN_RELEASE_QUEUE_MASK];
+    entry->ptime = ptime;
+    memcpy(&entry->frame, frame, get_can_frame_size(frame));
+    queue->count++;
+}
+
+int can_release_queue_init(can_release_queue_t* queue, can_tx_queue_t* tx_queue)
+{
+    memset(queue, 0, sizeof(*queue));
+    queue->tx_queue = tx_queue;
+
+    queue->timer_fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK);
+    if (queue->timer_fd < 0) {
+        perror("Failed to create timer");
+        return -1;
+    }
+
+    return 0;
+}
+
+void can_release_queue_close(can_release_queue_t* queue)
+{
+    close(queue->timer_fd);
+    queue->count = 0;
+}
+
+int can_release_queue_push(can_release_queue_t* queue, frame_t* frames,
+                           int num_frames, uint32_t avtp_time)
+{
+    uint64_t now, ptime, head_ptime;
+    uint32_t old_count = queue->count;
+    int i;
+
+    if (get_time_ns(&now) < 0) {
+        return -1;
+    }
+
+    ptime = Avtp_ExpandTimestamp(avtp_time, now);
+    if (ptime <= now) {
+        for (i = 0; i < num_frames; i++) {
+            release_frame(queue, &frames[i]);
+        }
+        queue->late += num_frames;
+        return 0;
+    }
+
+    head_ptime = queue->entries[queue->head].ptime;
+    for (i = 0; i < num_frames; i++) {
+        if (queue->count == CAN_RELEASE_QUEUE_SIZE) {
+            release_head(queue);
+            queue->overflows++;
+        }
+        insert_frame(queue, &frames[i], ptime);
+    }
+
+    // Only re-arm the timer if the earliest frame changed
+    if (!old_count || queue->entries[queue->head].ptime != head_ptime) {
+        return arm_release_timer(queue);
+    }
+
+    return 0;
+}
+
+int can_release_queue_timeout(can_release_queue_t* queue)
+{
+    uint64_t expirations, now;
+    ssize_t n;
+
+    n = read(queue->timer_fd, &expirations, sizeof(uint64_t));
+    if (n < 0 && errno != EAGAIN) {
+        perror("Failed to read timerfd");
+        return -1;
+    }
+
+    if (get_time_ns(&now) < 0) {
+        return -1;
+    }
+
+    while (queue->count && queue->entries[queue->head].ptime <= now) {
+        release_head(queue);
+    }
+
+    if (queue->count) {
+        return arm_release_timer(queue);
+    }
+
+    return 0;
+}
+
+void can_release_queue_print_stats(can_release_queue_t* queue)
+{
+    printf("CAN release statistics: released %"PRIu64", late %"PRIu64", overflows %"PRIu64"\n",
+            queue->released, queue->late, queue->overflows);
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "acf-can-common.h"
+#include "acf-can-tx-queue.h"
+
+/* Number of CAN frames that can be held back until their presentation
+ * time. Must be a power of 2.
+ */
+#define CAN_RELEASE_QUEUE_SIZE          256
+
+typedef struct {
+    uint64_t ptime;
+    frame_t frame;
+} can_release_entry_t;
+
+/* Time ordered ring of CAN frames waiting for their presentation time. All
+ * entries are preallocated; a single timerfd is armed for the head entry.
+ */
+typedef struct {
+    can_release_entry_t entries[CAN_RELEASE_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t count;
+    can_tx_queue_t* tx_queue;
+    int timer_fd;
+
+    /* Statistics */
+    uint64_t released;
+    uint64_t late;
+    uint64_t overflows;
+} can_release_queue_t;
+
+/* Initialize a release queue and create its timerfd.
+ * @queue: Queue to be initialized.
+ * @tx_queue: TX queue of the CAN socket the frames are released to.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Could not create timer.
+ */
+int can_release_queue_init(can_release_queue_t* queue, can_tx_queue_t* tx_queue);
+
+/* Close the timerfd of a release queue. Pending frames are discarded.
+ * @queue: Queue to be closed.
+ */
+void can_release_queue_close(can_release_queue_t* queue);
+
+/* Schedule CAN frames to be written to the TX queue at the presentation
+ * time. Frames whose presentation time already passed are written out
+ * immediately. If the queue is full, the earliest frame is written out
+ * ahead of its time to make room.
+ * @queue: Release queue.
+ * @frames: CAN frames to be scheduled.
+ * @num_frames: Number of frames.
+ * @avtp_time: 32-bit AVTP timestamp of the frames.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Could not get time or arm timer.
+ */
+int can_release_queue_push(can_release_queue_t* queue, frame_t* frames,
+                           int num_frames, uint32_t avtp_time);
+
+/* Write all frames whose presentation time has been reached to the TX queue
+ * and re-arm the timer for the next one. Should be called whenever the
+ * timerfd becomes readable.
+ * @queue: Release queue.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Could not read or arm timer.
+ */
+int can_release_queue_timeout(can_release_queue_t* queue);
+
+/* Print the statistics of a release queue to stdout. */
+void can_release_queue_print_stats(can_release_queue_t* queue);
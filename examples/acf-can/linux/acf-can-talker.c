@@ -47,6 +47,8 @@
 #define ARGPARSE_CAN_FD_OPTION      500
 #define ARGPARSE_CAN_IF_OPTION      501
 #define ARGPARSE_TALKER_ID_OPTION      502
+#define ARGPARSE_PRIO_THRESHOLD_OPTION  503
+#define ARGPARSE_PRIO_ID_OPTION         504
 
 static char ifname[IFNAMSIZ];
 static uint8_t macaddr[ETH_ALEN];
@@ -60,6 +62,7 @@ static uint8_t num_acf_msgs = 1;
 static char can_ifname[IFNAMSIZ];
 static uint64_t talker_stream_id = STREAM_ID;
 static char ip_addr_str[100];
+static can_prio_config_t prio_config;
 
 static char doc[] =
         "\nacf-can-talker -- a program to send CAN messages to a remote CAN bus over Ethernet using Open1722.\
@@ -79,6 +82,8 @@ static struct argp_option options[] = {
     {"dst-addr", 'd', "MACADDR", 0, "Stream destination MAC address (If Ethernet)"},
     {"dst-nw-addr", 'n', "NW_ADDR", 0, "Stream destination network address and port (If UDP)"},
     {"stream-id", ARGPARSE_TALKER_ID_OPTION, "STREAM_ID", 0, "Stream ID for talker stream"},
+    {"prio-threshold", ARGPARSE_PRIO_THRESHOLD_OPTION, "CAN_ID", 0, "Send CAN frames with an ID below CAN_ID (hex) immediately without aggregation"},
+    {"prio-id", ARGPARSE_PRIO_ID_OPTION, "CAN_ID", 0, "Send CAN frames with ID CAN_ID (hex) immediately without aggregation. Can be repeated."},
     { 0 }
 };
 
@@ -137,6 +142,25 @@ static error_t parser(int key, char *arg, struct argp_state *state)
             exit(EXIT_FAILURE);
         }
         break;
+    case ARGPARSE_PRIO_THRESHOLD_OPTION:
+        res = sscanf(arg, "%x", &prio_config.id_threshold);
+        if (res != 1) {
+            fprintf(stderr, "Invalid priority CAN ID threshold\n");
+            exit(EXIT_FAILURE);
+        }
+        break;
+    case ARGPARSE_PRIO_ID_OPTION:
+        if (prio_config.num_ids >= MAX_PRIO_CAN_IDS) {
+            fprintf(stderr, "Too many priority CAN IDs.\n");
+            exit(EXIT_FAILURE);
+        }
+        res = sscanf(arg, "%x", &prio_config.ids[prio_config.num_ids]);
+        if (res != 1) {
+            fprintf(stderr, "Invalid priority CAN ID\n");
+            exit(EXIT_FAILURE);
+        }
+        prio_config.num_ids++;
+        break;
     }
 
     return 0;
@@ -152,9 +176,6 @@ int main(int argc, char *argv[])
     struct sockaddr* dest_addr;
     uint8_t cf_seq_num = 0;
     uint32_t udp_seq_num = 0;
-
-    uint8_t pdu[MAX_ETH_PDU_SIZE];
-    uint16_t pdu_length = 0;
     frame_t can_frames[num_acf_msgs];
 
     argp_parse(&argp, argc, argv, 0, NULL, NULL);
@@ -178,6 +199,10 @@ int main(int argc, char *argv[])
     }
     printf("\tTalker Stream ID: 0x%lx\n", talker_stream_id);
     printf("\tNumber of ACF messages per AVTP frame in talker stream: %d\n", num_acf_msgs);
+    if (prio_config.id_threshold || prio_config.num_ids) {
+        printf("\tPriority CAN IDs: below 0x%x and %d additional IDs\n",
+                prio_config.id_threshold, prio_config.num_ids);
+    }
 
     // Create an appropriate talker socket: UDP or Ethernet raw
     // Setup the socket for sending to the destination
@@ -209,33 +234,24 @@ int main(int argc, char *argv[])
         while (i < num_acf_msgs) {
             // Get payload -- will 'spin' here until we get the requested number
             //                of CAN frames.
-            if(can_variant == AVTP_CAN_FD){
-                res = read(can_socket, &(can_frames[i].fd), sizeof(struct canfd_frame));
-            } else {
-                res = read(can_socket, &(can_frames[i].cc), sizeof(struct can_frame));
+            res = read_can_frame(can_socket, &can_frames[i]);
+            if (res < 0) {
+                continue;
             }
-            if (!res) {
-                perror("Error reading CAN frames");
+
+            // High priority frames are not held back by the aggregation
+            if (num_acf_msgs > 1 &&
+                is_prio_can_frame(&prio_config, &can_frames[i])) {
+                send_can_frames(fd, dest_addr, &can_frames[i], 1, use_udp, use_tscf,
+                                talker_stream_id, &cf_seq_num, &udp_seq_num);
                 continue;
             }
             i++;
         }
 
-        // Pack all the read frames into an AVTP frame
-        pdu_length = can_to_avtp(can_frames, can_variant, pdu, use_udp, use_tscf,
-                                    talker_stream_id, num_acf_msgs, cf_seq_num++, udp_seq_num++);
-
-        // Send the packed frame out
-        if (use_udp) {
-            res = sendto(fd, pdu, pdu_length, 0,
-                    (struct sockaddr *) dest_addr, sizeof(struct sockaddr_in));
-        } else {
-            res = sendto(fd, pdu, pdu_length, 0,
-                         (struct sockaddr *) dest_addr, sizeof(struct sockaddr_ll));
-        }
-        if (res < 0) {
-            perror("Failed to send data");
-        }
+        // Pack all the read frames into an AVTP frame and send it out
+        send_can_frames(fd, dest_addr, can_frames, num_acf_msgs, use_udp, use_tscf,
+                        talker_stream_id, &cf_seq_num, &udp_seq_num);
     }
 
 err:
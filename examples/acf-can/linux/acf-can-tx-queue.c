@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include "acf-can-tx-queue.h"
+
+#define CAN_TX_QUEUE_MASK               (CAN_TX_QUEUE_SIZE - 1)
+#define CAN_TX_ENTRY(queue, i)          (&(queue)->entries[((queue)->head + (i)) & CAN_TX_QUEUE_MASK])
+#define NSEC_PER_MSEC                   1000000ULL
+
+static uint64_t get_monotonic_ns(void)
+{
+    struct timespec tspec;
+
+    clock_gettime(CLOCK_MONOTONIC, &tspec);
+    return (uint64_t) tspec.tv_sec * 1000000000ULL + tspec.tv_nsec;
+}
+
+/* Returns 0 if the frame was consumed, 1 if the CAN controller is busy and
+ * -1 if the frame could not be written for any other reason.
+ */
+static int try_send(can_tx_queue_t* queue, frame_t* frame, size_t len)
+{
+    int res;
+
+    res = send(queue->can_socket, frame, len, MSG_DONTWAIT);
+    if (res >= 0) {
+        queue->sent++;
+        return 0;
+    }
+
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        // Socket buffer is full: wait until it can be written again
+        queue->wait_pollout = 1;
+        return 1;
+    } else if (errno == ENOBUFS) {
+        // TX queue of the controller is full: POLLOUT does not cover this
+        queue->wait_pollout = 0;
+        queue->retry_time = get_monotonic_ns() +
+                            CAN_TX_RETRY_INTERVAL_MS * NSEC_PER_MSEC;
+        return 1;
+    }
+
+    perror("Failed to write to CAN bus");
+    queue->errors++;
+    return -1;
+}
+
+static canid_t get_can_id(can_tx_entry_t* entry)
+{
+    // can_id is located at the same offset for CAN CC and FD frames
+    return entry->frame.cc.can_id & CAN_EFF_MASK;
+}
+
+static void remove_entry(can_tx_queue_t* queue, uint32_t pos)
+{
+    uint32_t i;
+
+    for (i = pos; i + 1 < queue->count; i++) {
+        *CAN_TX_ENTRY(queue, i) = *CAN_TX_ENTRY(queue, i + 1);
+    }
+    queue->count--;
+}
+
+static void enqueue(can_tx_queue_t* queue, frame_t* frame, size_t len)
+{
+    can_tx_entry_t* entry;
+    uint32_t i, victim;
+
+    if (queue->count == CAN_TX_QUEUE_SIZE) {
+        queue->dropped++;
+
+        switch (queue->policy) {
+        case CAN_TX_DROP_NEWEST:
+            return;
+        case CAN_TX_DROP_PRIORITY:
+            victim = 0;
+            for (i = 1; i < queue->count; i++) {
+                if (get_can_id(CAN_TX_ENTRY(queue, i)) >=
+                    get_can_id(CAN_TX_ENTRY(queue, victim))) {
+                    victim = i;
+                }
+            }
+            if ((frame->cc.can_id & CAN_EFF_MASK) >=
+                get_can_id(CAN_TX_ENTRY(queue, victim))) {
+                return;
+            }
+            remove_entry(queue, victim);
+            break;
+        case CAN_TX_DROP_OLDEST:
+        default:
+            queue->head = (queue->head + 1) & CAN_TX_QUEUE_MASK;
+            queue->count--;
+            break;
+        }
+    }
+
+    entry = CAN_TX_ENTRY(queue, queue->count);
+    entry->len = len;
+    memcpy(&entry->frame, frame, len);
+    queue->count++;
+    queue->queued++;
+}
+
+void can_tx_queue_init(can_tx_queue_t* queue, int can_socket,
+                       can_tx_drop_policy_t policy)
+{
+    memset(queue, 0, sizeof(*queue));
+    queue->can_socket = can_socket;
+    queue->policy = policy;
+}
+
+int can_tx_parse_drop_policy(const char* name, can_tx_drop_policy_t* policy)
+{
+    if (!strcmp(name, "oldest")) {
+        *policy = CAN_TX_DROP_OLDEST;
+    } else if (!strcmp(name, "newest")) {
+        *policy = CAN_TX_DROP_NEWEST;
+    } else if (!strcmp(name, "prio")) {
+        *policy = CAN_TX_DROP_PRIORITY;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+void can_tx_queue_write(can_tx_queue_t* queue, frame_t* frame)
+{
+    size_t len = get_can_frame_size(frame);
+
+    // Keep the order of frames: only bypass the queue if it is empty
+    if (!queue->count && try_send(queue, frame, len) <= 0) {
+        return;
+    }
+
+    enqueue(queue, frame, len);
+}
+
+void can_tx_queue_flush(can_tx_queue_t* queue)
+{
+    can_tx_entry_t* entry;
+
+    while (queue->count) {
+        entry = CAN_TX_ENTRY(queue, 0);
+        if (try_send(queue, &entry->frame, entry->len) > 0) {
+            break;
+        }
+        queue->head = (queue->head + 1) & CAN_TX_QUEUE_MASK;
+        queue->count--;
+    }
+}
+
+short can_tx_queue_poll_events(can_tx_queue_t* queue)
+{
+    return (queue->count && queue->wait_pollout) ? POLLOUT : 0;
+}
+
+int can_tx_queue_poll_timeout(can_tx_queue_t* queue)
+{
+    uint64_t now;
+
+    if (!queue->count || queue->wait_pollout) {
+        return -1;
+    }
+
+    now = get_monotonic_ns();
+    if (now >= queue->retry_time) {
+        return 0;
+    }
+
+    // Round up, so poll() does not return before the retry is due
+    return (queue->retry_time - now + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC;
+}
+
+int can_tx_queue_retry_due(can_tx_queue_t* queue)
+{
+    return queue->count && !queue->wait_pollout &&
+           get_monotonic_ns() >= queue->retry_time;
+}
+
+void can_tx_queue_print_stats(can_tx_queue_t* queue)
+{
+    printf("CAN TX statistics: sent %"PRIu64", queued %"PRIu64", dropped %"PRIu64", errors %"PRIu64"\n",
+            queue->sent, queue->queued, queue->dropped, queue->errors);
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "acf-can-common.h"
+
+/* Number of CAN frames that can wait for the CAN controller to accept them.
+ * Must be a power of 2.
+ */
+#define CAN_TX_QUEUE_SIZE               64
+
+/* Time to wait before retrying after the CAN controller ran out of buffers */
+#define CAN_TX_RETRY_INTERVAL_MS        1
+
+/* Frame to be dropped when the queue is full */
+typedef enum {
+    CAN_TX_DROP_OLDEST = 0,
+    CAN_TX_DROP_NEWEST,
+    CAN_TX_DROP_PRIORITY,       /* Frame with the highest CAN ID */
+} can_tx_drop_policy_t;
+
+typedef struct {
+    size_t len;
+    frame_t frame;
+} can_tx_entry_t;
+
+/* Bounded queue of CAN frames that could not be written to the CAN socket
+ * because the TX queue of the CAN controller was full.
+ */
+typedef struct {
+    can_tx_entry_t entries[CAN_TX_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t count;
+    int can_socket;
+    can_tx_drop_policy_t policy;
+    uint8_t wait_pollout;
+    uint64_t retry_time;        /* CLOCK_MONOTONIC ns of the next retry after ENOBUFS */
+
+    /* Statistics */
+    uint64_t sent;
+    uint64_t queued;
+    uint64_t dropped;
+    uint64_t errors;
+} can_tx_queue_t;
+
+/* Initialize a TX queue.
+ * @queue: Queue to be initialized.
+ * @can_socket: CAN socket the frames are written to.
+ * @policy: Frame to drop when the queue is full.
+ */
+void can_tx_queue_init(can_tx_queue_t* queue, int can_socket,
+                       can_tx_drop_policy_t policy);
+
+/* Parse the name of a drop policy.
+ * @name: "oldest", "newest" or "prio".
+ * @policy: Pointer to store the parsed policy.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Unknown policy name.
+ */
+int can_tx_parse_drop_policy(const char* name, can_tx_drop_policy_t* policy);
+
+/* Write a CAN frame to the CAN socket without blocking. If the CAN
+ * controller cannot take the frame, or older frames are still waiting,
+ * the frame is queued. A full queue drops a frame according to its policy.
+ * @queue: TX queue.
+ * @frame: CAN CC or CAN FD frame to be written.
+ */
+void can_tx_queue_write(can_tx_queue_t* queue, frame_t* frame);
+
+/* Write queued frames until the queue is empty or the CAN controller is
+ * busy again. Should be called on POLLOUT of the CAN socket or when
+ * can_tx_queue_retry_due() reports that the retry interval has passed.
+ * @queue: TX queue.
+ */
+void can_tx_queue_flush(can_tx_queue_t* queue);
+
+/* Poll events to be requested for the CAN socket. */
+short can_tx_queue_poll_events(can_tx_queue_t* queue);
+
+/* Poll timeout in ms until the next retry, -1 if no retry is pending. */
+int can_tx_queue_poll_timeout(can_tx_queue_t* queue);
+
+/* Check if queued frames should be retried because the retry interval after
+ * ENOBUFS has passed. Must be checked after every poll(), not only when it
+ * timed out, as other file descriptors may keep poll() from timing out.
+ * @queue: TX queue.
+ *
+ * Returns:
+ *    1: can_tx_queue_flush() should be called.
+ *    0: No retry is due.
+ */
+int can_tx_queue_retry_due(can_tx_queue_t* queue);
+
+/* Print the statistics of a TX queue to stdout. */
+void can_tx_queue_print_stats(can_tx_queue_t* queue);
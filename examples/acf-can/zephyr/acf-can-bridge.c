@@ -70,6 +70,9 @@ static uint8_t num_acf_msgs = CONFIG_ACF_CAN_BRIDGE_NUM_ACF_MSGS;
 static uint64_t listener_stream_id;
 static uint64_t talker_stream_id;
 static Avtp_CanVariant_t can_variant = AVTP_CAN_CLASSIC;
+static can_prio_config_t prio_config = {
+    .id_threshold = CONFIG_ACF_CAN_BRIDGE_PRIO_ID_THRESHOLD
+};
 
 int eth_socket = 0;
 struct sockaddr* dest_addr;
@@ -206,8 +209,6 @@ void can_to_avtp_runnable(void* p1, void* p2, void* p3) {
     uint8_t cf_seq_num = 0;
     uint32_t udp_seq_num = 0;
 
-    uint8_t pdu[MAX_ETH_PDU_SIZE];
-    uint16_t pdu_length = 0;
     frame_t can_frames[num_acf_msgs];
     int res;
     printf("Starting CAN-to-AVTP thread.\n");
@@ -250,24 +251,20 @@ void can_to_avtp_runnable(void* p1, void* p2, void* p3) {
                 printf("%d\n", res);
                 continue;
             }
+
+            // High priority frames are not held back by the aggregation
+            if (num_acf_msgs > 1 &&
+                is_prio_can_frame(&prio_config, &can_frames[i])) {
+                send_can_frames(eth_socket, dest_addr, &can_frames[i], 1, use_udp, use_tscf,
+                                talker_stream_id, &cf_seq_num, &udp_seq_num);
+                continue;
+            }
             i++;
         }
 
-        // Pack all the read frames into an AVTP frame
-        pdu_length = can_to_avtp(can_frames, can_variant, pdu, use_udp, use_tscf,
-                                    talker_stream_id, num_acf_msgs, cf_seq_num++, udp_seq_num++);
-
-        // Send the packed frame out over Ethernet
-        if (use_udp) {
-            res = sendto(eth_socket, pdu, pdu_length, 0,
-                    (struct sockaddr *) dest_addr, sizeof(struct sockaddr_in));
-        } else {
-            res = sendto(eth_socket, pdu, pdu_length, 0,
-                         (struct sockaddr *) dest_addr, sizeof(struct sockaddr_ll));
-        }
-        if (res < 0) {
-            perror("Failed to send data");
-        }
+        // Pack all the read frames into an AVTP frame and send it out over Ethernet
+        send_can_frames(eth_socket, dest_addr, can_frames, num_acf_msgs, use_udp, use_tscf,
+                        talker_stream_id, &cf_seq_num, &udp_seq_num);
     }
 
     return;
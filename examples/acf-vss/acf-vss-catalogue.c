@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "avtp/Byteorder.h"
+#include "acf-vss-catalogue.h"
+
+/* Must match catalogue_hash() in vss-catalogue-gen.py */
+static uint32_t catalogue_hash(const uint8_t* data, size_t len, uint32_t seed)
+{
+    uint32_t h = 0x811c9dc5u ^ seed;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 0x01000193u;
+    }
+
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint32_t catalogue_slot(const uint8_t* key, size_t len,
+                               const uint32_t* seeds, uint32_t num_buckets,
+                               uint32_t num_entries)
+{
+    uint32_t bucket = catalogue_hash(key, len, 0) % num_buckets;
+    return catalogue_hash(key, len, seeds[bucket]) % num_entries;
+}
+
+int32_t vss_catalogue_find_path(const vss_catalogue_t* catalogue,
+                                const char* path, uint16_t path_length)
+{
+    uint32_t entry;
+
+    if (!catalogue->num_entries) {
+        return -1;
+    }
+
+    entry = catalogue_slot((const uint8_t*) path, path_length,
+                           catalogue->path_seeds,
+                           catalogue->num_path_buckets,
+                           catalogue->num_entries);
+
+    // Paths not in the catalogue hash to an arbitrary entry
+    if (catalogue->path_lengths[entry] != path_length ||
+        memcmp(catalogue->paths[entry], path, path_length)) {
+        return -1;
+    }
+
+    return entry;
+}
+
+int32_t vss_catalogue_find_id(const vss_catalogue_t* catalogue, uint32_t static_id)
+{
+    uint32_t key = Avtp_CpuToBe32(static_id);
+    uint32_t slot, entry;
+
+    if (!catalogue->num_entries) {
+        return -1;
+    }
+
+    slot = catalogue_slot((const uint8_t*) &key, sizeof(key),
+                          catalogue->id_seeds,
+                          catalogue->num_id_buckets,
+                          catalogue->num_entries);
+    entry = catalogue->id_entries[slot];
+
+    if (catalogue->static_ids[entry] != static_id) {
+        return -1;
+    }
+
+    return entry;
+}
+
+int vss_catalogue_get_static_id(const vss_catalogue_t* catalogue,
+                                const char* path, uint16_t path_length,
+                                uint32_t* static_id)
+{
+    int32_t entry = vss_catalogue_find_path(catalogue, path, path_length);
+
+    if (entry < 0) {
+        return -1;
+    }
+
+    *static_id = catalogue->static_ids[entry];
+    return 0;
+}
+
+int vss_catalogue_get_path(const vss_catalogue_t* catalogue, uint32_t static_id,
+                           VssInteropPath_t* path)
+{
+    int32_t entry = vss_catalogue_find_id(catalogue, static_id);
+
+    if (entry < 0) {
+        return -1;
+    }
+
+    path->path = (char*) catalogue->paths[entry];
+    path->path_length = catalogue->path_lengths[entry];
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "avtp/acf/custom/Vss.h"
+
+/* VSS catalogue compiled by vss-catalogue-gen.py. Paths and static IDs are
+ * both resolved with a minimal perfect hash, i.e. with a single probe.
+ */
+typedef struct {
+    uint32_t num_entries;
+    uint32_t num_path_buckets;
+    uint32_t num_id_buckets;
+    const uint32_t* path_seeds;     /* Seed per bucket of the path hash */
+    const uint32_t* id_seeds;       /* Seed per bucket of the ID hash */
+    const char* const* paths;       /* Entries, ordered by path hash slot */
+    const uint16_t* path_lengths;
+    const uint32_t* static_ids;
+    const uint32_t* id_entries;     /* Entry per ID hash slot */
+} vss_catalogue_t;
+
+/* Catalogue generated at build time from VSS_CATALOGUE */
+extern const vss_catalogue_t vss_catalogue;
+
+/* Find the catalogue entry of a VSS path.
+ * @catalogue: Compiled catalogue.
+ * @path: VSS path, does not need to be NUL terminated.
+ * @path_length: Length of the path in bytes.
+ *
+ * Returns:
+ *    Index of the entry, or -1 if the path is not part of the catalogue.
+ */
+int32_t vss_catalogue_find_path(const vss_catalogue_t* catalogue,
+                                const char* path, uint16_t path_length);
+
+/* Find the catalogue entry of a static ID.
+ * @catalogue: Compiled catalogue.
+ * @static_id: Static ID.
+ *
+ * Returns:
+ *    Index of the entry, or -1 if the static ID is not part of the catalogue.
+ */
+int32_t vss_catalogue_find_id(const vss_catalogue_t* catalogue, uint32_t static_id);
+
+/* Look up the static ID of a VSS path.
+ * @catalogue: Compiled catalogue.
+ * @path: VSS path, does not need to be NUL terminated.
+ * @path_length: Length of the path in bytes.
+ * @static_id: Pointer to store the static ID.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: The path is not part of the catalogue.
+ */
+int vss_catalogue_get_static_id(const vss_catalogue_t* catalogue,
+                                const char* path, uint16_t path_length,
+                                uint32_t* static_id);
+
+/* Look up the VSS path of a static ID.
+ * @catalogue: Compiled catalogue.
+ * @static_id: Static ID.
+ * @path: Set to point at the path in the catalogue.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: The static ID is not part of the catalogue.
+ */
+int vss_catalogue_get_path(const vss_catalogue_t* catalogue, uint32_t static_id,
+                           VssInteropPath_t* path);
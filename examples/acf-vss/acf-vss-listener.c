@@ -36,6 +36,8 @@
 #include <string.h>
 #include <unistd.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "common/common.h"
 #include "avtp/Udp.h"
@@ -43,19 +45,31 @@
 #include "avtp/acf/Tscf.h"
 #include "avtp/acf/AcfCommon.h"
 #include "avtp/acf/custom/Vss.h"
+#include "avtp/acf/custom/VssBrief.h"
 #include "avtp/CommonHeader.h"
+#include "avtp/Utils.h"
+#include "acf-vss-catalogue.h"
+#include "acf-vss-signal-store.h"
 
 #define MAX_PDU_SIZE                1500
 #define MAX_MSG_SIZE                100
+#define NUM_DYNAMIC_SIGNALS         256
+#define NSEC_PER_SEC                1000000000ULL
+#define NSEC_PER_MSEC               1000000ULL
 
 static char ifname[IFNAMSIZ];
 static uint8_t macaddr[ETH_ALEN];
 static uint8_t use_udp;
 static uint32_t udp_port = 17220;
+static int snapshot_ms = 0;
+static uint8_t use_brief = 0;
+static vss_store_t store;
 
 static struct argp_option options[] = {
     {"port", 'p', "UDP_PORT", 0, "UDP Port to listen on if UDP enabled"},
     {"udp", 'u', 0, 0, "Use UDP"},
+    {"snapshot", 's', "MSEC", 0, "Print the last value of all catalogue signals every MSEC instead of each message"},
+    {"brief", 'b', 0, 0, "The stream carries VSS Brief messages"},
     {"dst-mac-address", 0, 0, OPTION_DOC, "Stream destination MAC address (If Ethernet)"},
     {"ifname", 0, 0, OPTION_DOC, "Network interface (If Ethernet)" },
     { 0 }
@@ -72,6 +86,12 @@ static error_t parser(int key, char *arg, struct argp_state *state)
     case 'u':
         use_udp = 1;
         break;
+    case 's':
+        snapshot_ms = atoi(arg);
+        break;
+    case 'b':
+        use_brief = 1;
+        break;
 
     case ARGP_KEY_NO_ARGS:
         break;
@@ -109,12 +129,156 @@ static char args_doc[] = "[ifname] dst-mac-address";
 
 static struct argp argp = { options, parser, args_doc, 0};
 
+// Print the contents of a parsed VSS message on the STDOUT. Path and data
+// are accessed through views into the received PDU.
+static void print_vss_msg(const Avtp_VssLayout_t* layout)
+{
+    VssPath_t path;
+    VssDataView_t view;
+
+    Avtp_VssLayout_GetVssPath(layout, &path);
+
+    if (layout->addr_mode == VSS_INTEROP_MODE) {
+        printf("VSS Path: %.*s, ", path.vss_interop_path.path_length,
+                path.vss_interop_path.path);
+    } else if (layout->addr_mode == VSS_STATIC_ID_MODE) {
+        VssInteropPath_t known_path;
+        // Static IDs of the compiled catalogue are resolved with one lookup
+        if (!vss_catalogue_get_path(&vss_catalogue, path.vss_static_id_path,
+                                    &known_path)) {
+            printf("VSS Path: %.*s (ID %u), ", known_path.path_length,
+                    known_path.path, path.vss_static_id_path);
+        } else {
+            printf("VSS Path: %u, ", path.vss_static_id_path);
+        }
+    }
+
+    Avtp_VssLayout_GetVssDataView(layout, &view);
+    if (view.datatype == VSS_FLOAT) {
+        uint32_t raw = (uint32_t) Avtp_Vss_GetViewElement(&view, 0);
+        float value;
+        memcpy(&value, &raw, sizeof(value));
+        printf("VSS Value: %f\n", value);
+    } else {
+        printf("VSS Datatype: 0x%x, %u element(s)\n", view.datatype, view.count);
+    }
+}
+
+// Extend a 32 bit AVTP timestamp to the 64 bit time closest to the local
+// clock. The talker derives both from CLOCK_REALTIME.
+static uint64_t extend_avtp_timestamp(uint32_t avtp_time)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return Avtp_ExpandTimestamp(avtp_time,
+                                (uint64_t)now.tv_sec * NSEC_PER_SEC + now.tv_nsec);
+}
+
+static void print_value(const vss_value_t* value)
+{
+    uint16_t val16;
+    uint32_t val32;
+    uint64_t val64;
+    float val_float;
+    double val_double;
+
+    switch (value->datatype) {
+    case VSS_UINT8:
+    case VSS_BOOL:
+        printf("%u", value->data[0]);
+        break;
+    case VSS_INT8:
+        printf("%d", (int8_t) value->data[0]);
+        break;
+    case VSS_UINT16:
+    case VSS_INT16:
+        memcpy(&val16, value->data, sizeof(val16));
+        printf("%d", value->datatype == VSS_INT16 ? (int16_t) val16 : (int) val16);
+        break;
+    case VSS_UINT32:
+    case VSS_INT32:
+        memcpy(&val32, value->data, sizeof(val32));
+        if (value->datatype == VSS_INT32) {
+            printf("%" PRId32, (int32_t) val32);
+        } else {
+            printf("%" PRIu32, val32);
+        }
+        break;
+    case VSS_UINT64:
+    case VSS_INT64:
+        memcpy(&val64, value->data, sizeof(val64));
+        if (value->datatype == VSS_INT64) {
+            printf("%" PRId64, (int64_t) val64);
+        } else {
+            printf("%" PRIu64, val64);
+        }
+        break;
+    case VSS_FLOAT:
+        memcpy(&val_float, value->data, sizeof(val_float));
+        printf("%f", val_float);
+        break;
+    case VSS_DOUBLE:
+        memcpy(&val_double, value->data, sizeof(val_double));
+        printf("%f", val_double);
+        break;
+    case VSS_STRING:
+        printf("%.*s%s", value->data_length, (const char*) value->data,
+               value->truncated ? "..." : "");
+        break;
+    default:
+        printf("<%u bytes of type 0x%x>", value->data_length, value->datatype);
+        break;
+    }
+}
+
+// Reader thread polling the signal store, independent of the receive loop
+static void* snapshot_thread(void* arg)
+{
+    const vss_catalogue_t* catalogue = store.catalogue;
+    struct timespec delay = {
+        .tv_sec = snapshot_ms / 1000,
+        .tv_nsec = (snapshot_ms % 1000) * NSEC_PER_MSEC
+    };
+    struct timespec now;
+    vss_value_t value;
+
+    (void) arg;
+
+    for (;;) {
+        nanosleep(&delay, NULL);
+        clock_gettime(CLOCK_REALTIME, &now);
+        uint64_t now_ns = (uint64_t)now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+
+        printf("--- Snapshot\n");
+        for (uint32_t i = 0; i < catalogue->num_entries; i++) {
+            if (vss_store_read_entry(&store, i, &value) < 0) {
+                continue;
+            }
+            printf("%s: ", catalogue->paths[i]);
+            print_value(&value);
+            // The message timestamp allows to detect stale values
+            if (value.mtv && now_ns >= value.msg_timestamp) {
+                printf(" (age %" PRIu64 " ms)",
+                       (uint64_t) ((now_ns - value.msg_timestamp) / NSEC_PER_MSEC));
+            }
+            printf("\n");
+        }
+        fflush(stdout);
+    }
+
+    return NULL;
+}
+
 int main(int argc, char *argv[])
 {
-    int sk_fd, res;
+    int sk_fd, res, res_parse;
     uint64_t proc_bytes = 0, msg_proc_bytes = 0;
     uint32_t udp_seq_num;
-    uint16_t msg_length, acf_msg_length;
+    uint16_t msg_length, acf_msg_length, acf_avail;
+    Avtp_VssLayout_t layout;
+    uint64_t stream_time = 0;
+    uint8_t stream_time_valid;
     uint8_t subtype, acf_type;
     uint64_t flag;
     uint8_t pdu[MAX_PDU_SIZE];
@@ -132,6 +296,21 @@ int main(int argc, char *argv[])
     if (sk_fd < 0)
         return 1;
 
+    if (vss_store_init(&store, &vss_catalogue, NUM_DYNAMIC_SIGNALS) < 0) {
+        fprintf(stderr, "Failed to create signal store\n");
+        goto err;
+    }
+
+    if (snapshot_ms > 0) {
+        pthread_t thread;
+        res = pthread_create(&thread, NULL, snapshot_thread, NULL);
+        if (res != 0) {
+            fprintf(stderr, "Failed to start snapshot thread\n");
+            goto err;
+        }
+        pthread_detach(thread);
+    }
+
     while (1) {
         proc_bytes = 0;
 
@@ -153,50 +332,68 @@ int main(int argc, char *argv[])
 
         // Check if the packet is a control format packet (i.e. NTSCF or TSCF)
         subtype = Avtp_CommonHeader_GetSubtype((Avtp_CommonHeader_t*)cf_pdu);
+        stream_time_valid = 0;
         if (subtype == AVTP_SUBTYPE_TSCF){
             proc_bytes += AVTP_TSCF_HEADER_LEN;
             msg_length = Avtp_Tscf_GetStreamDataLength((Avtp_Tscf_t*)cf_pdu);
+            if (Avtp_Tscf_GetField((Avtp_Tscf_t*)cf_pdu, AVTP_TSCF_FIELD_TV)) {
+                stream_time_valid = 1;
+                stream_time = extend_avtp_timestamp(
+                        Avtp_Tscf_GetField((Avtp_Tscf_t*)cf_pdu,
+                                           AVTP_TSCF_FIELD_AVTP_TIMESTAMP));
+            }
         } else {
             proc_bytes += AVTP_NTSCF_HEADER_LEN;
             msg_length = Avtp_Ntscf_GetNtscfDataLength((Avtp_Ntscf_t*)cf_pdu);
         }
 
-        // Check if the control packet payload is a ACF GPC.
-        acf_pdu = &pdu[proc_bytes];
-        acf_type = Avtp_AcfCommon_GetAcfMsgType((Avtp_AcfCommon_t*)acf_pdu);
-        if (acf_type != AVTP_ACF_TYPE_VSS) {
-            // Ignore further processing.
-            continue;
-        }
-
-        // Parse the VSS Packet and print contents on the STDOUT
-        Vss_AddrMode_t addrMode;
-        VssPath_t path;
-        addrMode = Avtp_Vss_GetAddrMode((Avtp_Vss_t*)acf_pdu);
-        Avtp_Vss_GetVssPath((Avtp_Vss_t*)acf_pdu, &path);
-
-        if (addrMode == VSS_INTEROP_MODE) {
-            char path_string[path.vss_interop_path.path_length+1];
-            memset(path_string, '\0', path.vss_interop_path.path_length+1);
-            memcpy(path_string, path.vss_interop_path.path, path.vss_interop_path.path_length);
-            printf("VSS Path: %s, ", path_string);
-        } else if (addrMode == VSS_STATIC_ID_MODE) {
-            printf("VSS Path: %d, ", path.vss_static_id_path);
-        }
-
-        VssData_t data;
-        Vss_Datatype_t dt = Avtp_Vss_GetDatatype((Avtp_Vss_t*)acf_pdu);
-        Avtp_Vss_GetVssData((Avtp_Vss_t*)acf_pdu, &data);
+        // A frame may carry several ACF messages, print all VSS messages
+        msg_proc_bytes = 0;
+        while (msg_proc_bytes < msg_length && proc_bytes + msg_proc_bytes < (uint64_t)res) {
+            acf_pdu = &pdu[proc_bytes + msg_proc_bytes];
+            acf_msg_length = Avtp_AcfCommon_GetAcfMsgLength((Avtp_AcfCommon_t*)acf_pdu) * 4;
+            if (acf_msg_length == 0) {
+                break;
+            }
 
-        if (dt == VSS_FLOAT) {
-            printf("VSS Value: %f\n", data.data_float);
+            acf_type = Avtp_AcfCommon_GetAcfMsgType((Avtp_AcfCommon_t*)acf_pdu);
+            if (acf_type == AVTP_ACF_TYPE_VSS) {
+                // Decode the header once and reject truncated messages
+                acf_avail = msg_length - msg_proc_bytes;
+                if (acf_avail > res - proc_bytes - msg_proc_bytes) {
+                    acf_avail = res - proc_bytes - msg_proc_bytes;
+                }
+                // VSS and VSS Brief share the ACF message type, the stream
+                // configuration tells which header the messages have
+                if (use_brief) {
+                    res_parse = Avtp_VssBrief_Parse((Avtp_VssBrief_t*)acf_pdu,
+                                                    acf_avail, &layout);
+                } else {
+                    res_parse = Avtp_Vss_Parse((Avtp_Vss_t*)acf_pdu, acf_avail,
+                                               &layout);
+                }
+                if (res_parse < 0) {
+                    fprintf(stderr, "Malformed VSS message\n");
+                    break;
+                }
+                // VSS Brief messages are timed by the AVTP timestamp
+                if (use_brief && layout.mtv) {
+                    layout.mtv = stream_time_valid;
+                    layout.msg_timestamp = stream_time;
+                }
+                vss_store_update(&store, &layout);
+                if (snapshot_ms <= 0) {
+                    print_vss_msg(&layout);
+                }
+            }
+            msg_proc_bytes += acf_msg_length;
         }
-
     }
 
     return 0;
 
 err:
+    vss_store_close(&store);
     close(sk_fd);
     return 1;
 
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "acf-vss-publish-policy.h"
+
+/* Returns 1 and the value as double for numeric scalar types */
+static int get_numeric_value(vss_update_t* update, double* value)
+{
+    VssData_t* data = &update->data;
+
+    switch (update->datatype) {
+    case VSS_UINT8:  *value = data->data_uint8; return 1;
+    case VSS_INT8:   *value = data->data_int8; return 1;
+    case VSS_UINT16: *value = data->data_uint16; return 1;
+    case VSS_INT16:  *value = data->data_int16; return 1;
+    case VSS_UINT32: *value = data->data_uint32; return 1;
+    case VSS_INT32:  *value = data->data_int32; return 1;
+    case VSS_UINT64: *value = (double) data->data_uint64; return 1;
+    case VSS_INT64:  *value = (double) data->data_int64; return 1;
+    case VSS_FLOAT:  *value = data->data_float; return 1;
+    case VSS_DOUBLE: *value = data->data_double; return 1;
+    default:
+        return 0;
+    }
+}
+
+static uint64_t hash_bytes(uint64_t h, const void* data, size_t len)
+{
+    const uint8_t* bytes = data;
+
+    // FNV-1a 64
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/* Hash of the raw value, used to detect changes of non-numeric types */
+static uint64_t hash_value(vss_update_t* update)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    VssData_t* data = &update->data;
+
+    h = hash_bytes(h, &update->datatype, sizeof(update->datatype));
+    if (update->datatype < VSS_STRING) {
+        return hash_bytes(h, data, Avtp_Vss_CalcVssDataLength(update->datatype, data));
+    }
+
+    // All string and array types share the layout of the length and data fields
+    h = hash_bytes(h, &data->data_uint8_array->data_length, sizeof(uint16_t));
+    return hash_bytes(h, data->data_uint8_array->data,
+                      data->data_uint8_array->data_length);
+}
+
+static int exceeds_deadband(vss_policy_t* policy, double value)
+{
+    double delta = fabs(value - policy->last_value);
+
+    if (policy->config.abs_deadband > 0 && delta <= policy->config.abs_deadband) {
+        return 0;
+    }
+    if (policy->config.rel_deadband > 0 &&
+        delta <= policy->config.rel_deadband * fabs(policy->last_value)) {
+        return 0;
+    }
+    return value != policy->last_value;
+}
+
+void vss_policy_init(vss_policy_t* policy, const vss_policy_config_t* config)
+{
+    memset(policy, 0, sizeof(*policy));
+    policy->config = *config;
+}
+
+int vss_policy_check(vss_policy_t* policy, vss_update_t* update, uint64_t now)
+{
+    uint64_t elapsed = now - policy->last_publish;
+    uint64_t hash = 0;
+    double value = 0;
+    int is_numeric, changed;
+
+    is_numeric = get_numeric_value(update, &value);
+    if (is_numeric) {
+        changed = exceeds_deadband(policy, value);
+    } else {
+        hash = hash_value(update);
+        changed = hash != policy->last_hash;
+    }
+
+    if (policy->published) {
+        int heartbeat = policy->config.max_interval_ns &&
+                        elapsed >= policy->config.max_interval_ns;
+        int rate_ok = elapsed >= policy->config.min_interval_ns;
+
+        if (!heartbeat) {
+            if (!changed && !policy->pending) {
+                return 0;
+            }
+            if (!rate_ok) {
+                // Publish the latest value once the interval has passed
+                policy->pending = 1;
+                return 0;
+            }
+        }
+    }
+
+    policy->published = 1;
+    policy->pending = 0;
+    policy->last_publish = now;
+    if (is_numeric) {
+        policy->last_value = value;
+    } else {
+        policy->last_hash = hash;
+    }
+    return 1;
+}
+
+uint64_t vss_policy_next_deadline(const vss_policy_t* policies, size_t num_policies)
+{
+    uint64_t deadline = UINT64_MAX;
+
+    for (size_t i = 0; i < num_policies; i++) {
+        const vss_policy_t* policy = &policies[i];
+
+        // The first update is published with the first sample
+        if (!policy->published) {
+            continue;
+        }
+        if (policy->pending &&
+            policy->last_publish + policy->config.min_interval_ns < deadline) {
+            deadline = policy->last_publish + policy->config.min_interval_ns;
+        }
+        if (policy->config.max_interval_ns &&
+            policy->last_publish + policy->config.max_interval_ns < deadline) {
+            deadline = policy->last_publish + policy->config.max_interval_ns;
+        }
+    }
+
+    return deadline;
+}
+
+int vss_policy_publish(vss_publisher_t* pub, vss_policy_t* policies,
+                       vss_update_t* updates, size_t num_updates, uint64_t now)
+{
+    int published = 0;
+
+    for (size_t i = 0; i < num_updates; i++) {
+        if (!vss_policy_check(&policies[i], &updates[i], now)) {
+            continue;
+        }
+        if (vss_publisher_add(pub, &updates[i]) < 0) {
+            return -1;
+        }
+        published++;
+    }
+
+    if (vss_publisher_flush(pub) < 0) {
+        return -1;
+    }
+
+    return published;
+}
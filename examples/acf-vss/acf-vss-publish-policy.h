@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "acf-vss-publisher.h"
+
+/* Publish policy of a single signal. A zero value disables the respective
+ * check.
+ */
+typedef struct {
+    double abs_deadband;        /* Minimum absolute change of numeric scalars */
+    double rel_deadband;        /* Minimum change relative to the last published value */
+    uint64_t min_interval_ns;   /* Minimum time between two publications */
+    uint64_t max_interval_ns;   /* Publish unchanged values at least this often */
+} vss_policy_config_t;
+
+/* State of the publish policy of a single signal */
+typedef struct {
+    vss_policy_config_t config;
+    uint8_t published;
+    uint8_t pending;            /* A change was held back by min_interval_ns */
+    uint64_t last_publish;
+    double last_value;          /* Last published value of numeric scalars */
+    uint64_t last_hash;         /* Last published value of other types */
+} vss_policy_t;
+
+/* Initialize the policy state of a signal.
+ * @policy: Policy state to be initialized.
+ * @config: Policy configuration.
+ */
+void vss_policy_init(vss_policy_t* policy, const vss_policy_config_t* config);
+
+/* Decide whether an update of a signal is published. The first update is
+ * always published. Afterwards an update is published if
+ *  - it changed by more than all configured deadbands (any change for
+ *    strings, arrays and when no deadband is configured) and at least
+ *    min_interval_ns passed since the last publication, or
+ *  - a change was held back earlier and min_interval_ns has now passed, or
+ *  - max_interval_ns passed since the last publication.
+ * The policy state is updated if the update is to be published.
+ * @policy: Policy state of the signal.
+ * @update: Candidate update.
+ * @now: Current time of CLOCK_MONOTONIC in ns.
+ *
+ * Returns:
+ *    1: Update should be published.
+ *    0: Update should be suppressed.
+ */
+int vss_policy_check(vss_policy_t* policy, vss_update_t* update, uint64_t now);
+
+/* Earliest time at which a signal has to be checked again without a new
+ * sample: when a held-back change may be published after min_interval_ns,
+ * or when max_interval_ns expires.
+ * @policies: Policy state per signal.
+ * @num_policies: Number of signals.
+ *
+ * Returns:
+ *    Time of CLOCK_MONOTONIC in ns, or UINT64_MAX if no check is due.
+ */
+uint64_t vss_policy_next_deadline(const vss_policy_t* policies, size_t num_policies);
+
+/* Pass qualifying updates of a batch to a publisher and flush it.
+ * @pub: Publisher.
+ * @policies: Policy state per update.
+ * @updates: Candidate updates.
+ * @num_updates: Number of updates.
+ * @now: Current time of CLOCK_MONOTONIC in ns.
+ *
+ * Returns:
+ *    Number of published updates, or -1 if publishing failed.
+ */
+int vss_policy_publish(vss_publisher_t* pub, vss_policy_t* policies,
+                       vss_update_t* updates, size_t num_updates, uint64_t now);
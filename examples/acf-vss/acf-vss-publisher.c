@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "avtp/Udp.h"
+#include "avtp/acf/Ntscf.h"
+#include "avtp/acf/Tscf.h"
+#include "avtp/acf/custom/VssBrief.h"
+#include "acf-vss-publisher.h"
+
+#define NSEC_PER_SEC            1000000000ULL
+#define NSEC_PER_MSEC           1000000ULL
+
+static uint64_t get_monotonic_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
+
+static uint16_t get_cf_offset(vss_publisher_t* pub)
+{
+    return pub->use_udp ? AVTP_UDP_HEADER_LEN : 0;
+}
+
+static uint16_t get_cf_header_len(vss_publisher_t* pub)
+{
+    return pub->use_tscf ? AVTP_TSCF_HEADER_LEN : AVTP_NTSCF_HEADER_LEN;
+}
+
+static void start_frame(vss_publisher_t* pub)
+{
+    uint8_t* cf_pdu = pub->pdu + get_cf_offset(pub);
+
+    if (pub->use_udp) {
+        Avtp_Udp_SetField((Avtp_Udp_t*) pub->pdu,
+                          AVTP_UDP_FIELD_ENCAPSULATION_SEQ_NO, pub->udp_seq_num++);
+    }
+
+    if (pub->use_tscf) {
+        Avtp_Tscf_t* tscf_pdu = (Avtp_Tscf_t*) cf_pdu;
+        memset(tscf_pdu, 0, AVTP_TSCF_HEADER_LEN);
+        Avtp_Tscf_Init(tscf_pdu);
+        Avtp_Tscf_SetField(tscf_pdu, AVTP_TSCF_FIELD_TU, 0U);
+        Avtp_Tscf_SetField(tscf_pdu, AVTP_TSCF_FIELD_SEQUENCE_NUM, pub->seq_num++);
+        Avtp_Tscf_SetField(tscf_pdu, AVTP_TSCF_FIELD_STREAM_ID, pub->stream_id);
+    } else {
+        Avtp_Ntscf_t* ntscf_pdu = (Avtp_Ntscf_t*) cf_pdu;
+        memset(ntscf_pdu, 0, AVTP_NTSCF_HEADER_LEN);
+        Avtp_Ntscf_Init(ntscf_pdu);
+        Avtp_Ntscf_SetField(ntscf_pdu, AVTP_NTSCF_FIELD_SEQUENCE_NUM, pub->seq_num++);
+        Avtp_Ntscf_SetField(ntscf_pdu, AVTP_NTSCF_FIELD_STREAM_ID, pub->stream_id);
+    }
+
+    pub->pdu_length = get_cf_offset(pub) + get_cf_header_len(pub);
+    pub->has_frame_time = 0;
+    pub->deadline = get_monotonic_time() + pub->max_delay_ns;
+}
+
+/* Decide whether the time of an update is carried precisely enough by the
+ * AVTP timestamp of the current frame
+ */
+static int fits_frame_time(vss_publisher_t* pub, vss_update_t* update)
+{
+    uint64_t diff;
+
+    if (!pub->use_brief || update->precision_ns == VSS_PRECISION_NONE ||
+        !pub->has_frame_time) {
+        return 1;
+    }
+
+    diff = update->msg_timestamp > pub->frame_time ?
+           update->msg_timestamp - pub->frame_time :
+           pub->frame_time - update->msg_timestamp;
+    return diff <= update->precision_ns;
+}
+
+static uint16_t calc_msg_length(vss_update_t* update, int brief)
+{
+    uint16_t path_length, data_length;
+
+    if (update->addr_mode == VSS_STATIC_ID_MODE) {
+        path_length = 4;
+    } else {
+        path_length = 2 + update->path.vss_interop_path.path_length;
+    }
+
+    data_length = Avtp_Vss_CalcVssDataLength(update->datatype, &update->data);
+    if (data_length == 0) {
+        return 0;
+    }
+
+    return (brief ? AVTP_VSS_BRIEF_HEADER_LEN : AVTP_VSS_FIXED_HEADER_LEN) +
+           path_length + data_length;
+}
+
+static void write_brief_msg(vss_publisher_t* pub, vss_update_t* update,
+                            uint16_t length)
+{
+    Avtp_VssBrief_t* vss_pdu = (Avtp_VssBrief_t*) (pub->pdu + pub->pdu_length);
+    int has_time = update->precision_ns != VSS_PRECISION_NONE;
+
+    // The message time is carried by the AVTP timestamp of the frame
+    if (has_time && !pub->has_frame_time) {
+        pub->has_frame_time = 1;
+        pub->frame_time = update->msg_timestamp;
+    }
+
+    Avtp_VssBrief_Init(vss_pdu);
+    Avtp_VssBrief_SetField(vss_pdu, AVTP_VSS_BRIEF_FIELD_MTV, has_time);
+    Avtp_VssBrief_SetField(vss_pdu, AVTP_VSS_BRIEF_FIELD_ADDR_MODE, update->addr_mode);
+    Avtp_VssBrief_SetField(vss_pdu, AVTP_VSS_BRIEF_FIELD_VSS_DATATYPE, update->datatype);
+    Avtp_VssBrief_SetField(vss_pdu, AVTP_VSS_BRIEF_FIELD_VSS_OP, update->op);
+    Avtp_VssBrief_SetVssPath(vss_pdu, &update->path);
+    Avtp_VssBrief_SetVssData(vss_pdu, &update->data);
+    Avtp_VssBrief_Pad(vss_pdu, length);
+
+    pub->pdu_length += Avtp_VssBrief_GetField(vss_pdu,
+                            AVTP_VSS_BRIEF_FIELD_ACF_MSG_LENGTH) * AVTP_QUADLET_SIZE;
+    pub->num_msgs++;
+}
+
+static void write_msg(vss_publisher_t* pub, vss_update_t* update, uint16_t length)
+{
+    Avtp_Vss_t* vss_pdu = (Avtp_Vss_t*) (pub->pdu + pub->pdu_length);
+
+    Avtp_Vss_Init(vss_pdu);
+    Avtp_Vss_SetField(vss_pdu, AVTP_VSS_FIELD_MSG_TIMESTAMP, update->msg_timestamp);
+    Avtp_Vss_SetField(vss_pdu, AVTP_VSS_FIELD_MTV, 1U);
+    Avtp_Vss_SetField(vss_pdu, AVTP_VSS_FIELD_ADDR_MODE, update->addr_mode);
+    Avtp_Vss_SetField(vss_pdu, AVTP_VSS_FIELD_VSS_DATATYPE, update->datatype);
+    Avtp_Vss_SetField(vss_pdu, AVTP_VSS_FIELD_VSS_OP, update->op);
+    Avtp_Vss_SetVssPath(vss_pdu, &update->path);
+    Avtp_Vss_SetVssData(vss_pdu, &update->data);
+    Avtp_Vss_Pad(vss_pdu, length);
+
+    pub->pdu_length += Avtp_Vss_GetAcfMsgLength(vss_pdu) * AVTP_QUADLET_SIZE;
+    pub->num_msgs++;
+}
+
+int vss_publisher_init(vss_publisher_t* pub, int fd,
+                       const struct sockaddr* dest_addr, socklen_t dest_addr_len,
+                       int use_udp, int use_tscf, uint64_t stream_id,
+                       uint16_t mtu, uint64_t max_delay_ns)
+{
+    memset(pub, 0, sizeof(*pub));
+    pub->fd = fd;
+    pub->dest_addr = dest_addr;
+    pub->dest_addr_len = dest_addr_len;
+    pub->use_udp = use_udp;
+    pub->use_tscf = use_tscf;
+    pub->stream_id = stream_id;
+    pub->mtu = mtu;
+    pub->max_delay_ns = max_delay_ns;
+
+    if (mtu > VSS_PUBLISHER_MAX_PDU_SIZE ||
+        mtu <= get_cf_offset(pub) + get_cf_header_len(pub) + AVTP_VSS_FIXED_HEADER_LEN) {
+        fprintf(stderr, "Invalid MTU %u\n", mtu);
+        return -1;
+    }
+
+    return 0;
+}
+
+void vss_publisher_set_catalogue(vss_publisher_t* pub,
+                                 const vss_catalogue_t* catalogue)
+{
+    pub->catalogue = catalogue;
+}
+
+void vss_publisher_set_brief(vss_publisher_t* pub, int use_brief)
+{
+    pub->use_brief = use_brief;
+}
+
+int vss_publisher_add(vss_publisher_t* pub, vss_update_t* update)
+{
+    vss_update_t static_update;
+    uint32_t static_id;
+
+    if (pub->catalogue && update->addr_mode == VSS_INTEROP_MODE &&
+        !vss_catalogue_get_static_id(pub->catalogue,
+                                     update->path.vss_interop_path.path,
+                                     update->path.vss_interop_path.path_length,
+                                     &static_id)) {
+        static_update = *update;
+        static_update.addr_mode = VSS_STATIC_ID_MODE;
+        static_update.path.vss_static_id_path = static_id;
+        update = &static_update;
+    }
+
+    uint16_t length = calc_msg_length(update, pub->use_brief);
+    uint16_t padded_length = (length + AVTP_QUADLET_SIZE - 1) & ~(AVTP_QUADLET_SIZE - 1);
+    uint16_t max_payload = pub->mtu - get_cf_offset(pub) - get_cf_header_len(pub);
+
+    // NTSCF frames have no AVTP timestamp to carry the time of VSS Brief
+    if (length == 0 || padded_length > max_payload ||
+        padded_length > VSS_PUBLISHER_MAX_MSG_SIZE ||
+        (pub->use_brief && !pub->use_tscf &&
+         update->precision_ns != VSS_PRECISION_NONE)) {
+        pub->dropped++;
+        return -1;
+    }
+
+    if (vss_publisher_check_deadline(pub) < 0) {
+        return -1;
+    }
+
+    if (pub->num_msgs && (pub->pdu_length + padded_length > pub->mtu ||
+                          !fits_frame_time(pub, update))) {
+        if (vss_publisher_flush(pub) < 0) {
+            return -1;
+        }
+    }
+
+    if (pub->num_msgs == 0) {
+        start_frame(pub);
+    }
+
+    if (pub->use_brief) {
+        write_brief_msg(pub, update, length);
+    } else {
+        write_msg(pub, update, length);
+    }
+    return 0;
+}
+
+int vss_publisher_publish(vss_publisher_t* pub, vss_update_t* updates,
+                          size_t num_updates)
+{
+    int res = 0;
+
+    for (size_t i = 0; i < num_updates; i++) {
+        if (vss_publisher_add(pub, &updates[i]) < 0) {
+            res = -1;
+        }
+    }
+
+    if (vss_publisher_flush(pub) < 0) {
+        res = -1;
+    }
+
+    return res;
+}
+
+int vss_publisher_flush(vss_publisher_t* pub)
+{
+    uint8_t* cf_pdu = pub->pdu + get_cf_offset(pub);
+    uint64_t payload_len = pub->pdu_length - get_cf_offset(pub) - get_cf_header_len(pub);
+    int res;
+
+    if (pub->num_msgs == 0) {
+        return 0;
+    }
+
+    if (pub->use_tscf) {
+        Avtp_Tscf_SetField((Avtp_Tscf_t*) cf_pdu,
+                           AVTP_TSCF_FIELD_STREAM_DATA_LENGTH, payload_len);
+        Avtp_Tscf_SetField((Avtp_Tscf_t*) cf_pdu,
+                           AVTP_TSCF_FIELD_TV, pub->has_frame_time);
+        Avtp_Tscf_SetField((Avtp_Tscf_t*) cf_pdu,
+                           AVTP_TSCF_FIELD_AVTP_TIMESTAMP,
+                           pub->has_frame_time ? (uint32_t) pub->frame_time : 0);
+    } else {
+        Avtp_Ntscf_SetField((Avtp_Ntscf_t*) cf_pdu,
+                            AVTP_NTSCF_FIELD_NTSCF_DATA_LENGTH, payload_len);
+    }
+
+    res = sendto(pub->fd, pub->pdu, pub->pdu_length, 0,
+                 pub->dest_addr, pub->dest_addr_len);
+    if (res < 0) {
+        perror("Failed to send data");
+        pub->dropped += pub->num_msgs;
+    } else {
+        pub->frames_sent++;
+        pub->msgs_sent += pub->num_msgs;
+    }
+
+    pub->num_msgs = 0;
+    pub->pdu_length = 0;
+
+    return res < 0 ? -1 : 0;
+}
+
+int vss_publisher_check_deadline(vss_publisher_t* pub)
+{
+    if (pub->num_msgs && get_monotonic_time() >= pub->deadline) {
+        return vss_publisher_flush(pub);
+    }
+    return 0;
+}
+
+int vss_publisher_poll_timeout(vss_publisher_t* pub)
+{
+    uint64_t now;
+
+    if (pub->num_msgs == 0) {
+        return -1;
+    }
+
+    now = get_monotonic_time();
+    if (now >= pub->deadline) {
+        return 0;
+    }
+
+    // Round up so the deadline has passed when poll() returns
+    return (pub->deadline - now + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC;
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include "avtp/acf/custom/Vss.h"
+#include "acf-vss-catalogue.h"
+
+/* Largest NTSCF/TSCF frame (including the UDP encapsulation header) the
+ * publisher can build.
+ */
+#define VSS_PUBLISHER_MAX_PDU_SIZE      1500
+
+/* Largest ACF message: the ACF message length field counts 9 bits of quadlets */
+#define VSS_PUBLISHER_MAX_MSG_SIZE      (511 * AVTP_QUADLET_SIZE)
+
+/* Precision of the message time a receiver needs for a signal update.
+ * Any other value is the tolerated error in ns.
+ */
+#define VSS_PRECISION_EXACT     0ULL            /* Always send msg_timestamp */
+#define VSS_PRECISION_NONE      UINT64_MAX      /* No message time needed */
+
+/* A single signal update to be published */
+typedef struct {
+    Vss_AddrMode_t addr_mode;
+    Vss_OpCode_t op;
+    Vss_Datatype_t datatype;
+    VssPath_t path;
+    VssData_t data;
+    uint64_t msg_timestamp;
+    uint64_t precision_ns;
+} vss_update_t;
+
+/* Packs VSS messages into NTSCF/TSCF frames. A frame is sent when the next
+ * message does not fit into the MTU anymore, when the oldest message in the
+ * frame has waited max_delay_ns or when the frame is flushed explicitly.
+ *
+ * A stream carries either VSS or VSS Brief messages, which omit the 8 byte
+ * msg_timestamp. Both use the same ACF message type, so the listener has to
+ * be configured for the same format. On TSCF streams, the first VSS Brief
+ * message with a time sets the AVTP timestamp of the frame; a message whose
+ * msg_timestamp is not within precision_ns of it starts a new frame.
+ */
+typedef struct {
+    int fd;
+    const struct sockaddr* dest_addr;
+    socklen_t dest_addr_len;
+    uint8_t use_udp;
+    uint8_t use_tscf;
+    uint64_t stream_id;
+    uint16_t mtu;
+    uint64_t max_delay_ns;
+    const vss_catalogue_t* catalogue;
+    uint8_t use_brief;
+
+    uint8_t pdu[VSS_PUBLISHER_MAX_PDU_SIZE];
+    uint16_t pdu_length;
+    uint16_t num_msgs;
+    uint64_t deadline;
+    uint8_t has_frame_time;
+    uint64_t frame_time;
+    uint8_t seq_num;
+    uint32_t udp_seq_num;
+
+    /* Statistics */
+    uint64_t frames_sent;
+    uint64_t msgs_sent;
+    uint64_t dropped;
+} vss_publisher_t;
+
+/* Initialize a publisher.
+ * @pub: Publisher to be initialized.
+ * @fd: Talker socket used for sending.
+ * @dest_addr: Destination address passed to sendto(). Must stay valid.
+ * @dest_addr_len: Size of dest_addr.
+ * @use_udp: Prepend the UDP encapsulation header.
+ * @use_tscf: Use TSCF instead of NTSCF.
+ * @stream_id: Stream ID of the frames.
+ * @mtu: Maximum size of a frame in bytes, at most VSS_PUBLISHER_MAX_PDU_SIZE.
+ * @max_delay_ns: Longest time a message may wait for more messages.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Invalid MTU.
+ */
+int vss_publisher_init(vss_publisher_t* pub, int fd,
+                       const struct sockaddr* dest_addr, socklen_t dest_addr_len,
+                       int use_udp, int use_tscf, uint64_t stream_id,
+                       uint16_t mtu, uint64_t max_delay_ns);
+
+/* Send signals found in a VSS catalogue in static ID mode. Interop mode
+ * updates for paths not in the catalogue are sent unchanged.
+ * @pub: Publisher.
+ * @catalogue: Compiled catalogue, NULL to send all paths as given.
+ */
+void vss_publisher_set_catalogue(vss_publisher_t* pub,
+                                 const vss_catalogue_t* catalogue);
+
+/* Send VSS Brief instead of VSS messages. Must be called before the first
+ * update is added. On NTSCF streams, VSS Brief messages carry no time, so
+ * only updates with VSS_PRECISION_NONE are accepted.
+ * @pub: Publisher.
+ * @use_brief: 1 for VSS Brief, 0 for VSS messages.
+ */
+void vss_publisher_set_brief(vss_publisher_t* pub, int use_brief);
+
+/* Append a VSS message to the current frame. The frame is sent first if the
+ * message does not fit anymore or its deadline has passed.
+ * @pub: Publisher.
+ * @update: Signal update to be serialized.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: The message can never fit into a frame or sending failed.
+ */
+int vss_publisher_add(vss_publisher_t* pub, vss_update_t* update);
+
+/* Append a batch of updates and send all pending messages.
+ * @pub: Publisher.
+ * @updates: Signal updates to be serialized.
+ * @num_updates: Number of updates.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: At least one update was dropped or sending failed.
+ */
+int vss_publisher_publish(vss_publisher_t* pub, vss_update_t* updates,
+                          size_t num_updates);
+
+/* Send the current frame if it contains any messages.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Sending failed.
+ */
+int vss_publisher_flush(vss_publisher_t* pub);
+
+/* Send the current frame if its deadline has passed. To be called when the
+ * timeout from vss_publisher_poll_timeout() expired.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Sending failed.
+ */
+int vss_publisher_check_deadline(vss_publisher_t* pub);
+
+/* Time in ms until the current frame must be sent, -1 if it is empty. */
+int vss_publisher_poll_timeout(vss_publisher_t* pub);
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "avtp/Byteorder.h"
+#include "common/seqlock.h"
+#include "acf-vss-signal-store.h"
+
+static uint32_t hash_key(uint8_t addr_mode, const char* key, uint16_t key_length)
+{
+    // FNV-1a over addressing mode and key
+    uint32_t h = 0x811c9dc5u;
+
+    h = (h ^ addr_mode) * 0x01000193u;
+    for (uint16_t i = 0; i < key_length; i++) {
+        h = (h ^ (uint8_t) key[i]) * 0x01000193u;
+    }
+    return h;
+}
+
+/* Find the slot of a signal outside the catalogue. If insert is set, the
+ * receive thread claims a free slot for a new signal.
+ */
+static vss_slot_t* find_dynamic_slot(vss_store_t* store, uint8_t addr_mode,
+                                     const char* key, uint16_t key_length,
+                                     int insert)
+{
+    uint32_t mask = store->num_dynamic_slots - 1;
+    uint32_t pos;
+
+    if (store->num_dynamic_slots == 0 || key_length > VSS_STORE_MAX_PATH_LEN) {
+        return NULL;
+    }
+
+    pos = hash_key(addr_mode, key, key_length) & mask;
+    for (uint32_t i = 0; i < store->num_dynamic_slots; i++) {
+        vss_dynamic_slot_t* dyn = &store->dynamic_slots[(pos + i) & mask];
+
+        if (!__atomic_load_n(&dyn->used, __ATOMIC_ACQUIRE)) {
+            if (!insert) {
+                return NULL;
+            }
+            // Publish the key before readers can see the slot in use
+            dyn->addr_mode = addr_mode;
+            dyn->key_length = key_length;
+            memcpy(dyn->key, key, key_length);
+            __atomic_store_n(&dyn->used, 1, __ATOMIC_RELEASE);
+            return &dyn->slot;
+        }
+
+        if (dyn->addr_mode == addr_mode && dyn->key_length == key_length &&
+            !memcmp(dyn->key, key, key_length)) {
+            return &dyn->slot;
+        }
+    }
+
+    return NULL;
+}
+
+static vss_slot_t* find_slot_by_id(vss_store_t* store, uint32_t static_id, int insert)
+{
+    uint32_t key = Avtp_CpuToBe32(static_id);
+    int32_t entry = -1;
+
+    if (store->catalogue) {
+        entry = vss_catalogue_find_id(store->catalogue, static_id);
+    }
+    if (entry >= 0) {
+        return &store->slots[entry];
+    }
+
+    return find_dynamic_slot(store, VSS_STATIC_ID_MODE, (const char*) &key,
+                             sizeof(key), insert);
+}
+
+static vss_slot_t* find_slot_by_path(vss_store_t* store, const char* path,
+                                     uint16_t path_length, int insert)
+{
+    int32_t entry = -1;
+
+    if (store->catalogue) {
+        entry = vss_catalogue_find_path(store->catalogue, path, path_length);
+    }
+    if (entry >= 0) {
+        return &store->slots[entry];
+    }
+
+    return find_dynamic_slot(store, VSS_INTEROP_MODE, path, path_length, insert);
+}
+
+static void write_slot(vss_slot_t* slot, const vss_value_t* value)
+{
+    // Only the receive thread writes
+    seqlock_write(&slot->seq, &slot->value, value, sizeof(*value));
+}
+
+static int read_slot(vss_slot_t* slot, vss_value_t* value)
+{
+    if (slot == NULL) {
+        return -1;
+    }
+
+    return seqlock_read(&slot->seq, value, &slot->value, sizeof(*value));
+}
+
+int vss_store_init(vss_store_t* store, const vss_catalogue_t* catalogue,
+                   uint32_t num_dynamic_slots)
+{
+    uint32_t num_slots = catalogue ? catalogue->num_entries : 0;
+
+    memset(store, 0, sizeof(*store));
+
+    if (num_dynamic_slots & (num_dynamic_slots - 1)) {
+        return -1;
+    }
+
+    store->catalogue = catalogue;
+    store->num_dynamic_slots = num_dynamic_slots;
+    store->slots = calloc(num_slots ? num_slots : 1, sizeof(vss_slot_t));
+    store->dynamic_slots = calloc(num_dynamic_slots ? num_dynamic_slots : 1,
+                                  sizeof(vss_dynamic_slot_t));
+    if (store->slots == NULL || store->dynamic_slots == NULL) {
+        vss_store_close(store);
+        return -1;
+    }
+
+    return 0;
+}
+
+void vss_store_close(vss_store_t* store)
+{
+    free(store->slots);
+    free(store->dynamic_slots);
+    store->slots = NULL;
+    store->dynamic_slots = NULL;
+}
+
+int vss_store_update(vss_store_t* store, const Avtp_VssLayout_t* layout)
+{
+    VssPath_t path;
+    VssDataView_t view;
+    vss_value_t value;
+    vss_slot_t* slot;
+    uint16_t copied;
+
+    Avtp_VssLayout_GetVssDataView(layout, &view);
+    Avtp_VssLayout_GetVssPath(layout, &path);
+    if (layout->addr_mode == VSS_STATIC_ID_MODE) {
+        slot = find_slot_by_id(store, path.vss_static_id_path, 1);
+    } else {
+        slot = find_slot_by_path(store, path.vss_interop_path.path,
+                                 path.vss_interop_path.path_length, 1);
+    }
+    if (slot == NULL) {
+        store->dropped++;
+        return -1;
+    }
+
+    // Decode outside of the slot to keep the write window short
+    value.datatype = view.datatype;
+    value.mtv = layout->mtv;
+    value.msg_timestamp = layout->msg_timestamp;
+    copied = Avtp_Vss_CopyViewData(&view, value.data,
+                                   VSS_STORE_MAX_VALUE_SIZE / view.element_size);
+    if (view.datatype == VSS_STRING_ARRAY) {
+        value.data_length = copied;
+        value.truncated = copied < view.data_length;
+    } else {
+        value.data_length = copied * view.element_size;
+        value.truncated = copied < view.count;
+    }
+
+    write_slot(slot, &value);
+    store->updates++;
+    return 0;
+}
+
+int vss_store_read_id(vss_store_t* store, uint32_t static_id, vss_value_t* value)
+{
+    return read_slot(find_slot_by_id(store, static_id, 0), value);
+}
+
+int vss_store_read_path(vss_store_t* store, const char* path,
+                        uint16_t path_length, vss_value_t* value)
+{
+    return read_slot(find_slot_by_path(store, path, path_length, 0), value);
+}
+
+int vss_store_read_entry(vss_store_t* store, uint32_t entry, vss_value_t* value)
+{
+    if (store->catalogue == NULL || entry >= store->catalogue->num_entries) {
+        return -1;
+    }
+    return read_slot(&store->slots[entry], value);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "avtp/acf/custom/Vss.h"
+#include "acf-vss-catalogue.h"
+
+/* Largest value (in bytes) a slot can hold. Longer strings and arrays are
+ * truncated.
+ */
+#define VSS_STORE_MAX_VALUE_SIZE        64
+
+/* Longest interop path of signals that are not part of the catalogue */
+#define VSS_STORE_MAX_PATH_LEN          128
+
+/* Copy of the last received value of a signal */
+typedef struct {
+    Vss_Datatype_t datatype;
+    uint16_t data_length;       /* Length of data in bytes */
+    uint8_t truncated;
+    uint8_t mtv;                /* msg_timestamp is valid */
+    uint64_t msg_timestamp;
+    uint8_t data[VSS_STORE_MAX_VALUE_SIZE];     /* Host byte-order */
+} vss_value_t;
+
+/* Value slot protected by a seqlock. The sequence number is odd while the
+ * receive thread updates the slot; readers retry if it changed while they
+ * copied the value.
+ */
+typedef struct {
+    uint32_t seq;
+    vss_value_t value;
+} vss_slot_t;
+
+/* Slot of a signal that is not part of the catalogue, keyed by its interop
+ * path or static ID.
+ */
+typedef struct {
+    uint32_t used;
+    uint8_t addr_mode;
+    uint16_t key_length;
+    char key[VSS_STORE_MAX_PATH_LEN];
+    vss_slot_t slot;
+} vss_dynamic_slot_t;
+
+/* Last-value cache of VSS signals. Signals of the catalogue are stored in a
+ * dense array indexed by their catalogue entry. Other signals are stored in
+ * a fixed-size hash table. There must be a single writer; any number of
+ * threads may read concurrently.
+ */
+typedef struct {
+    const vss_catalogue_t* catalogue;
+    vss_slot_t* slots;
+    vss_dynamic_slot_t* dynamic_slots;
+    uint32_t num_dynamic_slots;
+
+    /* Statistics */
+    uint64_t updates;
+    uint64_t dropped;
+} vss_store_t;
+
+/* Initialize a signal store.
+ * @store: Store to be initialized.
+ * @catalogue: Compiled catalogue, may be NULL.
+ * @num_dynamic_slots: Capacity for signals outside the catalogue. Must be a
+ * power of 2 or 0.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Invalid capacity or out of memory.
+ */
+int vss_store_init(vss_store_t* store, const vss_catalogue_t* catalogue,
+                   uint32_t num_dynamic_slots);
+
+/* Free the memory of a signal store. */
+void vss_store_close(vss_store_t* store);
+
+/* Store the value of a received VSS message. Must only be called from a
+ * single thread.
+ * @store: Signal store.
+ * @layout: ACF VSS message parsed with Avtp_Vss_Parse.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: No slot left for a signal outside the catalogue.
+ */
+int vss_store_update(vss_store_t* store, const Avtp_VssLayout_t* layout);
+
+/* Read the last value of a signal by static ID.
+ * @store: Signal store.
+ * @static_id: Static ID of the signal.
+ * @value: Pointer to store a copy of the value.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: The signal has not been received yet.
+ */
+int vss_store_read_id(vss_store_t* store, uint32_t static_id, vss_value_t* value);
+
+/* Read the last value of a signal by its interop path. Signals of the
+ * catalogue are found regardless of the addressing mode they were sent in.
+ * @store: Signal store.
+ * @path: VSS path, does not need to be NUL terminated.
+ * @path_length: Length of the path in bytes.
+ * @value: Pointer to store a copy of the value.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: The signal has not been received yet.
+ */
+int vss_store_read_path(vss_store_t* store, const char* path,
+                        uint16_t path_length, vss_value_t* value);
+
+/* Read the last value of a catalogue entry. Allows readers to iterate over
+ * all signals of the catalogue.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: The signal has not been received yet.
+ */
+int vss_store_read_entry(vss_store_t* store, uint32_t entry, vss_value_t* value);
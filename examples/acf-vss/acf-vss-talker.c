@@ -42,24 +42,35 @@
 #include <time.h>
 
 #include "common/common.h"
-#include "avtp/Udp.h"
-#include "avtp/acf/Ntscf.h"
-#include "avtp/acf/Tscf.h"
-#include "avtp/CommonHeader.h"
 #include "avtp/acf/custom/Vss.h"
+#include "acf-vss-publisher.h"
+#include "acf-vss-publish-policy.h"
 
 #define MAX_PDU_SIZE                1500
+#define UDP_IP_HEADER_LEN           28
 #define STREAM_ID                   0xAABBCCDDEEFF0001
+#define MAX_SIGNALS                 1024
+#define MAX_PATH_LEN                64
+#define NSEC_PER_MSEC               1000000ULL
+#define NSEC_PER_SEC                1000000000ULL
+#define NSEC_PER_USEC               1000ULL
+#define MAX_SPEED                   250.0
 
 static char ifname[IFNAMSIZ];
 static uint8_t macaddr[ETH_ALEN];
 static uint8_t ip_addr[sizeof(struct in_addr)];
 static uint32_t udp_port=17220;
 static int priority = -1;
-static uint8_t seq_num = 0;
-static uint32_t udp_seq_num = 0;
 static uint8_t use_tscf = 0;
 static uint8_t use_udp = 0;
+static int num_signals = 1;
+static int max_delay_ms = 1;
+static uint8_t use_static_id = 0;
+static int period_ms = 1000;
+static uint8_t use_policy = 0;
+static vss_policy_config_t policy_config;
+static uint8_t use_brief = 0;
+static uint64_t precision_ns = VSS_PRECISION_EXACT;
 static char VSS_PATH[] = "Vehicle.Speed";
 
 static char doc[] = "\nacf-vss-talker -- a program designed to send VSS messages in \
@@ -75,6 +86,16 @@ static char args_doc[] = "[ifname] dst-mac-address/dst-nw-address:port";
 static struct argp_option options[] = {
     {"tscf", 't', 0, 0, "Use TSCF"},
     {"udp", 'u', 0, 0, "Use UDP" },
+    {"signals", 's', "NUM", 0, "Number of VSS signals sent per cycle (default 1)"},
+    {"max-delay", 'd', "MSEC", 0, "Longest time a VSS message waits to be packed with others (default 1)"},
+    {"static-id", 'i', 0, 0, "Send signals of the VSS catalogue in static ID mode"},
+    {"period", 'P', "MSEC", 0, "Interval at which signal values are sampled (default 1000)"},
+    {"deadband", 501, "VALUE", 0, "Only publish changes larger than VALUE"},
+    {"rel-deadband", 502, "FRACTION", 0, "Only publish changes larger than FRACTION of the last published value"},
+    {"min-interval", 503, "MSEC", 0, "Publish a signal at most every MSEC"},
+    {"max-interval", 504, "MSEC", 0, "Publish unchanged signals at least every MSEC"},
+    {"brief", 'b', 0, 0, "Send VSS Brief messages, timed by the AVTP timestamp of TSCF frames"},
+    {"precision", 505, "USEC|none", 0, "Tolerated error of the message time with --brief. A new TSCF frame is started for messages not within USEC of its AVTP timestamp (default 0)"},
     {"ifname", 0, 0, OPTION_DOC, "Network interface (If Ethernet)"},
     {"dst-mac-address", 0, 0, OPTION_DOC, "Stream destination MAC address (If Ethernet)"},
     {"dst-nw-address:port", 0, 0, OPTION_DOC, "Stream destination network address and port (If UDP)"},
@@ -93,6 +114,48 @@ static error_t parser(int key, char *arg, struct argp_state *state)
     case 'u':
         use_udp = 1;
         break;
+    case 's':
+        num_signals = atoi(arg);
+        if (num_signals < 1 || num_signals > MAX_SIGNALS) {
+            fprintf(stderr, "Number of signals must be between 1 and %d\n\n", MAX_SIGNALS);
+            argp_usage(state);
+        }
+        break;
+    case 'd':
+        max_delay_ms = atoi(arg);
+        break;
+    case 'i':
+        use_static_id = 1;
+        break;
+    case 'b':
+        use_brief = 1;
+        break;
+    case 'P':
+        period_ms = atoi(arg);
+        break;
+    case 501:
+        policy_config.abs_deadband = atof(arg);
+        use_policy = 1;
+        break;
+    case 502:
+        policy_config.rel_deadband = atof(arg);
+        use_policy = 1;
+        break;
+    case 503:
+        policy_config.min_interval_ns = atoll(arg) * NSEC_PER_MSEC;
+        use_policy = 1;
+        break;
+    case 504:
+        policy_config.max_interval_ns = atoll(arg) * NSEC_PER_MSEC;
+        use_policy = 1;
+        break;
+    case 505:
+        if (!strcmp(arg, "none")) {
+            precision_ns = VSS_PRECISION_NONE;
+        } else {
+            precision_ns = atoll(arg) * NSEC_PER_USEC;
+        }
+        break;
     case ARGP_KEY_NO_ARGS:
         argp_usage(state);
 
@@ -139,85 +202,35 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 
 static struct argp argp = { options, parser, args_doc, doc };
 
-static int init_cf_pdu(uint8_t* pdu)
+static uint64_t get_monotonic_ns(void)
 {
-    int res;
-    if (use_tscf) {
-        Avtp_Tscf_t* tscf_pdu = (Avtp_Tscf_t*) pdu;
-        memset(tscf_pdu, 0, AVTP_TSCF_HEADER_LEN);
-        Avtp_Tscf_Init(tscf_pdu);
-        Avtp_Tscf_SetField(tscf_pdu, AVTP_TSCF_FIELD_TU, 0U);
-        Avtp_Tscf_SetField(tscf_pdu, AVTP_TSCF_FIELD_SEQUENCE_NUM, seq_num++);
-        Avtp_Tscf_SetField(tscf_pdu, AVTP_TSCF_FIELD_STREAM_ID, STREAM_ID);
-        res = AVTP_TSCF_HEADER_LEN;
-    } else {
-        Avtp_Ntscf_t* ntscf_pdu = (Avtp_Ntscf_t*) pdu;
-        memset(ntscf_pdu, 0, AVTP_NTSCF_HEADER_LEN);
-        Avtp_Ntscf_Init(ntscf_pdu);
-        Avtp_Ntscf_SetField(ntscf_pdu, AVTP_NTSCF_FIELD_SEQUENCE_NUM, seq_num++);
-        Avtp_Ntscf_SetField(ntscf_pdu, AVTP_NTSCF_FIELD_STREAM_ID, STREAM_ID);
-        res = AVTP_NTSCF_HEADER_LEN;
-    }
-    return res;
-}
+    struct timespec tspec;
 
-static int update_cf_length(uint8_t* cf_pdu, uint64_t length)
-{
-    if (use_tscf) {
-        uint64_t payloadLen = length - AVTP_TSCF_HEADER_LEN;
-        Avtp_Tscf_SetField((Avtp_Tscf_t*)cf_pdu, AVTP_TSCF_FIELD_STREAM_DATA_LENGTH, payloadLen);
-    } else {
-        uint64_t payloadLen = length - AVTP_NTSCF_HEADER_LEN;
-        Avtp_Ntscf_SetField((Avtp_Ntscf_t*)cf_pdu, AVTP_NTSCF_FIELD_NTSCF_DATA_LENGTH, payloadLen);
-    }
-    return 0;
-}
-
-static int prepare_vss_interop_packet(uint8_t* acf_pdu, Vss_Datatype_t dt,
-                              Vss_OpCode_t op, Vss_AddrMode_t am,
-                              VssPath_t* vp, VssData_t* vd) {
-
-    int processedBytes;
-    struct timespec now;
-    Avtp_Vss_t* pdu = (Avtp_Vss_t*) acf_pdu;
-
-    // Clear bits
-    memset(pdu, 0, AVTP_VSS_FIXED_HEADER_LEN);
-
-    // Prepare ACF PDU for VSS
-    Avtp_Vss_Init(pdu);
-    clock_gettime(CLOCK_REALTIME, &now);
-    Avtp_Vss_SetField(pdu, AVTP_VSS_FIELD_MSG_TIMESTAMP,
-                      (uint64_t)now.tv_nsec + (uint64_t)(now.tv_sec * 1e9));
-    Avtp_Vss_SetField(pdu, AVTP_VSS_FIELD_MTV, 1U);
-
-    // Set ACF VSS Metadata fields
-    Avtp_Vss_SetField(pdu, AVTP_VSS_FIELD_ADDR_MODE, am);
-    Avtp_Vss_SetField(pdu, AVTP_VSS_FIELD_VSS_DATATYPE, dt);
-    Avtp_Vss_SetField(pdu, AVTP_VSS_FIELD_VSS_OP, op);
-
-    // Setup VSS Path in the PDU
-    Avtp_Vss_SetVssPath(pdu, vp);
-
-    // Copy data
-    Avtp_Vss_SetVssData(pdu, vd);
-
-    // Count the processed bytes
-    processedBytes = AVTP_VSS_FIXED_HEADER_LEN + 2 + vp->vss_interop_path.path_length + 4;
-    return processedBytes;
+    clock_gettime(CLOCK_MONOTONIC, &tspec);
+    return (uint64_t)tspec.tv_sec * NSEC_PER_SEC + tspec.tv_nsec;
 }
 
 int main(int argc, char *argv[])
 {
 
-    int fd, res, can_socket=0;
+    int fd, res;
     struct sockaddr_ll sk_ll_addr;
     struct sockaddr_in sk_udp_addr;
-    uint8_t pdu[MAX_PDU_SIZE];
-    uint16_t pdu_length, cf_length;
-    struct canfd_frame can_frame;
+    vss_publisher_t publisher;
+    static vss_update_t updates[MAX_SIGNALS];
+    static vss_policy_t policies[MAX_SIGNALS];
+    static char paths[MAX_SIGNALS][MAX_PATH_LEN];
+    struct timespec now, wake;
+    uint64_t period_ns, next_sample, deadline, policy_deadline, mono_ns;
 
     argp_parse(&argp, argc, argv, 0, NULL, NULL);
+    period_ns = (uint64_t) period_ms * NSEC_PER_MSEC;
+
+    // Only TSCF frames have an AVTP timestamp to time VSS Brief messages
+    if (use_brief && !use_tscf && precision_ns != VSS_PRECISION_NONE) {
+        fprintf(stderr, "VSS Brief over NTSCF requires --precision none\n");
+        return 1;
+    }
 
     // Create an appropriate talker socket: UDP or Ethernet raw
     // Setup the socket for sending to the destination
@@ -227,77 +240,90 @@ int main(int argc, char *argv[])
 
         res = setup_udp_socket_address((struct in_addr*) ip_addr,
                                        udp_port, &sk_udp_addr);
+        if (res < 0) goto err;
+        res = vss_publisher_init(&publisher, fd, (struct sockaddr*) &sk_udp_addr,
+                                 sizeof(sk_udp_addr), use_udp, use_tscf, STREAM_ID,
+                                 MAX_PDU_SIZE - UDP_IP_HEADER_LEN,
+                                 max_delay_ms * NSEC_PER_MSEC);
     } else {
         fd = create_talker_socket(priority);
         if (fd < 0) return fd;
         res = setup_socket_address(fd, ifname, macaddr,
                                    ETH_P_TSN, &sk_ll_addr);
+        if (res < 0) goto err;
+        res = vss_publisher_init(&publisher, fd, (struct sockaddr*) &sk_ll_addr,
+                                 sizeof(sk_ll_addr), use_udp, use_tscf, STREAM_ID,
+                                 MAX_PDU_SIZE, max_delay_ms * NSEC_PER_MSEC);
     }
     if (res < 0) goto err;
 
+    if (use_static_id) {
+        vss_publisher_set_catalogue(&publisher, &vss_catalogue);
+    }
+    vss_publisher_set_brief(&publisher, use_brief);
+
+    // The first signal is Vehicle.Speed, additional ones are numbered
+    for (int i = 0; i < num_signals; i++) {
+        if (i == 0) {
+            snprintf(paths[i], MAX_PATH_LEN, "%s", VSS_PATH);
+        } else {
+            snprintf(paths[i], MAX_PATH_LEN, "Vehicle.Private.Signal%d", i);
+        }
+        updates[i].addr_mode = VSS_INTEROP_MODE;
+        updates[i].op = PUBLISH_CURRENT_VALUE;
+        updates[i].datatype = VSS_FLOAT;
+        updates[i].path.vss_interop_path.path = paths[i];
+        updates[i].path.vss_interop_path.path_length = strlen(paths[i]);
+        updates[i].data.data_float = (rand()%2500)/10.0;
+        updates[i].precision_ns = precision_ns;
+        vss_policy_init(&policies[i], &policy_config);
+    }
+
     // Sending loop
+    next_sample = get_monotonic_ns();
     for(;;) {
 
-        // Pack into control formats
-        uint8_t *cf_pdu;
-        pdu_length = 0;
-        cf_length = 0;
-        uint8_t acf_length= 0;
-
-        // Usage of UDP means the PDU needs a
-        if (use_udp) {
-            Avtp_Udp_t *udp_pdu = (Avtp_Udp_t *) pdu;
-            Avtp_Udp_SetField(udp_pdu, AVTP_UDP_FIELD_ENCAPSULATION_SEQ_NO,
-                              udp_seq_num++);
-            pdu_length +=  sizeof(Avtp_Udp_t);
-        }
+        mono_ns = get_monotonic_ns();
+        if (mono_ns >= next_sample) {
+            clock_gettime(CLOCK_REALTIME, &now);
+            for (int i = 0; i < num_signals; i++) {
+                // Signals drift slowly, as sensor values typically do
+                float value = updates[i].data.data_float + ((rand()%41) - 20)/10.0;
+                if (value < 0) value = 0;
+                if (value > MAX_SPEED) value = MAX_SPEED;
+                updates[i].data.data_float = value;
+                updates[i].msg_timestamp = (uint64_t)now.tv_nsec + (uint64_t)(now.tv_sec * 1e9);
+            }
+            next_sample += period_ns;
 
-        cf_pdu = pdu + pdu_length;
-        res = init_cf_pdu(cf_pdu);
-        if (res < 0)
-            goto err;
-        pdu_length += res;
-        cf_length += res;
-
-        uint8_t* acf_pdu = pdu + pdu_length;
-        VssPath_t vss_path = {
-            .vss_interop_path.path_length = strlen(VSS_PATH),
-            .vss_interop_path.path = VSS_PATH
-        };
-        VssData_t data = {
-            .data_float = (rand()%2500)/10.0
-        };
-        res = prepare_vss_interop_packet(acf_pdu, VSS_FLOAT,
-                                            PUBLISH_CURRENT_VALUE,
-                                            VSS_INTEROP_MODE, &vss_path, &data);
-        if (res < 0) goto err;
-        pdu_length += res;
-        cf_length += res;
-        acf_length = res;
-
-        Avtp_Vss_Pad((Avtp_Vss_t*) acf_pdu, acf_length);
-        uint8_t pad_length = Avtp_Vss_GetField((Avtp_Vss_t*)acf_pdu, AVTP_VSS_FIELD_PAD);
-        pdu_length += pad_length;
-        cf_length += pad_length;
-
-        res = update_cf_length(cf_pdu, cf_length);
-        if (res < 0)
-            goto err;
-
-        if (use_udp) {
-            res = sendto(fd, pdu, pdu_length, 0,
-                    (struct sockaddr *) &sk_udp_addr, sizeof(sk_udp_addr));
-        } else {
-            res = sendto(fd, pdu, pdu_length, 0,
-                         (struct sockaddr *) &sk_ll_addr, sizeof(sk_ll_addr));
+            // All signals of a cycle are packed into as few frames as possible
+            if (!use_policy) {
+                res = vss_publisher_publish(&publisher, updates, num_signals);
+                if (res < 0) goto err;
+            }
         }
-        if (res < 0) {
-            perror("Failed to send data");
-            goto err;
+
+        // Between samples, the policy publishes held-back changes and
+        // heartbeats as soon as their interval expired
+        deadline = next_sample;
+        if (use_policy) {
+            res = vss_policy_publish(&publisher, policies, updates, num_signals,
+                                     mono_ns);
+            if (res < 0) goto err;
+
+            policy_deadline = vss_policy_next_deadline(policies, num_signals);
+            if (policy_deadline < deadline) {
+                deadline = policy_deadline;
+            }
         }
-        sleep(1);
+
+        wake.tv_sec = deadline / NSEC_PER_SEC;
+        wake.tv_nsec = deadline % NSEC_PER_SEC;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
     }
 
+    return 0;
+
 err:
     close(fd);
     return 1;
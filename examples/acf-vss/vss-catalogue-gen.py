@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2024, COVESA
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+#    # Redistributions of source code must retain the above copyright notice,
+#      this list of conditions and the following disclaimer.
+#    # Redistributions in binary form must reproduce the above copyright
+#      notice, this list of conditions and the following disclaimer in the
+#      documentation and/or other materials provided with the distribution.
+#    # Neither the name of COVESA nor the names of its contributors may be
+#      used to endorse or promote products derived from this software without
+#      specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+"""
+Compiles a VSS catalogue into C tables for acf-vss-catalogue.c.
+
+The catalogue is a text file with one signal per line:
+
+    <vss path>[,<static id>]
+
+Empty lines and lines starting with '#' are ignored. Static IDs are given in
+decimal or as 0x prefixed hex (as produced by the vss-tools id exporter).
+Signals without a static ID are numbered after the highest explicit ID.
+
+Two minimal perfect hashes are generated with the hash-and-displace (CHD)
+method: one from path to catalogue entry and one from static ID to catalogue
+entry. The hash function must match catalogue_hash() in acf-vss-catalogue.c.
+"""
+
+import argparse
+import sys
+
+FNV_OFFSET = 0x811C9DC5
+FNV_PRIME = 0x01000193
+MASK32 = 0xFFFFFFFF
+
+# Average number of keys per bucket. Larger values shrink the seed table but
+# make the search for seeds slower.
+KEYS_PER_BUCKET = 4
+
+
+def catalogue_hash(data, seed):
+    h = (FNV_OFFSET ^ seed) & MASK32
+    for b in data:
+        h ^= b
+        h = (h * FNV_PRIME) & MASK32
+    # Final avalanche (murmur3 fmix32) so that the seed affects all bits
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & MASK32
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & MASK32
+    h ^= h >> 16
+    return h
+
+
+def build_mph(keys):
+    """Returns (seeds, slots) where slots[i] is the index of the key that
+    hashes to slot i."""
+    n = len(keys)
+    num_buckets = max(1, (n + KEYS_PER_BUCKET - 1) // KEYS_PER_BUCKET)
+    buckets = [[] for _ in range(num_buckets)]
+    for idx, key in enumerate(keys):
+        buckets[catalogue_hash(key, 0) % num_buckets].append(idx)
+
+    seeds = [0] * num_buckets
+    slots = [None] * n
+    for b in sorted(range(num_buckets), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            break
+        seed = 1
+        while True:
+            positions = [catalogue_hash(keys[i], seed) % n for i in buckets[b]]
+            if len(set(positions)) == len(positions) and \
+               all(slots[p] is None for p in positions):
+                break
+            seed += 1
+            if seed > 0xFFFFFF:
+                sys.exit("Failed to build perfect hash, duplicate keys?")
+        seeds[b] = seed
+        for i, p in zip(buckets[b], positions):
+            slots[p] = i
+    return seeds, slots
+
+
+def parse_catalogue(path):
+    entries = []
+    with open(path, encoding="utf-8") as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            fields = [x.strip() for x in line.split(",")]
+            if len(fields) > 2 or not fields[0]:
+                sys.exit(f"{path}:{lineno}: expected <path>[,<static id>]")
+            static_id = int(fields[1], 0) if len(fields) == 2 and fields[1] else None
+            if static_id is not None and not 0 <= static_id <= MASK32:
+                sys.exit(f"{path}:{lineno}: static id out of range")
+            entries.append((fields[0], static_id))
+
+    next_id = max([i for _, i in entries if i is not None], default=-1) + 1
+    result = []
+    for vss_path, static_id in entries:
+        if static_id is None:
+            static_id = next_id
+            next_id += 1
+        result.append((vss_path, static_id))
+
+    if len({p for p, _ in result}) != len(result):
+        sys.exit(f"{path}: duplicate VSS path")
+    if len({i for _, i in result}) != len(result):
+        sys.exit(f"{path}: duplicate static id")
+    if not result:
+        sys.exit(f"{path}: empty catalogue")
+    return result
+
+
+def c_string(s):
+    return '"' + s.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def format_table(ctype, name, values, fmt, per_line=8):
+    lines = [f"static const {ctype} {name}[] = {{"]
+    for i in range(0, len(values), per_line):
+        lines.append("    " + ", ".join(fmt(v) for v in values[i:i + per_line]) + ",")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("catalogue", help="VSS catalogue file")
+    parser.add_argument("-o", "--output", required=True, help="C file to generate")
+    args = parser.parse_args()
+
+    entries = parse_catalogue(args.catalogue)
+    path_seeds, path_slots = build_mph([p.encode() for p, _ in entries])
+    # Entries are stored in the order of the path hash slots
+    entries = [entries[i] for i in path_slots]
+    id_seeds, id_slots = build_mph([i.to_bytes(4, "big") for _, i in entries])
+
+    out = [
+        "/* Generated by vss-catalogue-gen.py from "
+        f"{args.catalogue.split('/')[-1]}. Do not edit. */",
+        "",
+        '#include "acf-vss-catalogue.h"',
+        "",
+        format_table("uint32_t", "path_seeds", path_seeds, str),
+        "",
+        format_table("uint32_t", "id_seeds", id_seeds, str),
+        "",
+        format_table("char* const", "paths", [p for p, _ in entries], c_string, 1),
+        "",
+        format_table("uint16_t", "path_lengths",
+                     [len(p.encode()) for p, _ in entries], str),
+        "",
+        format_table("uint32_t", "static_ids", [i for _, i in entries], hex),
+        "",
+        format_table("uint32_t", "id_entries", id_slots, str),
+        "",
+        "const vss_catalogue_t vss_catalogue = {",
+        f"    .num_entries = {len(entries)},",
+        f"    .num_path_buckets = {len(path_seeds)},",
+        f"    .num_id_buckets = {len(id_seeds)},",
+        "    .path_seeds = path_seeds,",
+        "    .id_seeds = id_seeds,",
+        "    .paths = paths,",
+        "    .path_lengths = path_lengths,",
+        "    .static_ids = static_ids,",
+        "    .id_entries = id_entries,",
+        "};",
+        "",
+    ]
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "avtp/Utils.h"
+#include "clock-domain.h"
+#include "seqlock.h"
+
+/* Create the page exclusively and lock it. Returns the file descriptor. */
+static int create_page(const char* name)
+{
+    int fd, res;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd >= 0) {
+            break;
+        }
+        if (errno != EEXIST) {
+            perror("Failed to create clock domain");
+            return -1;
+        }
+
+        // An existing page is stale unless its publisher still locks it
+        fd = shm_open(name, O_RDWR, 0);
+        if (fd < 0) {
+            continue;
+        }
+        res = flock(fd, LOCK_EX | LOCK_NB);
+        close(fd);
+        fd = -1;
+        if (res < 0) {
+            fprintf(stderr, "Clock domain %s is published by another process\n", name);
+            return -1;
+        }
+        shm_unlink(name);
+    }
+    if (fd < 0) {
+        fprintf(stderr, "Failed to create clock domain %s\n", name);
+        return -1;
+    }
+
+    if (flock(fd, LOCK_EX | LOCK_NB) < 0) {
+        perror("Failed to lock clock domain");
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int map_page(clock_domain_t* dom, const char* name, int owner)
+{
+    int fd, prot = PROT_READ;
+
+    memset(dom, 0, sizeof(*dom));
+    snprintf(dom->name, sizeof(dom->name), "%s", name);
+    dom->owner = owner;
+    dom->lock_fd = -1;
+
+    if (owner) {
+        fd = create_page(name);
+        prot |= PROT_WRITE;
+    } else {
+        fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0) {
+            perror("Failed to open clock domain");
+        }
+    }
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (owner && ftruncate(fd, sizeof(clock_domain_page_t)) < 0) {
+        perror("Failed to size clock domain");
+        goto err;
+    }
+
+    dom->page = mmap(NULL, sizeof(clock_domain_page_t), prot, MAP_SHARED, fd, 0);
+    if (dom->page == MAP_FAILED) {
+        perror("Failed to map clock domain");
+        dom->page = NULL;
+        goto err;
+    }
+
+    // The publisher keeps the page locked until clock_domain_close()
+    if (owner) {
+        dom->lock_fd = fd;
+    } else {
+        close(fd);
+    }
+    return 0;
+
+err:
+    close(fd);
+    if (owner) {
+        shm_unlink(name);
+    }
+    return -1;
+}
+
+int clock_domain_create(clock_domain_t* dom, const char* name)
+{
+    if (map_page(dom, name, 1) < 0) {
+        return -1;
+    }
+
+    // Readers that open the page early see an unpublished domain
+    memset(dom->page, 0, sizeof(*dom->page));
+    dom->page->version = CLOCK_DOMAIN_VERSION;
+    __atomic_store_n(&dom->page->magic, CLOCK_DOMAIN_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int clock_domain_open(clock_domain_t* dom, const char* name)
+{
+    if (map_page(dom, name, 0) < 0) {
+        return -1;
+    }
+
+    if (__atomic_load_n(&dom->page->magic, __ATOMIC_ACQUIRE) != CLOCK_DOMAIN_MAGIC ||
+        dom->page->version != CLOCK_DOMAIN_VERSION) {
+        fprintf(stderr, "Unknown clock domain layout\n");
+        clock_domain_close(dom);
+        return -1;
+    }
+    return 0;
+}
+
+static void publish(clock_domain_t* dom)
+{
+    seqlock_write(&dom->page->seq, &dom->page->data, &dom->data,
+                  sizeof(dom->data));
+}
+
+void clock_domain_close(clock_domain_t* dom)
+{
+    // Readers that keep the page mapped must not trust the last references
+    if (dom->owner && dom->page != NULL) {
+        dom->data.flags = 0;
+        publish(dom);
+    }
+    if (dom->page != NULL) {
+        munmap(dom->page, sizeof(clock_domain_page_t));
+        dom->page = NULL;
+    }
+    if (dom->owner) {
+        shm_unlink(dom->name);
+        close(dom->lock_fd);
+        dom->lock_fd = -1;
+        dom->owner = 0;
+    }
+}
+
+void clock_domain_publish_gptp(clock_domain_t* dom, uint64_t local,
+                               uint64_t gptp, double rate)
+{
+    dom->data.flags |= CLOCK_DOMAIN_GPTP_VALID;
+    dom->data.local_ref = local;
+    dom->data.gptp_ref = gptp;
+    dom->data.rate = rate;
+    publish(dom);
+}
+
+void clock_domain_publish_media_clock(clock_domain_t* dom,
+                                      const Avtp_MediaClock_t* clk)
+{
+    clock_domain_data_t* data = &dom->data;
+
+    if (!clk->locked) {
+        if (data->flags & CLOCK_DOMAIN_MCLK_VALID) {
+            data->flags &= ~CLOCK_DOMAIN_MCLK_VALID;
+            publish(dom);
+        }
+        return;
+    }
+
+    data->flags |= CLOCK_DOMAIN_MCLK_VALID;
+    data->mclk_base_frequency = clk->base_frequency;
+    data->mclk_pull = clk->pull;
+    data->mclk_timestamp_interval = clk->timestamp_interval;
+    data->mclk_anchor = clk->anchor;
+    data->mclk_anchor_frac = clk->anchor_frac;
+    data->mclk_edge = clk->edge;
+    data->mclk_period = clk->period;
+    publish(dom);
+}
+
+int clock_domain_read(clock_domain_t* dom, clock_domain_data_t* data)
+{
+    return seqlock_read(&dom->page->seq, data, &dom->page->data, sizeof(*data));
+}
+
+int clock_domain_local_to_gptp(clock_domain_t* dom, uint64_t local,
+                               uint64_t* gptp)
+{
+    clock_domain_data_t data;
+
+    if (clock_domain_read(dom, &data) < 0 || !(data.flags & CLOCK_DOMAIN_GPTP_VALID)) {
+        return -1;
+    }
+
+    *gptp = data.gptp_ref + (int64_t) ((int64_t) (local - data.local_ref) * data.rate);
+    return 0;
+}
+
+int clock_domain_avtp_to_local(clock_domain_t* dom, uint32_t avtp_time,
+                               uint64_t* local)
+{
+    clock_domain_data_t data;
+    int64_t offset;
+
+    if (clock_domain_read(dom, &data) < 0 || !(data.flags & CLOCK_DOMAIN_GPTP_VALID)) {
+        return -1;
+    }
+
+    // Signed distance from the published gPTP time
+    offset = (int64_t) (Avtp_ExpandTimestamp(avtp_time, data.gptp_ref) - data.gptp_ref);
+    *local = data.local_ref + (int64_t) (offset / data.rate);
+    return 0;
+}
+
+int clock_domain_align(clock_domain_t* dom, uint32_t avtp_time,
+                       uint64_t* edge_time, int64_t* phase_error)
+{
+    clock_domain_data_t data;
+    Avtp_MediaClock_t clk;
+
+    if (clock_domain_read(dom, &data) < 0 || !(data.flags & CLOCK_DOMAIN_MCLK_VALID)) {
+        return -1;
+    }
+
+    memset(&clk, 0, sizeof(clk));
+    clk.base_frequency = data.mclk_base_frequency;
+    clk.pull = data.mclk_pull;
+    clk.timestamp_interval = data.mclk_timestamp_interval;
+    clk.locked = 1;
+    clk.anchor = data.mclk_anchor;
+    clk.anchor_frac = data.mclk_anchor_frac;
+    clk.edge = data.mclk_edge;
+    clk.period = data.mclk_period;
+
+    return Avtp_MediaClock_Align(&clk, avtp_time, edge_time, phase_error) < 0 ? -1 : 0;
+}
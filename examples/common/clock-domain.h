@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "avtp/MediaClock.h"
+
+/* Clock domain shared between the processes of a host.
+ *
+ * One process, the clock service, publishes the mapping between gPTP time
+ * and the local CLOCK_MONOTONIC, and the media clock recovered from a CRF
+ * stream, in a POSIX shared memory page. Talkers and listeners map the page
+ * read-only and convert AVTP timestamps with a few loads, without reading
+ * the gPTP clock themselves.
+ *
+ * The page is protected by a seqlock: the sequence number is odd while the
+ * service updates the page, and readers retry if it changed while they
+ * copied the data.
+ */
+
+#define CLOCK_DOMAIN_DEFAULT_NAME       "/open1722-clock"
+
+#define CLOCK_DOMAIN_MAGIC              0x31373232      /* "1722" */
+#define CLOCK_DOMAIN_VERSION            1
+
+/* Flags of clock_domain_data_t */
+#define CLOCK_DOMAIN_GPTP_VALID         0x1
+#define CLOCK_DOMAIN_MCLK_VALID         0x2
+
+/* Published clocks. gPTP time is gptp_ref + (local - local_ref) * rate,
+ * with local the CLOCK_MONOTONIC time in ns.
+ */
+typedef struct {
+    uint32_t flags;
+    uint64_t local_ref;
+    uint64_t gptp_ref;
+    double rate;                /* gPTP ns per local ns */
+
+    /* Recovered media clock, see Avtp_MediaClock_t */
+    uint32_t mclk_base_frequency;
+    uint8_t mclk_pull;
+    uint16_t mclk_timestamp_interval;
+    uint64_t mclk_anchor;       /* gPTP time of edge mclk_edge */
+    double mclk_anchor_frac;
+    int64_t mclk_edge;
+    double mclk_period;         /* gPTP ns per media clock edge */
+} clock_domain_data_t;
+
+/* Layout of the shared memory page */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seq;
+    clock_domain_data_t data;
+} clock_domain_page_t;
+
+typedef struct {
+    clock_domain_page_t* page;
+    clock_domain_data_t data;   /* Publisher's copy of the page */
+    int owner;
+    int lock_fd;                /* Publisher's locked shared memory object */
+    char name[64];
+} clock_domain_t;
+
+/* Create the shared memory page of a clock domain and map it for writing.
+ * There must be a single publisher per domain: the publisher holds an
+ * exclusive flock() on the page for its lifetime. A page left behind by a
+ * publisher that did not exit cleanly is not locked and is replaced.
+ * @dom: Clock domain handle.
+ * @name: Shared memory object name, starting with '/'.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Could not create or map the page, or the domain is already
+ *    published by another process.
+ */
+int clock_domain_create(clock_domain_t* dom, const char* name);
+
+/* Map the page of an existing clock domain for reading.
+ * @dom: Clock domain handle.
+ * @name: Shared memory object name, starting with '/'.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: The page does not exist, could not be mapped or has an unknown
+ *    layout.
+ */
+int clock_domain_open(clock_domain_t* dom, const char* name);
+
+/* Unmap the page. The publisher also removes the shared memory object. */
+void clock_domain_close(clock_domain_t* dom);
+
+/* Publish the mapping between gPTP and local time.
+ * @dom: Clock domain created with clock_domain_create().
+ * @local: CLOCK_MONOTONIC time in ns.
+ * @gptp: gPTP time at local, in ns.
+ * @rate: gPTP ns per local ns.
+ */
+void clock_domain_publish_gptp(clock_domain_t* dom, uint64_t local,
+                               uint64_t gptp, double rate);
+
+/* Publish a recovered media clock, or withdraw it if it is not locked.
+ * @dom: Clock domain created with clock_domain_create().
+ * @clk: Media clock.
+ */
+void clock_domain_publish_media_clock(clock_domain_t* dom,
+                                      const Avtp_MediaClock_t* clk);
+
+/* Read a consistent copy of the published clocks.
+ * @dom: Clock domain.
+ * @data: Receives the clocks.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Nothing published yet.
+ */
+int clock_domain_read(clock_domain_t* dom, clock_domain_data_t* data);
+
+/* Convert a local CLOCK_MONOTONIC time into gPTP time.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: No gPTP mapping published.
+ */
+int clock_domain_local_to_gptp(clock_domain_t* dom, uint64_t local,
+                               uint64_t* gptp);
+
+/* Convert a 32-bit AVTP timestamp into local CLOCK_MONOTONIC time. The
+ * timestamp is expanded around the published gPTP time, so it must lie
+ * within about 2 seconds of it.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: No gPTP mapping published.
+ */
+int clock_domain_avtp_to_local(clock_domain_t* dom, uint32_t avtp_time,
+                               uint64_t* local);
+
+/* Align a 32-bit AVTP timestamp with the published media clock, see
+ * Avtp_MediaClock_Align().
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: No media clock published.
+ */
+int clock_domain_align(clock_domain_t* dom, uint32_t avtp_time,
+                       uint64_t* edge_time, int64_t* phase_error);
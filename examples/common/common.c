@@ -47,56 +47,58 @@
 #include <unistd.h>
 
 #include "common.h"
+#ifdef __linux__
+#include "fast-clock.h"
+#endif
 
 #ifdef __linux__
 #define NSEC_PER_SEC		1000000000ULL
 #define NSEC_PER_MSEC		1000000ULL
 
+/* Per-thread reader of CLOCK_REALTIME, so timestamping a PDU does not
+ * cost a system clock read on every call.
+ */
+static __thread fast_clock_t realtime;
+static __thread int realtime_ready;
+
+static int get_realtime(fast_clock_t **fc)
+{
+    if (!realtime_ready) {
+        if (fast_clock_init(&realtime, CLOCK_REALTIME) < 0)
+            return -1;
+        realtime_ready = 1;
+    }
+    *fc = &realtime;
+    return 0;
+}
+
 int calculate_avtp_time(uint32_t *avtp_time, uint32_t max_transit_time)
 {
-    int res;
-    struct timespec tspec;
-    uint64_t ptime;
+    fast_clock_t *fc;
 
-    res = clock_gettime(CLOCK_REALTIME, &tspec);
-    if (res < 0) {
-        perror("Failed to get time");
+    if (get_realtime(&fc) < 0)
         return -1;
-    }
-
-    ptime = (tspec.tv_sec * NSEC_PER_SEC) +
-            (max_transit_time * NSEC_PER_MSEC) + tspec.tv_nsec;
 
-    *avtp_time = ptime % (1ULL << 32);
+    *avtp_time = fast_clock_avtp_time(fc, max_transit_time * NSEC_PER_MSEC);
 
     return 0;
 }
 
 int get_presentation_time(uint64_t avtp_time, struct timespec *tspec)
 {
-    int res;
-    uint64_t ptime, now;
+    fast_clock_t *fc;
+    uint64_t ptime;
 
-    res = clock_gettime(CLOCK_REALTIME, tspec);
-    if (res < 0) {
-        perror("Failed to get time from PHC");
+    if (get_realtime(&fc) < 0)
         return -1;
-    }
-
-    now = (tspec->tv_sec * NSEC_PER_SEC) + tspec->tv_nsec;
 
     /* The avtp_timestamp within AAF packet is the lower part (32
      * less-significant bits) from presentation time calculated by the
-     * talker.
-     */
-    ptime = (now & 0xFFFFFFFF00000000ULL) | avtp_time;
-
-    /* If 'ptime' is less than the 'now', it means the higher part
-     * from 'ptime' needs to be incremented by 1 in order to recover the
-     * presentation time set by the talker.
+     * talker. Pick the presentation time closest to 'now': the 32-bit
+     * timestamp wraps every 4.29 s, so a PDU that arrives after its
+     * presentation time must not be scheduled one wrap period later.
      */
-    if (ptime < now)
-        ptime += (1ULL << 32);
+    ptime = fast_clock_expand(fc, (uint32_t) avtp_time);
 
     tspec->tv_sec = ptime / NSEC_PER_SEC;
     tspec->tv_nsec = ptime % NSEC_PER_SEC;
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdio.h>
+
+// The TSC calibration needs 128 bit arithmetic, only 64 bit x86 has it
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define FAST_CLOCK_TSC
+#endif
+
+#include "fast-clock.h"
+
+#define NSEC_PER_SEC            1000000000ULL
+
+/* Fixed point of the TSC multiplier. Limits the TSC ticks between
+ * recalibrations to 2^64 / mult, several seconds even at 1 GHz.
+ */
+#define MULT_SHIFT              32
+
+/* Duration of the initial TSC calibration */
+#define CALIBRATE_NS            1000000ULL
+
+/* Rate deviations beyond this restart the rate measurement */
+#define MAX_RATE_ERROR_PPM      500
+
+/* Clock reads per calibration sample */
+#define SAMPLE_TRIES            3
+
+static int read_clock(clockid_t clock, uint64_t *ns)
+{
+    struct timespec ts;
+
+    if (clock_gettime(clock, &ts) < 0) {
+        perror("Failed to get time");
+        return -1;
+    }
+    *ns = (uint64_t) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+    return 0;
+}
+
+#ifdef FAST_CLOCK_TSC
+
+static int has_invariant_tsc(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        return 0;
+    return (edx >> 8) & 1;
+}
+
+/* Read the clock between two TSC reads and return the midpoint TSC. The
+ * tightest of a few reads is kept, so a preempted read does not skew the
+ * mapping.
+ */
+static uint64_t sample(fast_clock_t *fc, uint64_t *ns)
+{
+    uint64_t t1, t2, t, best = UINT64_MAX, tsc = 0;
+    int i;
+
+    for (i = 0; i < SAMPLE_TRIES; i++) {
+        t1 = __rdtsc();
+        read_clock(fc->clock, &t);
+        t2 = __rdtsc();
+        if (t2 - t1 < best) {
+            best = t2 - t1;
+            tsc = t1 + best / 2;
+            *ns = t;
+        }
+    }
+    return tsc;
+}
+
+static uint64_t calc_mult(uint64_t ticks, uint64_t ns)
+{
+    return (uint64_t) (((unsigned __int128) ns << MULT_SHIFT) / ticks);
+}
+
+static void recalibrate(fast_clock_t *fc)
+{
+    uint64_t ns, tsc = sample(fc, &ns);
+    uint64_t mult = calc_mult(tsc - fc->tsc_base, ns - fc->ns_base);
+    uint64_t max_diff = fc->mult / 1000000 * MAX_RATE_ERROR_PPM;
+
+    /* The rate is measured since the first calibration for precision. A
+     * step of the system clock restarts the measurement.
+     */
+    if (mult > fc->mult + max_diff || mult + max_diff < fc->mult) {
+        fc->tsc_base = fc->tsc_ref;
+        fc->ns_base = fc->ns_ref;
+    } else {
+        fc->mult = mult;
+    }
+
+    fc->tsc_ref = tsc;
+    fc->ns_ref = ns;
+    fc->tsc_limit = tsc + ((FAST_CLOCK_RECALIBRATE_NS << MULT_SHIFT) / fc->mult);
+}
+
+#endif
+
+int fast_clock_init(fast_clock_t *fc, clockid_t clock)
+{
+    uint64_t ns;
+
+    fc->clock = clock;
+    fc->use_tsc = 0;
+    if (read_clock(clock, &ns) < 0)
+        return -1;
+
+#ifdef FAST_CLOCK_TSC
+    if (has_invariant_tsc()) {
+        uint64_t tsc, ns2, tsc2;
+
+        tsc = sample(fc, &ns);
+        do {
+            tsc2 = sample(fc, &ns2);
+        } while (ns2 - ns < CALIBRATE_NS);
+
+        fc->mult = calc_mult(tsc2 - tsc, ns2 - ns);
+        fc->tsc_base = tsc;
+        fc->ns_base = ns;
+        fc->tsc_ref = tsc2;
+        fc->ns_ref = ns2;
+        fc->tsc_limit = tsc2 + ((FAST_CLOCK_RECALIBRATE_NS << MULT_SHIFT) / fc->mult);
+        fc->use_tsc = 1;
+    }
+#endif
+
+    return 0;
+}
+
+uint64_t fast_clock_now(fast_clock_t *fc)
+{
+    uint64_t ns = 0;
+
+#ifdef FAST_CLOCK_TSC
+    if (fc->use_tsc) {
+        uint64_t tsc = __rdtsc();
+
+        if (tsc - fc->tsc_ref >= fc->tsc_limit - fc->tsc_ref) {
+            recalibrate(fc);
+            tsc = __rdtsc();
+        }
+        return fc->ns_ref + (((tsc - fc->tsc_ref) * fc->mult) >> MULT_SHIFT);
+    }
+#endif
+
+    read_clock(fc->clock, &ns);
+    return ns;
+}
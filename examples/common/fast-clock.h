@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+#include "avtp/Utils.h"
+
+/* Fast reader of a system clock for per-packet timestamps.
+ *
+ * On x86-64 CPUs with an invariant TSC the clock is extrapolated from the TSC
+ * with a multiply and a shift. The mapping is recalibrated against the
+ * system clock every FAST_CLOCK_RECALIBRATE_NS, so it follows steps and
+ * frequency adjustments of the system clock (e.g. by phc2sys) with that
+ * delay. Elsewhere clock_gettime() is used, which is served by the vDSO.
+ *
+ * A fast_clock_t must only be used by one thread.
+ */
+
+#define FAST_CLOCK_RECALIBRATE_NS       100000000ULL
+
+typedef struct {
+    clockid_t clock;
+    int use_tsc;
+    uint64_t tsc_ref;           /* TSC at the reference point */
+    uint64_t ns_ref;            /* Clock time at the reference point */
+    uint64_t tsc_limit;         /* TSC at which to recalibrate */
+    uint64_t mult;              /* ns per TSC tick, fixed point */
+    uint64_t tsc_base;          /* Start of the rate measurement */
+    uint64_t ns_base;
+} fast_clock_t;
+
+/* Initialize a fast clock. Calibrating the TSC takes about 1 ms.
+ * @fc: Fast clock.
+ * @clock: System clock to follow, e.g. CLOCK_REALTIME.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Could not read the clock.
+ */
+int fast_clock_init(fast_clock_t *fc, clockid_t clock);
+
+/* Current time of the clock in ns. */
+uint64_t fast_clock_now(fast_clock_t *fc);
+
+/* AVTP timestamp, the lower 32 bits of the current time plus an offset.
+ * @fc: Fast clock.
+ * @offset: Offset in ns, e.g. the max transit time.
+ */
+static inline uint32_t fast_clock_avtp_time(fast_clock_t *fc, uint64_t offset)
+{
+    return (uint32_t) (fast_clock_now(fc) + offset);
+}
+
+/* Expand an AVTP timestamp to the time closest to now, within 2^31 ns.
+ * @fc: Fast clock.
+ * @avtp_time: AVTP timestamp.
+ */
+static inline uint64_t fast_clock_expand(fast_clock_t *fc, uint32_t avtp_time)
+{
+    return Avtp_ExpandTimestamp(avtp_time, fast_clock_now(fc));
+}
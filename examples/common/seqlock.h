@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/* Sequence lock for a single writer and any number of readers, which may
+ * live in other threads or processes (shared memory). The sequence number
+ * is odd while the writer updates the protected data; readers retry until
+ * they copied the data between two identical even sequence numbers.
+ * Readers never block the writer. A sequence number of 0 means the data
+ * was never written.
+ */
+
+/* Write protected data. Must only be called by the single writer.
+ * @seq: Sequence number of the protected data.
+ * @dst: Protected data.
+ * @src: New value.
+ * @len: Size of the protected data.
+ */
+static inline void seqlock_write(uint32_t *seq, void *dst, const void *src,
+                                 size_t len)
+{
+    // Only the writer changes the sequence number
+    uint32_t s = *seq;
+
+    __atomic_store_n(seq, s + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(dst, src, len);
+    __atomic_store_n(seq, s + 2, __ATOMIC_RELEASE);
+}
+
+/* Read a consistent copy of protected data.
+ * @seq: Sequence number of the protected data.
+ * @dst: Location to copy the data to.
+ * @src: Protected data.
+ * @len: Size of the protected data.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Data was never written.
+ */
+static inline int seqlock_read(const uint32_t *seq, void *dst, const void *src,
+                               size_t len)
+{
+    uint32_t seq1, seq2;
+
+    do {
+        seq1 = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+        if (seq1 == 0) {
+            return -1;
+        }
+        if (seq1 & 1) {
+            continue;
+        }
+        memcpy(dst, src, len);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq2 = __atomic_load_n(seq, __ATOMIC_RELAXED);
+    } while ((seq1 & 1) || seq1 != seq2);
+
+    return 0;
+}
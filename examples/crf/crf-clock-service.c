@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* CRF Clock Service example.
+ *
+ * This example publishes the clocks of a host in a clock domain (see
+ * common/clock-domain.h), a POSIX shared memory page that talkers and
+ * listeners running on the same host map read-only:
+ *
+ * - The mapping between gPTP time and CLOCK_MONOTONIC, sampled every 100 ms.
+ *   gPTP time is read from CLOCK_REALTIME, which must be synchronized with
+ *   PTP time (see ptp4l(8) and phc2sys(8)), or directly from a PTP Hardware
+ *   Clock (PHC) with the --phc option.
+ * - The media clock recovered from a CRF stream, if a CRF stream address is
+ *   given. It is republished on every CRF PDU.
+ *
+ * With the --show option the example instead opens an existing clock domain
+ * as a reader and prints the published clocks once per second.
+ *
+ * Run 'crf-clock-service --help' for more information.
+ */
+
+#include <argp.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <linux/if.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "avtp/CommonHeader.h"
+#include "avtp/Crf.h"
+#include "avtp/MediaClock.h"
+#include "common/common.h"
+#include "common/clock-domain.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define SAMPLE_INTERVAL_NS	100000000ULL
+#define MAX_PDU_SIZE		1500
+
+/* Clock samples whose CLOCK_MONOTONIC reads are further apart are retried */
+#define MAX_SAMPLE_WINDOW_NS	20000
+#define SAMPLE_TRIES		3
+
+/* Rate changes beyond this are clock steps, not frequency changes */
+#define MAX_RATE_ERROR		500e-6
+
+#define FD_TO_CLOCKID(fd)	((~(clockid_t) (fd) << 3) | 3)
+
+static char ifname[IFNAMSIZ];
+static uint8_t macaddr[ETH_ALEN];
+static int have_macaddr;
+static char domain_name[64] = CLOCK_DOMAIN_DEFAULT_NAME;
+static char phc_path[64];
+static int show;
+static volatile sig_atomic_t stop;
+
+static struct argp_option options[] = {
+    {"ifname", 'i', "IFNAME", 0, "Network Interface" },
+    {"crf-addr", 'c', "MACADDR", 0, "CRF Stream Destination MAC address" },
+    {"name", 'n', "NAME", 0, "Shared memory name of the clock domain (default "
+                             CLOCK_DOMAIN_DEFAULT_NAME ")" },
+    {"phc", 'p', "DEVICE", 0, "Read gPTP time from a PHC, e.g. /dev/ptp0" },
+    {"show", 's', 0, 0, "Print the clocks of a running clock service" },
+    { 0 }
+};
+
+static error_t parser(int key, char *arg, struct argp_state *state)
+{
+    int res;
+
+    switch (key) {
+    case 'i':
+        strncpy(ifname, arg, sizeof(ifname) - 1);
+        break;
+    case 'c':
+        res = sscanf(arg, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+                    &macaddr[0], &macaddr[1], &macaddr[2],
+                    &macaddr[3], &macaddr[4], &macaddr[5]);
+        if (res != 6) {
+            fprintf(stderr, "Invalid address\n");
+            exit(EXIT_FAILURE);
+        }
+        have_macaddr = 1;
+        break;
+    case 'n':
+        snprintf(domain_name, sizeof(domain_name), "%s", arg);
+        break;
+    case 'p':
+        snprintf(phc_path, sizeof(phc_path), "%s", arg);
+        break;
+    case 's':
+        show = 1;
+        break;
+    }
+
+    return 0;
+}
+
+static struct argp argp = { options, parser };
+
+static void handle_signal(int sig)
+{
+    stop = 1;
+}
+
+static uint64_t read_clock(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (uint64_t) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/* Read gPTP time between two reads of CLOCK_MONOTONIC, keeping the sample
+ * with the narrowest window.
+ */
+static void sample_clocks(clockid_t gptp_clock, uint64_t *local, uint64_t *gptp)
+{
+    uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < SAMPLE_TRIES && best > MAX_SAMPLE_WINDOW_NS; i++) {
+        uint64_t t1 = read_clock(CLOCK_MONOTONIC);
+        uint64_t g = read_clock(gptp_clock);
+        uint64_t t2 = read_clock(CLOCK_MONOTONIC);
+
+        if (t2 - t1 < best) {
+            best = t2 - t1;
+            *local = t1 + (t2 - t1) / 2;
+            *gptp = g;
+        }
+    }
+}
+
+static void update_gptp(clock_domain_t *dom, clockid_t gptp_clock)
+{
+    static uint64_t prev_local, prev_gptp;
+    static double rate = 1.0;
+    uint64_t local, gptp;
+
+    sample_clocks(gptp_clock, &local, &gptp);
+
+    if (prev_local != 0) {
+        double r = (double) (int64_t) (gptp - prev_gptp) /
+                   (double) (int64_t) (local - prev_local);
+
+        /* Smooth the rate; a step of the gPTP clock only moves the
+         * reference point.
+         */
+        if (r > 1.0 - MAX_RATE_ERROR && r < 1.0 + MAX_RATE_ERROR)
+            rate += (r - rate) / 8;
+    }
+    prev_local = local;
+    prev_gptp = gptp;
+
+    clock_domain_publish_gptp(dom, local, gptp, rate);
+}
+
+static int handle_crf_pdu(clock_domain_t *dom, Avtp_MediaClock_t *mclk, int fd)
+{
+    uint8_t pdu[MAX_PDU_SIZE];
+    Avtp_Crf_t *crf = (Avtp_Crf_t *) pdu;
+    ssize_t n;
+    int res;
+
+    n = recv(fd, pdu, sizeof(pdu), 0);
+    if (n < 0) {
+        perror("Failed to receive data");
+        return -1;
+    }
+
+    if (n < AVTP_CRF_HEADER_LEN ||
+        Avtp_CommonHeader_GetSubtype((Avtp_CommonHeader_t *) pdu) != AVTP_SUBTYPE_CRF ||
+        n < AVTP_CRF_HEADER_LEN + Avtp_Crf_GetCrfDataLength(crf))
+        return 0;
+
+    res = Avtp_MediaClock_ProcessPdu(mclk, crf);
+    if (res < 0) {
+        fprintf(stderr, "Invalid CRF PDU: %d\n", res);
+        return 0;
+    }
+
+    clock_domain_publish_media_clock(dom, mclk);
+    return 0;
+}
+
+static int run_service(void)
+{
+    clock_domain_t dom;
+    Avtp_MediaClock_t mclk;
+    clockid_t gptp_clock = CLOCK_REALTIME;
+    struct itimerspec itspec = { 0 };
+    struct pollfd fds[2];
+    int phc_fd = -1, timer_fd, sk_fd = -1, ret = 1;
+    uint64_t expirations;
+
+    if (phc_path[0] != '\0') {
+        phc_fd = open(phc_path, O_RDONLY);
+        if (phc_fd < 0) {
+            perror("Failed to open PHC");
+            return 1;
+        }
+        gptp_clock = FD_TO_CLOCKID(phc_fd);
+    }
+
+    Avtp_MediaClock_Init(&mclk, AVTP_MEDIA_CLOCK_DEFAULT_BANDWIDTH);
+
+    if (clock_domain_create(&dom, domain_name) < 0)
+        goto err_phc;
+
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, 0);
+    if (timer_fd < 0) {
+        perror("Failed to create timer");
+        goto err_domain;
+    }
+    itspec.it_value.tv_nsec = 1;
+    itspec.it_interval.tv_nsec = SAMPLE_INTERVAL_NS;
+    if (timerfd_settime(timer_fd, 0, &itspec, NULL) < 0) {
+        perror("Failed to set timer");
+        goto err_timer;
+    }
+
+    if (have_macaddr) {
+        sk_fd = create_listener_socket(ifname, macaddr, ETH_P_TSN);
+        if (sk_fd < 0)
+            goto err_timer;
+    }
+
+    fds[0].fd = timer_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = sk_fd;
+    fds[1].events = POLLIN;
+
+    while (!stop) {
+        if (poll(fds, sk_fd < 0 ? 1 : 2, -1) < 0) {
+            if (stop)
+                break;
+            perror("Failed to poll() fds");
+            goto err_socket;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            if (read(timer_fd, &expirations, sizeof(expirations)) < 0) {
+                perror("Failed to read timerfd");
+                goto err_socket;
+            }
+            update_gptp(&dom, gptp_clock);
+        }
+
+        if (sk_fd >= 0 && (fds[1].revents & POLLIN)) {
+            if (handle_crf_pdu(&dom, &mclk, sk_fd) < 0)
+                goto err_socket;
+        }
+    }
+
+    ret = 0;
+
+err_socket:
+    if (sk_fd >= 0)
+        close(sk_fd);
+err_timer:
+    close(timer_fd);
+err_domain:
+    clock_domain_close(&dom);
+err_phc:
+    if (phc_fd >= 0)
+        close(phc_fd);
+    return ret;
+}
+
+static int run_show(void)
+{
+    clock_domain_t dom;
+    clock_domain_data_t data;
+    uint64_t gptp;
+
+    if (clock_domain_open(&dom, domain_name) < 0)
+        return 1;
+
+    while (!stop) {
+        if (clock_domain_read(&dom, &data) < 0) {
+            printf("Nothing published yet\n");
+        } else {
+            if (clock_domain_local_to_gptp(&dom, read_clock(CLOCK_MONOTONIC),
+                                           &gptp) == 0) {
+                printf("gPTP time %" PRIu64 " ns, rate %+.3f ppm\n",
+                       gptp, (data.rate - 1.0) * 1e6);
+            }
+            if (data.flags & CLOCK_DOMAIN_MCLK_VALID) {
+                printf("Media clock %.3f Hz (base %u Hz, pull %u)\n",
+                       NSEC_PER_SEC / data.mclk_period,
+                       data.mclk_base_frequency, data.mclk_pull);
+            } else {
+                printf("Media clock not locked\n");
+            }
+        }
+        fflush(stdout);
+        sleep(1);
+    }
+
+    clock_domain_close(&dom);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    argp_parse(&argp, argc, argv, 0, NULL, NULL);
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    return show ? run_show() : run_service();
+}
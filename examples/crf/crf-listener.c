@@ -40,11 +40,9 @@
  *
  * When operating as AAF listener, it receives AAF packets and checks if their
  * presentation time is aligned with the clock reference provided by the CRF
- * stream.
- *
- * Note that the application running on AAF listener mode should be started
- * before the application running on AAF talker mode so the former is able to
- * recover the media clock and check for AAF stream alignment.
+ * stream. Each presentation time is compared with the nearest edge of the
+ * recovered media clock, so AAF packets are only checked once the first CRF
+ * packet is received.
  *
  * TSN stream parameters (e.g. destination mac address and mode) are passed
  * via command-line arguments. Run 'crf-listener --help' for more information.
@@ -93,15 +91,16 @@
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/param.h>
-#include <sys/queue.h>
 #include <sys/timerfd.h>
 #include <unistd.h>
 #include <math.h>
 #include <inttypes.h>
 
 #include "avtp/Crf.h"
+#include "avtp/MediaClock.h"
 #include "avtp/aaf/Pcm.h"
 #include "common/common.h"
+#include "common/clock-domain.h"
 #include "avtp/CommonHeader.h"
 
 #define AAF_STREAM_ID		0xAABBCCDDEEFF0001
@@ -124,16 +123,10 @@
 #define TIME_PERIOD_NS		((double)NSEC_PER_SEC / CRF_SAMPLE_RATE)
 #define AAF_PERIOD		(NSEC_PER_SEC * AAF_NUM_SAMPLES / AAF_SAMPLE_RATE)
 #define MCLK_PERIOD		AAF_PERIOD
-#define MCLKLIST_TS_PER_CRF	(CRF_SAMPLE_RATE / CRF_TIMESTAMPS_PER_SEC)
 
 #define NSEC_PER_SEC		1000000000ULL
 #define NSEC_PER_MSEC		1000000ULL
 
-struct media_clock_entry {
-    STAILQ_ENTRY(media_clock_entry) mclk_entries;
-    uint64_t timestamp;
-};
-
 static enum {
     MODE_TALKER,
     MODE_LISTENER,
@@ -146,11 +139,12 @@ static int priority = -1;
 static int mtt;
 static bool prev_state;
 static bool first_aaf_pdu = true;
-static bool need_mclk_lookup = true;
 static uint8_t crf_seq_num;
 static uint8_t aaf_seq_num;
-static uint64_t prev_mclk_timestamp, rounded_mtt;
-static STAILQ_HEAD(timestamp_queue, media_clock_entry) mclk_timestamps;
+static uint64_t next_aaf_time, rounded_mtt;
+static Avtp_MediaClock_t mclk;
+static char domain_name[64];
+static clock_domain_t clock_domain;
 
 static struct argp_option options[] = {
     {"crf-addr", 'c', "MACADDR", 0, "CRF Stream Destination MAC address" },
@@ -159,6 +153,8 @@ static struct argp_option options[] = {
     {"prio", 'p', "NUM", 0, "SO_PRIORITY to be set in AAF stream" },
     {"mtt", 'm', "MSEC", 0, "Max Transit time from AAF stream (in ms)" },
     {"mode", 'o', "talker|listener", 0, "AAF operation mode"},
+    {"clock-domain", 'D', "NAME", 0, "In listener mode, use the media clock "
+                                     "published by crf-clock-service" },
     { 0 }
 };
 
@@ -196,6 +192,9 @@ static error_t parser(int key, char *arg, struct argp_state *state)
     case 'p':
         priority = atoi(arg);
         break;
+    case 'D':
+        snprintf(domain_name, sizeof(domain_name), "%s", arg);
+        break;
     case 'o':
         if (strcmp(arg, "talker") == 0)
             mode = MODE_TALKER;
@@ -213,59 +212,20 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 
 static struct argp argp = { options, parser };
 
-static uint64_t mclk_dequeue_ts(void)
-{
-    uint64_t mclk_timestamp;
-    struct media_clock_entry *mclk_entry;
-
-    mclk_entry = STAILQ_FIRST(&mclk_timestamps);
-    mclk_timestamp = mclk_entry->timestamp;
-    STAILQ_REMOVE_HEAD(&mclk_timestamps, mclk_entries);
-    free(mclk_entry);
-
-    return mclk_timestamp;
-}
-
-static int mclk_enqueue_ts(uint64_t ts)
-{
-    struct media_clock_entry *mclk_entry;
-
-    mclk_entry = malloc(sizeof(*mclk_entry));
-    if (!mclk_entry) {
-        fprintf(stderr, "Failed to allocate memory\n");
-        return -1;
-    }
-
-    mclk_entry->timestamp = ts;
-    STAILQ_INSERT_TAIL(&mclk_timestamps, mclk_entry, mclk_entries);
-
-    return 0;
-}
-
-static uint64_t get_next_mclk_timestamp(void)
-{
-    uint64_t mclk_timestamp;
-
-    if (STAILQ_EMPTY(&mclk_timestamps)) {
-        mclk_timestamp = prev_mclk_timestamp + MCLK_PERIOD;
-        need_mclk_lookup = true;
-    } else {
-        mclk_timestamp = mclk_dequeue_ts();
-    }
-
-    prev_mclk_timestamp = mclk_timestamp;
-
-    return mclk_timestamp;
-}
-
-static uint64_t mclk_lookup(uint32_t avtp_time)
+/* Returns the presentation time of the AAF PDU following the one presented at
+ * 'time'. AAF PDUs are presented on every AAF_NUM_SAMPLES-th edge of the
+ * recovered media clock, delayed by the max transit time.
+ */
+static uint64_t get_next_aaf_time(uint64_t time)
 {
-    uint64_t mclk_timestamp = get_next_mclk_timestamp();
+    uint64_t edge;
 
-    while (mclk_timestamp % (1ULL << 32) != avtp_time)
-        mclk_timestamp = get_next_mclk_timestamp();
+    if (Avtp_MediaClock_NextEdge(&mclk, time - rounded_mtt + 1,
+                                 AAF_NUM_SAMPLES, &edge) < 0)
+        /* Freewheel if the media clock is lost. */
+        return time + MCLK_PERIOD;
 
-    return mclk_timestamp;
+    return edge + rounded_mtt;
 }
 
 static bool is_valid_crf_pdu(struct avtp_crf_pdu *pdu)
@@ -594,7 +554,8 @@ static int aaf_talker_tx_timeout(int fd_timer, int fd_sk,
     }
 
     while (expirations--) {
-        avtp_time = get_next_mclk_timestamp();
+        avtp_time = next_aaf_time;
+        next_aaf_time = get_next_aaf_time(next_aaf_time);
 
         res = avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_TIMESTAMP,
                                 avtp_time);
@@ -622,53 +583,10 @@ static int aaf_talker_tx_timeout(int fd_timer, int fd_sk,
     return 0;
 }
 
-/* This routine generates media clock timestamps using timestamps from CRF
- * stream.
- */
-static int recover_mclk(struct avtp_crf_pdu *pdu)
-{
-    int res, idx;
-    uint64_t ts_mclk, ts_crf;
-
-    /* For simplicity's sake, we consider only the first timestamp from
-     * CRF PDU to recover the media clock.
-     */
-    ts_crf = be64toh(pdu->crf_data[0]);
-
-    for (idx = 0; idx < MCLKLIST_TS_PER_CRF; idx++) {
-        ts_mclk = ts_crf + (idx * MCLK_PERIOD);
-
-        if (mode == MODE_TALKER) {
-            /* If we are operating in talker mode, the max transit
-             * time is added to the recovered timestamp, rounding
-             * it up to the nearest multiple fo the media clock.
-             */
-            ts_mclk += rounded_mtt;
-        }
-
-        if (ts_mclk <= prev_mclk_timestamp)
-            /* If the recovered timestamp is less than the
-             * timestamp from the last AAF pdu received, we discard
-             * it. This situation happens when the CRF pdu is
-             * received late and the media clock has already
-             * freewheeled.
-             */
-            continue;
-
-        res = mclk_enqueue_ts(ts_mclk);
-        if (res < 0)
-            return res;
-    }
-
-    return 0;
-}
-
-static int is_ts_aligned(uint32_t mclk_ts, uint32_t avtp_ts)
+static int is_ts_aligned(int64_t t_offset)
 {
     int n = 0;
-    int t_offset, delta_ll, delta_hl;
-
-    t_offset = avtp_ts - mclk_ts;
+    int delta_ll, delta_hl;
 
     delta_ll = (n * TIME_PERIOD_NS) - (TIME_PERIOD_NS/4);
     delta_hl = (n * TIME_PERIOD_NS) + (TIME_PERIOD_NS/4);
@@ -687,12 +605,24 @@ static int is_ts_aligned(uint32_t mclk_ts, uint32_t avtp_ts)
     return true;
 }
 
+/* Media clock timestamps are recovered from all timestamps of the CRF
+ * stream. The loop filters out the network jitter and follows the frequency
+ * of the CRF talker.
+ */
 static int handle_crf_pdu(struct avtp_crf_pdu *pdu)
 {
+    int res;
+
     if (!is_valid_crf_pdu(pdu))
         return 0;
 
-    return recover_mclk(pdu);
+    res = Avtp_MediaClock_ProcessPdu(&mclk, (Avtp_Crf_t *) pdu);
+    if (res < 0) {
+        fprintf(stderr, "Failed to recover media clock: %d\n", res);
+        return res;
+    }
+
+    return 0;
 }
 
 static int handle_aaf_pdu(struct avtp_stream_pdu *pdu)
@@ -700,7 +630,8 @@ static int handle_aaf_pdu(struct avtp_stream_pdu *pdu)
     int res;
     bool state;
     uint64_t val;
-    uint32_t avtp_time, mclk_time;
+    int64_t t_offset;
+    uint32_t avtp_time;
 
     if (!is_valid_aaf_pdu(pdu))
         return 0;
@@ -712,14 +643,17 @@ static int handle_aaf_pdu(struct avtp_stream_pdu *pdu)
     }
     avtp_time = val;
 
-    if (need_mclk_lookup) {
-        mclk_time = mclk_lookup(avtp_time);
-        need_mclk_lookup = false;
-    } else {
-        mclk_time = get_next_mclk_timestamp();
-    }
+    /* The presentation time is compared with the nearest edge of the
+     * media clock. Nothing can be checked before the first CRF PDU.
+     */
+    if (domain_name[0] != '\0')
+        res = clock_domain_align(&clock_domain, avtp_time, NULL, &t_offset);
+    else
+        res = Avtp_MediaClock_Align(&mclk, avtp_time, NULL, &t_offset);
+    if (res < 0)
+        return 0;
 
-    state = is_ts_aligned(mclk_time, avtp_time);
+    state = is_ts_aligned(t_offset);
     if (prev_state != state) {
         if (state)
             printf("AAF Stream is aligned with common media clock\n");
@@ -760,8 +694,20 @@ static int aaf_talker_recv_pdu(int fd_sk, int fd_timer)
     /* Arm the timer for the first time to start sending AAF stream. */
     if (first_aaf_pdu) {
         struct itimerspec itspec = { 0 };
-        uint64_t ts = mclk_dequeue_ts();
+        uint64_t crf_ts[TIMESTAMPS_PER_PKT], ts;
+
+        res = Avtp_Crf_GetTimestamps((Avtp_Crf_t *) pdu, crf_ts,
+                                     TIMESTAMPS_PER_PKT);
+        if (res < 0)
+            return 0;
+
+        res = Avtp_MediaClock_NextEdge(&mclk, crf_ts[0], AAF_NUM_SAMPLES,
+                                        &ts);
+        if (res < 0)
+            return 0;
 
+        ts += rounded_mtt;
+        next_aaf_time = ts;
         first_aaf_pdu = false;
 
         itspec.it_value.tv_sec = ts / NSEC_PER_SEC;
@@ -964,7 +910,7 @@ int main(int argc, char *argv[])
 
     argp_parse(&argp, argc, argv, 0, NULL, NULL);
 
-    STAILQ_INIT(&mclk_timestamps);
+    Avtp_MediaClock_Init(&mclk, AVTP_MEDIA_CLOCK_DEFAULT_BANDWIDTH);
     rounded_mtt = ceil((double)mtt / MCLK_PERIOD) * MCLK_PERIOD;
 
     fd_rx = setup_rx_socket();
@@ -973,6 +919,9 @@ int main(int argc, char *argv[])
 
     switch (mode) {
     case MODE_LISTENER:
+        if (domain_name[0] != '\0' &&
+            clock_domain_open(&clock_domain, domain_name) < 0)
+            break;
         aaf_listener(fd_rx);
         break;
     case MODE_TALKER:
@@ -194,7 +194,7 @@ static int init_pdu(struct avtp_crf_pdu *pdu)
 
 int main(int argc, char *argv[])
 {
-    int sk_fd, res, idx;
+    int sk_fd, res;
     uint8_t seq_num = 0;
     uint64_t crf_time, rounded_mtt;
     struct timespec clksrc_ts = {0};
@@ -228,8 +228,10 @@ int main(int argc, char *argv[])
         ssize_t n;
 
         crf_time = calculate_crf_timestamp(clksrc_ts, rounded_mtt);
-        for (idx = 0; idx < TIMESTAMPS_PER_PKT; idx++)
-            pdu->crf_data[idx] = htobe64(crf_time + (CRF_PERIOD * idx));
+        res = Avtp_Crf_SetTimestamps((Avtp_Crf_t *) pdu, crf_time, CRF_PERIOD,
+                                     TIMESTAMPS_PER_PKT);
+        if (res < 0)
+            goto err;
 
         res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_SEQ_NUM, seq_num++);
         if (res < 0)
@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* CVF Annex B benchmark.
+ *
+ * Measures splitting an H.264 byte-stream into NAL units, as done by
+ * cvf-talker, on a synthetic stream of 4K intra frames. Each frame is made
+ * of several slices of incompressible data with emulation prevention
+ * applied, so start codes only occur between NAL units. The stream is fed
+ * in chunks like reads from a pipe.
+ *
+ * Reported are the start code scan alone and the ring buffer splitter from
+ * avtp/cvf/AnnexB.h for every instruction set supported by the CPU, and the
+ * previous cvf-talker approach, a bytewise scan over a linear buffer that
+ * is moved down after every NAL unit.
+ *
+ * $ cvf-annexb-bench --frame-size 2048 --slices 8
+ */
+
+#include <argp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "avtp/cvf/AnnexB.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define CHUNK_SIZE		(64 * 1024)
+
+static int frame_kib = 2048;
+static int slices = 8;
+static int frames = 8;
+static int duration_ms = 500;
+
+static const char* isa_names[] = {
+    [AVTP_ANNEXB_ISA_SCALAR] = "scalar",
+    [AVTP_ANNEXB_ISA_SSE2] = "sse2",
+    [AVTP_ANNEXB_ISA_AVX2] = "avx2",
+    [AVTP_ANNEXB_ISA_NEON] = "neon",
+};
+
+static struct argp_option options[] = {
+    {"frame-size", 's', "KIB", 0, "Size of an intra frame (default 2048)" },
+    {"slices", 'n', "NUM", 0, "Slices per frame (default 8)" },
+    {"frames", 'f', "NUM", 0, "Frames in the stream (default 8)" },
+    {"duration", 'd', "MSEC", 0, "Duration of each measurement (default 500)" },
+    { 0 }
+};
+
+static error_t parser(int key, char *arg, struct argp_state *state)
+{
+    switch (key) {
+    case 's':
+        frame_kib = atoi(arg);
+        if (frame_kib < 1 || frame_kib > 65536) {
+            argp_error(state, "Frame size must be between 1 and 65536 KiB");
+        }
+        break;
+    case 'n':
+        slices = atoi(arg);
+        if (slices < 1 || slices > 1024) {
+            argp_error(state, "Slices must be between 1 and 1024");
+        }
+        break;
+    case 'f':
+        frames = atoi(arg);
+        if (frames < 1 || frames > 64) {
+            argp_error(state, "Frames must be between 1 and 64");
+        }
+        break;
+    case 'd':
+        duration_ms = atoi(arg);
+        break;
+    }
+
+    return 0;
+}
+
+static struct argp argp = { options, parser };
+
+static uint8_t *stream;
+static size_t stream_len;
+static size_t max_nal_len;
+static size_t nal_count;
+
+static uint8_t *ring;
+static size_t ring_size;
+static uint8_t *linear;
+static size_t linear_size;
+
+static uint64_t get_time_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
+
+static uint32_t seed = 1;
+
+static uint8_t rand_byte(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+/* Appends a NAL unit of len random bytes, with emulation prevention bytes
+ * inserted so the payload contains no start code.
+ */
+static void append_nal(uint8_t header, size_t len)
+{
+    size_t start, zeros = 0;
+
+    memcpy(stream + stream_len, "\x00\x00\x00\x01", 4);
+    stream_len += 4;
+    start = stream_len;
+    stream[stream_len++] = header;
+
+    for (size_t i = 1; i < len; i++) {
+        uint8_t b = rand_byte();
+
+        if (zeros >= 2 && b <= 3) {
+            stream[stream_len++] = 0x03;
+            zeros = 0;
+        }
+        stream[stream_len++] = b;
+        zeros = b == 0 ? zeros + 1 : 0;
+    }
+    /* A NAL unit does not end with a zero byte */
+    if (stream[stream_len - 1] == 0x00) {
+        stream[stream_len - 1] = 0x80;
+    }
+
+    if (stream_len - start > max_nal_len) {
+        max_nal_len = stream_len - start;
+    }
+    nal_count++;
+}
+
+static int build_stream(void)
+{
+    size_t slice_len = (size_t) frame_kib * 1024 / slices;
+
+    /* Room for emulation prevention bytes and start codes */
+    stream = malloc((size_t) frames * (frame_kib * 1024 * 2 + slices * 8 + 64));
+    if (!stream)
+        return -1;
+
+    for (int f = 0; f < frames; f++) {
+        append_nal(0x67, 24);           /* SPS */
+        append_nal(0x68, 4);            /* PPS */
+        for (int s = 0; s < slices; s++)
+            append_nal(0x65, slice_len); /* IDR slice */
+    }
+
+    /* Ring for twice the largest NAL unit, rounded to a power of two */
+    for (ring_size = 1; ring_size < 2 * max_nal_len; ring_size <<= 1)
+        ;
+    ring = malloc(ring_size);
+    linear_size = 2 * max_nal_len + CHUNK_SIZE;
+    linear = malloc(linear_size);
+    if (!ring || !linear)
+        return -1;
+
+    return 0;
+}
+
+/* Start code scan over the whole stream, returns start codes found */
+static size_t run_scan(void)
+{
+    size_t pos = 0, found = 0;
+
+    while (pos < stream_len) {
+        pos += Avtp_AnnexB_FindStartCode(stream + pos, stream_len - pos);
+        if (pos < stream_len) {
+            found++;
+            pos += 3;
+        }
+    }
+    return found;
+}
+
+/* Splitter on the ring buffer, returns NAL units found */
+static size_t run_ring(void)
+{
+    Avtp_AnnexB_Reader_t r;
+    Avtp_AnnexB_Nal_t nal;
+    size_t pos = 0, found = 0;
+
+    Avtp_AnnexB_Init(&r, ring, ring_size);
+
+    while (1) {
+        uint8_t *ptr;
+        size_t n = Avtp_AnnexB_GetWriteSpace(&r, &ptr);
+        int end;
+
+        if (n > CHUNK_SIZE)
+            n = CHUNK_SIZE;
+        if (n > stream_len - pos)
+            n = stream_len - pos;
+        memcpy(ptr, stream + pos, n);
+        Avtp_AnnexB_Commit(&r, n);
+        pos += n;
+        end = pos == stream_len;
+
+        while (Avtp_AnnexB_NextNal(&r, end, &nal) == 1)
+            found++;
+
+        if (end)
+            break;
+    }
+    return found;
+}
+
+/* Bytewise scan as formerly used by cvf-talker */
+static ssize_t start_code_position(size_t offset, size_t level)
+{
+    while (offset + 2 < level) {
+        if (linear[offset + 2] == 0x1) {
+            if (linear[offset] == 0x0 && linear[offset + 1] == 0x0)
+                return offset;
+            offset += 3;
+        } else if (linear[offset + 2] == 0x0) {
+            offset++;
+        } else {
+            offset += 3;
+        }
+    }
+
+    return -1;
+}
+
+/* Linear buffer moved down after every NAL unit, returns NAL units found */
+static size_t run_linear(void)
+{
+    size_t pos = 0, level = 0, found = 0;
+
+    while (1) {
+        size_t n = linear_size - level;
+        int end;
+
+        if (n > CHUNK_SIZE)
+            n = CHUNK_SIZE;
+        if (n > stream_len - pos)
+            n = stream_len - pos;
+        memcpy(linear + level, stream + pos, n);
+        level += n;
+        pos += n;
+        end = pos == stream_len;
+
+        while (level > 0) {
+            ssize_t start = start_code_position(0, level);
+            ssize_t next;
+
+            if (start < 0)
+                break;
+            next = start_code_position(start + 3, level);
+            if (next < 0) {
+                if (!end)
+                    break;
+                next = level;
+            }
+            found++;
+            memmove(linear, linear + next, level - next);
+            level -= next;
+        }
+
+        if (end)
+            break;
+    }
+    return found;
+}
+
+/* Runs fn repeatedly and returns the throughput in MB/s */
+static double measure(size_t (*fn)(void), size_t expected)
+{
+    uint64_t start, end, deadline, runs = 0;
+
+    if (fn() != expected) {
+        fprintf(stderr, "Found wrong number of NAL units\n");
+        exit(EXIT_FAILURE);
+    }
+
+    start = get_time_ns();
+    deadline = start + (uint64_t)duration_ms * 1000000ULL;
+    do {
+        fn();
+        runs++;
+        end = get_time_ns();
+    } while (end < deadline);
+
+    return (double)runs * stream_len * 1000.0 / (end - start);
+}
+
+int main(int argc, char *argv[])
+{
+    argp_parse(&argp, argc, argv, 0, NULL, NULL);
+
+    if (build_stream() < 0) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return 1;
+    }
+
+    printf("%zu bytes, %zu NAL units, largest %zu bytes\n", stream_len,
+           nal_count, max_nal_len);
+    printf("%-9s %12s %12s\n", "method", "scan MB/s", "split MB/s");
+
+    Avtp_AnnexB_SelectIsa(AVTP_ANNEXB_ISA_SCALAR);
+    printf("%-9s %12s %12.1f\n", "memmove", "-",
+           measure(run_linear, nal_count));
+
+    for (int isa = AVTP_ANNEXB_ISA_SCALAR; isa <= AVTP_ANNEXB_ISA_NEON; isa++) {
+        if (Avtp_AnnexB_SelectIsa(isa) < 0) {
+            continue;
+        }
+        double scan = measure(run_scan, nal_count);
+        double split = measure(run_ring, nal_count);
+        printf("%-9s %12.1f %12.1f\n", isa_names[isa], scan, split);
+    }
+
+    free(stream);
+    free(ring);
+    free(linear);
+    return 0;
+}
@@ -35,7 +35,10 @@
  * them to stdout once the presentation time is reached.
  *
  * For simplicity, this examples accepts only CVF H.264 packets, and the H.264
- * data must be composed of NAL and each NAL unit can not exceed 1400 bytes.
+ * data must be composed of single NAL unit packets or FU-A fragments
+ * (RFC 6184). Each NAL unit can not exceed MAX_NAL_SIZE bytes. NAL units are
+ * kept in a preallocated pool until presented; a NAL unit received in a
+ * single PDU is presented from the buffer it was received into.
  *
  * The H.264 data sent to output is in H.264 byte-stream format.
  *
@@ -82,16 +85,31 @@
 #define AVTP_H264_HEADER_LEN	(sizeof(Avtp_H264_t))
 #define AVTP_FULL_HEADER_LEN	(sizeof(Avtp_Cvf_t) + sizeof(Avtp_H264_t))
 #define MAX_PDU_SIZE			(AVTP_FULL_HEADER_LEN + DATA_LEN)
+#define MAX_NAL_SIZE			(256 * 1024)
+#define NAL_POOL_SIZE			32
+#define START_CODE_LEN			4
 
+/* A PDU is received into buf, so a NAL unit sent in one PDU starts at
+ * AVTP_FULL_HEADER_LEN. Fragmented NAL units are reassembled at the same
+ * offset. The start code is written over the parsed headers in front of it.
+ */
 struct nal_entry {
     STAILQ_ENTRY(nal_entry) entries;
 
-    uint16_t len;
+    uint8_t *data;
+    size_t len;
     struct timespec tspec;
-    uint8_t nal[DATA_LEN];
+    uint8_t buf[AVTP_FULL_HEADER_LEN + MAX_NAL_SIZE];
 };
 
-static STAILQ_HEAD(nal_queue, nal_entry) nals;
+STAILQ_HEAD(nal_queue, nal_entry);
+
+static struct nal_entry pool[NAL_POOL_SIZE];
+static struct nal_queue nals;
+static struct nal_queue free_nals;
+static struct nal_entry *rx_entry;
+static struct nal_entry *reassembly_entry;
+static Avtp_H264_Reassembler_t reassembler;
 static char ifname[IFNAMSIZ];
 static uint8_t macaddr[ETH_ALEN];
 static uint8_t expected_seq;
@@ -127,22 +145,33 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 
 static struct argp argp = { options, parser };
 
-static int schedule_nal(int fd, struct timespec *tspec, uint8_t *nal,
-                                ssize_t len)
+static struct nal_entry *get_free_entry(void)
 {
-    struct nal_entry *entry;
+    struct nal_entry *entry = STAILQ_FIRST(&free_nals);
 
-    entry = malloc(sizeof(*entry));
-    if (!entry) {
-        fprintf(stderr, "Failed to allocate memory\n");
-        return -1;
-    }
+    if (entry)
+        STAILQ_REMOVE_HEAD(&free_nals, entries);
+
+    return entry;
+}
 
-    entry->len = len;
-    entry->tspec.tv_sec = tspec->tv_sec;
-    entry->tspec.tv_nsec = tspec->tv_nsec;
-    memcpy(entry->nal, nal, entry->len);
+static void init_pool(void)
+{
+    int i;
 
+    STAILQ_INIT(&nals);
+    STAILQ_INIT(&free_nals);
+    for (i = 0; i < NAL_POOL_SIZE; i++)
+        STAILQ_INSERT_TAIL(&free_nals, &pool[i], entries);
+
+    rx_entry = get_free_entry();
+    reassembly_entry = get_free_entry();
+    Avtp_H264_ReassemblerInit(&reassembler,
+            reassembly_entry->buf + AVTP_FULL_HEADER_LEN, MAX_NAL_SIZE);
+}
+
+static int schedule_nal(int fd, struct nal_entry *entry)
+{
     STAILQ_INSERT_TAIL(&nals, entry, entries);
 
     /* If this was the first entry inserted onto the queue, we need to arm
@@ -151,10 +180,9 @@ static int schedule_nal(int fd, struct timespec *tspec, uint8_t *nal,
     if (STAILQ_FIRST(&nals) == entry) {
         int res;
 
-        res = arm_timer(fd, tspec);
+        res = arm_timer(fd, &entry->tspec);
         if (res < 0) {
             STAILQ_REMOVE(&nals, entry, nal_entry, entries);
-            free(entry);
             return -1;
         }
     }
@@ -216,48 +244,86 @@ static bool is_valid_packet(Avtp_Cvf_t* cvf)
     return true;
 }
 
-static uint16_t get_h264_data_len(Avtp_Cvf_t* cvf)
+static int get_h264_data_len(Avtp_Cvf_t* cvf, ssize_t pdu_len)
 {
     uint16_t stream_data_len = Avtp_Cvf_GetStreamDataLength(cvf);
+
+    if (stream_data_len < AVTP_H264_HEADER_LEN ||
+            stream_data_len > pdu_len - sizeof(Avtp_Cvf_t))
+        return -1;
+
     return stream_data_len - AVTP_H264_HEADER_LEN;
 }
 
 static int new_packet(int sk_fd, int timer_fd)
 {
-    int res;
+    int res, h264_data_len;
     ssize_t n;
-    uint16_t h264_data_len;
     uint32_t avtp_time;
-    struct timespec tspec;
-    Avtp_Cvf_t* cvf = alloca(MAX_PDU_SIZE);
+    uint64_t dropped;
+    const uint8_t *nal;
+    size_t nal_len;
+    struct nal_entry *entry;
+    Avtp_Cvf_t* cvf = (Avtp_Cvf_t*)rx_entry->buf;
     Avtp_H264_t* h264Header = (Avtp_H264_t*)(&cvf->payload);
     uint8_t* h264Payload = (uint8_t*)(&h264Header->payload);
 
-    memset(cvf, 1, MAX_PDU_SIZE);
-
     n = recv(sk_fd, cvf, MAX_PDU_SIZE, 0);
     if (n < 0 || n > MAX_PDU_SIZE) {
         perror("Failed to receive data");
         return -1;
     }
 
-    if (!is_valid_packet(cvf)) {
+    if (n < AVTP_FULL_HEADER_LEN || !is_valid_packet(cvf)) {
         fprintf(stderr, "Dropping packet\n");
         return 0;
     }
 
+    h264_data_len = get_h264_data_len(cvf, n);
+    if (h264_data_len < 0) {
+        fprintf(stderr, "Invalid stream data length, dropping packet\n");
+        return 0;
+    }
+
+    dropped = reassembler.stats.dropped_nal_units;
+    res = Avtp_H264_Reassemble(&reassembler, Avtp_Cvf_GetSequenceNum(cvf),
+                    Avtp_Cvf_GetM(cvf), h264Payload, h264_data_len,
+                    &nal, &nal_len);
+    if (reassembler.stats.dropped_nal_units != dropped)
+        fprintf(stderr, "Dropped incomplete NAL unit\n");
+    if (res <= 0)
+        return res;
+
+    /* Keep one free entry for each role, otherwise drop the NAL unit */
+    if (STAILQ_EMPTY(&free_nals)) {
+        fprintf(stderr, "NAL pool exhausted, dropping NAL unit\n");
+        return 0;
+    }
+
+    entry = nal == h264Payload ? rx_entry : reassembly_entry;
+
     avtp_time = Avtp_Cvf_GetAvtpTimestamp(cvf);
 
-    res = get_presentation_time(avtp_time, &tspec);
+    res = get_presentation_time(avtp_time, &entry->tspec);
     if (res < 0)
         return -1;
 
-    h264_data_len = get_h264_data_len(cvf);
+    entry->data = (uint8_t *) nal - START_CODE_LEN;
+    entry->len = nal_len + START_CODE_LEN;
+    memcpy(entry->data, "\x00\x00\x00\x01", START_CODE_LEN);
 
-    res = schedule_nal(timer_fd, &tspec, h264Payload, h264_data_len);
+    res = schedule_nal(timer_fd, entry);
     if (res < 0)
         return -1;
 
+    if (entry == rx_entry) {
+        rx_entry = get_free_entry();
+    } else {
+        reassembly_entry = get_free_entry();
+        Avtp_H264_ReassemblerSetBuffer(&reassembler,
+                reassembly_entry->buf + AVTP_FULL_HEADER_LEN, MAX_NAL_SIZE);
+    }
+
     return 0;
 }
 
@@ -279,12 +345,12 @@ static int timeout(int fd)
     entry = STAILQ_FIRST(&nals);
     assert(entry != NULL);
 
-    res = present_data(entry->nal, entry->len);
+    res = present_data(entry->data, entry->len);
     if (res < 0)
         return -1;
 
     STAILQ_REMOVE_HEAD(&nals, entries);
-    free(entry);
+    STAILQ_INSERT_TAIL(&free_nals, entry, entries);
 
     if (!STAILQ_EMPTY(&nals)) {
         entry = STAILQ_FIRST(&nals);
@@ -304,7 +370,7 @@ int main(int argc, char *argv[])
 
     argp_parse(&argp, argc, argv, 0, NULL, NULL);
 
-    STAILQ_INIT(&nals);
+    init_pool();
 
     sk_fd = create_listener_socket(ifname, macaddr, ETH_P_TSN);
     if (sk_fd < 0)
@@ -34,8 +34,10 @@
  * an H.264 byte-stream from stdin, creates CVF packets and transmit them via
  * network.
  *
- * For simplicity, this example supports only NAL units in byte-stream format,
- * and each NAL unit can not exceed 1400 bytes.
+ * For simplicity, this example supports only NAL units in byte-stream format.
+ * NAL units larger than a PDU are split into FU-A fragments (RFC 6184), and
+ * each NAL unit can not exceed MAX_NAL_SIZE bytes. PDUs are sent with
+ * sendmsg(), gathering headers and NAL data without copying the NAL data.
  *
  * TSN stream parameters (e.g. destination mac address, traffic priority) are
  * passed via command-line arguments. Run 'cvf-talker --help' for more
@@ -59,22 +61,23 @@
  *  | cvf-talker <args>
  *
  * Note that the `x264enc` may be changed by any other H.264 encoder
- * available, as long as it generates a byte-stream with NAL units no longer
- * than 1400 bytes.
+ * available, as long as it generates a byte-stream.
  */
 
-#include <alloca.h>
 #include <argp.h>
 #include <arpa/inet.h>
-#include <assert.h>
+#include <errno.h>
 #include <linux/if.h>
 #include <linux/if_ether.h>
 #include <linux/if_packet.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include "avtp/cvf/AnnexB.h"
 #include "avtp/cvf/Cvf.h"
 #include "avtp/cvf/H264.h"
 #include "common/common.h"
@@ -84,19 +87,28 @@
 #define DATA_LEN				1400
 #define AVTP_H264_HEADER_LEN	(sizeof(Avtp_H264_t))
 #define AVTP_FULL_HEADER_LEN	(sizeof(Avtp_Cvf_t) + sizeof(Avtp_H264_t))
-#define MAX_PDU_SIZE			(AVTP_FULL_HEADER_LEN + DATA_LEN)
+#define MAX_NAL_SIZE			(256 * 1024)
+#define RING_SIZE				(2 * MAX_NAL_SIZE)
 
 static char ifname[IFNAMSIZ];
 static uint8_t macaddr[ETH_ALEN];
 static int priority = -1;
 static int max_transit_time;
 
-static char buffer[MAX_PDU_SIZE * 2];
-static size_t buffer_level;
+/* The byte-stream is read into a ring and split into NAL units in place.
+ * Only a NAL unit that wraps around the end of the ring is copied.
+ */
+static uint8_t ring[RING_SIZE];
+static uint8_t wrapped_nal[MAX_NAL_SIZE];
+static Avtp_AnnexB_Reader_t reader;
 
 static uint8_t seq_num;
 
-enum process_result {PROCESS_OK, PROCESS_NONE, PROCESS_ERROR};
+/* PDUs are sent with sendmsg(), gathering the headers and the NAL data from
+ * where they are. The headers, including the FU header of a fragment, are
+ * updated in place for each PDU.
+ */
+static uint8_t header[AVTP_FULL_HEADER_LEN + AVTP_H264_FU_HEADER_LEN];
 
 static struct argp_option options[] = {
     {"dst-addr", 'd', "MACADDR", 0, "Stream Destination MAC address" },
@@ -157,44 +169,58 @@ static int init_pdu(Avtp_Cvf_t* cvf)
 static ssize_t fill_buffer(void)
 {
     ssize_t n;
+    uint8_t *ptr;
+    size_t space;
+
+    space = Avtp_AnnexB_GetWriteSpace(&reader, &ptr);
 
-    n = read(STDIN_FILENO, buffer + buffer_level,
-                    sizeof(buffer) - buffer_level);
+    n = read(STDIN_FILENO, ptr, space);
     if (n < 0) {
         perror("Could not read from standard input");
+        return -1;
     }
 
-    buffer_level += n;
+    Avtp_AnnexB_Commit(&reader, n);
 
     return n;
 }
 
-static ssize_t start_code_position(size_t offset)
+static Avtp_Cvf_t* prepare_header(uint32_t avtp_time,
+                                Avtp_H264_Fragment_t *frag)
 {
-    assert(offset < buffer_level);
-
-    /* Simplified Boyer-Moore, inspired by gstreamer */
-    while (offset < buffer_level - 2) {
-        if (buffer[offset + 2] == 0x1) {
-            if (buffer[offset] == 0x0 && buffer[offset + 1] == 0x0)
-                return offset;
-            offset += 3;
-        } else if (buffer[offset + 2] == 0x0) {
-            offset++;
-        } else {
-            offset += 3;
-        }
-    }
+    Avtp_Cvf_t* cvfHeader = (Avtp_Cvf_t*) header;
+    Avtp_H264_t* h264Header = (Avtp_H264_t*)(&cvfHeader->payload);
+    uint8_t* h264Payload = (uint8_t*)(&h264Header->payload);
+
+    Avtp_Cvf_SetField(cvfHeader, AVTP_CVF_FIELD_AVTP_TIMESTAMP, avtp_time);
+    Avtp_Cvf_SetField(cvfHeader, AVTP_CVF_FIELD_SEQUENCE_NUM, seq_num++);
+    Avtp_Cvf_SetField(cvfHeader, AVTP_CVF_FIELD_M, frag->last);
+    Avtp_Cvf_SetField(cvfHeader, AVTP_CVF_FIELD_STREAM_DATA_LENGTH,
+            frag->header_len + frag->data_len + AVTP_H264_HEADER_LEN);
+
+    memcpy(h264Payload, frag->header, frag->header_len);
 
-    return -1;
+    return cvfHeader;
 }
 
-static int prepare_packet(Avtp_Cvf_t* cvfHeader, char *nal_data, size_t nal_data_len)
+/* Sends a NAL unit in one PDU, or in FU-A fragments if it does not fit.
+ * All PDUs of a NAL unit carry the same presentation time.
+ */
+static int send_nal(int fd, struct sockaddr_ll *sk_addr,
+                                const uint8_t *nal, size_t nal_len)
 {
     int res;
+    ssize_t n;
+    size_t offset = 0;
     uint32_t avtp_time;
-    Avtp_H264_t* h264Header = (Avtp_H264_t*)(&cvfHeader->payload);
-    uint8_t* h264Payload = (uint8_t*)(&h264Header->payload);
+    Avtp_H264_Fragment_t frag;
+    struct iovec iov[2];
+    struct msghdr msg = {
+        .msg_name = sk_addr,
+        .msg_namelen = sizeof(*sk_addr),
+        .msg_iov = iov,
+        .msg_iovlen = 2,
+    };
 
     res = calculate_avtp_time(&avtp_time, max_transit_time);
     if (res < 0) {
@@ -202,68 +228,64 @@ static int prepare_packet(Avtp_Cvf_t* cvfHeader, char *nal_data, size_t nal_data
         return -1;
     }
 
-    Avtp_Cvf_SetField(cvfHeader, AVTP_CVF_FIELD_AVTP_TIMESTAMP, avtp_time);
-    Avtp_Cvf_SetField(cvfHeader, AVTP_CVF_FIELD_SEQUENCE_NUM, seq_num++);
-    Avtp_Cvf_SetField(cvfHeader, AVTP_CVF_FIELD_STREAM_DATA_LENGTH, nal_data_len + AVTP_H264_HEADER_LEN);
-
-    memcpy(h264Payload, nal_data, nal_data_len);
+    while ((res = Avtp_H264_NextFragment(nal, nal_len, &offset, DATA_LEN,
+                                                &frag)) == 1) {
+        iov[0].iov_base = prepare_header(avtp_time, &frag);
+        iov[0].iov_len = AVTP_FULL_HEADER_LEN + frag.header_len;
+        iov[1].iov_base = (void *) frag.data;
+        iov[1].iov_len = frag.data_len;
+
+        n = sendmsg(fd, &msg, 0);
+        if (n < 0) {
+            perror("Failed to send data");
+            return -1;
+        }
+    }
 
-    return 0;
+    return res;
 }
 
-static int process_nal(Avtp_Cvf_t* pdu, bool process_last,
-                            size_t* nal_len)
+static int process_nals(int fd, struct sockaddr_ll *sk_addr,
+                            bool process_last)
 {
     int res;
-    ssize_t start, end;
-
-    *nal_len = 0;
+    size_t len;
+    const uint8_t *data;
+    Avtp_AnnexB_Nal_t nal;
+
+    while ((res = Avtp_AnnexB_NextNal(&reader, process_last, &nal)) == 1) {
+        len = nal.len + nal.wrap_len;
+        if (len > MAX_NAL_SIZE) {
+            fprintf(stderr, "NAL length bigger than expected. Expected %u, "
+                        "found %zu\n", MAX_NAL_SIZE, len);
+            return -1;
+        }
 
-    start = start_code_position(0);
-    if (start == -1) {
-        fprintf(stderr, "Unable to find NAL start\n");
-        return PROCESS_NONE;
-    }
-    /* Now, let's find where the next starts. This is where current ends */
-    end = start_code_position(start + 1);
-    if (end == -1) {
-        if (process_last == false) {
-            return PROCESS_NONE;
-        } else {
-            end = buffer_level;
+        data = nal.data;
+        if (nal.wrap_len > 0) {
+            memcpy(wrapped_nal, nal.data, nal.len);
+            memcpy(wrapped_nal + nal.len, nal.wrap_data, nal.wrap_len);
+            data = wrapped_nal;
         }
-    }
 
-    *nal_len = end - start;
-    if (*nal_len > DATA_LEN) {
-        fprintf(stderr, "NAL length bigger than expected. Expected %u, "
-                    "found %zd\n", DATA_LEN, *nal_len);
-        goto err;
+        res = send_nal(fd, sk_addr, data, len);
+        if (res < 0)
+            return -1;
     }
 
-    /* Sets AVTP packet headers and content - the NAL unit */
-    res = prepare_packet(pdu, &buffer[start], *nal_len);
-    if (res < 0) {
-        goto err;
+    if (res == -ENOSPC) {
+        fprintf(stderr, "NAL length bigger than expected. Expected %u\n",
+                    MAX_NAL_SIZE);
+        return -1;
     }
 
-    /* Finally, let's offset any remaining data on the buffer to the
-     * beginning. Not really efficient, but keep things simple */
-    memmove(buffer, buffer + end, buffer_level - end);
-    buffer_level -= end;
-
-    return PROCESS_OK;
-
-err:
-    return PROCESS_ERROR;
+    return res;
 }
 
 int main(int argc, char *argv[])
 {
     int fd, res;
     struct sockaddr_ll sk_addr;
-    uint8_t* pdu = alloca(MAX_PDU_SIZE);
-    Avtp_Cvf_t* cvf = (Avtp_Cvf_t*)pdu;
 
     argp_parse(&argp, argc, argv, 0, NULL, NULL);
 
@@ -275,33 +297,25 @@ int main(int argc, char *argv[])
     if (res < 0)
         goto err;
 
-    res = init_pdu(cvf);
+    res = init_pdu((Avtp_Cvf_t*) header);
     if (res < 0)
         goto err;
 
+    Avtp_AnnexB_Init(&reader, ring, sizeof(ring));
+
     while (1) {
         ssize_t n;
         bool end = false;
 
         n = fill_buffer();
+        if (n < 0)
+            goto err;
         if (n == 0)
             end = true;
 
-        while (buffer_level > 0) {
-            enum process_result pr =
-                    process_nal(cvf, end, (size_t *)&n);
-            if (pr == PROCESS_ERROR)
-                goto err;
-            if (pr == PROCESS_NONE)
-                break;
-
-            n = sendto(fd, pdu, AVTP_FULL_HEADER_LEN + n, 0,
-                (struct sockaddr *) &sk_addr, sizeof(sk_addr));
-            if (n < 0) {
-                perror("Failed to send data");
-                goto err;
-            }
-        }
+        res = process_nals(fd, &sk_addr, end);
+        if (res < 0)
+            goto err;
 
         if (end)
             break;
@@ -30,8 +30,11 @@
 
 #ifdef LINUX_KERNEL1722
 #include <linux/types.h>
+#include <linux/string.h>
 #else
 #include <stdint.h>
+#include <stddef.h>
+#include <string.h>
 #endif
 
 #ifdef __cplusplus
@@ -103,6 +106,44 @@ static inline uint32_t Avtp_BeToCpu32(uint32_t x) { return x; }
 static inline uint64_t Avtp_BeToCpu64(uint64_t x) { return x; }
 #endif
 
+/**
+ * Swap the byteorder of an array of 16bit integers. Source and destination
+ * may be unaligned and may be the same buffer, but must not partially overlap.
+ * On x86 and ARM the swap is done with SIMD byte shuffles selected at runtime.
+ *
+ * @param dst Destination buffer of count 16bit elements.
+ * @param src Source buffer of count 16bit elements.
+ * @param count Number of elements to swap.
+ */
+void Avtp_BswapArray16(void* dst, const void* src, size_t count);
+
+/**
+ * Swap the byteorder of an array of 32bit integers or floats.
+ * See Avtp_BswapArray16.
+ */
+void Avtp_BswapArray32(void* dst, const void* src, size_t count);
+
+/**
+ * Swap the byteorder of an array of 64bit integers or doubles.
+ * See Avtp_BswapArray16.
+ */
+void Avtp_BswapArray64(void* dst, const void* src, size_t count);
+
+#if(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+static inline void Avtp_BeToCpuArray16(void* dst, const void* src, size_t count) { Avtp_BswapArray16(dst, src, count); }
+static inline void Avtp_BeToCpuArray32(void* dst, const void* src, size_t count) { Avtp_BswapArray32(dst, src, count); }
+static inline void Avtp_BeToCpuArray64(void* dst, const void* src, size_t count) { Avtp_BswapArray64(dst, src, count); }
+#else
+static inline void Avtp_BeToCpuArray16(void* dst, const void* src, size_t count) { memmove(dst, src, count * 2); }
+static inline void Avtp_BeToCpuArray32(void* dst, const void* src, size_t count) { memmove(dst, src, count * 4); }
+static inline void Avtp_BeToCpuArray64(void* dst, const void* src, size_t count) { memmove(dst, src, count * 8); }
+#endif
+
+/* Conversions are symmetric, the aliases only document the direction. */
+#define Avtp_CpuToBeArray16 Avtp_BeToCpuArray16
+#define Avtp_CpuToBeArray32 Avtp_BeToCpuArray32
+#define Avtp_CpuToBeArray64 Avtp_BeToCpuArray64
+
 #ifdef __cplusplus
 }
 #endif
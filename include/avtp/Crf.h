@@ -31,6 +31,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "avtp/Utils.h"
 
@@ -40,6 +41,9 @@ extern "C" {
 
 #define AVTP_CRF_HEADER_LEN     (5 * AVTP_QUADLET_SIZE)
 
+/* Most timestamps a crf_data_length field can describe. */
+#define AVTP_CRF_MAX_TIMESTAMPS (UINT16_MAX / sizeof(uint64_t))
+
 typedef struct Avtp_Cvf {
     uint8_t header[AVTP_CRF_HEADER_LEN];
     uint8_t payload[0];
@@ -118,6 +122,46 @@ void Avtp_Crf_SetBaseFrequency(Avtp_Crf_t* pdu, uint32_t value);
 void Avtp_Crf_SetCrfDataLength(Avtp_Crf_t* pdu, uint16_t value);
 void Avtp_Crf_SetTimestampInterval(Avtp_Crf_t* pdu, uint16_t value);
 
+/**
+ * Fills the payload of a CRF PDU with evenly spaced timestamps and sets
+ * crf_data_length accordingly. The timestamps are converted to network
+ * byte order in bulk.
+ *
+ * @param pdu CRF PDU with a non-zero timestamp_interval and room for count
+ * timestamps.
+ * @param base First timestamp in ns.
+ * @param period Time between timestamps in ns.
+ * @param count Number of timestamps, at most AVTP_CRF_MAX_TIMESTAMPS.
+ * @returns 0 on success, -EINVAL for invalid arguments.
+ */
+int Avtp_Crf_SetTimestamps(Avtp_Crf_t* pdu, uint64_t base, uint64_t period,
+                           size_t count);
+
+/**
+ * Copies timestamps into the payload of a CRF PDU and sets crf_data_length
+ * accordingly. See Avtp_Crf_SetTimestamps.
+ *
+ * @param pdu CRF PDU with a non-zero timestamp_interval and room for count
+ * timestamps.
+ * @param timestamps Timestamps in ns.
+ * @param count Number of timestamps, at most AVTP_CRF_MAX_TIMESTAMPS.
+ * @returns 0 on success, -EINVAL for invalid arguments.
+ */
+int Avtp_Crf_SetTimestampArray(Avtp_Crf_t* pdu, const uint64_t* timestamps,
+                               size_t count);
+
+/**
+ * Reads all timestamps from the payload of a CRF PDU.
+ *
+ * @param pdu CRF PDU.
+ * @param timestamps Receives the timestamps in ns.
+ * @param max_count Capacity of timestamps.
+ * @returns Number of timestamps read, -EINVAL for invalid arguments, if
+ * crf_data_length is zero or not a multiple of 8, if timestamp_interval is
+ * zero or if the PDU holds more than max_count timestamps.
+ */
+int Avtp_Crf_GetTimestamps(Avtp_Crf_t* pdu, uint64_t* timestamps, size_t max_count);
+
 /******************************************************************************
  * Legacy API (deprecated)
  *****************************************************************************/
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * @file
+ * Media clock recovery from CRF streams. Every CRF timestamp is fed to a
+ * second order delay-locked loop (DLL) which filters the network jitter out
+ * of the timestamps and tracks the frequency of the talker's media clock.
+ * The recovered clock is kept as the time of one media clock edge and the
+ * period between edges, so the time of any edge is predicted with a single
+ * multiplication. All state lives in Avtp_MediaClock_t; nothing is allocated.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "avtp/Crf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default loop bandwidth in Hz. */
+#define AVTP_MEDIA_CLOCK_DEFAULT_BANDWIDTH      1.0
+
+/**
+ * State of a media clock recovered from a CRF stream.
+ */
+typedef struct {
+    /* Nominal clock, from the CRF header */
+    uint32_t base_frequency;
+    uint8_t pull;
+    uint16_t timestamp_interval;        /* Media clock edges per timestamp */
+    double nominal_period;              /* ns per media clock edge */
+
+    /* Loop filter */
+    double bandwidth;                   /* Loop bandwidth in Hz */
+    double b, c;                        /* Phase and frequency gains */
+
+    /* Recovered clock */
+    uint8_t locked;
+    uint64_t anchor;                    /* Time of edge number 'edge', in ns */
+    double anchor_frac;                 /* Fractional ns of anchor, in [0, 1) */
+    int64_t edge;                       /* Edges counted since the clock locked */
+    double period;                      /* Recovered ns per media clock edge */
+    double phase_error;                 /* Error of the last timestamp in ns */
+
+    /* Statistics */
+    uint32_t timestamps;                /* Timestamps fed to the loop */
+    uint32_t stale;                     /* Timestamps not newer than the clock */
+    uint32_t relocks;                   /* Phase jumps that restarted the loop */
+} Avtp_MediaClock_t;
+
+/**
+ * Initializes a media clock. It has to be configured, explicitly or by the
+ * first CRF PDU, before timestamps can be added.
+ *
+ * @param clk Media clock to be initialized.
+ * @param bandwidth Loop bandwidth in Hz. Lower values filter more jitter but
+ * follow frequency changes more slowly.
+ * @returns 0 on success, -EINVAL for invalid arguments.
+ */
+int Avtp_MediaClock_Init(Avtp_MediaClock_t* clk, double bandwidth);
+
+/**
+ * Sets the nominal frequency of the media clock. The clock is unlocked if
+ * the configuration changes.
+ *
+ * @param clk Media clock.
+ * @param base_frequency Base frequency in Hz, as in the CRF header.
+ * @param pull Multiplier modifier of the base frequency, AVTP_CRF_PULL_*.
+ * @param timestamp_interval Number of media clock edges between timestamps.
+ * @returns 0 on success, -EINVAL for invalid arguments or a bandwidth too
+ * high for the timestamp rate.
+ */
+int Avtp_MediaClock_Configure(Avtp_MediaClock_t* clk, uint32_t base_frequency,
+                              uint8_t pull, uint16_t timestamp_interval);
+
+/**
+ * Unlocks the media clock. The next timestamp restarts the loop.
+ *
+ * @param clk Media clock.
+ */
+void Avtp_MediaClock_Reset(Avtp_MediaClock_t* clk);
+
+/**
+ * Feeds one CRF timestamp to the loop. Timestamps are expected in order,
+ * timestamp_interval edges apart; lost timestamps are bridged, older ones
+ * are ignored and a phase jump of more than a quarter of the timestamp
+ * interval restarts the loop.
+ *
+ * @param clk Media clock.
+ * @param timestamp Timestamp in ns.
+ * @returns 0 on success, -EINVAL if the clock is not configured.
+ */
+int Avtp_MediaClock_AddTimestamp(Avtp_MediaClock_t* clk, uint64_t timestamp);
+
+/**
+ * Feeds all timestamps of a CRF PDU to the loop. The clock is configured
+ * from the base_frequency, pull and timestamp_interval fields, and
+ * restarted when the tu field is set.
+ *
+ * @param clk Media clock.
+ * @param pdu CRF PDU with crf_data_length bytes of timestamps.
+ * @returns 0 on success, -EINVAL for invalid arguments or header fields.
+ */
+int Avtp_MediaClock_ProcessPdu(Avtp_MediaClock_t* clk, Avtp_Crf_t* pdu);
+
+/**
+ * Predicts the first media clock edge at or after a given time.
+ *
+ * @param clk Media clock.
+ * @param time Time in ns.
+ * @param divider Only edges whose number since the clock locked is a
+ * multiple of divider are considered, e.g. the number of frames per AAF
+ * PDU. 1 for every edge.
+ * @param edge_time Receives the time of the edge in ns, rounded to the
+ * nearest ns.
+ * @returns 0 on success, -EAGAIN if the clock is not locked, -EINVAL for
+ * invalid arguments.
+ */
+int Avtp_MediaClock_NextEdge(Avtp_MediaClock_t* clk, uint64_t time,
+                             uint32_t divider, uint64_t* edge_time);
+
+/**
+ * Aligns a 32-bit AVTP timestamp, e.g. the presentation time of an AAF PDU,
+ * with the media clock. The timestamp is expanded to 64 bits around the
+ * recovered clock, so it must lie within about 2 seconds of the last CRF
+ * timestamp; no history of timestamps is needed.
+ *
+ * @param clk Media clock.
+ * @param avtp_time AVTP timestamp, the lower 32 bits of the time in ns.
+ * @param edge_time Receives the time of the nearest media clock edge in ns,
+ * or NULL.
+ * @param phase_error Receives the offset of the timestamp from that edge in
+ * ns, at most half a period either way, or NULL.
+ * @returns 0 on success, -EAGAIN if the clock is not locked, -EINVAL for
+ * invalid arguments.
+ */
+int Avtp_MediaClock_Align(Avtp_MediaClock_t* clk, uint32_t avtp_time,
+                          uint64_t* edge_time, int64_t* phase_error);
+
+#ifdef __cplusplus
+}
+#endif
@@ -67,6 +67,20 @@ uint64_t Avtp_GetField(const Avtp_FieldDescriptor_t* fieldDescriptors,
 void Avtp_SetField(const Avtp_FieldDescriptor_t* fieldDescriptors,
         uint8_t numFields, uint8_t* pdu, uint8_t field, uint64_t value);
 
+/**
+ * Expands a 32-bit AVTP timestamp to 64 bits. The AVTP timestamp wraps every
+ * ~4.29s, so the result is the 64-bit time closest to a reference time, i.e.
+ * timestamps up to ~2.1s before or after the reference are expanded correctly.
+ *
+ * @param avtpTime 32-bit AVTP timestamp in ns.
+ * @param reference 64-bit reference time in ns, typically the current time.
+ * @returns The 64-bit time in ns matching the AVTP timestamp.
+ */
+static inline uint64_t Avtp_ExpandTimestamp(uint32_t avtpTime, uint64_t reference)
+{
+    return reference + (uint64_t) (int64_t) (int32_t) (avtpTime - (uint32_t) reference);
+}
+
 #ifdef __cplusplus
 }
 #endif
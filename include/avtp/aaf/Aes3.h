@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * @file
+ * Encoding and decoding of the payload of AAF AES3 streams
+ * (AVTP_AAF_FORMAT_AES3_32BIT). Each AES3 subframe is carried as a 32-bit
+ * big-endian word holding the time slots of the subframe in order:
+ *
+ *   bits 31-28: preamble (slots 0-3), one of Avtp_Aes3Preamble_t
+ *   bits 27-4:  audio word including auxiliary bits (slots 4-27), MSB first
+ *   bit 3:      validity (V)
+ *   bit 2:      user data (U)
+ *   bit 1:      channel status (C)
+ *   bit 0:      even parity over slots 4-31 (P)
+ *
+ * Channels are grouped in AES3 pairs: even channels carry the X preamble,
+ * or Z on the first frame of a 192 frame block, and odd channels carry Y.
+ * The channel status and user data of each channel are 24 byte blocks
+ * transmitted one bit per frame, starting with bit 0 of byte 0.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "avtp/aaf/PcmSamples.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AVTP_AES3_BLOCK_FRAMES          192
+#define AVTP_AES3_BLOCK_LEN             (AVTP_AES3_BLOCK_FRAMES / 8)
+
+/** Size of the work buffer of an Avtp_Aes3Decoder_t for a channel count. */
+#define AVTP_AES3_DECODER_WORK_SIZE(channels)   ((channels) * 2 * AVTP_AES3_BLOCK_LEN)
+
+typedef enum {
+    AVTP_AES3_PREAMBLE_X = 1,
+    AVTP_AES3_PREAMBLE_Y = 2,
+    AVTP_AES3_PREAMBLE_Z = 3,
+} Avtp_Aes3Preamble_t;
+
+/**
+ * State of an AES3 encoder. Channel status and user data blocks continue
+ * across calls to Avtp_Aes3_Encode, so a block may span several PDUs.
+ */
+typedef struct {
+    uint16_t channels;
+    uint8_t frame;                      /* Frame index within the block */
+    uint8_t validity;                   /* V bit of all subframes */
+    const uint8_t* channel_status;      /* 24 bytes per channel */
+    const uint8_t* user_data;           /* 24 bytes per channel or NULL */
+} Avtp_Aes3Encoder_t;
+
+/**
+ * State of an AES3 decoder. Channel status and user data blocks are
+ * assembled across calls to Avtp_Aes3_Decode; a block is only output if it
+ * started with a Z preamble and was received completely.
+ */
+typedef struct {
+    uint16_t channels;
+    uint8_t locked;                     /* A Z preamble has been seen */
+    uint8_t frame;                      /* Frame index within the block */
+    uint8_t* work;                      /* Blocks being assembled */
+    uint8_t* channel_status;            /* 24 bytes per channel */
+    uint8_t* user_data;                 /* 24 bytes per channel or NULL */
+
+    /* Statistics */
+    uint32_t blocks;                    /* Complete blocks received */
+    uint32_t parity_errors;             /* Subframes with wrong parity */
+    uint32_t crc_errors;                /* Professional blocks with bad CRCC */
+    uint32_t sync_errors;               /* Z preambles at the wrong frame */
+    uint32_t invalid;                   /* Subframes with the V bit set */
+} Avtp_Aes3Decoder_t;
+
+/**
+ * Initializes an AES3 encoder.
+ *
+ * @param enc Encoder to be initialized.
+ * @param channels Number of channels per frame.
+ * @param channel_status Channel status blocks, 24 bytes per channel. Read
+ * while encoding, so changes take effect at the next frame.
+ * @param user_data User data blocks, 24 bytes per channel, or NULL to send
+ * zero user bits.
+ * @returns 0 on success, -EINVAL for invalid arguments.
+ */
+int Avtp_Aes3_InitEncoder(Avtp_Aes3Encoder_t* enc, uint16_t channels,
+                          const uint8_t* channel_status, const uint8_t* user_data);
+
+/**
+ * Encodes interleaved samples into AES3 subframes.
+ *
+ * @param enc Encoder.
+ * @param payload Destination payload, 4 bytes per sample.
+ * @param samples Interleaved MSB-justified 32-bit samples, of which the 24
+ * MSBs are sent. Also used for non-PCM data words with the V bit set.
+ * @param frames Number of frames to encode.
+ * @returns Number of payload bytes written, -EINVAL for invalid arguments.
+ */
+int Avtp_Aes3_Encode(Avtp_Aes3Encoder_t* enc, void* payload,
+                     const int32_t* samples, size_t frames);
+
+/**
+ * Initializes an AES3 decoder.
+ *
+ * @param dec Decoder to be initialized.
+ * @param channels Number of channels per frame.
+ * @param work Buffer of AVTP_AES3_DECODER_WORK_SIZE(channels) bytes.
+ * @param channel_status Receives the last complete channel status blocks,
+ * 24 bytes per channel.
+ * @param user_data Receives the last complete user data blocks, 24 bytes per
+ * channel, or NULL.
+ * @returns 0 on success, -EINVAL for invalid arguments.
+ */
+int Avtp_Aes3_InitDecoder(Avtp_Aes3Decoder_t* dec, uint16_t channels,
+                          uint8_t* work, uint8_t* channel_status,
+                          uint8_t* user_data);
+
+/**
+ * Decodes AES3 subframes into interleaved samples and assembles channel
+ * status and user data blocks. Subframes with parity errors are decoded
+ * anyway and counted.
+ *
+ * @param dec Decoder.
+ * @param samples Interleaved MSB-justified 32-bit samples, the 8 LSBs are 0.
+ * @param payload Source payload, 4 bytes per sample.
+ * @param frames Number of frames to decode.
+ * @returns Number of blocks completed by this call, -EINVAL for invalid
+ * arguments.
+ */
+int Avtp_Aes3_Decode(Avtp_Aes3Decoder_t* dec, int32_t* samples,
+                     const void* payload, size_t frames);
+
+/**
+ * Computes the CRCC (byte 23) of a professional channel status block.
+ *
+ * @param block Channel status block of 24 bytes.
+ * @returns CRC of bytes 0 to 22.
+ */
+uint8_t Avtp_Aes3_CalcCrc(const uint8_t* block);
+
+/**
+ * Selects the instruction set of the subframe kernels, independently of the
+ * PCM sample conversion. By default the best instruction set supported by
+ * the CPU is selected on first use. Mainly intended for tests and benchmarks.
+ *
+ * @param isa Instruction set, AVTP_PCM_ISA_AUTO for the best available.
+ * @returns 0 on success, -ENOTSUP if the CPU or build does not support isa.
+ */
+int Avtp_Aes3_SelectIsa(Avtp_PcmIsa_t isa);
+
+/**
+ * Returns the instruction set currently used by the subframe kernels.
+ */
+Avtp_PcmIsa_t Avtp_Aes3_GetIsa(void);
+
+#ifdef __cplusplus
+}
+#endif
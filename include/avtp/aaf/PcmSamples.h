@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * @file
+ * Conversion between host PCM buffers and the payload of AAF PCM streams.
+ * The payload carries big-endian, MSB-justified samples of the size given by
+ * the AAF 'format' field, interleaved by channel.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "avtp/aaf/Pcm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Sample types of host PCM buffers. Integer samples use their full range,
+ * float samples the range [-1.0, 1.0).
+ */
+typedef enum {
+    AVTP_PCM_SAMPLE_INT16 = 0,
+    AVTP_PCM_SAMPLE_INT32,
+    AVTP_PCM_SAMPLE_FLOAT,
+} Avtp_PcmSampleType_t;
+
+/**
+ * Instruction set used by the conversion kernels.
+ */
+typedef enum {
+    AVTP_PCM_ISA_AUTO = 0,
+    AVTP_PCM_ISA_SCALAR,
+    AVTP_PCM_ISA_SSSE3,
+    AVTP_PCM_ISA_AVX2,
+    AVTP_PCM_ISA_NEON,
+} Avtp_PcmIsa_t;
+
+/**
+ * Returns the number of payload bytes of a single sample.
+ *
+ * @param format AAF format, one of the INT_16BIT, INT_24BIT, INT_32BIT and
+ * FLOAT_32BIT formats.
+ * @returns Sample size in bytes, 0 for unsupported formats.
+ */
+uint8_t Avtp_PcmSamples_GetSampleSize(Avtp_AafFormat_t format);
+
+/**
+ * Converts interleaved host samples into an AAF payload. Samples with a
+ * bit_depth below the sample size of the format are truncated and their
+ * unused LSBs cleared.
+ *
+ * @param payload Destination payload.
+ * @param format AAF format of the payload.
+ * @param bit_depth AAF bit depth of the payload.
+ * @param src Interleaved host samples.
+ * @param src_type Sample type of src.
+ * @param channels Number of channels per frame.
+ * @param frames Number of frames to convert.
+ * @returns Number of payload bytes written, -EINVAL for invalid arguments.
+ */
+int Avtp_PcmSamples_PackInterleaved(void* payload, Avtp_AafFormat_t format,
+                                    uint8_t bit_depth, const void* src,
+                                    Avtp_PcmSampleType_t src_type,
+                                    uint16_t channels, size_t frames);
+
+/**
+ * Converts planar host samples, one buffer per channel, into an AAF payload.
+ * See Avtp_PcmSamples_PackInterleaved.
+ *
+ * @param src Array of channels pointers to the host samples of each channel.
+ */
+int Avtp_PcmSamples_PackPlanar(void* payload, Avtp_AafFormat_t format,
+                               uint8_t bit_depth, const void* const src[],
+                               Avtp_PcmSampleType_t src_type,
+                               uint16_t channels, size_t frames);
+
+/**
+ * Converts an AAF payload into interleaved host samples.
+ *
+ * @param dst Interleaved host samples.
+ * @param dst_type Sample type of dst.
+ * @param payload Source payload.
+ * @param format AAF format of the payload.
+ * @param channels Number of channels per frame.
+ * @param frames Number of frames to convert.
+ * @returns Number of payload bytes read, -EINVAL for invalid arguments.
+ */
+int Avtp_PcmSamples_UnpackInterleaved(void* dst, Avtp_PcmSampleType_t dst_type,
+                                      const void* payload, Avtp_AafFormat_t format,
+                                      uint16_t channels, size_t frames);
+
+/**
+ * Converts an AAF payload into planar host samples, one buffer per channel.
+ * See Avtp_PcmSamples_UnpackInterleaved.
+ *
+ * @param dst Array of channels pointers to the host samples of each channel.
+ */
+int Avtp_PcmSamples_UnpackPlanar(void* const dst[], Avtp_PcmSampleType_t dst_type,
+                                 const void* payload, Avtp_AafFormat_t format,
+                                 uint16_t channels, size_t frames);
+
+/**
+ * Converts planar host samples into selected channels of an AAF payload.
+ * Channels of the payload that are not in the map are left unchanged, so a
+ * payload can be filled from several sources.
+ *
+ * @param payload Destination payload of channels channels per frame.
+ * @param format AAF format of the payload.
+ * @param bit_depth AAF bit depth of the payload.
+ * @param src Array of map_len pointers to the host samples of each mapped
+ * channel.
+ * @param src_type Sample type of src.
+ * @param channels Number of channels per frame of the payload.
+ * @param map Payload channel of each host buffer.
+ * @param map_len Number of mapped channels.
+ * @param frames Number of frames to convert.
+ * @returns Number of payload bytes spanned by the frames, -EINVAL for invalid
+ * arguments.
+ */
+int Avtp_PcmSamples_PackChannels(void* payload, Avtp_AafFormat_t format,
+                                 uint8_t bit_depth, const void* const src[],
+                                 Avtp_PcmSampleType_t src_type, uint16_t channels,
+                                 const uint16_t map[], uint16_t map_len,
+                                 size_t frames);
+
+/**
+ * Converts selected channels of an AAF payload into planar host samples,
+ * without touching the other channels. Intended for listeners that render
+ * a few channels of a wide stream.
+ *
+ * @param dst Array of map_len pointers to the host buffers.
+ * @param dst_type Sample type of dst.
+ * @param payload Source payload of channels channels per frame.
+ * @param format AAF format of the payload.
+ * @param channels Number of channels per frame of the payload.
+ * @param map Payload channel copied to each host buffer.
+ * @param map_len Number of mapped channels.
+ * @param frames Number of frames to convert.
+ * @returns Number of payload bytes spanned by the frames, -EINVAL for invalid
+ * arguments.
+ */
+int Avtp_PcmSamples_UnpackChannels(void* const dst[], Avtp_PcmSampleType_t dst_type,
+                                   const void* payload, Avtp_AafFormat_t format,
+                                   uint16_t channels, const uint16_t map[],
+                                   uint16_t map_len, size_t frames);
+
+/**
+ * Converts planar host samples into selected channels of an AAF PCM PDU,
+ * using the format, bit depth and channels of its header.
+ * See Avtp_PcmSamples_PackChannels.
+ *
+ * @param pdu AAF PCM PDU with an initialized header.
+ * @returns Number of payload bytes spanned by the frames, -EINVAL for invalid
+ * arguments.
+ */
+int Avtp_PcmSamples_InsertChannels(Avtp_Pcm_t* pdu, const void* const src[],
+                                   Avtp_PcmSampleType_t src_type,
+                                   const uint16_t map[], uint16_t map_len,
+                                   size_t frames);
+
+/**
+ * Converts selected channels of a received AAF PCM PDU into planar host
+ * samples. The number of frames is derived from the stream data length.
+ * See Avtp_PcmSamples_UnpackChannels.
+ *
+ * @param pdu Received AAF PCM PDU.
+ * @returns Number of frames written to each host buffer, -EINVAL for invalid
+ * arguments.
+ */
+int Avtp_PcmSamples_ExtractChannels(Avtp_Pcm_t* pdu, void* const dst[],
+                                    Avtp_PcmSampleType_t dst_type,
+                                    const uint16_t map[], uint16_t map_len);
+
+/**
+ * Selects the instruction set of the conversion kernels. By default the best
+ * instruction set supported by the CPU is selected on first use. Mainly
+ * intended for tests and benchmarks. Byteorder swaps always use the kernels
+ * of Avtp_BswapArray16/32.
+ *
+ * @param isa Instruction set, AVTP_PCM_ISA_AUTO for the best available.
+ * @returns 0 on success, -ENOTSUP if the CPU or build does not support isa.
+ */
+int Avtp_PcmSamples_SelectIsa(Avtp_PcmIsa_t isa);
+
+/**
+ * Returns the instruction set currently used by the conversion kernels.
+ */
+Avtp_PcmIsa_t Avtp_PcmSamples_GetIsa(void);
+
+#ifdef __cplusplus
+}
+#endif
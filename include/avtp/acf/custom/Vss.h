@@ -209,6 +209,44 @@ typedef union vss_data {
     VssDataStringArray_t* data_string_array;
 } VssData_t;
 
+/**
+ * Zero-copy view of the data field of an ACF VSS PDU. The data pointer refers
+ * into the PDU itself. Multi-byte numeric elements are left in the byte-order
+ * they were received in (see big_endian) and are only converted on access.
+ */
+typedef struct vss_data_view {
+    Vss_Datatype_t datatype;
+    uint8_t* data;          // First byte of the value (after any length field)
+    uint16_t data_length;   // Length of the value in bytes
+    uint16_t count;         // Number of elements (1 for scalars)
+    uint8_t element_size;   // Size of a single element in bytes
+    uint8_t big_endian;     // 1 if elements need a byte-order conversion
+} VssDataView_t;
+
+/**
+ * Layout of an ACF VSS message as determined by Avtp_Vss_Parse. The header
+ * fields are decoded once and the offsets of the variable-length path and
+ * data fields are cached, so a receiver does not need to walk the message
+ * again for every accessor. VSS Brief messages, decoded by
+ * Avtp_VssBrief_Parse, are described by the same layout. They carry no
+ * msg_timestamp; if mtv is set, the message time is given by the AVTP
+ * timestamp of the enclosing TSCF stream.
+ */
+typedef struct avtp_vss_layout {
+    uint8_t* pdu;           // First byte of the ACF VSS message
+    uint16_t msg_length;    // Length of the message in bytes (incl. padding)
+    uint8_t header_length;  // Length of the fixed header: VSS or VSS Brief
+    uint8_t mtv;
+    Vss_AddrMode_t addr_mode;
+    Vss_OpCode_t op;
+    Vss_Datatype_t datatype;
+    uint64_t msg_timestamp;
+    uint16_t path_offset;   // Offset of the path field from pdu
+    uint16_t path_length;   // Length of the path field (incl. length field)
+    uint16_t data_offset;   // Offset of the data field from pdu
+    uint16_t data_length;   // Length of the data field (incl. length field)
+} Avtp_VssLayout_t;
+
 /**
  * Initializes an ACF VSS PDU header as specified in the VSS - IEEE 1722
  * Mapping Specification.
@@ -263,6 +301,122 @@ uint16_t Avtp_Vss_CalcVssPathLength (Avtp_Vss_t* pdu);
 void Avtp_Vss_DeserializeStringArray(VssDataStringArray_t* vss_data_string_array,
                                      VssDataString_t* strings[],
                                      uint16_t num_strings);
+
+/**
+ * Calculates the number of bytes the data field of a VSS message occupies,
+ * including the length field of strings and arrays.
+ *
+ * @param datatype VSS datatype of the value.
+ * @param val Value as passed to Avtp_Vss_SetVssData.
+ * @returns Length of the data field in bytes, 0 if the datatype is not known.
+ */
+uint16_t Avtp_Vss_CalcVssDataLength(Vss_Datatype_t datatype, VssData_t* val);
+
+/**
+ * Returns the VSS path without copying it. In interop mode the path pointer
+ * refers into the PDU and is not NUL terminated.
+ *
+ * @param pdu Pointer to the first bit of an 1722 ACF VSS PDU.
+ * @param val Path to fill. Its interop path pointer is overwritten.
+ */
+void Avtp_Vss_GetVssPathView(Avtp_Vss_t* pdu, VssPath_t* val);
+
+/**
+ * Returns a view on the data field of an ACF VSS PDU without copying or
+ * converting the payload. Scalars, strings and numeric arrays are all
+ * described as a span of elements; for string arrays the span covers the
+ * serialized array and count is the number of strings it contains.
+ *
+ * @param pdu Pointer to the first bit of an 1722 ACF VSS PDU.
+ * @param view View to fill.
+ * @returns 0 on success, -EINVAL if the datatype is not known.
+ */
+int Avtp_Vss_GetVssDataView(Avtp_Vss_t* pdu, VssDataView_t* view);
+
+/**
+ * Returns element idx of a numeric view converted to host byte-order. The
+ * raw bits are returned zero-extended; signed, float and double values can
+ * be recovered by casting or memcpy'ing to the respective type.
+ *
+ * @param view View returned by Avtp_Vss_GetVssDataView.
+ * @param idx Index of the element. Must be smaller than view->count.
+ * @returns Raw element value in host byte-order.
+ */
+uint64_t Avtp_Vss_GetViewElement(const VssDataView_t* view, uint16_t idx);
+
+/**
+ * Copies the elements of a view into a caller provided buffer converting
+ * them to host byte-order.
+ *
+ * @param view View returned by Avtp_Vss_GetVssDataView.
+ * @param dst Destination buffer of at least max_elements elements.
+ * @param max_elements Capacity of dst in elements.
+ * @returns Number of elements copied.
+ */
+uint16_t Avtp_Vss_CopyViewData(const VssDataView_t* view, void* dst,
+                               uint16_t max_elements);
+
+/**
+ * Iterates over the strings of a VSS_STRING_ARRAY view without copying them.
+ *
+ * @param view View returned by Avtp_Vss_GetVssDataView.
+ * @param offset Iterator state. Must be set to 0 before the first call.
+ * @param str Set to point at the next string within the PDU.
+ * @returns 1 if a string was returned, 0 at the end of the array.
+ */
+int Avtp_Vss_NextStringView(const VssDataView_t* view, uint16_t* offset,
+                            VssDataString_t* str);
+
+/**
+ * Decodes the header of an ACF VSS message in a single pass and validates
+ * that the path and data fields lie within the message and within len bytes.
+ *
+ * @param pdu Pointer to the first bit of a 1722 ACF VSS PDU.
+ * @param len Number of bytes available at pdu.
+ * @param layout Filled with the decoded header and the field offsets.
+ * @returns 0 on success, -EINVAL if the message is malformed or truncated.
+ */
+int Avtp_Vss_Parse(Avtp_Vss_t* pdu, uint16_t len, Avtp_VssLayout_t* layout);
+
+/**
+ * Decodes a VSS message with the given header length. Used by
+ * Avtp_Vss_Parse and Avtp_VssBrief_Parse: VSS and VSS Brief share the ACF
+ * message type and only differ in the header preceding the path.
+ *
+ * @param pdu Pointer to the first bit of the message.
+ * @param len Number of bytes available at pdu.
+ * @param header_length AVTP_VSS_FIXED_HEADER_LEN or AVTP_VSS_BRIEF_HEADER_LEN.
+ * @param layout Filled with the decoded header and the field offsets.
+ * @returns 0 on success, -EINVAL if the message is malformed or truncated.
+ */
+int Avtp_Vss_ParseLayout(uint8_t* pdu, uint16_t len, uint8_t header_length,
+                         Avtp_VssLayout_t* layout);
+
+/**
+ * Returns the VSS path of a parsed message. In interop mode the path string
+ * points into the PDU and is not NUL-terminated.
+ *
+ * @param layout Layout filled by Avtp_Vss_Parse.
+ * @param val Set to the VSS path.
+ */
+void Avtp_VssLayout_GetVssPath(const Avtp_VssLayout_t* layout, VssPath_t* val);
+
+/**
+ * Returns a zero-copy view of the data field of a parsed message.
+ *
+ * @param layout Layout filled by Avtp_Vss_Parse.
+ * @param view Filled with the view of the data field.
+ */
+void Avtp_VssLayout_GetVssDataView(const Avtp_VssLayout_t* layout, VssDataView_t* view);
+
+/**
+ * Decodes the data field of a parsed message, see Avtp_Vss_GetVssData.
+ *
+ * @param layout Layout filled by Avtp_Vss_Parse.
+ * @param val Destination of the decoded value.
+ */
+void Avtp_VssLayout_GetVssData(const Avtp_VssLayout_t* layout, VssData_t* val);
+
 void Avtp_Vss_SetAcfMsgType(Avtp_Vss_t* pdu, Avtp_AcfMsgType_t val);
 void Avtp_Vss_SetAcfMsgLength(Avtp_Vss_t* pdu, uint8_t val);
 void Avtp_Vss_SetPad(Avtp_Vss_t* pdu, uint8_t val);
@@ -274,6 +428,29 @@ void Avtp_Vss_SetDatatype(Avtp_Vss_t* pdu, Vss_Datatype_t val);
 void Avtp_Vss_SetMsgTimestamp(Avtp_Vss_t* pdu, uint64_t val);
 void Avtp_Vss_SetVssPath(Avtp_Vss_t* pdu, VssPath_t* val);
 void Avtp_Vss_SetVssData(Avtp_Vss_t* pdu, VssData_t* val);
+
+/**
+ * Writes the path field of a VSS message. Used by VSS and VSS Brief, which
+ * only differ in the header preceding the path.
+ *
+ * @param vss_path_ptr First byte of the path field.
+ * @param addr_mode Addressing mode of the message.
+ * @param val VSS path.
+ */
+void Avtp_Vss_SerializeVssPath(uint8_t* vss_path_ptr, Vss_AddrMode_t addr_mode,
+                               VssPath_t* val);
+
+/**
+ * Writes the data field of a VSS message, including the length field of
+ * strings and arrays.
+ *
+ * @param vss_data_ptr First byte of the data field.
+ * @param datatype VSS datatype of the value.
+ * @param val Value to be written.
+ */
+void Avtp_Vss_SerializeVssData(uint8_t* vss_data_ptr, Vss_Datatype_t datatype,
+                               VssData_t* val);
+
 void Avtp_Vss_SerializeStringArray(VssDataStringArray_t* vss_data_string_array,
                                    VssDataString_t* strings[],
                                    uint16_t num_strings);
@@ -38,12 +38,15 @@
 #include <stdint.h>
 
 #include "avtp/Defines.h"
+#include "avtp/acf/custom/Vss.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define AVTP_VSS_BRIEF_HEADER_LEN   (1 * AVTP_QUADLET_SIZE)
+// VSS Brief uses the ACF message type of VSS. Whether a stream carries VSS
+// or VSS Brief messages is part of its configuration.
 #define AVTP_ACF_TYPE_VSS_BRIEF     0x42
 
 typedef struct {
@@ -99,6 +102,45 @@ uint64_t Avtp_VssBrief_GetField(Avtp_VssBrief_t* vss_pdu, Avtp_VssBriefFields_t
  */
 void Avtp_VssBrief_SetField(Avtp_VssBrief_t* vss_pdu, Avtp_VssBriefFields_t field, uint64_t value);
 
+/**
+ * Sets the VSS path of an ACF VSS Brief PDU. The addressing mode must be set
+ * before.
+ *
+ * @param vss_pdu Pointer to the first bit of an 1722 ACF VSS Brief PDU.
+ * @param val VSS path.
+ */
+void Avtp_VssBrief_SetVssPath(Avtp_VssBrief_t* vss_pdu, VssPath_t* val);
+
+/**
+ * Sets the VSS data of an ACF VSS Brief PDU. The addressing mode, path and
+ * datatype must be set before.
+ *
+ * @param vss_pdu Pointer to the first bit of an 1722 ACF VSS Brief PDU.
+ * @param val Value to be written.
+ */
+void Avtp_VssBrief_SetVssData(Avtp_VssBrief_t* vss_pdu, VssData_t* val);
+
+/**
+ * Decodes the header of an ACF VSS Brief message into the layout used for
+ * VSS messages, see Avtp_Vss_Parse. The msg_timestamp of the layout is 0.
+ *
+ * @param vss_pdu Pointer to the first bit of an 1722 ACF VSS Brief PDU.
+ * @param len Number of bytes available at vss_pdu.
+ * @param layout Filled with the decoded header and the field offsets.
+ * @returns 0 on success, -EINVAL if the message is malformed or truncated.
+ */
+int Avtp_VssBrief_Parse(Avtp_VssBrief_t* vss_pdu, uint16_t len,
+                        Avtp_VssLayout_t* layout);
+
+/**
+ * Pads an ACF VSS Brief PDU to a multiple of quadlets and sets the ACF
+ * message length and pad fields.
+ *
+ * @param vss_pdu Pointer to the first bit of an 1722 ACF VSS Brief PDU.
+ * @param vss_length Length of the message in bytes without padding.
+ */
+void Avtp_VssBrief_Pad(Avtp_VssBrief_t* vss_pdu, uint16_t vss_length);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Splits an H.264 Annex B byte stream into NAL units. */
+
+/* Length of the start code prefix 00 00 01 */
+#define AVTP_ANNEXB_START_CODE_LEN 3
+
+/* Byte stream buffered in a ring, written by the caller */
+typedef struct Avtp_AnnexB_Reader {
+    uint8_t* buf;
+    size_t mask;
+    /* Positions in the stream, the ring index is position & mask */
+    uint64_t head;      /* End of the written data */
+    uint64_t tail;      /* Start of the data still in use */
+    uint64_t nal;       /* Start of the current NAL unit */
+    uint64_t next;      /* Start code following the current NAL unit */
+    uint64_t scan;      /* Start codes before this position are found */
+    uint8_t in_nal;
+    uint8_t returned;
+} Avtp_AnnexB_Reader_t;
+
+/* NAL unit in the ring. It wraps to the start of the ring if wrap_len is not
+ * zero.
+ */
+typedef struct Avtp_AnnexB_Nal {
+    const uint8_t* data;
+    size_t len;
+    const uint8_t* wrap_data;
+    size_t wrap_len;
+} Avtp_AnnexB_Nal_t;
+
+/**
+ * Instruction set used by the start code search.
+ */
+typedef enum {
+    AVTP_ANNEXB_ISA_AUTO = 0,
+    AVTP_ANNEXB_ISA_SCALAR,
+    AVTP_ANNEXB_ISA_SSE2,
+    AVTP_ANNEXB_ISA_AVX2,
+    AVTP_ANNEXB_ISA_NEON,
+} Avtp_AnnexBIsa_t;
+
+/**
+ * Selects the instruction set of the start code search. By default the best
+ * instruction set supported by the CPU is selected on first use. Mainly
+ * intended for tests and benchmarks.
+ *
+ * @param isa Instruction set, AVTP_ANNEXB_ISA_AUTO for the best available.
+ * @returns 0 on success, -ENOTSUP if the CPU or build does not support isa.
+ */
+int Avtp_AnnexB_SelectIsa(Avtp_AnnexBIsa_t isa);
+
+/**
+ * Returns the instruction set currently used by the start code search.
+ */
+Avtp_AnnexBIsa_t Avtp_AnnexB_GetIsa(void);
+
+/**
+ * Finds the next start code prefix (00 00 01), see Avtp_AnnexB_SelectIsa().
+ *
+ * @param data Bytes to search.
+ * @param len Length of data.
+ * @returns Offset of the first start code prefix, len if there is none.
+ */
+size_t Avtp_AnnexB_FindStartCode(const uint8_t* data, size_t len);
+
+/**
+ * Initializes a reader.
+ *
+ * @param r Reader.
+ * @param buf Ring buffer, at least twice the largest NAL unit.
+ * @param size Size of buf, a power of two.
+ * @returns 0 on success, -EINVAL for invalid arguments.
+ */
+int Avtp_AnnexB_Init(Avtp_AnnexB_Reader_t* r, uint8_t* buf, size_t size);
+
+/**
+ * Returns the contiguous free space of the ring for the caller to write
+ * stream data into, followed by Avtp_AnnexB_Commit().
+ *
+ * @param r Reader.
+ * @param ptr Receives the start of the free space.
+ * @returns Number of bytes that can be written at ptr.
+ */
+size_t Avtp_AnnexB_GetWriteSpace(Avtp_AnnexB_Reader_t* r, uint8_t** ptr);
+
+/**
+ * Adds bytes written into the free space to the stream.
+ *
+ * @param r Reader.
+ * @param len Number of bytes written, at most the write space.
+ */
+void Avtp_AnnexB_Commit(Avtp_AnnexB_Reader_t* r, size_t len);
+
+/**
+ * Returns the next NAL unit, without start code and trailing zero bytes. The
+ * NAL unit is not copied and stays valid until the next call, which releases
+ * its space in the ring. Bytes before the first start code are discarded.
+ *
+ * @param r Reader.
+ * @param flush Set at the end of the stream, so the last NAL unit is returned
+ * without a following start code.
+ * @param nal Receives the NAL unit.
+ * @returns 1 if a NAL unit was returned, 0 if more data is needed, -ENOSPC
+ * if the ring is full without the end of a NAL unit, -EINVAL for invalid
+ * arguments.
+ */
+int Avtp_AnnexB_NextNal(Avtp_AnnexB_Reader_t* r, int flush,
+                        Avtp_AnnexB_Nal_t* nal);
+
+#ifdef __cplusplus
+}
+#endif
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "avtp/Utils.h"
@@ -39,6 +40,11 @@ extern "C" {
 
 #define AVTP_H246_HEADER_LEN (1 * AVTP_QUADLET_SIZE)
 
+/* NAL unit type of fragmentation units A (RFC 6184, section 5.8) */
+#define AVTP_H264_NAL_TYPE_FU_A 28
+/* Length of the FU indicator and FU header */
+#define AVTP_H264_FU_HEADER_LEN 2
+
 typedef struct Avtp_H264 {
     uint8_t header[AVTP_H246_HEADER_LEN];
     uint8_t payload[0];
@@ -51,6 +57,35 @@ typedef enum Avtp_H264Field {
     AVTP_H264_FIELD_MAX,
 } Avtp_H264Field_t;
 
+/* Payload of one PDU carrying a NAL unit or a fragment of it */
+typedef struct Avtp_H264_Fragment {
+    /* FU indicator and FU header, for FU-A fragments only */
+    uint8_t header[AVTP_H264_FU_HEADER_LEN];
+    /* Length of header, 0 for single NAL unit packets */
+    uint8_t header_len;
+    /* Set if this fragment completes the NAL unit */
+    uint8_t last;
+    /* NAL unit bytes following header */
+    const uint8_t* data;
+    size_t data_len;
+} Avtp_H264_Fragment_t;
+
+/* Reassembles FU-A fragments into NAL units */
+typedef struct Avtp_H264_Reassembler {
+    uint8_t* buf;
+    size_t size;
+    size_t len;
+    uint8_t in_progress;
+    uint8_t seq_valid;
+    uint8_t expected_seq;
+    struct {
+        uint64_t nal_units;
+        uint64_t fragmented;
+        uint64_t lost_pdus;
+        uint64_t dropped_nal_units;
+    } stats;
+} Avtp_H264_Reassembler_t;
+
 void Avtp_H264_Init(Avtp_H264_t* pdu);
 
 uint64_t Avtp_H264_GetField(Avtp_H264_t* pdu, Avtp_H264Field_t field);
@@ -59,6 +94,68 @@ uint32_t Avtp_H264_GetTimestamp(Avtp_H264_t* pdu);
 void Avtp_H264_SetField(Avtp_H264_t* pdu, Avtp_H264Field_t field, uint64_t value);
 void Avtp_H264_SetTimestamp(Avtp_H264_t* pdu, uint32_t value);
 
+/**
+ * Splits a NAL unit into the payloads of consecutive PDUs. A NAL unit that
+ * fits into max_len is sent as a single NAL unit packet, otherwise it is
+ * split into FU-A fragments (RFC 6184, section 5.8). The NAL unit bytes are
+ * not copied, so the caller may gather header and data into the PDU.
+ *
+ * @param nal NAL unit, without start code.
+ * @param nal_len Length of the NAL unit.
+ * @param offset Bytes of the NAL unit consumed by previous fragments, 0 on
+ * the first call. Advanced past the returned fragment.
+ * @param max_len Maximum H.264 payload length of a PDU, more than
+ * AVTP_H264_FU_HEADER_LEN.
+ * @param frag Receives the next fragment.
+ * @returns 1 if a fragment was returned, 0 if the NAL unit is complete,
+ * -EINVAL for invalid arguments.
+ */
+int Avtp_H264_NextFragment(const uint8_t* nal, size_t nal_len, size_t* offset,
+                           size_t max_len, Avtp_H264_Fragment_t* frag);
+
+/**
+ * Initializes a reassembler.
+ *
+ * @param r Reassembler.
+ * @param buf Buffer for fragmented NAL units.
+ * @param size Size of buf, the largest NAL unit that can be reassembled.
+ */
+void Avtp_H264_ReassemblerInit(Avtp_H264_Reassembler_t* r, uint8_t* buf,
+                               size_t size);
+
+/**
+ * Replaces the reassembly buffer, e.g. with a free one after a reassembled
+ * NAL unit was queued for presentation. Any NAL unit in progress is dropped.
+ *
+ * @param r Reassembler.
+ * @param buf Buffer for fragmented NAL units.
+ * @param size Size of buf.
+ */
+void Avtp_H264_ReassemblerSetBuffer(Avtp_H264_Reassembler_t* r, uint8_t* buf,
+                                    size_t size);
+
+/**
+ * Processes the H.264 payload of a CVF PDU. A NAL unit received in a single
+ * PDU is returned in place, without copying. FU-A fragments are collected in
+ * the reassembly buffer. A gap in the sequence numbers or a PDU with the M bit
+ * set that does not end the NAL unit drops the NAL unit in progress. A repeat
+ * of the previous PDU is ignored.
+ *
+ * @param r Reassembler.
+ * @param seq_num sequence_num of the CVF PDU.
+ * @param m M bit of the CVF PDU.
+ * @param payload H.264 payload of the PDU, following the H.264 header.
+ * @param len Length of payload.
+ * @param nal Receives the NAL unit, pointing into payload or the reassembly
+ * buffer.
+ * @param nal_len Receives the length of the NAL unit.
+ * @returns 1 if a NAL unit is complete, 0 if more fragments are needed or the
+ * PDU was dropped, -EINVAL for invalid arguments.
+ */
+int Avtp_H264_Reassemble(Avtp_H264_Reassembler_t* r, uint8_t seq_num,
+                         uint8_t m, const uint8_t* payload, size_t len,
+                         const uint8_t** nal, size_t* nal_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifdef LINUX_KERNEL1722
+#include <linux/string.h>
+#else
+#include <string.h>
+#endif
+
+#include "avtp/Byteorder.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(LINUX_KERNEL1722) && !defined(__ZEPHYR__)
+#define AVTP_BSWAP_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && !defined(LINUX_KERNEL1722) && !defined(__ZEPHYR__)
+#define AVTP_BSWAP_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef void (*Avtp_BswapArrayFn_t)(uint8_t* dst, const uint8_t* src, size_t count);
+
+/*
+ * Scalar kernels. They go through memcpy so that neither buffer needs to be
+ * aligned; they also handle the tail left over by the SIMD kernels.
+ */
+static void BswapArray16Scalar(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    uint16_t val;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(&val, src + i * 2, sizeof(val));
+        val = Avtp_Bswap16(val);
+        memcpy(dst + i * 2, &val, sizeof(val));
+    }
+}
+
+static void BswapArray32Scalar(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    uint32_t val;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(&val, src + i * 4, sizeof(val));
+        val = Avtp_Bswap32(val);
+        memcpy(dst + i * 4, &val, sizeof(val));
+    }
+}
+
+static void BswapArray64Scalar(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    uint64_t val;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(&val, src + i * 8, sizeof(val));
+        val = Avtp_Bswap64(val);
+        memcpy(dst + i * 8, &val, sizeof(val));
+    }
+}
+
+#if defined(AVTP_BSWAP_X86)
+
+/*
+ * Shuffle masks reversing the bytes of each 2, 4 and 8 byte element within a
+ * 16 byte lane. AVX2 shuffles each 128bit lane separately so the same masks
+ * are broadcast to both lanes.
+ */
+static const uint8_t Avtp_BswapMask[3][16] = {
+    { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },
+    { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+    { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 },
+};
+
+__attribute__((target("ssse3")))
+static size_t BswapArraySsse3(uint8_t* dst, const uint8_t* src, size_t bytes,
+                              const uint8_t* mask_bytes)
+{
+    const __m128i mask = _mm_loadu_si128((const __m128i*) mask_bytes);
+    size_t i = 0;
+
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + i));
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t BswapArrayAvx2(uint8_t* dst, const uint8_t* src, size_t bytes,
+                             const uint8_t* mask_bytes)
+{
+    const __m256i mask = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128((const __m128i*) mask_bytes));
+    size_t i = 0;
+
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (src + i));
+        _mm256_storeu_si256((__m256i*) (dst + i), _mm256_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+
+#define DEFINE_X86_KERNELS(bits, size, idx)                                     \
+static void BswapArray##bits##Ssse3(uint8_t* dst, const uint8_t* src,          \
+                                    size_t count)                               \
+{                                                                               \
+    size_t done = BswapArraySsse3(dst, src, count * size, Avtp_BswapMask[idx]); \
+    BswapArray##bits##Scalar(dst + done, src + done, count - done / size);      \
+}                                                                               \
+static void BswapArray##bits##Avx2(uint8_t* dst, const uint8_t* src,           \
+                                   size_t count)                                \
+{                                                                               \
+    size_t done = BswapArrayAvx2(dst, src, count * size, Avtp_BswapMask[idx]);  \
+    done += BswapArraySsse3(dst + done, src + done, count * size - done,        \
+                            Avtp_BswapMask[idx]);                               \
+    BswapArray##bits##Scalar(dst + done, src + done, count - done / size);      \
+}
+
+DEFINE_X86_KERNELS(16, 2, 0)
+DEFINE_X86_KERNELS(32, 4, 1)
+DEFINE_X86_KERNELS(64, 8, 2)
+
+#elif defined(AVTP_BSWAP_NEON)
+
+static void BswapArray16Neon(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        vst1q_u8(dst + i * 2, vrev16q_u8(vld1q_u8(src + i * 2)));
+    }
+    BswapArray16Scalar(dst + i * 2, src + i * 2, count - i);
+}
+
+static void BswapArray32Neon(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u8(dst + i * 4, vrev32q_u8(vld1q_u8(src + i * 4)));
+    }
+    BswapArray32Scalar(dst + i * 4, src + i * 4, count - i);
+}
+
+static void BswapArray64Neon(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        vst1q_u8(dst + i * 8, vrev64q_u8(vld1q_u8(src + i * 8)));
+    }
+    BswapArray64Scalar(dst + i * 8, src + i * 8, count - i);
+}
+
+#endif
+
+static void BswapArray16Resolve(uint8_t* dst, const uint8_t* src, size_t count);
+static void BswapArray32Resolve(uint8_t* dst, const uint8_t* src, size_t count);
+static void BswapArray64Resolve(uint8_t* dst, const uint8_t* src, size_t count);
+
+/*
+ * The kernels are resolved on first use. Concurrent first calls may all
+ * resolve, which is harmless as every caller stores the same function
+ * pointer; the pointers are accessed atomically so that this is not a data
+ * race.
+ */
+static Avtp_BswapArrayFn_t BswapArray16Fn = BswapArray16Resolve;
+static Avtp_BswapArrayFn_t BswapArray32Fn = BswapArray32Resolve;
+static Avtp_BswapArrayFn_t BswapArray64Fn = BswapArray64Resolve;
+
+static void StoreKernels(Avtp_BswapArrayFn_t fn16, Avtp_BswapArrayFn_t fn32,
+                         Avtp_BswapArrayFn_t fn64)
+{
+    __atomic_store_n(&BswapArray16Fn, fn16, __ATOMIC_RELAXED);
+    __atomic_store_n(&BswapArray32Fn, fn32, __ATOMIC_RELAXED);
+    __atomic_store_n(&BswapArray64Fn, fn64, __ATOMIC_RELAXED);
+}
+
+static void ResolveKernels(void)
+{
+#if defined(AVTP_BSWAP_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        StoreKernels(BswapArray16Avx2, BswapArray32Avx2, BswapArray64Avx2);
+        return;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        StoreKernels(BswapArray16Ssse3, BswapArray32Ssse3, BswapArray64Ssse3);
+        return;
+    }
+#elif defined(AVTP_BSWAP_NEON)
+    StoreKernels(BswapArray16Neon, BswapArray32Neon, BswapArray64Neon);
+    return;
+#endif
+    StoreKernels(BswapArray16Scalar, BswapArray32Scalar, BswapArray64Scalar);
+}
+
+static void BswapArray16Resolve(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    ResolveKernels();
+    Avtp_BswapArray16(dst, src, count);
+}
+
+static void BswapArray32Resolve(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    ResolveKernels();
+    Avtp_BswapArray32(dst, src, count);
+}
+
+static void BswapArray64Resolve(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    ResolveKernels();
+    Avtp_BswapArray64(dst, src, count);
+}
+
+void Avtp_BswapArray16(void* dst, const void* src, size_t count)
+{
+    Avtp_BswapArrayFn_t fn = __atomic_load_n(&BswapArray16Fn, __ATOMIC_RELAXED);
+    fn((uint8_t*) dst, (const uint8_t*) src, count);
+}
+
+void Avtp_BswapArray32(void* dst, const void* src, size_t count)
+{
+    Avtp_BswapArrayFn_t fn = __atomic_load_n(&BswapArray32Fn, __ATOMIC_RELAXED);
+    fn((uint8_t*) dst, (const uint8_t*) src, count);
+}
+
+void Avtp_BswapArray64(void* dst, const void* src, size_t count)
+{
+    Avtp_BswapArrayFn_t fn = __atomic_load_n(&BswapArray64Fn, __ATOMIC_RELAXED);
+    fn((uint8_t*) dst, (const uint8_t*) src, count);
+}
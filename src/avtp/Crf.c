@@ -32,6 +32,7 @@
 #include <errno.h>
 
 #include "avtp/Crf.h"
+#include "avtp/Byteorder.h"
 #include "avtp/Utils.h"
 #include "avtp/CommonHeader.h"
 
@@ -231,6 +232,64 @@ void Avtp_Crf_SetTimestampInterval(Avtp_Crf_t* pdu, uint16_t value)
     SET_FIELD(AVTP_CRF_FIELD_TIMESTAMP_INTERVAL, value);
 }
 
+/* Timestamps generated on the stack before being swapped into the payload */
+#define AVTP_CRF_TIMESTAMP_CHUNK    64
+
+int Avtp_Crf_SetTimestamps(Avtp_Crf_t* pdu, uint64_t base, uint64_t period,
+                           size_t count)
+{
+    uint64_t chunk[AVTP_CRF_TIMESTAMP_CHUNK];
+    size_t n;
+
+    if (pdu == NULL || count == 0 || count > AVTP_CRF_MAX_TIMESTAMPS ||
+        Avtp_Crf_GetTimestampInterval(pdu) == 0) {
+        return -EINVAL;
+    }
+
+    for (size_t i = 0; i < count; i += n) {
+        n = count - i < AVTP_CRF_TIMESTAMP_CHUNK ? count - i : AVTP_CRF_TIMESTAMP_CHUNK;
+        for (size_t j = 0; j < n; j++) {
+            chunk[j] = base + (i + j) * period;
+        }
+        Avtp_CpuToBeArray64(pdu->payload + i * sizeof(uint64_t), chunk, n);
+    }
+    Avtp_Crf_SetCrfDataLength(pdu, count * sizeof(uint64_t));
+    return 0;
+}
+
+int Avtp_Crf_SetTimestampArray(Avtp_Crf_t* pdu, const uint64_t* timestamps,
+                               size_t count)
+{
+    if (pdu == NULL || timestamps == NULL || count == 0 ||
+        count > AVTP_CRF_MAX_TIMESTAMPS || Avtp_Crf_GetTimestampInterval(pdu) == 0) {
+        return -EINVAL;
+    }
+
+    Avtp_CpuToBeArray64(pdu->payload, timestamps, count);
+    Avtp_Crf_SetCrfDataLength(pdu, count * sizeof(uint64_t));
+    return 0;
+}
+
+int Avtp_Crf_GetTimestamps(Avtp_Crf_t* pdu, uint64_t* timestamps, size_t max_count)
+{
+    uint16_t len;
+    size_t count;
+
+    if (pdu == NULL || timestamps == NULL) {
+        return -EINVAL;
+    }
+
+    len = Avtp_Crf_GetCrfDataLength(pdu);
+    count = len / sizeof(uint64_t);
+    if (len == 0 || len % sizeof(uint64_t) != 0 || count > max_count ||
+        Avtp_Crf_GetTimestampInterval(pdu) == 0) {
+        return -EINVAL;
+    }
+
+    Avtp_BeToCpuArray64(timestamps, pdu->payload, count);
+    return count;
+}
+
 /******************************************************************************
  * Legacy API
  *****************************************************************************/
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "avtp/MediaClock.h"
+#include "avtp/Byteorder.h"
+#include "avtp/Utils.h"
+
+#define NSEC_PER_SEC            1000000000.0
+#define PI                      3.14159265358979323846
+
+/* Gaps longer than this restart the loop instead of being bridged */
+#define MAX_GAP_NS              NSEC_PER_SEC
+
+/* Timestamps converted from network byte order at once */
+#define TIMESTAMP_CHUNK         64
+
+/* Timestamp period multipliers of the CRF pull field, i.e. 1 / pull */
+static const double pull_period[] = {
+    [AVTP_CRF_PULL_MULT_BY_1] = 1.0,
+    [AVTP_CRF_PULL_MULT_BY_1_OVER_1_001] = 1.001,
+    [AVTP_CRF_PULL_MULT_BY_1_001] = 1.0 / 1.001,
+    [AVTP_CRF_PULL_MULT_BY_24_OVER_25] = 25.0 / 24.0,
+    [AVTP_CRF_PULL_MULT_BY_25_OVER_24] = 24.0 / 25.0,
+    [AVTP_CRF_PULL_MULT_BY_1_OVER_8] = 8.0,
+};
+
+/* Rounding without libm, which is not available on every target */
+static int64_t FloorToInt(double x)
+{
+    int64_t i = (int64_t) x;
+
+    return (double) i > x ? i - 1 : i;
+}
+
+static int64_t CeilToInt(double x)
+{
+    return -FloorToInt(-x);
+}
+
+static int64_t RoundToInt(double x)
+{
+    return FloorToInt(x + 0.5);
+}
+
+/* Time from the anchor edge to a timestamp, valid across wraparound */
+static double TimeSinceAnchor(const Avtp_MediaClock_t* clk, uint64_t time)
+{
+    return (double) (int64_t) (time - clk->anchor) - clk->anchor_frac;
+}
+
+static void MoveAnchor(Avtp_MediaClock_t* clk, double delta, int64_t edges)
+{
+    double frac = clk->anchor_frac + delta;
+    int64_t whole = FloorToInt(frac);
+
+    clk->anchor += (uint64_t) whole;
+    clk->anchor_frac = frac - (double) whole;
+    clk->edge += edges;
+}
+
+static void Lock(Avtp_MediaClock_t* clk, uint64_t timestamp)
+{
+    clk->locked = 1;
+    clk->anchor = timestamp;
+    clk->anchor_frac = 0.0;
+    clk->edge = 0;
+    clk->period = clk->nominal_period;
+    clk->phase_error = 0.0;
+}
+
+int Avtp_MediaClock_Init(Avtp_MediaClock_t* clk, double bandwidth)
+{
+    if (clk == NULL || !(bandwidth > 0.0)) {
+        return -EINVAL;
+    }
+
+    memset(clk, 0, sizeof(*clk));
+    clk->bandwidth = bandwidth;
+    return 0;
+}
+
+int Avtp_MediaClock_Configure(Avtp_MediaClock_t* clk, uint32_t base_frequency,
+                              uint8_t pull, uint16_t timestamp_interval)
+{
+    double period, omega;
+
+    if (clk == NULL || base_frequency == 0 || timestamp_interval == 0 ||
+        pull >= sizeof(pull_period) / sizeof(pull_period[0])) {
+        return -EINVAL;
+    }
+
+    if (clk->nominal_period > 0.0 && clk->base_frequency == base_frequency &&
+        clk->pull == pull && clk->timestamp_interval == timestamp_interval) {
+        return 0;
+    }
+
+    /*
+     * Standard DLL coefficients for a critically damped loop, with omega the
+     * loop bandwidth normalized to the timestamp period. The loop becomes
+     * unstable as omega approaches 1.
+     */
+    period = NSEC_PER_SEC / base_frequency * pull_period[pull];
+    omega = 2.0 * PI * clk->bandwidth * period * timestamp_interval / NSEC_PER_SEC;
+    if (omega >= 0.5) {
+        return -EINVAL;
+    }
+
+    clk->base_frequency = base_frequency;
+    clk->pull = pull;
+    clk->timestamp_interval = timestamp_interval;
+    clk->nominal_period = period;
+    clk->b = 1.4142135623730951 * omega;
+    clk->c = omega * omega;
+    clk->locked = 0;
+    return 0;
+}
+
+void Avtp_MediaClock_Reset(Avtp_MediaClock_t* clk)
+{
+    if (clk != NULL) {
+        clk->locked = 0;
+    }
+}
+
+int Avtp_MediaClock_AddTimestamp(Avtp_MediaClock_t* clk, uint64_t timestamp)
+{
+    double elapsed, step, error;
+    int64_t steps, edges;
+
+    if (clk == NULL || clk->nominal_period <= 0.0) {
+        return -EINVAL;
+    }
+
+    clk->timestamps++;
+    if (!clk->locked) {
+        Lock(clk, timestamp);
+        return 0;
+    }
+
+    // Number of timestamp intervals since the anchor, more than one if
+    // timestamps were lost
+    elapsed = TimeSinceAnchor(clk, timestamp);
+    step = clk->period * clk->timestamp_interval;
+    steps = RoundToInt(elapsed / step);
+    if (steps <= 0 && elapsed > -MAX_GAP_NS) {
+        clk->stale++;
+        return 0;
+    }
+
+    edges = steps * clk->timestamp_interval;
+    error = elapsed - edges * clk->period;
+    if (elapsed > MAX_GAP_NS || elapsed < -MAX_GAP_NS ||
+        error > step / 4 || error < -step / 4) {
+        clk->relocks++;
+        Lock(clk, timestamp);
+        return 0;
+    }
+
+    MoveAnchor(clk, edges * clk->period + clk->b * error, edges);
+    clk->period += clk->c * error / edges;
+    clk->phase_error = error;
+    return 0;
+}
+
+int Avtp_MediaClock_ProcessPdu(Avtp_MediaClock_t* clk, Avtp_Crf_t* pdu)
+{
+    uint64_t timestamps[TIMESTAMP_CHUNK];
+    size_t count, n;
+    uint16_t len;
+    int res;
+
+    if (clk == NULL || pdu == NULL) {
+        return -EINVAL;
+    }
+
+    len = Avtp_Crf_GetCrfDataLength(pdu);
+    if (len == 0 || len % sizeof(uint64_t) != 0) {
+        return -EINVAL;
+    }
+
+    res = Avtp_MediaClock_Configure(clk, Avtp_Crf_GetBaseFrequency(pdu),
+                                    Avtp_Crf_GetPull(pdu),
+                                    Avtp_Crf_GetTimestampInterval(pdu));
+    if (res < 0) {
+        return res;
+    }
+
+    if (Avtp_Crf_GetTu(pdu)) {
+        Avtp_MediaClock_Reset(clk);
+    }
+
+    count = len / sizeof(uint64_t);
+    for (size_t i = 0; i < count; i += n) {
+        n = count - i < TIMESTAMP_CHUNK ? count - i : TIMESTAMP_CHUNK;
+        Avtp_BeToCpuArray64(timestamps, pdu->payload + i * sizeof(uint64_t), n);
+        for (size_t j = 0; j < n; j++) {
+            Avtp_MediaClock_AddTimestamp(clk, timestamps[j]);
+        }
+    }
+    return 0;
+}
+
+int Avtp_MediaClock_NextEdge(Avtp_MediaClock_t* clk, uint64_t time,
+                             uint32_t divider, uint64_t* edge_time)
+{
+    int64_t k, rem;
+
+    if (clk == NULL || divider == 0 || edge_time == NULL) {
+        return -EINVAL;
+    }
+    if (!clk->locked) {
+        return -EAGAIN;
+    }
+
+    k = CeilToInt(TimeSinceAnchor(clk, time) / clk->period);
+    rem = (clk->edge + k) % divider;
+    if (rem < 0) {
+        rem += divider;
+    }
+    if (rem != 0) {
+        k += divider - rem;
+    }
+
+    *edge_time = clk->anchor + (uint64_t) RoundToInt(clk->anchor_frac + k * clk->period);
+    return 0;
+}
+
+int Avtp_MediaClock_Align(Avtp_MediaClock_t* clk, uint32_t avtp_time,
+                          uint64_t* edge_time, int64_t* phase_error)
+{
+    uint64_t time, edge;
+    int64_t k;
+
+    if (clk == NULL) {
+        return -EINVAL;
+    }
+    if (!clk->locked) {
+        return -EAGAIN;
+    }
+
+    // Expand to 64 bits with the timestamp closest to the anchor
+    time = Avtp_ExpandTimestamp(avtp_time, clk->anchor);
+
+    k = RoundToInt(TimeSinceAnchor(clk, time) / clk->period);
+    edge = clk->anchor + (uint64_t) RoundToInt(clk->anchor_frac + k * clk->period);
+
+    if (edge_time != NULL) {
+        *edge_time = edge;
+    }
+    if (phase_error != NULL) {
+        *phase_error = (int64_t) (time - edge);
+    }
+    return 0;
+}
@@ -0,0 +1,593 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "avtp/aaf/Aes3.h"
+#include "avtp/aaf/PcmSamples.h"
+#include "avtp/Byteorder.h"
+
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(LINUX_KERNEL1722) && !defined(__ZEPHYR__)
+#define AVTP_AES3_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && !defined(LINUX_KERNEL1722) && !defined(__ZEPHYR__)
+#define AVTP_AES3_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+/* Subframes staged at once, holds a frame of any channel count */
+#define AVTP_AES3_STAGING           1024
+
+/* The channels_per_frame field of the AAF header has 10 bits */
+#define AVTP_AES3_MAX_CHANNELS      1023
+
+#define AVTP_AES3_AUDIO_MASK        0x0FFFFFF0u
+#define AVTP_AES3_PARITY_MASK       0x0FFFFFFEu     /* Slots 4-30 */
+#define AVTP_AES3_CHECK_MASK        0x0FFFFFFFu     /* Slots 4-31 */
+#define AVTP_AES3_AUX_MASK          0xF000000Fu
+#define AVTP_AES3_V_BIT             3
+#define AVTP_AES3_U_BIT             2
+#define AVTP_AES3_C_BIT             1
+
+/*
+ * Subframe kernels. The host side is split into MSB-justified samples and
+ * aux words holding the preamble and the V, U and C bits in their subframe
+ * positions. Payload buffers may be unaligned.
+ */
+typedef struct {
+    Avtp_PcmIsa_t isa;
+    /* Merge samples and aux words, add parity and store big-endian */
+    void (*Encode)(uint8_t* dst, const int32_t* src, const uint32_t* aux, size_t n);
+    /* Split big-endian subframes, returns the number of parity errors */
+    uint32_t (*Decode)(int32_t* dst, uint32_t* aux, const uint8_t* src, size_t n);
+} Avtp_Aes3Kernels_t;
+
+static void EncodeScalar(uint8_t* dst, const int32_t* src, const uint32_t* aux, size_t n)
+{
+    uint32_t word;
+    for (size_t i = 0; i < n; i++) {
+        word = (((uint32_t) src[i] >> 4) & AVTP_AES3_AUDIO_MASK) | aux[i];
+        word |= __builtin_parity(word & AVTP_AES3_PARITY_MASK);
+        word = Avtp_CpuToBe32(word);
+        memcpy(dst + i * 4, &word, sizeof(word));
+    }
+}
+
+static uint32_t DecodeScalar(int32_t* dst, uint32_t* aux, const uint8_t* src, size_t n)
+{
+    uint32_t word, errors = 0;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(&word, src + i * 4, sizeof(word));
+        word = Avtp_BeToCpu32(word);
+        dst[i] = (int32_t) ((word << 4) & 0xFFFFFF00u);
+        aux[i] = word & AVTP_AES3_AUX_MASK;
+        errors += __builtin_parity(word & AVTP_AES3_CHECK_MASK);
+    }
+    return errors;
+}
+
+static const Avtp_Aes3Kernels_t ScalarKernels = {
+    .isa = AVTP_PCM_ISA_SCALAR,
+    .Encode = EncodeScalar,
+    .Decode = DecodeScalar,
+};
+
+#if defined(AVTP_AES3_X86)
+
+static const uint8_t Avtp_Aes3Swap32Mask[16] = {
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+};
+
+/* Parity of each 32-bit lane in bit 0, by folding the lane onto itself */
+__attribute__((target("ssse3")))
+static inline __m128i Parity128(__m128i v)
+{
+    v = _mm_xor_si128(v, _mm_srli_epi32(v, 16));
+    v = _mm_xor_si128(v, _mm_srli_epi32(v, 8));
+    v = _mm_xor_si128(v, _mm_srli_epi32(v, 4));
+    v = _mm_xor_si128(v, _mm_srli_epi32(v, 2));
+    v = _mm_xor_si128(v, _mm_srli_epi32(v, 1));
+    return _mm_and_si128(v, _mm_set1_epi32(1));
+}
+
+__attribute__((target("ssse3")))
+static void EncodeSsse3(uint8_t* dst, const int32_t* src, const uint32_t* aux, size_t n)
+{
+    const __m128i shuf = _mm_loadu_si128((const __m128i*) Avtp_Aes3Swap32Mask);
+    const __m128i audio = _mm_set1_epi32((int) AVTP_AES3_AUDIO_MASK);
+    const __m128i parity = _mm_set1_epi32((int) AVTP_AES3_PARITY_MASK);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i a = _mm_loadu_si128((const __m128i*) (aux + i));
+        __m128i w = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(s, 4), audio), a);
+        w = _mm_or_si128(w, Parity128(_mm_and_si128(w, parity)));
+        _mm_storeu_si128((__m128i*) (dst + i * 4), _mm_shuffle_epi8(w, shuf));
+    }
+    EncodeScalar(dst + i * 4, src + i, aux + i, n - i);
+}
+
+__attribute__((target("ssse3")))
+static uint32_t DecodeSsse3(int32_t* dst, uint32_t* aux, const uint8_t* src, size_t n)
+{
+    const __m128i shuf = _mm_loadu_si128((const __m128i*) Avtp_Aes3Swap32Mask);
+    const __m128i sample = _mm_set1_epi32((int) 0xFFFFFF00u);
+    const __m128i bits = _mm_set1_epi32((int) AVTP_AES3_AUX_MASK);
+    const __m128i check = _mm_set1_epi32((int) AVTP_AES3_CHECK_MASK);
+    __m128i errors = _mm_setzero_si128();
+    uint32_t lanes[4];
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i w = _mm_loadu_si128((const __m128i*) (src + i * 4));
+        w = _mm_shuffle_epi8(w, shuf);
+        _mm_storeu_si128((__m128i*) (dst + i),
+                         _mm_and_si128(_mm_slli_epi32(w, 4), sample));
+        _mm_storeu_si128((__m128i*) (aux + i), _mm_and_si128(w, bits));
+        errors = _mm_add_epi32(errors, Parity128(_mm_and_si128(w, check)));
+    }
+    _mm_storeu_si128((__m128i*) lanes, errors);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           DecodeScalar(dst + i, aux + i, src + i * 4, n - i);
+}
+
+static const Avtp_Aes3Kernels_t Ssse3Kernels = {
+    .isa = AVTP_PCM_ISA_SSSE3,
+    .Encode = EncodeSsse3,
+    .Decode = DecodeSsse3,
+};
+
+#define LOAD_MASK256(mask) \
+    _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) (mask)))
+
+__attribute__((target("avx2")))
+static inline __m256i Parity256(__m256i v)
+{
+    v = _mm256_xor_si256(v, _mm256_srli_epi32(v, 16));
+    v = _mm256_xor_si256(v, _mm256_srli_epi32(v, 8));
+    v = _mm256_xor_si256(v, _mm256_srli_epi32(v, 4));
+    v = _mm256_xor_si256(v, _mm256_srli_epi32(v, 2));
+    v = _mm256_xor_si256(v, _mm256_srli_epi32(v, 1));
+    return _mm256_and_si256(v, _mm256_set1_epi32(1));
+}
+
+__attribute__((target("avx2")))
+static void EncodeAvx2(uint8_t* dst, const int32_t* src, const uint32_t* aux, size_t n)
+{
+    const __m256i shuf = LOAD_MASK256(Avtp_Aes3Swap32Mask);
+    const __m256i audio = _mm256_set1_epi32((int) AVTP_AES3_AUDIO_MASK);
+    const __m256i parity = _mm256_set1_epi32((int) AVTP_AES3_PARITY_MASK);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*) (src + i));
+        __m256i a = _mm256_loadu_si256((const __m256i*) (aux + i));
+        __m256i w = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(s, 4), audio), a);
+        w = _mm256_or_si256(w, Parity256(_mm256_and_si256(w, parity)));
+        _mm256_storeu_si256((__m256i*) (dst + i * 4), _mm256_shuffle_epi8(w, shuf));
+    }
+    EncodeSsse3(dst + i * 4, src + i, aux + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static uint32_t DecodeAvx2(int32_t* dst, uint32_t* aux, const uint8_t* src, size_t n)
+{
+    const __m256i shuf = LOAD_MASK256(Avtp_Aes3Swap32Mask);
+    const __m256i sample = _mm256_set1_epi32((int) 0xFFFFFF00u);
+    const __m256i bits = _mm256_set1_epi32((int) AVTP_AES3_AUX_MASK);
+    const __m256i check = _mm256_set1_epi32((int) AVTP_AES3_CHECK_MASK);
+    __m256i errors = _mm256_setzero_si256();
+    uint32_t lanes[8], sum = 0;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i w = _mm256_loadu_si256((const __m256i*) (src + i * 4));
+        w = _mm256_shuffle_epi8(w, shuf);
+        _mm256_storeu_si256((__m256i*) (dst + i),
+                            _mm256_and_si256(_mm256_slli_epi32(w, 4), sample));
+        _mm256_storeu_si256((__m256i*) (aux + i), _mm256_and_si256(w, bits));
+        errors = _mm256_add_epi32(errors, Parity256(_mm256_and_si256(w, check)));
+    }
+    _mm256_storeu_si256((__m256i*) lanes, errors);
+    for (int l = 0; l < 8; l++) {
+        sum += lanes[l];
+    }
+    return sum + DecodeSsse3(dst + i, aux + i, src + i * 4, n - i);
+}
+
+static const Avtp_Aes3Kernels_t Avx2Kernels = {
+    .isa = AVTP_PCM_ISA_AVX2,
+    .Encode = EncodeAvx2,
+    .Decode = DecodeAvx2,
+};
+
+#elif defined(AVTP_AES3_NEON)
+
+static inline uint32x4_t ParityNeon(uint32x4_t v)
+{
+    v = veorq_u32(v, vshrq_n_u32(v, 16));
+    v = veorq_u32(v, vshrq_n_u32(v, 8));
+    v = veorq_u32(v, vshrq_n_u32(v, 4));
+    v = veorq_u32(v, vshrq_n_u32(v, 2));
+    v = veorq_u32(v, vshrq_n_u32(v, 1));
+    return vandq_u32(v, vdupq_n_u32(1));
+}
+
+static void EncodeNeon(uint8_t* dst, const int32_t* src, const uint32_t* aux, size_t n)
+{
+    const uint32x4_t audio = vdupq_n_u32(AVTP_AES3_AUDIO_MASK);
+    const uint32x4_t parity = vdupq_n_u32(AVTP_AES3_PARITY_MASK);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t s = vreinterpretq_u32_s32(vld1q_s32(src + i));
+        uint32x4_t w = vorrq_u32(vandq_u32(vshrq_n_u32(s, 4), audio),
+                                 vld1q_u32(aux + i));
+        w = vorrq_u32(w, ParityNeon(vandq_u32(w, parity)));
+        vst1q_u8(dst + i * 4, vrev32q_u8(vreinterpretq_u8_u32(w)));
+    }
+    EncodeScalar(dst + i * 4, src + i, aux + i, n - i);
+}
+
+static uint32_t DecodeNeon(int32_t* dst, uint32_t* aux, const uint8_t* src, size_t n)
+{
+    const uint32x4_t sample = vdupq_n_u32(0xFFFFFF00u);
+    const uint32x4_t bits = vdupq_n_u32(AVTP_AES3_AUX_MASK);
+    const uint32x4_t check = vdupq_n_u32(AVTP_AES3_CHECK_MASK);
+    uint32x4_t errors = vdupq_n_u32(0);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t w = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(src + i * 4)));
+        vst1q_s32(dst + i, vreinterpretq_s32_u32(vandq_u32(vshlq_n_u32(w, 4), sample)));
+        vst1q_u32(aux + i, vandq_u32(w, bits));
+        errors = vaddq_u32(errors, ParityNeon(vandq_u32(w, check)));
+    }
+    return vgetq_lane_u32(errors, 0) + vgetq_lane_u32(errors, 1) +
+           vgetq_lane_u32(errors, 2) + vgetq_lane_u32(errors, 3) +
+           DecodeScalar(dst + i, aux + i, src + i * 4, n - i);
+}
+
+static const Avtp_Aes3Kernels_t NeonKernels = {
+    .isa = AVTP_PCM_ISA_NEON,
+    .Encode = EncodeNeon,
+    .Decode = DecodeNeon,
+};
+
+#endif
+
+/*
+ * Kernels are resolved on first use, independently of the PCM sample
+ * conversion. Concurrent first calls may all resolve, which is harmless as
+ * every caller stores the same pointer; the pointer is accessed atomically
+ * so that this is not a data race.
+ */
+static const Avtp_Aes3Kernels_t* Kernels;
+
+static const Avtp_Aes3Kernels_t* FindKernels(Avtp_PcmIsa_t isa)
+{
+#if defined(AVTP_AES3_X86)
+    __builtin_cpu_init();
+    if ((isa == AVTP_PCM_ISA_AUTO || isa == AVTP_PCM_ISA_AVX2) &&
+        __builtin_cpu_supports("avx2")) {
+        return &Avx2Kernels;
+    }
+    if ((isa == AVTP_PCM_ISA_AUTO || isa == AVTP_PCM_ISA_SSSE3) &&
+        __builtin_cpu_supports("ssse3")) {
+        return &Ssse3Kernels;
+    }
+#elif defined(AVTP_AES3_NEON)
+    if (isa == AVTP_PCM_ISA_AUTO || isa == AVTP_PCM_ISA_NEON) {
+        return &NeonKernels;
+    }
+#endif
+    if (isa == AVTP_PCM_ISA_AUTO || isa == AVTP_PCM_ISA_SCALAR) {
+        return &ScalarKernels;
+    }
+    return NULL;
+}
+
+static const Avtp_Aes3Kernels_t* GetKernels(void)
+{
+    const Avtp_Aes3Kernels_t* kernels = __atomic_load_n(&Kernels, __ATOMIC_RELAXED);
+
+    if (kernels == NULL) {
+        kernels = FindKernels(AVTP_PCM_ISA_AUTO);
+        __atomic_store_n(&Kernels, kernels, __ATOMIC_RELAXED);
+    }
+    return kernels;
+}
+
+int Avtp_Aes3_SelectIsa(Avtp_PcmIsa_t isa)
+{
+    const Avtp_Aes3Kernels_t* kernels = FindKernels(isa);
+
+    if (kernels == NULL) {
+        return -ENOTSUP;
+    }
+    __atomic_store_n(&Kernels, kernels, __ATOMIC_RELAXED);
+    return 0;
+}
+
+Avtp_PcmIsa_t Avtp_Aes3_GetIsa(void)
+{
+    return GetKernels()->isa;
+}
+
+static const uint8_t Avtp_Aes3ZeroBlock[AVTP_AES3_BLOCK_LEN];
+
+/*
+ * Builds the aux words of n frames starting at block position 'frame'. Each
+ * channel is handled in turn so its channel status and user data bits are
+ * read sequentially.
+ */
+static void BuildAux(const Avtp_Aes3Encoder_t* enc, uint32_t* aux, size_t n)
+{
+    uint16_t channels = enc->channels;
+    uint32_t v = (uint32_t) (enc->validity != 0) << AVTP_AES3_V_BIT;
+
+    for (uint16_t c = 0; c < channels; c++) {
+        const uint8_t* cs = enc->channel_status + c * AVTP_AES3_BLOCK_LEN;
+        const uint8_t* ud = enc->user_data != NULL ?
+                            enc->user_data + c * AVTP_AES3_BLOCK_LEN :
+                            Avtp_Aes3ZeroBlock;
+        uint32_t x = (c & 1) ? AVTP_AES3_PREAMBLE_Y : AVTP_AES3_PREAMBLE_X;
+        uint32_t z = (c & 1) ? AVTP_AES3_PREAMBLE_Y : AVTP_AES3_PREAMBLE_Z;
+        uint32_t* a = aux + c;
+        uint8_t frame = enc->frame;
+
+        for (size_t i = 0; i < n; i++, a += channels) {
+            uint32_t shift = frame & 7;
+
+            *a = (frame == 0 ? z : x) << 28 | v |
+                 ((cs[frame >> 3] >> shift) & 1) << AVTP_AES3_C_BIT |
+                 ((ud[frame >> 3] >> shift) & 1) << AVTP_AES3_U_BIT;
+            if (++frame == AVTP_AES3_BLOCK_FRAMES) {
+                frame = 0;
+            }
+        }
+    }
+}
+
+int Avtp_Aes3_InitEncoder(Avtp_Aes3Encoder_t* enc, uint16_t channels,
+                          const uint8_t* channel_status, const uint8_t* user_data)
+{
+    if (enc == NULL || channel_status == NULL || channels == 0 ||
+            channels > AVTP_AES3_MAX_CHANNELS) {
+        return -EINVAL;
+    }
+
+    enc->channels = channels;
+    enc->frame = 0;
+    enc->validity = 0;
+    enc->channel_status = channel_status;
+    enc->user_data = user_data;
+    return 0;
+}
+
+int Avtp_Aes3_Encode(Avtp_Aes3Encoder_t* enc, void* payload,
+                     const int32_t* samples, size_t frames)
+{
+    const Avtp_Aes3Kernels_t* k = GetKernels();
+    uint32_t aux[AVTP_AES3_STAGING];
+    uint8_t* dst = payload;
+    uint16_t channels;
+    size_t block, n;
+
+    if (enc == NULL || payload == NULL || samples == NULL ||
+            frames * enc->channels * 4 > INT32_MAX) {
+        return -EINVAL;
+    }
+
+    channels = enc->channels;
+    block = AVTP_AES3_STAGING / channels;
+    for (size_t f = 0; f < frames; f += n) {
+        n = frames - f < block ? frames - f : block;
+        BuildAux(enc, aux, n);
+        enc->frame = (enc->frame + n) % AVTP_AES3_BLOCK_FRAMES;
+
+        k->Encode(dst, samples + f * channels, aux, n * channels);
+        dst += n * channels * 4;
+    }
+
+    return frames * channels * 4;
+}
+
+int Avtp_Aes3_InitDecoder(Avtp_Aes3Decoder_t* dec, uint16_t channels,
+                          uint8_t* work, uint8_t* channel_status,
+                          uint8_t* user_data)
+{
+    if (dec == NULL || work == NULL || channel_status == NULL ||
+            channels == 0 || channels > AVTP_AES3_MAX_CHANNELS) {
+        return -EINVAL;
+    }
+
+    memset(dec, 0, sizeof(*dec));
+    dec->channels = channels;
+    dec->work = work;
+    dec->channel_status = channel_status;
+    dec->user_data = user_data;
+    return 0;
+}
+
+/* Outputs the blocks assembled in the work buffer */
+static void CompleteBlock(Avtp_Aes3Decoder_t* dec)
+{
+    size_t len = dec->channels * AVTP_AES3_BLOCK_LEN;
+
+    for (uint16_t c = 0; c < dec->channels; c++) {
+        const uint8_t* cs = dec->work + c * AVTP_AES3_BLOCK_LEN;
+
+        // Byte 0 bit 0 marks the professional format, which carries a CRCC
+        if ((cs[0] & 1) && Avtp_Aes3_CalcCrc(cs) != cs[AVTP_AES3_BLOCK_LEN - 1]) {
+            dec->crc_errors++;
+        }
+    }
+
+    memcpy(dec->channel_status, dec->work, len);
+    if (dec->user_data != NULL) {
+        memcpy(dec->user_data, dec->work + len, len);
+    }
+    dec->blocks++;
+}
+
+/*
+ * Collects the C and U bits of 'len' frames of a block, starting at block
+ * position 'frame', into the work buffer. The bits of each channel are
+ * gathered in a register and stored once per byte.
+ */
+static void AssembleBits(Avtp_Aes3Decoder_t* dec, const uint32_t* aux,
+                         uint8_t frame, size_t len)
+{
+    uint16_t channels = dec->channels;
+
+    for (uint16_t c = 0; c < channels; c++) {
+        uint8_t* cs = dec->work + c * AVTP_AES3_BLOCK_LEN;
+        uint8_t* ud = dec->work + (channels + c) * AVTP_AES3_BLOCK_LEN;
+        const uint32_t* a = aux + c;
+        uint8_t cbits = 0, ubits = 0;
+        uint32_t f = frame;
+
+        for (size_t i = 0; i < len; i++, f++, a += channels) {
+            uint32_t shift = f & 7;
+
+            cbits |= ((*a >> AVTP_AES3_C_BIT) & 1) << shift;
+            ubits |= ((*a >> AVTP_AES3_U_BIT) & 1) << shift;
+            if (shift == 7 || i + 1 == len) {
+                cs[f >> 3] |= cbits;
+                ud[f >> 3] |= ubits;
+                cbits = 0;
+                ubits = 0;
+            }
+        }
+    }
+}
+
+/* Tracks the block position over n frames and assembles the locked parts */
+static int SyncBlocks(Avtp_Aes3Decoder_t* dec, const uint32_t* aux, size_t n)
+{
+    uint16_t channels = dec->channels;
+    int completed = 0;
+    size_t i = 0;
+
+    while (i < n) {
+        size_t len = 1;
+        uint8_t frame = dec->frame;
+
+        // Blocks are framed by the preamble of the first channel
+        if ((aux[i * channels] >> 28) == AVTP_AES3_PREAMBLE_Z) {
+            if (dec->locked && frame != 0) {
+                dec->sync_errors++;
+            }
+            dec->locked = 1;
+            frame = 0;
+            memset(dec->work, 0, channels * 2 * AVTP_AES3_BLOCK_LEN);
+        } else if (dec->locked && frame == 0) {
+            dec->sync_errors++;
+            dec->locked = 0;
+        }
+
+        if (!dec->locked) {
+            i++;
+            continue;
+        }
+
+        // Extend the run up to the end of the block or the next Z preamble
+        while (i + len < n && frame + len < AVTP_AES3_BLOCK_FRAMES &&
+               (aux[(i + len) * channels] >> 28) != AVTP_AES3_PREAMBLE_Z) {
+            len++;
+        }
+        AssembleBits(dec, aux + i * channels, frame, len);
+        i += len;
+        frame += len;
+
+        if (frame == AVTP_AES3_BLOCK_FRAMES) {
+            CompleteBlock(dec);
+            completed++;
+            frame = 0;
+        }
+        dec->frame = frame;
+    }
+
+    return completed;
+}
+
+int Avtp_Aes3_Decode(Avtp_Aes3Decoder_t* dec, int32_t* samples,
+                     const void* payload, size_t frames)
+{
+    const Avtp_Aes3Kernels_t* k = GetKernels();
+    uint32_t aux[AVTP_AES3_STAGING];
+    const uint8_t* src = payload;
+    uint16_t channels;
+    size_t block, n;
+    int completed = 0;
+
+    if (dec == NULL || payload == NULL || samples == NULL) {
+        return -EINVAL;
+    }
+
+    channels = dec->channels;
+    block = AVTP_AES3_STAGING / channels;
+    for (size_t f = 0; f < frames; f += n) {
+        uint32_t invalid = 0;
+
+        n = frames - f < block ? frames - f : block;
+        dec->parity_errors += k->Decode(samples + f * channels, aux, src,
+                                        n * channels);
+        src += n * channels * 4;
+
+        for (size_t i = 0; i < n * channels; i++) {
+            invalid += (aux[i] >> AVTP_AES3_V_BIT) & 1;
+        }
+        dec->invalid += invalid;
+
+        completed += SyncBlocks(dec, aux, n);
+    }
+
+    return completed;
+}
+
+uint8_t Avtp_Aes3_CalcCrc(const uint8_t* block)
+{
+    // x^8 + x^4 + x^3 + x^2 + 1, processed LSB first as transmitted
+    uint8_t crc = 0xFF;
+
+    for (int i = 0; i < AVTP_AES3_BLOCK_LEN - 1; i++) {
+        crc ^= block[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xB8 : crc >> 1;
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,1079 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+
+#include "avtp/aaf/PcmSamples.h"
+#include "avtp/Byteorder.h"
+
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(LINUX_KERNEL1722) && !defined(__ZEPHYR__)
+#define AVTP_PCM_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && !defined(LINUX_KERNEL1722) && !defined(__ZEPHYR__)
+#define AVTP_PCM_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+/* Samples converted at once, sized to keep the staging buffers in L1 */
+#define AVTP_PCM_BLOCK              256
+
+/* Samples staged for (de)interleaving, holds a frame of any channel count */
+#define AVTP_PCM_STAGING            1024
+
+/* The channels_per_frame field of the AAF header has 10 bits */
+#define AVTP_PCM_MAX_CHANNELS       1023
+
+/* Largest float below 1.0, maps to the largest positive integer sample */
+#define AVTP_PCM_FLOAT_MAX          0x1.fffffep-1f
+#define AVTP_PCM_FLOAT_SCALE        2147483648.0f
+
+/*
+ * Conversion kernels. All buffers are byte pointers and may be unaligned.
+ * Integer samples are MSB-justified in 32bit (Widen16/Narrow16 convert to
+ * and from 16bit), so every AAF sample size is a prefix of the same value.
+ * The byteorder of 16/32bit samples is swapped by the Avtp_CpuToBeArray
+ * functions of Byteorder.h.
+ */
+typedef struct {
+    Avtp_PcmIsa_t isa;
+    /* Host 32bit samples to and from big-endian 24bit samples */
+    void (*Pack24)(uint8_t* dst, const uint8_t* src, size_t n, uint32_t mask);
+    void (*Unpack24)(uint8_t* dst, const uint8_t* src, size_t n);
+    /* Host 16bit samples to and from host 32bit samples */
+    void (*Widen16)(uint8_t* dst, const uint8_t* src, size_t n);
+    void (*Narrow16)(uint8_t* dst, const uint8_t* src, size_t n);
+    /* Host float samples to and from host 32bit samples, may work in place */
+    void (*FloatToInt)(uint8_t* dst, const uint8_t* src, size_t n);
+    void (*IntToFloat)(uint8_t* dst, const uint8_t* src, size_t n);
+} Avtp_PcmKernels_t;
+
+static void Pack24Scalar(uint8_t* dst, const uint8_t* src, size_t n, uint32_t mask)
+{
+    uint32_t val;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(&val, src + i * 4, sizeof(val));
+        val &= mask;
+        dst[i * 3] = val >> 24;
+        dst[i * 3 + 1] = val >> 16;
+        dst[i * 3 + 2] = val >> 8;
+    }
+}
+
+static void Unpack24Scalar(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    uint32_t val;
+    for (size_t i = 0; i < n; i++) {
+        val = (uint32_t) src[i * 3] << 24 | (uint32_t) src[i * 3 + 1] << 16 |
+              (uint32_t) src[i * 3 + 2] << 8;
+        memcpy(dst + i * 4, &val, sizeof(val));
+    }
+}
+
+static void Widen16Scalar(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    uint16_t in;
+    uint32_t out;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(&in, src + i * 2, sizeof(in));
+        out = (uint32_t) in << 16;
+        memcpy(dst + i * 4, &out, sizeof(out));
+    }
+}
+
+static void Narrow16Scalar(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    uint32_t in;
+    uint16_t out;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(&in, src + i * 4, sizeof(in));
+        out = in >> 16;
+        memcpy(dst + i * 2, &out, sizeof(out));
+    }
+}
+
+static void FloatToIntScalar(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    float in;
+    int32_t out;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(&in, src + i * 4, sizeof(in));
+        // Also maps NaN to the smallest sample
+        if (!(in >= -1.0f)) {
+            in = -1.0f;
+        } else if (in > AVTP_PCM_FLOAT_MAX) {
+            in = AVTP_PCM_FLOAT_MAX;
+        }
+        out = (int32_t) (in * AVTP_PCM_FLOAT_SCALE);
+        memcpy(dst + i * 4, &out, sizeof(out));
+    }
+}
+
+static void IntToFloatScalar(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    int32_t in;
+    float out;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(&in, src + i * 4, sizeof(in));
+        out = (float) in * (1.0f / AVTP_PCM_FLOAT_SCALE);
+        memcpy(dst + i * 4, &out, sizeof(out));
+    }
+}
+
+static const Avtp_PcmKernels_t ScalarKernels = {
+    .isa = AVTP_PCM_ISA_SCALAR,
+    .Pack24 = Pack24Scalar,
+    .Unpack24 = Unpack24Scalar,
+    .Widen16 = Widen16Scalar,
+    .Narrow16 = Narrow16Scalar,
+    .FloatToInt = FloatToIntScalar,
+    .IntToFloat = IntToFloatScalar,
+};
+
+#if defined(AVTP_PCM_X86)
+
+/* Byte shuffles within a 16 byte lane. 0x80 clears the destination byte. */
+static const uint8_t Avtp_PcmPack24Mask[16] = {
+    3, 2, 1, 7, 6, 5, 11, 10, 9, 15, 14, 13, 0x80, 0x80, 0x80, 0x80
+};
+static const uint8_t Avtp_PcmUnpack24Mask[16] = {
+    0x80, 2, 1, 0, 0x80, 5, 4, 3, 0x80, 8, 7, 6, 0x80, 11, 10, 9
+};
+
+__attribute__((target("ssse3")))
+static void Pack24Ssse3(uint8_t* dst, const uint8_t* src, size_t n, uint32_t mask)
+{
+    const __m128i shuf = _mm_loadu_si128((const __m128i*) Avtp_PcmPack24Mask);
+    const __m128i bits = _mm_set1_epi32((int) mask);
+    size_t i = 0;
+
+    // Each store writes 16 bytes of which 12 are valid
+    for (; i + 6 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + i * 4));
+        v = _mm_shuffle_epi8(_mm_and_si128(v, bits), shuf);
+        _mm_storeu_si128((__m128i*) (dst + i * 3), v);
+    }
+    Pack24Scalar(dst + i * 3, src + i * 4, n - i, mask);
+}
+
+__attribute__((target("ssse3")))
+static void Unpack24Ssse3(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    const __m128i shuf = _mm_loadu_si128((const __m128i*) Avtp_PcmUnpack24Mask);
+    size_t i = 0;
+
+    // Each load reads 16 bytes of which 12 are used
+    for (; i + 6 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + i * 3));
+        _mm_storeu_si128((__m128i*) (dst + i * 4), _mm_shuffle_epi8(v, shuf));
+    }
+    Unpack24Scalar(dst + i * 4, src + i * 3, n - i);
+}
+
+__attribute__((target("ssse3")))
+static void Widen16Ssse3(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + i * 2));
+        _mm_storeu_si128((__m128i*) (dst + i * 4), _mm_unpacklo_epi16(zero, v));
+        _mm_storeu_si128((__m128i*) (dst + i * 4 + 16), _mm_unpackhi_epi16(zero, v));
+    }
+    Widen16Scalar(dst + i * 4, src + i * 2, n - i);
+}
+
+__attribute__((target("ssse3")))
+static void Narrow16Ssse3(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = _mm_loadu_si128((const __m128i*) (src + i * 4));
+        __m128i hi = _mm_loadu_si128((const __m128i*) (src + i * 4 + 16));
+        lo = _mm_srai_epi32(lo, 16);
+        hi = _mm_srai_epi32(hi, 16);
+        _mm_storeu_si128((__m128i*) (dst + i * 2), _mm_packs_epi32(lo, hi));
+    }
+    Narrow16Scalar(dst + i * 2, src + i * 4, n - i);
+}
+
+__attribute__((target("ssse3")))
+static void FloatToIntSsse3(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    const __m128 min = _mm_set1_ps(-1.0f);
+    const __m128 max = _mm_set1_ps(AVTP_PCM_FLOAT_MAX);
+    const __m128 scale = _mm_set1_ps(AVTP_PCM_FLOAT_SCALE);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps((const float*) (src + i * 4));
+        // maxps returns its second operand for NaN, like the scalar kernel
+        v = _mm_min_ps(_mm_max_ps(v, min), max);
+        _mm_storeu_si128((__m128i*) (dst + i * 4),
+                         _mm_cvttps_epi32(_mm_mul_ps(v, scale)));
+    }
+    FloatToIntScalar(dst + i * 4, src + i * 4, n - i);
+}
+
+__attribute__((target("ssse3")))
+static void IntToFloatSsse3(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    const __m128 scale = _mm_set1_ps(1.0f / AVTP_PCM_FLOAT_SCALE);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + i * 4));
+        _mm_storeu_ps((float*) (dst + i * 4), _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    IntToFloatScalar(dst + i * 4, src + i * 4, n - i);
+}
+
+static const Avtp_PcmKernels_t Ssse3Kernels = {
+    .isa = AVTP_PCM_ISA_SSSE3,
+    .Pack24 = Pack24Ssse3,
+    .Unpack24 = Unpack24Ssse3,
+    .Widen16 = Widen16Ssse3,
+    .Narrow16 = Narrow16Ssse3,
+    .FloatToInt = FloatToIntSsse3,
+    .IntToFloat = IntToFloatSsse3,
+};
+
+/* AVX2 shuffles each 128bit lane separately, the masks are broadcast. */
+#define LOAD_MASK256(mask) \
+    _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) (mask)))
+
+__attribute__((target("avx2")))
+static void Pack24Avx2(uint8_t* dst, const uint8_t* src, size_t n, uint32_t mask)
+{
+    const __m256i shuf = LOAD_MASK256(Avtp_PcmPack24Mask);
+    const __m256i bits = _mm256_set1_epi32((int) mask);
+    // Move the 12 valid bytes of the upper lane next to those of the lower
+    const __m256i perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    size_t i = 0;
+
+    for (; i + 11 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (src + i * 4));
+        v = _mm256_shuffle_epi8(_mm256_and_si256(v, bits), shuf);
+        v = _mm256_permutevar8x32_epi32(v, perm);
+        _mm256_storeu_si256((__m256i*) (dst + i * 3), v);
+    }
+    Pack24Ssse3(dst + i * 3, src + i * 4, n - i, mask);
+}
+
+__attribute__((target("avx2")))
+static void Unpack24Avx2(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    const __m256i shuf = LOAD_MASK256(Avtp_PcmUnpack24Mask);
+    // Samples 4..7 start at byte 12, move them to the start of the upper lane
+    const __m256i perm = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+    size_t i = 0;
+
+    for (; i + 11 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (src + i * 3));
+        v = _mm256_permutevar8x32_epi32(v, perm);
+        _mm256_storeu_si256((__m256i*) (dst + i * 4), _mm256_shuffle_epi8(v, shuf));
+    }
+    Unpack24Ssse3(dst + i * 4, src + i * 3, n - i);
+}
+
+__attribute__((target("avx2")))
+static void Widen16Avx2(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) (src + i * 2)));
+        _mm256_storeu_si256((__m256i*) (dst + i * 4), _mm256_slli_epi32(v, 16));
+    }
+    Widen16Scalar(dst + i * 4, src + i * 2, n - i);
+}
+
+__attribute__((target("avx2")))
+static void Narrow16Avx2(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m256i lo = _mm256_loadu_si256((const __m256i*) (src + i * 4));
+        __m256i hi = _mm256_loadu_si256((const __m256i*) (src + i * 4 + 32));
+        // packs works per lane, restore the sample order afterwards
+        __m256i v = _mm256_packs_epi32(_mm256_srai_epi32(lo, 16),
+                                       _mm256_srai_epi32(hi, 16));
+        v = _mm256_permute4x64_epi64(v, 0xd8);
+        _mm256_storeu_si256((__m256i*) (dst + i * 2), v);
+    }
+    Narrow16Ssse3(dst + i * 2, src + i * 4, n - i);
+}
+
+__attribute__((target("avx2")))
+static void FloatToIntAvx2(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    const __m256 min = _mm256_set1_ps(-1.0f);
+    const __m256 max = _mm256_set1_ps(AVTP_PCM_FLOAT_MAX);
+    const __m256 scale = _mm256_set1_ps(AVTP_PCM_FLOAT_SCALE);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps((const float*) (src + i * 4));
+        v = _mm256_min_ps(_mm256_max_ps(v, min), max);
+        _mm256_storeu_si256((__m256i*) (dst + i * 4),
+                            _mm256_cvttps_epi32(_mm256_mul_ps(v, scale)));
+    }
+    FloatToIntSsse3(dst + i * 4, src + i * 4, n - i);
+}
+
+__attribute__((target("avx2")))
+static void IntToFloatAvx2(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(1.0f / AVTP_PCM_FLOAT_SCALE);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (src + i * 4));
+        _mm256_storeu_ps((float*) (dst + i * 4),
+                         _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    IntToFloatSsse3(dst + i * 4, src + i * 4, n - i);
+}
+
+static const Avtp_PcmKernels_t Avx2Kernels = {
+    .isa = AVTP_PCM_ISA_AVX2,
+    .Pack24 = Pack24Avx2,
+    .Unpack24 = Unpack24Avx2,
+    .Widen16 = Widen16Avx2,
+    .Narrow16 = Narrow16Avx2,
+    .FloatToInt = FloatToIntAvx2,
+    .IntToFloat = IntToFloatAvx2,
+};
+
+#elif defined(AVTP_PCM_NEON)
+
+/*
+ * The structured loads split 16 samples into one vector per byte, so 24bit
+ * samples are packed by storing three of the four byte vectors.
+ */
+static void Pack24Neon(uint8_t* dst, const uint8_t* src, size_t n, uint32_t mask)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x4_t in = vld4q_u8(src + i * 4);
+        uint8x16x3_t out;
+        out.val[0] = vandq_u8(in.val[3], vdupq_n_u8(mask >> 24));
+        out.val[1] = vandq_u8(in.val[2], vdupq_n_u8(mask >> 16));
+        out.val[2] = vandq_u8(in.val[1], vdupq_n_u8(mask >> 8));
+        vst3q_u8(dst + i * 3, out);
+    }
+    Pack24Scalar(dst + i * 3, src + i * 4, n - i, mask);
+}
+
+static void Unpack24Neon(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x3_t in = vld3q_u8(src + i * 3);
+        uint8x16x4_t out;
+        out.val[0] = vdupq_n_u8(0);
+        out.val[1] = in.val[2];
+        out.val[2] = in.val[1];
+        out.val[3] = in.val[0];
+        vst4q_u8(dst + i * 4, out);
+    }
+    Unpack24Scalar(dst + i * 4, src + i * 3, n - i);
+}
+
+static void Widen16Neon(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vreinterpretq_s16_u8(vld1q_u8(src + i * 2));
+        vst1q_u8(dst + i * 4, vreinterpretq_u8_s32(vshll_n_s16(vget_low_s16(v), 16)));
+        vst1q_u8(dst + i * 4 + 16, vreinterpretq_u8_s32(vshll_n_s16(vget_high_s16(v), 16)));
+    }
+    Widen16Scalar(dst + i * 4, src + i * 2, n - i);
+}
+
+static void Narrow16Neon(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t lo = vreinterpretq_s32_u8(vld1q_u8(src + i * 4));
+        int32x4_t hi = vreinterpretq_s32_u8(vld1q_u8(src + i * 4 + 16));
+        int16x8_t v = vcombine_s16(vshrn_n_s32(lo, 16), vshrn_n_s32(hi, 16));
+        vst1q_u8(dst + i * 2, vreinterpretq_u8_s16(v));
+    }
+    Narrow16Scalar(dst + i * 2, src + i * 4, n - i);
+}
+
+static void FloatToIntNeon(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    const float32x4_t min = vdupq_n_f32(-1.0f);
+    const float32x4_t max = vdupq_n_f32(AVTP_PCM_FLOAT_MAX);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vreinterpretq_f32_u8(vld1q_u8(src + i * 4));
+        v = vminq_f32(vmaxq_f32(v, min), max);
+        v = vmulq_n_f32(v, AVTP_PCM_FLOAT_SCALE);
+        vst1q_u8(dst + i * 4, vreinterpretq_u8_s32(vcvtq_s32_f32(v)));
+    }
+    FloatToIntScalar(dst + i * 4, src + i * 4, n - i);
+}
+
+static void IntToFloatNeon(uint8_t* dst, const uint8_t* src, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t v = vreinterpretq_s32_u8(vld1q_u8(src + i * 4));
+        float32x4_t f = vmulq_n_f32(vcvtq_f32_s32(v), 1.0f / AVTP_PCM_FLOAT_SCALE);
+        vst1q_u8(dst + i * 4, vreinterpretq_u8_f32(f));
+    }
+    IntToFloatScalar(dst + i * 4, src + i * 4, n - i);
+}
+
+static const Avtp_PcmKernels_t NeonKernels = {
+    .isa = AVTP_PCM_ISA_NEON,
+    .Pack24 = Pack24Neon,
+    .Unpack24 = Unpack24Neon,
+    .Widen16 = Widen16Neon,
+    .Narrow16 = Narrow16Neon,
+    .FloatToInt = FloatToIntNeon,
+    .IntToFloat = IntToFloatNeon,
+};
+
+#endif
+
+/*
+ * Kernels are resolved on first use. Concurrent first calls may all resolve,
+ * which is harmless as every caller stores the same pointer; the pointer is
+ * accessed atomically so that this is not a data race.
+ */
+static const Avtp_PcmKernels_t* Kernels;
+
+static const Avtp_PcmKernels_t* FindKernels(Avtp_PcmIsa_t isa)
+{
+#if defined(AVTP_PCM_X86)
+    __builtin_cpu_init();
+    if ((isa == AVTP_PCM_ISA_AUTO || isa == AVTP_PCM_ISA_AVX2) &&
+        __builtin_cpu_supports("avx2")) {
+        return &Avx2Kernels;
+    }
+    if ((isa == AVTP_PCM_ISA_AUTO || isa == AVTP_PCM_ISA_SSSE3) &&
+        __builtin_cpu_supports("ssse3")) {
+        return &Ssse3Kernels;
+    }
+#elif defined(AVTP_PCM_NEON)
+    if (isa == AVTP_PCM_ISA_AUTO || isa == AVTP_PCM_ISA_NEON) {
+        return &NeonKernels;
+    }
+#endif
+    if (isa == AVTP_PCM_ISA_AUTO || isa == AVTP_PCM_ISA_SCALAR) {
+        return &ScalarKernels;
+    }
+    return NULL;
+}
+
+static const Avtp_PcmKernels_t* GetKernels(void)
+{
+    const Avtp_PcmKernels_t* kernels = __atomic_load_n(&Kernels, __ATOMIC_RELAXED);
+
+    if (kernels == NULL) {
+        kernels = FindKernels(AVTP_PCM_ISA_AUTO);
+        __atomic_store_n(&Kernels, kernels, __ATOMIC_RELAXED);
+    }
+    return kernels;
+}
+
+int Avtp_PcmSamples_SelectIsa(Avtp_PcmIsa_t isa)
+{
+    const Avtp_PcmKernels_t* kernels = FindKernels(isa);
+
+    if (kernels == NULL) {
+        return -ENOTSUP;
+    }
+    __atomic_store_n(&Kernels, kernels, __ATOMIC_RELAXED);
+    return 0;
+}
+
+Avtp_PcmIsa_t Avtp_PcmSamples_GetIsa(void)
+{
+    return GetKernels()->isa;
+}
+
+uint8_t Avtp_PcmSamples_GetSampleSize(Avtp_AafFormat_t format)
+{
+    switch (format) {
+    case AVTP_AAF_FORMAT_INT_16BIT:
+        return 2;
+    case AVTP_AAF_FORMAT_INT_24BIT:
+        return 3;
+    case AVTP_AAF_FORMAT_INT_32BIT:
+    case AVTP_AAF_FORMAT_FLOAT_32BIT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+static uint8_t GetHostSampleSize(Avtp_PcmSampleType_t type)
+{
+    switch (type) {
+    case AVTP_PCM_SAMPLE_INT16:
+        return 2;
+    case AVTP_PCM_SAMPLE_INT32:
+    case AVTP_PCM_SAMPLE_FLOAT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+/* Validates the arguments shared by all conversions, returns the payload size */
+static int CalcPayloadLength(Avtp_AafFormat_t format, Avtp_PcmSampleType_t type,
+                             uint16_t channels, size_t frames)
+{
+    uint8_t size = Avtp_PcmSamples_GetSampleSize(format);
+
+    if (size == 0 || GetHostSampleSize(type) == 0 || channels == 0 ||
+        channels > AVTP_PCM_MAX_CHANNELS || frames > INT_MAX / size / channels) {
+        return -EINVAL;
+    }
+    return frames * channels * size;
+}
+
+/* Clear the bits below the bit depth of big-endian 16/32bit samples */
+static void MaskBe16(uint8_t* buf, size_t n, uint16_t mask)
+{
+    uint16_t be_mask = Avtp_CpuToBe16(mask);
+    uint16_t val;
+
+    if (mask == UINT16_MAX) {
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        memcpy(&val, buf + i * 2, sizeof(val));
+        val &= be_mask;
+        memcpy(buf + i * 2, &val, sizeof(val));
+    }
+}
+
+static void MaskBe32(uint8_t* buf, size_t n, uint32_t mask)
+{
+    uint32_t be_mask = Avtp_CpuToBe32(mask);
+    uint32_t val;
+
+    if (mask == UINT32_MAX) {
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        memcpy(&val, buf + i * 4, sizeof(val));
+        val &= be_mask;
+        memcpy(buf + i * 4, &val, sizeof(val));
+    }
+}
+
+static void PackBlock(const Avtp_PcmKernels_t* k, uint8_t* dst, const uint8_t* src,
+                      Avtp_PcmSampleType_t src_type, Avtp_AafFormat_t format,
+                      size_t n, uint32_t mask)
+{
+    uint32_t tmp[AVTP_PCM_BLOCK];
+    uint16_t tmp16[AVTP_PCM_BLOCK];
+    const uint8_t* samples = src;
+
+    switch (format) {
+    case AVTP_AAF_FORMAT_INT_16BIT:
+        if (src_type != AVTP_PCM_SAMPLE_INT16) {
+            if (src_type == AVTP_PCM_SAMPLE_FLOAT) {
+                k->FloatToInt((uint8_t*) tmp, samples, n);
+                samples = (uint8_t*) tmp;
+            }
+            k->Narrow16((uint8_t*) tmp16, samples, n);
+            samples = (uint8_t*) tmp16;
+        }
+        Avtp_CpuToBeArray16(dst, samples, n);
+        MaskBe16(dst, n, mask);
+        break;
+    case AVTP_AAF_FORMAT_INT_24BIT:
+    case AVTP_AAF_FORMAT_INT_32BIT:
+        if (src_type == AVTP_PCM_SAMPLE_INT16) {
+            k->Widen16((uint8_t*) tmp, samples, n);
+            samples = (uint8_t*) tmp;
+        } else if (src_type == AVTP_PCM_SAMPLE_FLOAT) {
+            k->FloatToInt((uint8_t*) tmp, samples, n);
+            samples = (uint8_t*) tmp;
+        }
+        if (format == AVTP_AAF_FORMAT_INT_24BIT) {
+            k->Pack24(dst, samples, n, mask);
+        } else {
+            Avtp_CpuToBeArray32(dst, samples, n);
+            MaskBe32(dst, n, mask);
+        }
+        break;
+    default:
+        if (src_type != AVTP_PCM_SAMPLE_FLOAT) {
+            if (src_type == AVTP_PCM_SAMPLE_INT16) {
+                k->Widen16((uint8_t*) tmp, samples, n);
+                samples = (uint8_t*) tmp;
+            }
+            k->IntToFloat((uint8_t*) tmp, samples, n);
+            samples = (uint8_t*) tmp;
+        }
+        Avtp_CpuToBeArray32(dst, samples, n);
+        break;
+    }
+}
+
+static void UnpackBlock(const Avtp_PcmKernels_t* k, uint8_t* dst,
+                        Avtp_PcmSampleType_t dst_type, const uint8_t* src,
+                        Avtp_AafFormat_t format, size_t n)
+{
+    uint32_t tmp[AVTP_PCM_BLOCK];
+    uint16_t tmp16[AVTP_PCM_BLOCK];
+
+    switch (format) {
+    case AVTP_AAF_FORMAT_INT_16BIT:
+        if (dst_type == AVTP_PCM_SAMPLE_INT16) {
+            Avtp_BeToCpuArray16(dst, src, n);
+            break;
+        }
+        Avtp_BeToCpuArray16(tmp16, src, n);
+        k->Widen16(dst, (uint8_t*) tmp16, n);
+        if (dst_type == AVTP_PCM_SAMPLE_FLOAT) {
+            k->IntToFloat(dst, dst, n);
+        }
+        break;
+    case AVTP_AAF_FORMAT_INT_24BIT:
+    case AVTP_AAF_FORMAT_INT_32BIT:
+        if (dst_type == AVTP_PCM_SAMPLE_INT32) {
+            if (format == AVTP_AAF_FORMAT_INT_24BIT) {
+                k->Unpack24(dst, src, n);
+            } else {
+                Avtp_BeToCpuArray32(dst, src, n);
+            }
+            break;
+        }
+        if (format == AVTP_AAF_FORMAT_INT_24BIT) {
+            k->Unpack24((uint8_t*) tmp, src, n);
+        } else {
+            Avtp_BeToCpuArray32(tmp, src, n);
+        }
+        if (dst_type == AVTP_PCM_SAMPLE_INT16) {
+            k->Narrow16(dst, (uint8_t*) tmp, n);
+        } else {
+            k->IntToFloat(dst, (uint8_t*) tmp, n);
+        }
+        break;
+    default:
+        if (dst_type == AVTP_PCM_SAMPLE_FLOAT) {
+            Avtp_BeToCpuArray32(dst, src, n);
+            break;
+        }
+        Avtp_BeToCpuArray32(tmp, src, n);
+        if (dst_type == AVTP_PCM_SAMPLE_INT32) {
+            k->FloatToInt(dst, (uint8_t*) tmp, n);
+        } else {
+            k->FloatToInt((uint8_t*) tmp, (uint8_t*) tmp, n);
+            k->Narrow16(dst, (uint8_t*) tmp, n);
+        }
+        break;
+    }
+}
+
+static void PackSamples(const Avtp_PcmKernels_t* k, uint8_t* dst, const uint8_t* src,
+                        Avtp_PcmSampleType_t src_type, Avtp_AafFormat_t format,
+                        size_t count, uint32_t mask)
+{
+    uint8_t size = Avtp_PcmSamples_GetSampleSize(format);
+    uint8_t host_size = GetHostSampleSize(src_type);
+    size_t n;
+
+    for (size_t i = 0; i < count; i += n) {
+        n = count - i < AVTP_PCM_BLOCK ? count - i : AVTP_PCM_BLOCK;
+        PackBlock(k, dst + i * size, src + i * host_size, src_type, format, n, mask);
+    }
+}
+
+static void UnpackSamples(const Avtp_PcmKernels_t* k, uint8_t* dst,
+                          Avtp_PcmSampleType_t dst_type, const uint8_t* src,
+                          Avtp_AafFormat_t format, size_t count)
+{
+    uint8_t size = Avtp_PcmSamples_GetSampleSize(format);
+    uint8_t host_size = GetHostSampleSize(dst_type);
+    size_t n;
+
+    for (size_t i = 0; i < count; i += n) {
+        n = count - i < AVTP_PCM_BLOCK ? count - i : AVTP_PCM_BLOCK;
+        UnpackBlock(k, dst + i * host_size, dst_type, src + i * size, format, n);
+    }
+}
+
+/* Mask clearing the bits below bit_depth, -1 for an invalid bit depth */
+static int64_t CalcSampleMask(Avtp_AafFormat_t format, uint8_t bit_depth)
+{
+    switch (format) {
+    case AVTP_AAF_FORMAT_INT_16BIT:
+        if (bit_depth == 0 || bit_depth > 16) {
+            return -1;
+        }
+        return (uint16_t) (UINT16_MAX << (16 - bit_depth));
+    case AVTP_AAF_FORMAT_INT_24BIT:
+    case AVTP_AAF_FORMAT_INT_32BIT:
+        if (bit_depth == 0 || bit_depth > Avtp_PcmSamples_GetSampleSize(format) * 8) {
+            return -1;
+        }
+        return (uint32_t) (UINT32_MAX << (32 - bit_depth));
+    case AVTP_AAF_FORMAT_FLOAT_32BIT:
+        if (bit_depth != 32) {
+            return -1;
+        }
+        return UINT32_MAX;
+    default:
+        return -1;
+    }
+}
+
+int Avtp_PcmSamples_PackInterleaved(void* payload, Avtp_AafFormat_t format,
+                                    uint8_t bit_depth, const void* src,
+                                    Avtp_PcmSampleType_t src_type,
+                                    uint16_t channels, size_t frames)
+{
+    int length = CalcPayloadLength(format, src_type, channels, frames);
+    int64_t mask = CalcSampleMask(format, bit_depth);
+
+    if (payload == NULL || src == NULL || length < 0 || mask < 0) {
+        return -EINVAL;
+    }
+
+    PackSamples(GetKernels(), payload, src, src_type, format,
+                frames * channels, mask);
+    return length;
+}
+
+int Avtp_PcmSamples_UnpackInterleaved(void* dst, Avtp_PcmSampleType_t dst_type,
+                                      const void* payload, Avtp_AafFormat_t format,
+                                      uint16_t channels, size_t frames)
+{
+    int length = CalcPayloadLength(format, dst_type, channels, frames);
+
+    if (payload == NULL || dst == NULL || length < 0) {
+        return -EINVAL;
+    }
+
+    UnpackSamples(GetKernels(), dst, dst_type, payload, format, frames * channels);
+    return length;
+}
+
+/*
+ * Planar buffers are interleaved through a staging buffer of whole frames.
+ * Each channel is read sequentially, the strided writes stay within L1.
+ */
+static void Interleave(uint8_t* dst, const void* const src[], uint8_t host_size,
+                       uint16_t channels, size_t first, size_t frames)
+{
+    for (uint16_t c = 0; c < channels; c++) {
+        if (host_size == 2) {
+            const uint16_t* in = (const uint16_t*) src[c] + first;
+            uint16_t* out = (uint16_t*) dst + c;
+            for (size_t f = 0; f < frames; f++) {
+                out[f * channels] = in[f];
+            }
+        } else {
+            const uint32_t* in = (const uint32_t*) src[c] + first;
+            uint32_t* out = (uint32_t*) dst + c;
+            for (size_t f = 0; f < frames; f++) {
+                out[f * channels] = in[f];
+            }
+        }
+    }
+}
+
+static void Deinterleave(void* const dst[], const uint8_t* src, uint8_t host_size,
+                         uint16_t channels, size_t first, size_t frames)
+{
+    for (uint16_t c = 0; c < channels; c++) {
+        if (host_size == 2) {
+            const uint16_t* in = (const uint16_t*) src + c;
+            uint16_t* out = (uint16_t*) dst[c] + first;
+            for (size_t f = 0; f < frames; f++) {
+                out[f] = in[f * channels];
+            }
+        } else {
+            const uint32_t* in = (const uint32_t*) src + c;
+            uint32_t* out = (uint32_t*) dst[c] + first;
+            for (size_t f = 0; f < frames; f++) {
+                out[f] = in[f * channels];
+            }
+        }
+    }
+}
+
+int Avtp_PcmSamples_PackPlanar(void* payload, Avtp_AafFormat_t format,
+                               uint8_t bit_depth, const void* const src[],
+                               Avtp_PcmSampleType_t src_type,
+                               uint16_t channels, size_t frames)
+{
+    int length = CalcPayloadLength(format, src_type, channels, frames);
+    int64_t mask = CalcSampleMask(format, bit_depth);
+    const Avtp_PcmKernels_t* k = GetKernels();
+    uint32_t staging[AVTP_PCM_STAGING];
+    uint8_t size = Avtp_PcmSamples_GetSampleSize(format);
+    uint8_t host_size = GetHostSampleSize(src_type);
+    size_t block, n;
+
+    if (payload == NULL || src == NULL || length < 0 || mask < 0) {
+        return -EINVAL;
+    }
+
+    block = AVTP_PCM_STAGING / channels;
+    for (size_t f = 0; f < frames; f += n) {
+        n = frames - f < block ? frames - f : block;
+        Interleave((uint8_t*) staging, src, host_size, channels, f, n);
+        PackSamples(k, (uint8_t*) payload + f * channels * size,
+                    (uint8_t*) staging, src_type, format, n * channels, mask);
+    }
+    return length;
+}
+
+int Avtp_PcmSamples_UnpackPlanar(void* const dst[], Avtp_PcmSampleType_t dst_type,
+                                 const void* payload, Avtp_AafFormat_t format,
+                                 uint16_t channels, size_t frames)
+{
+    int length = CalcPayloadLength(format, dst_type, channels, frames);
+    const Avtp_PcmKernels_t* k = GetKernels();
+    uint32_t staging[AVTP_PCM_STAGING];
+    uint8_t size = Avtp_PcmSamples_GetSampleSize(format);
+    uint8_t host_size = GetHostSampleSize(dst_type);
+    size_t block, n;
+
+    if (payload == NULL || dst == NULL || length < 0) {
+        return -EINVAL;
+    }
+
+    block = AVTP_PCM_STAGING / channels;
+    for (size_t f = 0; f < frames; f += n) {
+        n = frames - f < block ? frames - f : block;
+        UnpackSamples(k, (uint8_t*) staging, dst_type,
+                      (const uint8_t*) payload + f * channels * size, format,
+                      n * channels);
+        Deinterleave(dst, (uint8_t*) staging, host_size, channels, f, n);
+    }
+    return length;
+}
+
+/*
+ * Sparse channel access. The selected channels of a block of frames are
+ * gathered from the payload in a single pass over the frames into a staging
+ * buffer holding one row of network-order samples per channel, which is then
+ * converted row by row. Channels that are not selected are never touched.
+ */
+static inline void GatherChannels(uint8_t* dst, const uint8_t* src, uint8_t size,
+                                  uint16_t channels, const uint16_t map[],
+                                  uint16_t map_len, size_t frames)
+{
+    size_t stride = (size_t) channels * size;
+
+    for (size_t f = 0; f < frames; f++, src += stride) {
+        for (uint16_t i = 0; i < map_len; i++) {
+            memcpy(dst + (i * frames + f) * size, src + map[i] * size, size);
+        }
+    }
+}
+
+static inline void ScatterChannels(uint8_t* dst, const uint8_t* src, uint8_t size,
+                                   uint16_t channels, const uint16_t map[],
+                                   uint16_t map_len, size_t frames)
+{
+    size_t stride = (size_t) channels * size;
+
+    for (size_t f = 0; f < frames; f++, dst += stride) {
+        for (uint16_t i = 0; i < map_len; i++) {
+            memcpy(dst + map[i] * size, src + (i * frames + f) * size, size);
+        }
+    }
+}
+
+/* Specialized per sample size so the copies compile to single moves */
+static void Gather(uint8_t* dst, const uint8_t* src, uint8_t size, uint16_t channels,
+                   const uint16_t map[], uint16_t map_len, size_t frames)
+{
+    switch (size) {
+    case 2:
+        GatherChannels(dst, src, 2, channels, map, map_len, frames);
+        break;
+    case 3:
+        GatherChannels(dst, src, 3, channels, map, map_len, frames);
+        break;
+    default:
+        GatherChannels(dst, src, 4, channels, map, map_len, frames);
+        break;
+    }
+}
+
+static void Scatter(uint8_t* dst, const uint8_t* src, uint8_t size, uint16_t channels,
+                    const uint16_t map[], uint16_t map_len, size_t frames)
+{
+    switch (size) {
+    case 2:
+        ScatterChannels(dst, src, 2, channels, map, map_len, frames);
+        break;
+    case 3:
+        ScatterChannels(dst, src, 3, channels, map, map_len, frames);
+        break;
+    default:
+        ScatterChannels(dst, src, 4, channels, map, map_len, frames);
+        break;
+    }
+}
+
+static int IsValidChannelMap(const uint16_t map[], uint16_t map_len, uint16_t channels)
+{
+    if (map == NULL || map_len == 0 || map_len > AVTP_PCM_MAX_CHANNELS) {
+        return 0;
+    }
+    for (uint16_t i = 0; i < map_len; i++) {
+        if (map[i] >= channels) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int Avtp_PcmSamples_PackChannels(void* payload, Avtp_AafFormat_t format,
+                                 uint8_t bit_depth, const void* const src[],
+                                 Avtp_PcmSampleType_t src_type, uint16_t channels,
+                                 const uint16_t map[], uint16_t map_len,
+                                 size_t frames)
+{
+    int length = CalcPayloadLength(format, src_type, channels, frames);
+    int64_t mask = CalcSampleMask(format, bit_depth);
+    const Avtp_PcmKernels_t* k = GetKernels();
+    uint32_t staging[AVTP_PCM_STAGING];
+    uint8_t size = Avtp_PcmSamples_GetSampleSize(format);
+    uint8_t host_size = GetHostSampleSize(src_type);
+    size_t block, n;
+
+    if (payload == NULL || src == NULL || length < 0 || mask < 0 ||
+        !IsValidChannelMap(map, map_len, channels)) {
+        return -EINVAL;
+    }
+
+    block = AVTP_PCM_STAGING / map_len;
+    for (size_t f = 0; f < frames; f += n) {
+        n = frames - f < block ? frames - f : block;
+        for (uint16_t i = 0; i < map_len; i++) {
+            PackSamples(k, (uint8_t*) staging + i * n * size,
+                        (const uint8_t*) src[i] + f * host_size, src_type,
+                        format, n, mask);
+        }
+        Scatter((uint8_t*) payload + f * channels * size, (uint8_t*) staging,
+                size, channels, map, map_len, n);
+    }
+    return length;
+}
+
+int Avtp_PcmSamples_UnpackChannels(void* const dst[], Avtp_PcmSampleType_t dst_type,
+                                   const void* payload, Avtp_AafFormat_t format,
+                                   uint16_t channels, const uint16_t map[],
+                                   uint16_t map_len, size_t frames)
+{
+    int length = CalcPayloadLength(format, dst_type, channels, frames);
+    const Avtp_PcmKernels_t* k = GetKernels();
+    uint32_t staging[AVTP_PCM_STAGING];
+    uint8_t size = Avtp_PcmSamples_GetSampleSize(format);
+    uint8_t host_size = GetHostSampleSize(dst_type);
+    size_t block, n;
+
+    if (payload == NULL || dst == NULL || length < 0 ||
+        !IsValidChannelMap(map, map_len, channels)) {
+        return -EINVAL;
+    }
+
+    block = AVTP_PCM_STAGING / map_len;
+    for (size_t f = 0; f < frames; f += n) {
+        n = frames - f < block ? frames - f : block;
+        Gather((uint8_t*) staging, (const uint8_t*) payload + f * channels * size,
+               size, channels, map, map_len, n);
+        for (uint16_t i = 0; i < map_len; i++) {
+            UnpackSamples(k, (uint8_t*) dst[i] + f * host_size, dst_type,
+                          (uint8_t*) staging + i * n * size, format, n);
+        }
+    }
+    return length;
+}
+
+int Avtp_PcmSamples_InsertChannels(Avtp_Pcm_t* pdu, const void* const src[],
+                                   Avtp_PcmSampleType_t src_type,
+                                   const uint16_t map[], uint16_t map_len,
+                                   size_t frames)
+{
+    if (pdu == NULL) {
+        return -EINVAL;
+    }
+
+    return Avtp_PcmSamples_PackChannels(pdu->payload, Avtp_Pcm_GetFormat(pdu),
+                                        Avtp_Pcm_GetBitDepth(pdu), src, src_type,
+                                        Avtp_Pcm_GetChannelsPerFrame(pdu), map,
+                                        map_len, frames);
+}
+
+int Avtp_PcmSamples_ExtractChannels(Avtp_Pcm_t* pdu, void* const dst[],
+                                    Avtp_PcmSampleType_t dst_type,
+                                    const uint16_t map[], uint16_t map_len)
+{
+    uint8_t size;
+    uint16_t channels;
+    size_t frames;
+    int res;
+
+    if (pdu == NULL) {
+        return -EINVAL;
+    }
+
+    size = Avtp_PcmSamples_GetSampleSize(Avtp_Pcm_GetFormat(pdu));
+    channels = Avtp_Pcm_GetChannelsPerFrame(pdu);
+    if (size == 0 || channels == 0) {
+        return -EINVAL;
+    }
+
+    frames = Avtp_Pcm_GetStreamDataLength(pdu) / (channels * size);
+    res = Avtp_PcmSamples_UnpackChannels(dst, dst_type, pdu->payload,
+                                         Avtp_Pcm_GetFormat(pdu), channels,
+                                         map, map_len, frames);
+    return res < 0 ? res : (int) frames;
+}
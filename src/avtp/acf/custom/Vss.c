@@ -83,7 +83,7 @@ void Avtp_Vss_Pad(Avtp_Vss_t* vss_pdu, uint16_t vss_length) {
     // Check if padding is required
     padSize = (AVTP_QUADLET_SIZE - (vss_length % AVTP_QUADLET_SIZE)) % AVTP_QUADLET_SIZE;
     if (vss_length % AVTP_QUADLET_SIZE) {
-        memset(vss_pdu + vss_length, 0, padSize);
+        memset((uint8_t*) vss_pdu + vss_length, 0, padSize);
     }
 
     // Set the length and padding fields
@@ -189,12 +189,8 @@ void Avtp_Vss_DeserializeStringArray(VssDataStringArray_t* vss_data_string_array
     }
 }
 
-void Avtp_Vss_GetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
-
-    // Get a pointer to the start of the VSS data
-    uint8_t* vss_data_ptr = (uint8_t*) pdu + AVTP_VSS_FIXED_HEADER_LEN +
-                                Avtp_Vss_CalcVssPathLength(pdu);
-    Vss_Datatype_t datatype = Avtp_Vss_GetDatatype(pdu);
+static void Avtp_Vss_DecodeVssData(Vss_Datatype_t datatype,
+                                   uint8_t* vss_data_ptr, VssData_t* val) {
 
     uint32_t temp_float;
     uint64_t temp_double;
@@ -272,9 +268,8 @@ void Avtp_Vss_GetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
             val->data_uint16_array->data_length = Avtp_BeToCpu16(*(uint16_t*)vss_data_ptr);
             vss_data_ptr += 2;
             if (val->data_uint16_array->data != NULL) {
-                for (int i = 0; i < val->data_uint16_array->data_length/2; i++) {
-                    *(val->data_uint16_array->data + i) = Avtp_BeToCpu16(*((uint16_t*)vss_data_ptr+i));
-                }
+                Avtp_BeToCpuArray16(val->data_uint16_array->data, vss_data_ptr,
+                                    val->data_uint16_array->data_length/2);
             }
             break;
 
@@ -282,9 +277,8 @@ void Avtp_Vss_GetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
             val->data_int16_array->data_length = Avtp_BeToCpu16(*(uint16_t*)vss_data_ptr);
             vss_data_ptr += 2;
             if (val->data_int16_array->data != NULL) {
-                for (int i = 0; i < val->data_int16_array->data_length/2; i++) {
-                    *(val->data_int16_array->data + i) = (int16_t) Avtp_BeToCpu16(*((uint16_t*)vss_data_ptr+i));
-                }
+                Avtp_BeToCpuArray16(val->data_int16_array->data, vss_data_ptr,
+                                    val->data_int16_array->data_length/2);
             }
             break;
 
@@ -292,9 +286,8 @@ void Avtp_Vss_GetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
             val->data_uint32_array->data_length = Avtp_BeToCpu16(*(uint16_t*)vss_data_ptr);
             vss_data_ptr += 2;
             if (val->data_uint32_array->data != NULL) {
-                for (int i = 0; i < val->data_uint32_array->data_length/4; i++) {
-                    *(val->data_uint32_array->data + i) = Avtp_BeToCpu32(*((uint32_t*)vss_data_ptr+i));
-                }
+                Avtp_BeToCpuArray32(val->data_uint32_array->data, vss_data_ptr,
+                                    val->data_uint32_array->data_length/4);
             }
             break;
 
@@ -302,19 +295,17 @@ void Avtp_Vss_GetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
             val->data_int32_array->data_length = Avtp_BeToCpu16(*(uint16_t*)vss_data_ptr);
             vss_data_ptr += 2;
             if (val->data_int32_array->data != NULL) {
-                for (int i = 0; i < val->data_int32_array->data_length/4; i++) {
-                    *(val->data_int32_array->data + i) = (int32_t) Avtp_BeToCpu32(*((uint32_t*)vss_data_ptr+i));
-                }
+                Avtp_BeToCpuArray32(val->data_int32_array->data, vss_data_ptr,
+                                    val->data_int32_array->data_length/4);
             }
             break;
 
         case VSS_UINT64_ARRAY:
             val->data_uint64_array->data_length = Avtp_BeToCpu16(*(uint16_t*)vss_data_ptr);
             vss_data_ptr += 2;
-            if (val->data_int64_array->data != NULL) {
-                for (int i = 0; i < val->data_uint64_array->data_length/8; i++) {
-                    *(val->data_uint64_array->data + i) = Avtp_BeToCpu64(*((uint64_t*)vss_data_ptr+i));
-                }
+            if (val->data_uint64_array->data != NULL) {
+                Avtp_BeToCpuArray64(val->data_uint64_array->data, vss_data_ptr,
+                                    val->data_uint64_array->data_length/8);
             }
             break;
 
@@ -322,9 +313,8 @@ void Avtp_Vss_GetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
             val->data_int64_array->data_length = Avtp_BeToCpu16(*(uint16_t*)vss_data_ptr);
             vss_data_ptr += 2;
             if (val->data_int64_array->data != NULL) {
-                for (int i = 0; i < val->data_int64_array->data_length/8; i++) {
-                    *(val->data_int64_array->data + i) = (int64_t) Avtp_BeToCpu64(*((uint64_t*)vss_data_ptr+i));
-                }
+                Avtp_BeToCpuArray64(val->data_int64_array->data, vss_data_ptr,
+                                    val->data_int64_array->data_length/8);
             }
             break;
 
@@ -339,10 +329,8 @@ void Avtp_Vss_GetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
             val->data_float_array->data_length = Avtp_BeToCpu16(*(uint16_t*)vss_data_ptr);
             vss_data_ptr += 2;
             if (val->data_float_array->data != NULL) {
-                for (int i = 0; i < val->data_float_array->data_length/4; i++) {
-                    uint32_t temp_float = Avtp_BeToCpu32(*((uint32_t*)vss_data_ptr+i));
-                    memcpy(val->data_float_array->data + i, &temp_float, sizeof(float));
-                }
+                Avtp_BeToCpuArray32(val->data_float_array->data, vss_data_ptr,
+                                    val->data_float_array->data_length/4);
             }
             break;
 
@@ -350,10 +338,8 @@ void Avtp_Vss_GetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
             val->data_double_array->data_length = Avtp_BeToCpu16(*(uint16_t*)vss_data_ptr);
             vss_data_ptr += 2;
             if (val->data_double_array->data != NULL) {
-                for (int i = 0; i < val->data_double_array->data_length/8; i++) {
-                    uint64_t temp_double = Avtp_BeToCpu64(*((uint64_t*)vss_data_ptr+i));
-                    memcpy(val->data_double_array->data + i, &temp_double, sizeof(double));
-                }
+                Avtp_BeToCpuArray64(val->data_double_array->data, vss_data_ptr,
+                                    val->data_double_array->data_length/8);
             }
             break;
 
@@ -371,6 +357,363 @@ void Avtp_Vss_GetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
     }
 }
 
+void Avtp_Vss_GetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
+
+    // Get a pointer to the start of the VSS data
+    uint8_t* vss_data_ptr = (uint8_t*) pdu + AVTP_VSS_FIXED_HEADER_LEN +
+                                Avtp_Vss_CalcVssPathLength(pdu);
+
+    Avtp_Vss_DecodeVssData(Avtp_Vss_GetDatatype(pdu), vss_data_ptr, val);
+}
+
+static uint8_t Avtp_Vss_GetElementSize(Vss_Datatype_t datatype) {
+
+    switch (datatype) {
+        case VSS_UINT8:
+        case VSS_INT8:
+        case VSS_BOOL:
+        case VSS_STRING:
+        case VSS_UINT8_ARRAY:
+        case VSS_INT8_ARRAY:
+        case VSS_BOOL_ARRAY:
+        case VSS_STRING_ARRAY:
+            return 1;
+        case VSS_UINT16:
+        case VSS_INT16:
+        case VSS_UINT16_ARRAY:
+        case VSS_INT16_ARRAY:
+            return 2;
+        case VSS_UINT32:
+        case VSS_INT32:
+        case VSS_FLOAT:
+        case VSS_UINT32_ARRAY:
+        case VSS_INT32_ARRAY:
+        case VSS_FLOAT_ARRAY:
+            return 4;
+        case VSS_UINT64:
+        case VSS_INT64:
+        case VSS_DOUBLE:
+        case VSS_UINT64_ARRAY:
+        case VSS_INT64_ARRAY:
+        case VSS_DOUBLE_ARRAY:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+uint16_t Avtp_Vss_CalcVssDataLength(Vss_Datatype_t datatype, VssData_t* val) {
+
+    // Scalars are stored without a length field
+    if (datatype < VSS_STRING) {
+        return Avtp_Vss_GetElementSize(datatype);
+    }
+
+    // All string and array types share the same layout of the length field
+    switch (datatype) {
+        case VSS_STRING:
+            return 2 + val->data_string->data_length;
+        case VSS_UINT8_ARRAY:
+        case VSS_INT8_ARRAY:
+        case VSS_UINT16_ARRAY:
+        case VSS_INT16_ARRAY:
+        case VSS_UINT32_ARRAY:
+        case VSS_INT32_ARRAY:
+        case VSS_UINT64_ARRAY:
+        case VSS_INT64_ARRAY:
+        case VSS_BOOL_ARRAY:
+        case VSS_FLOAT_ARRAY:
+        case VSS_DOUBLE_ARRAY:
+        case VSS_STRING_ARRAY:
+            return 2 + val->data_uint8_array->data_length;
+        default:
+            return 0;
+    }
+}
+
+void Avtp_Vss_GetVssPathView(Avtp_Vss_t* pdu, VssPath_t* val) {
+
+    uint8_t* vss_path_ptr = (uint8_t*) pdu + AVTP_VSS_FIXED_HEADER_LEN;
+    uint16_t path_length;
+    uint32_t static_id;
+
+    // Check the used VSS addressing mode
+    Vss_AddrMode_t addr_mode = Avtp_Vss_GetAddrMode(pdu);
+
+    if (addr_mode == VSS_STATIC_ID_MODE) {
+        memcpy(&static_id, vss_path_ptr, sizeof(static_id));
+        val->vss_static_id_path = Avtp_BeToCpu32(static_id);
+    } else if (addr_mode == VSS_INTEROP_MODE) {
+        memcpy(&path_length, vss_path_ptr, sizeof(path_length));
+        val->vss_interop_path.path_length = Avtp_BeToCpu16(path_length);
+        val->vss_interop_path.path = (char*) vss_path_ptr + 2;
+    }
+}
+
+/* data_length is the length of an array or string without its length field,
+ * it is ignored for scalar values.
+ */
+static int Avtp_Vss_FillDataView(Vss_Datatype_t datatype, uint8_t* vss_data_ptr,
+                                 uint16_t data_length, VssDataView_t* view) {
+
+    uint8_t element_size = Avtp_Vss_GetElementSize(datatype);
+
+    if (element_size == 0) {
+        return -EINVAL;
+    }
+
+    view->datatype = datatype;
+    view->element_size = element_size;
+    view->big_endian = element_size > 1;
+
+    if (datatype < VSS_STRING) {
+        // Scalar values are stored without a length field
+        view->data = vss_data_ptr;
+        view->data_length = element_size;
+        view->count = 1;
+        return 0;
+    }
+
+    view->data = vss_data_ptr + 2;
+    view->data_length = data_length;
+    view->count = view->data_length / element_size;
+
+    if (datatype == VSS_STRING_ARRAY) {
+        VssDataStringArray_t str_array = {
+            .data_length = view->data_length,
+            .data = view->data
+        };
+        view->count = Avtp_Vss_GetVSSDataStringArrayLength(&str_array);
+    }
+
+    return 0;
+}
+
+int Avtp_Vss_GetVssDataView(Avtp_Vss_t* pdu, VssDataView_t* view) {
+
+    // Get a pointer to the start of the VSS data
+    uint8_t* vss_data_ptr = (uint8_t*) pdu + AVTP_VSS_FIXED_HEADER_LEN +
+                                Avtp_Vss_CalcVssPathLength(pdu);
+    Vss_Datatype_t datatype = Avtp_Vss_GetDatatype(pdu);
+    uint16_t data_length = 0;
+
+    if (datatype >= VSS_STRING) {
+        memcpy(&data_length, vss_data_ptr, sizeof(data_length));
+        data_length = Avtp_BeToCpu16(data_length);
+    }
+
+    return Avtp_Vss_FillDataView(datatype, vss_data_ptr, data_length, view);
+}
+
+uint64_t Avtp_Vss_GetViewElement(const VssDataView_t* view, uint16_t idx) {
+
+    const uint8_t* elem = view->data + (size_t) idx * view->element_size;
+    uint16_t val16;
+    uint32_t val32;
+    uint64_t val64;
+
+    switch (view->element_size) {
+        case 1:
+            return *elem;
+        case 2:
+            memcpy(&val16, elem, sizeof(val16));
+            return view->big_endian ? Avtp_BeToCpu16(val16) : val16;
+        case 4:
+            memcpy(&val32, elem, sizeof(val32));
+            return view->big_endian ? Avtp_BeToCpu32(val32) : val32;
+        case 8:
+            memcpy(&val64, elem, sizeof(val64));
+            return view->big_endian ? Avtp_BeToCpu64(val64) : val64;
+        default:
+            return 0;
+    }
+}
+
+uint16_t Avtp_Vss_CopyViewData(const VssDataView_t* view, void* dst,
+                               uint16_t max_elements) {
+
+    uint16_t count = view->count < max_elements ? view->count : max_elements;
+    uint8_t* out = (uint8_t*) dst;
+
+    if (view->datatype == VSS_STRING_ARRAY) {
+        // Copy the serialized array as is, count is in strings not bytes
+        count = view->data_length < max_elements ? view->data_length : max_elements;
+        memcpy(out, view->data, count);
+        return count;
+    }
+
+    if (!view->big_endian) {
+        memcpy(out, view->data, (size_t) count * view->element_size);
+        return count;
+    }
+
+    switch (view->element_size) {
+        case 2:
+            Avtp_BeToCpuArray16(out, view->data, count);
+            break;
+        case 4:
+            Avtp_BeToCpuArray32(out, view->data, count);
+            break;
+        case 8:
+            Avtp_BeToCpuArray64(out, view->data, count);
+            break;
+    }
+
+    return count;
+}
+
+int Avtp_Vss_NextStringView(const VssDataView_t* view, uint16_t* offset,
+                            VssDataString_t* str) {
+
+    uint16_t str_length;
+
+    if (view->datatype != VSS_STRING_ARRAY || *offset + 2 > view->data_length) {
+        return 0;
+    }
+
+    memcpy(&str_length, view->data + *offset, sizeof(str_length));
+    str_length = Avtp_BeToCpu16(str_length);
+    if (*offset + 2 + str_length > view->data_length) {
+        return 0;
+    }
+
+    str->data_length = str_length;
+    str->data = (char*) view->data + *offset + 2;
+    *offset += 2 + str_length;
+
+    return 1;
+}
+
+static uint32_t Avtp_Vss_GetHeaderField(uint32_t quadlet, Avtp_VssFields_t field) {
+
+    const Avtp_FieldDescriptor_t* desc = &Avtp_VssFieldDesc[field];
+    uint32_t mask = (1u << desc->bits) - 1;
+
+    return (quadlet >> (32 - desc->offset - desc->bits)) & mask;
+}
+
+int Avtp_Vss_Parse(Avtp_Vss_t* pdu, uint16_t len, Avtp_VssLayout_t* layout) {
+
+    return Avtp_Vss_ParseLayout((uint8_t*) pdu, len, AVTP_VSS_FIXED_HEADER_LEN,
+                                layout);
+}
+
+int Avtp_Vss_ParseLayout(uint8_t* ptr, uint16_t len, uint8_t header_length,
+                         Avtp_VssLayout_t* layout) {
+
+    uint32_t quadlet;
+    uint64_t timestamp;
+    uint16_t length_field, end;
+    uint32_t field_length;
+    uint8_t element_size, pad;
+
+    if (ptr == NULL || layout == NULL || header_length < AVTP_QUADLET_SIZE ||
+        len < header_length) {
+        return -EINVAL;
+    }
+
+    // All header bits except the timestamp are located in the first quadlet.
+    // VSS Brief shares this quadlet and only omits the timestamp.
+    memcpy(&quadlet, ptr, sizeof(quadlet));
+    quadlet = Avtp_BeToCpu32(quadlet);
+    if (Avtp_Vss_GetHeaderField(quadlet, AVTP_VSS_FIELD_ACF_MSG_TYPE) !=
+            AVTP_ACF_TYPE_VSS) {
+        return -EINVAL;
+    }
+    layout->header_length = header_length;
+    if (header_length == AVTP_VSS_FIXED_HEADER_LEN) {
+        memcpy(&timestamp, ptr + AVTP_QUADLET_SIZE, sizeof(timestamp));
+        layout->msg_timestamp = Avtp_BeToCpu64(timestamp);
+    } else {
+        layout->msg_timestamp = 0;
+    }
+
+    layout->pdu = ptr;
+    layout->msg_length = Avtp_Vss_GetHeaderField(quadlet, AVTP_VSS_FIELD_ACF_MSG_LENGTH) *
+                            AVTP_QUADLET_SIZE;
+    pad = Avtp_Vss_GetHeaderField(quadlet, AVTP_VSS_FIELD_PAD);
+    layout->mtv = Avtp_Vss_GetHeaderField(quadlet, AVTP_VSS_FIELD_MTV);
+    layout->addr_mode = Avtp_Vss_GetHeaderField(quadlet, AVTP_VSS_FIELD_ADDR_MODE);
+    layout->op = Avtp_Vss_GetHeaderField(quadlet, AVTP_VSS_FIELD_VSS_OP);
+    layout->datatype = Avtp_Vss_GetHeaderField(quadlet, AVTP_VSS_FIELD_VSS_DATATYPE);
+
+    if (layout->msg_length > len ||
+        layout->msg_length < layout->header_length + pad) {
+        return -EINVAL;
+    }
+    end = layout->msg_length - pad;
+
+    // Locate the path
+    // Lengths are summed in 32 bit so a length field of 0xFFFF cannot wrap
+    // around and are checked before they are stored in the layout.
+    layout->path_offset = layout->header_length;
+    if (layout->addr_mode == VSS_STATIC_ID_MODE) {
+        field_length = 4;
+    } else if (layout->addr_mode == VSS_INTEROP_MODE) {
+        if (layout->path_offset + 2 > end) {
+            return -EINVAL;
+        }
+        memcpy(&length_field, ptr + layout->path_offset, sizeof(length_field));
+        field_length = 2 + (uint32_t) Avtp_BeToCpu16(length_field);
+    } else {
+        return -EINVAL;
+    }
+    if (layout->path_offset + field_length > end) {
+        return -EINVAL;
+    }
+    layout->path_length = field_length;
+
+    // Locate the data
+    layout->data_offset = layout->path_offset + layout->path_length;
+    element_size = Avtp_Vss_GetElementSize(layout->datatype);
+    if (element_size == 0) {
+        return -EINVAL;
+    }
+    if (layout->datatype < VSS_STRING) {
+        field_length = element_size;
+    } else {
+        if (layout->data_offset + 2 > end) {
+            return -EINVAL;
+        }
+        memcpy(&length_field, ptr + layout->data_offset, sizeof(length_field));
+        field_length = 2 + (uint32_t) Avtp_BeToCpu16(length_field);
+    }
+    if (layout->data_offset + field_length > end) {
+        return -EINVAL;
+    }
+    layout->data_length = field_length;
+
+    return 0;
+}
+
+void Avtp_VssLayout_GetVssPath(const Avtp_VssLayout_t* layout, VssPath_t* val) {
+
+    uint8_t* vss_path_ptr = layout->pdu + layout->path_offset;
+    uint32_t static_id;
+
+    if (layout->addr_mode == VSS_STATIC_ID_MODE) {
+        memcpy(&static_id, vss_path_ptr, sizeof(static_id));
+        val->vss_static_id_path = Avtp_BeToCpu32(static_id);
+    } else {
+        val->vss_interop_path.path_length = layout->path_length - 2;
+        val->vss_interop_path.path = (char*) vss_path_ptr + 2;
+    }
+}
+
+void Avtp_VssLayout_GetVssDataView(const Avtp_VssLayout_t* layout, VssDataView_t* view) {
+
+    uint16_t data_length = layout->datatype < VSS_STRING ? layout->data_length :
+                                                           layout->data_length - 2;
+
+    Avtp_Vss_FillDataView(layout->datatype, layout->pdu + layout->data_offset,
+                          data_length, view);
+}
+
+void Avtp_VssLayout_GetVssData(const Avtp_VssLayout_t* layout, VssData_t* val) {
+
+    Avtp_Vss_DecodeVssData(layout->datatype, layout->pdu + layout->data_offset, val);
+}
+
 void Avtp_Vss_SetAcfMsgType(Avtp_Vss_t* pdu, Avtp_AcfMsgType_t val) {
     SET_FIELD(AVTP_VSS_FIELD_ACF_MSG_TYPE, val);
 }
@@ -411,11 +754,13 @@ void Avtp_Vss_SetMsgTimestamp(Avtp_Vss_t* pdu, uint64_t val)  {
 
 void Avtp_Vss_SetVssPath(Avtp_Vss_t* pdu, VssPath_t* val)
 {
-    uint8_t* vss_path_ptr = (uint8_t*) pdu + AVTP_VSS_FIXED_HEADER_LEN;
-
-    // Check the used VSS addressing mode
-    Vss_AddrMode_t addr_mode = Avtp_Vss_GetAddrMode(pdu);
+    Avtp_Vss_SerializeVssPath((uint8_t*) pdu + AVTP_VSS_FIXED_HEADER_LEN,
+                              Avtp_Vss_GetAddrMode(pdu), val);
+}
 
+void Avtp_Vss_SerializeVssPath(uint8_t* vss_path_ptr, Vss_AddrMode_t addr_mode,
+                               VssPath_t* val)
+{
     if (addr_mode == VSS_STATIC_ID_MODE) {
         uint32_t* static_id = (uint32_t*) vss_path_ptr;
         *static_id = Avtp_CpuToBe32(val->vss_static_id_path);
@@ -431,7 +776,12 @@ void Avtp_Vss_SetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
     // Get a pointer to the start of the VSS data
     uint8_t* vss_data_ptr = (uint8_t*) pdu + AVTP_VSS_FIXED_HEADER_LEN +
                                 Avtp_Vss_CalcVssPathLength(pdu);
-    Vss_Datatype_t datatype = Avtp_Vss_GetDatatype(pdu);
+
+    Avtp_Vss_SerializeVssData(vss_data_ptr, Avtp_Vss_GetDatatype(pdu), val);
+}
+
+void Avtp_Vss_SerializeVssData(uint8_t* vss_data_ptr, Vss_Datatype_t datatype,
+                               VssData_t* val) {
 
     uint32_t temp_float;
     uint64_t temp_double;
@@ -504,44 +854,38 @@ void Avtp_Vss_SetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
 
         case VSS_UINT16_ARRAY:
             *(uint16_t*)vss_data_ptr = Avtp_CpuToBe16(val->data_uint16_array->data_length);
-            for (int i = 0; i < val->data_uint16_array->data_length/2; i++) {
-                *((uint16_t*)(vss_data_ptr+2) + i) = Avtp_CpuToBe16(*(val->data_uint16_array->data+i));
-            }
+            Avtp_CpuToBeArray16(vss_data_ptr+2, val->data_uint16_array->data,
+                                val->data_uint16_array->data_length/2);
             break;
 
         case VSS_INT16_ARRAY:
             *(uint16_t*)vss_data_ptr = Avtp_CpuToBe16(val->data_int16_array->data_length);
-            for (int i = 0; i < val->data_int16_array->data_length/2; i++) {
-                *((int16_t*)(vss_data_ptr+2) + i) = Avtp_CpuToBe16(*(val->data_int16_array->data+i));
-            }
+            Avtp_CpuToBeArray16(vss_data_ptr+2, val->data_int16_array->data,
+                                val->data_int16_array->data_length/2);
             break;
 
         case VSS_UINT32_ARRAY:
             *(uint16_t*)vss_data_ptr = Avtp_CpuToBe16(val->data_uint32_array->data_length);
-            for (int i = 0; i < val->data_uint32_array->data_length/4; i++) {
-                *((uint32_t*)(vss_data_ptr+2) + i) = Avtp_CpuToBe32(*(val->data_uint32_array->data+i));
-            }
+            Avtp_CpuToBeArray32(vss_data_ptr+2, val->data_uint32_array->data,
+                                val->data_uint32_array->data_length/4);
             break;
 
         case VSS_INT32_ARRAY:
             *(uint16_t*)vss_data_ptr = Avtp_CpuToBe16(val->data_int32_array->data_length);
-            for (int i = 0; i < val->data_int32_array->data_length/4; i++) {
-                *((int32_t*)(vss_data_ptr+2) + i) = Avtp_CpuToBe32(*(val->data_int32_array->data+i));
-            }
+            Avtp_CpuToBeArray32(vss_data_ptr+2, val->data_int32_array->data,
+                                val->data_int32_array->data_length/4);
             break;
 
         case VSS_UINT64_ARRAY:
             *(uint16_t*)vss_data_ptr = Avtp_CpuToBe16(val->data_uint64_array->data_length);
-            for (int i = 0; i < val->data_uint64_array->data_length/8; i++) {
-                *((uint64_t*)(vss_data_ptr+2) + i) = Avtp_CpuToBe64(*(val->data_uint64_array->data+i));
-            }
+            Avtp_CpuToBeArray64(vss_data_ptr+2, val->data_uint64_array->data,
+                                val->data_uint64_array->data_length/8);
             break;
 
         case VSS_INT64_ARRAY:
             *(uint16_t*)vss_data_ptr = Avtp_CpuToBe16(val->data_int64_array->data_length);
-            for (int i = 0; i < val->data_int64_array->data_length/8; i++) {
-                *((int64_t*)(vss_data_ptr+2) + i) = Avtp_CpuToBe64(*(val->data_int64_array->data+i));
-            }
+            Avtp_CpuToBeArray64(vss_data_ptr+2, val->data_int64_array->data,
+                                val->data_int64_array->data_length/8);
             break;
 
         case VSS_BOOL_ARRAY:
@@ -552,18 +896,14 @@ void Avtp_Vss_SetVssData(Avtp_Vss_t* pdu, VssData_t* val) {
 
         case VSS_FLOAT_ARRAY:
             *(uint16_t*)vss_data_ptr = Avtp_CpuToBe16(val->data_float_array->data_length);
-            for (int i = 0; i < val->data_float_array->data_length/4; i++) {
-                uint32_t temp_float = Avtp_CpuToBe32(*(uint32_t*)(val->data_float_array->data+i));
-                memcpy((uint32_t*)(vss_data_ptr+2) + i, &temp_float, sizeof(float));
-            }
+            Avtp_CpuToBeArray32(vss_data_ptr+2, val->data_float_array->data,
+                                val->data_float_array->data_length/4);
             break;
 
         case VSS_DOUBLE_ARRAY:
             *(uint16_t*)vss_data_ptr = Avtp_CpuToBe16(val->data_double_array->data_length);
-            for (int i = 0; i < val->data_double_array->data_length/8; i++) {
-                uint64_t temp_double = Avtp_CpuToBe64(*(uint64_t*)(val->data_double_array->data+i));
-                memcpy((uint64_t*)(vss_data_ptr+2) + i, &temp_double, sizeof(double));
-            }
+            Avtp_CpuToBeArray64(vss_data_ptr+2, val->data_double_array->data,
+                                val->data_double_array->data_length/8);
             break;
 
         case VSS_STRING_ARRAY:
@@ -34,6 +34,7 @@
 #include "avtp/acf/custom/VssBrief.h"
 #include "avtp/Utils.h"
 #include "avtp/Defines.h"
+#include "avtp/Byteorder.h"
 
 /**
  * This table maps all IEEE 1722 ACF VSS header fields to a descriptor.
@@ -71,4 +72,52 @@ void Avtp_VssBrief_SetField(Avtp_VssBrief_t* vss_pdu,
 {
     Avtp_SetField(Avtp_VssBriefFieldDesc, AVTP_VSS_BRIEF_FIELD_MAX,
                          (uint8_t *) vss_pdu, (uint8_t) field, value);
-}
\ No newline at end of file
+}
+
+static uint16_t Avtp_VssBrief_CalcVssPathLength(Avtp_VssBrief_t* vss_pdu)
+{
+    uint8_t* vss_path_ptr = (uint8_t*) vss_pdu + AVTP_VSS_BRIEF_HEADER_LEN;
+    uint16_t path_length;
+
+    if (Avtp_VssBrief_GetField(vss_pdu, AVTP_VSS_BRIEF_FIELD_ADDR_MODE) ==
+            VSS_STATIC_ID_MODE) {
+        return 4;
+    }
+
+    memcpy(&path_length, vss_path_ptr, sizeof(path_length));
+    return Avtp_BeToCpu16(path_length) + 2;
+}
+
+void Avtp_VssBrief_SetVssPath(Avtp_VssBrief_t* vss_pdu, VssPath_t* val)
+{
+    Avtp_Vss_SerializeVssPath((uint8_t*) vss_pdu + AVTP_VSS_BRIEF_HEADER_LEN,
+            Avtp_VssBrief_GetField(vss_pdu, AVTP_VSS_BRIEF_FIELD_ADDR_MODE), val);
+}
+
+void Avtp_VssBrief_SetVssData(Avtp_VssBrief_t* vss_pdu, VssData_t* val)
+{
+    uint8_t* vss_data_ptr = (uint8_t*) vss_pdu + AVTP_VSS_BRIEF_HEADER_LEN +
+                                Avtp_VssBrief_CalcVssPathLength(vss_pdu);
+
+    Avtp_Vss_SerializeVssData(vss_data_ptr,
+            Avtp_VssBrief_GetField(vss_pdu, AVTP_VSS_BRIEF_FIELD_VSS_DATATYPE), val);
+}
+
+void Avtp_VssBrief_Pad(Avtp_VssBrief_t* vss_pdu, uint16_t vss_length)
+{
+    uint8_t padSize;
+
+    padSize = (AVTP_QUADLET_SIZE - (vss_length % AVTP_QUADLET_SIZE)) % AVTP_QUADLET_SIZE;
+    memset((uint8_t*) vss_pdu + vss_length, 0, padSize);
+
+    Avtp_VssBrief_SetField(vss_pdu, AVTP_VSS_BRIEF_FIELD_ACF_MSG_LENGTH,
+                           (uint64_t) (vss_length + padSize) / AVTP_QUADLET_SIZE);
+    Avtp_VssBrief_SetField(vss_pdu, AVTP_VSS_BRIEF_FIELD_PAD, padSize);
+}
+
+int Avtp_VssBrief_Parse(Avtp_VssBrief_t* vss_pdu, uint16_t len,
+                        Avtp_VssLayout_t* layout)
+{
+    return Avtp_Vss_ParseLayout((uint8_t*) vss_pdu, len,
+                                AVTP_VSS_BRIEF_HEADER_LEN, layout);
+}
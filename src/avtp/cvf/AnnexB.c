@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "avtp/cvf/AnnexB.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(LINUX_KERNEL1722) && !defined(__ZEPHYR__)
+#define AVTP_ANNEXB_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && !defined(LINUX_KERNEL1722) && !defined(__ZEPHYR__)
+#define AVTP_ANNEXB_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef size_t (*Avtp_AnnexB_FindFn_t)(const uint8_t* data, size_t len);
+
+typedef struct {
+    Avtp_AnnexBIsa_t isa;
+    Avtp_AnnexB_FindFn_t Find;
+} Avtp_AnnexBKernels_t;
+
+/* Selected on first use, see Avtp_AnnexB_SelectIsa() */
+static const Avtp_AnnexBKernels_t* Kernels;
+
+/*
+ * Skips ahead by the third byte of each candidate: a byte above 1 cannot be
+ * part of a start code prefix, so the search moves past it.
+ */
+static size_t FindScalar(const uint8_t* data, size_t len)
+{
+    size_t i = 0;
+
+    while (i + 2 < len) {
+        if (data[i + 2] == 0x01) {
+            if (data[i] == 0x00 && data[i + 1] == 0x00) {
+                return i;
+            }
+            i += 3;
+        } else if (data[i + 2] == 0x00) {
+            i++;
+        } else {
+            i += 3;
+        }
+    }
+    return len;
+}
+
+#if defined(AVTP_ANNEXB_X86)
+
+/*
+ * Compares each position and the two following ones at once: a start code
+ * begins where the first two bytes OR to zero and the third is one.
+ */
+__attribute__((target("sse2")))
+static size_t FindSse2(const uint8_t* data, size_t len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    size_t i = 0;
+
+    for (; i + 18 <= len; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*) (data + i));
+        __m128i b = _mm_loadu_si128((const __m128i*) (data + i + 1));
+        __m128i c = _mm_loadu_si128((const __m128i*) (data + i + 2));
+        __m128i m = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(a, b), zero),
+                                  _mm_cmpeq_epi8(c, one));
+        int bits = _mm_movemask_epi8(m);
+
+        if (bits != 0) {
+            return i + __builtin_ctz(bits);
+        }
+    }
+    return i + FindScalar(data + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t FindAvx2(const uint8_t* data, size_t len)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    size_t i = 0;
+
+    for (; i + 34 <= len; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*) (data + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*) (data + i + 1));
+        __m256i c = _mm256_loadu_si256((const __m256i*) (data + i + 2));
+        __m256i m = _mm256_and_si256(
+                        _mm256_cmpeq_epi8(_mm256_or_si256(a, b), zero),
+                        _mm256_cmpeq_epi8(c, one));
+        uint32_t bits = (uint32_t) _mm256_movemask_epi8(m);
+
+        if (bits != 0) {
+            return i + __builtin_ctz(bits);
+        }
+    }
+    return i + FindSse2(data + i, len - i);
+}
+
+#elif defined(AVTP_ANNEXB_NEON)
+
+static size_t FindNeon(const uint8_t* data, size_t len)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    size_t i = 0;
+
+    for (; i + 18 <= len; i += 16) {
+        uint8x16_t a = vld1q_u8(data + i);
+        uint8x16_t b = vld1q_u8(data + i + 1);
+        uint8x16_t c = vld1q_u8(data + i + 2);
+        uint64x2_t m = vreinterpretq_u64_u8(
+                           vandq_u8(vceqq_u8(vorrq_u8(a, b), zero),
+                                    vceqq_u8(c, one)));
+
+        /* The block has a match, locate it within its 16 positions */
+        if ((vgetq_lane_u64(m, 0) | vgetq_lane_u64(m, 1)) != 0) {
+            return i + FindScalar(data + i, 18);
+        }
+    }
+    return i + FindScalar(data + i, len - i);
+}
+
+#endif
+
+static const Avtp_AnnexBKernels_t ScalarKernels = {
+    .isa = AVTP_ANNEXB_ISA_SCALAR,
+    .Find = FindScalar,
+};
+
+#if defined(AVTP_ANNEXB_X86)
+static const Avtp_AnnexBKernels_t Sse2Kernels = {
+    .isa = AVTP_ANNEXB_ISA_SSE2,
+    .Find = FindSse2,
+};
+
+static const Avtp_AnnexBKernels_t Avx2Kernels = {
+    .isa = AVTP_ANNEXB_ISA_AVX2,
+    .Find = FindAvx2,
+};
+#elif defined(AVTP_ANNEXB_NEON)
+static const Avtp_AnnexBKernels_t NeonKernels = {
+    .isa = AVTP_ANNEXB_ISA_NEON,
+    .Find = FindNeon,
+};
+#endif
+
+static const Avtp_AnnexBKernels_t* FindKernels(Avtp_AnnexBIsa_t isa)
+{
+#if defined(AVTP_ANNEXB_X86)
+    __builtin_cpu_init();
+    if ((isa == AVTP_ANNEXB_ISA_AUTO || isa == AVTP_ANNEXB_ISA_AVX2) &&
+        __builtin_cpu_supports("avx2")) {
+        return &Avx2Kernels;
+    }
+    if ((isa == AVTP_ANNEXB_ISA_AUTO || isa == AVTP_ANNEXB_ISA_SSE2) &&
+        __builtin_cpu_supports("sse2")) {
+        return &Sse2Kernels;
+    }
+#elif defined(AVTP_ANNEXB_NEON)
+    if (isa == AVTP_ANNEXB_ISA_AUTO || isa == AVTP_ANNEXB_ISA_NEON) {
+        return &NeonKernels;
+    }
+#endif
+    if (isa == AVTP_ANNEXB_ISA_AUTO || isa == AVTP_ANNEXB_ISA_SCALAR) {
+        return &ScalarKernels;
+    }
+    return NULL;
+}
+
+static const Avtp_AnnexBKernels_t* GetKernels(void)
+{
+    const Avtp_AnnexBKernels_t* kernels = __atomic_load_n(&Kernels, __ATOMIC_RELAXED);
+
+    if (kernels == NULL) {
+        kernels = FindKernels(AVTP_ANNEXB_ISA_AUTO);
+        __atomic_store_n(&Kernels, kernels, __ATOMIC_RELAXED);
+    }
+    return kernels;
+}
+
+int Avtp_AnnexB_SelectIsa(Avtp_AnnexBIsa_t isa)
+{
+    const Avtp_AnnexBKernels_t* kernels = FindKernels(isa);
+
+    if (kernels == NULL) {
+        return -ENOTSUP;
+    }
+    __atomic_store_n(&Kernels, kernels, __ATOMIC_RELAXED);
+    return 0;
+}
+
+Avtp_AnnexBIsa_t Avtp_AnnexB_GetIsa(void)
+{
+    return GetKernels()->isa;
+}
+
+size_t Avtp_AnnexB_FindStartCode(const uint8_t* data, size_t len)
+{
+    if (data == NULL) {
+        return len;
+    }
+    return GetKernels()->Find(data, len);
+}
+
+int Avtp_AnnexB_Init(Avtp_AnnexB_Reader_t* r, uint8_t* buf, size_t size)
+{
+    if (r == NULL || buf == NULL || size < 2 * AVTP_ANNEXB_START_CODE_LEN ||
+            (size & (size - 1)) != 0) {
+        return -EINVAL;
+    }
+
+    memset(r, 0, sizeof(*r));
+    r->buf = buf;
+    r->mask = size - 1;
+    return 0;
+}
+
+size_t Avtp_AnnexB_GetWriteSpace(Avtp_AnnexB_Reader_t* r, uint8_t** ptr)
+{
+    size_t size, index, space;
+
+    if (r == NULL || ptr == NULL) {
+        return 0;
+    }
+
+    size = r->mask + 1;
+    index = r->head & r->mask;
+    space = size - (size_t) (r->head - r->tail);
+    *ptr = r->buf + index;
+    return space < size - index ? space : size - index;
+}
+
+void Avtp_AnnexB_Commit(Avtp_AnnexB_Reader_t* r, size_t len)
+{
+    if (r != NULL) {
+        r->head += len;
+    }
+}
+
+static inline uint8_t At(const Avtp_AnnexB_Reader_t* r, uint64_t pos)
+{
+    return r->buf[pos & r->mask];
+}
+
+/* Finds a start code between positions from and to, returns to if none */
+static uint64_t FindInRing(const Avtp_AnnexB_Reader_t* r,
+                           Avtp_AnnexB_FindFn_t find, uint64_t from,
+                           uint64_t to)
+{
+    size_t index = from & r->mask;
+    size_t len = (size_t) (to - from);
+    size_t first = r->mask + 1 - index;
+    size_t offset;
+    uint64_t pos;
+
+    if (len <= first) {
+        offset = find(r->buf + index, len);
+        return offset < len ? from + offset : to;
+    }
+
+    offset = find(r->buf + index, first);
+    if (offset < first) {
+        return from + offset;
+    }
+
+    /* Start codes across the end of the ring */
+    pos = first >= 2 ? from + first - 2 : from;
+    for (; pos < from + first && pos + 2 < to; pos++) {
+        if (At(r, pos) == 0x00 && At(r, pos + 1) == 0x00 &&
+                At(r, pos + 2) == 0x01) {
+            return pos;
+        }
+    }
+
+    offset = find(r->buf, len - first);
+    return offset < len - first ? from + first + offset : to;
+}
+
+int Avtp_AnnexB_NextNal(Avtp_AnnexB_Reader_t* r, int flush,
+                        Avtp_AnnexB_Nal_t* nal)
+{
+    Avtp_AnnexB_FindFn_t find;
+    uint64_t pos, start, end;
+    size_t index, first;
+
+    if (r == NULL || nal == NULL) {
+        return -EINVAL;
+    }
+
+    /* Release the NAL unit returned by the previous call */
+    if (r->returned) {
+        r->tail = r->next;
+        r->returned = 0;
+    }
+
+    find = GetKernels()->Find;
+
+    for (;;) {
+        if (!r->in_nal) {
+            pos = FindInRing(r, find, r->scan, r->head);
+            if (pos == r->head) {
+                /* Discard all but the bytes that may begin a start code */
+                if (r->head - r->scan > 2) {
+                    r->scan = r->head - 2;
+                }
+                r->tail = r->scan;
+                return 0;
+            }
+            r->tail = pos;
+            r->nal = pos + AVTP_ANNEXB_START_CODE_LEN;
+            r->scan = r->nal;
+            r->in_nal = 1;
+        }
+
+        start = r->nal;
+        pos = FindInRing(r, find, r->scan, r->head);
+        if (pos < r->head) {
+            r->next = pos;
+            r->nal = pos + AVTP_ANNEXB_START_CODE_LEN;
+            r->scan = r->nal;
+        } else if (flush) {
+            r->next = r->head;
+            r->scan = r->head;
+            r->in_nal = 0;
+        } else {
+            if (r->head - r->scan > 2) {
+                r->scan = r->head - 2;
+            }
+            if (r->head - r->tail > r->mask) {
+                return -ENOSPC;
+            }
+            return 0;
+        }
+
+        /* Trailing zero bytes, e.g. of a 4-byte start code, are not part of
+         * the NAL unit.
+         */
+        end = r->next;
+        while (end > start && At(r, end - 1) == 0x00) {
+            end--;
+        }
+        if (end == start) {
+            r->tail = r->next;
+            continue;
+        }
+
+        index = start & r->mask;
+        first = r->mask + 1 - index;
+        nal->data = r->buf + index;
+        if (end - start <= first) {
+            nal->len = (size_t) (end - start);
+            nal->wrap_data = NULL;
+            nal->wrap_len = 0;
+        } else {
+            nal->len = first;
+            nal->wrap_data = r->buf;
+            nal->wrap_len = (size_t) (end - start) - first;
+        }
+        r->returned = 1;
+        return 1;
+    }
+}
@@ -70,3 +70,174 @@ void Avtp_H264_SetTimestamp(Avtp_H264_t* pdu, uint32_t value)
 {
     SET_FIELD(AVTP_H264_FIELD_TIMESTAMP, value);
 }
+
+/* FU indicator: F and NRI of the NAL unit, type FU-A */
+#define FU_INDICATOR(nal_hdr)   (((nal_hdr) & 0xE0) | AVTP_H264_NAL_TYPE_FU_A)
+#define FU_START                0x80
+#define FU_END                  0x40
+#define NAL_TYPE(hdr)           ((hdr) & 0x1F)
+
+int Avtp_H264_NextFragment(const uint8_t* nal, size_t nal_len, size_t* offset,
+                           size_t max_len, Avtp_H264_Fragment_t* frag)
+{
+    size_t pos, room;
+
+    if (nal == NULL || offset == NULL || frag == NULL || nal_len == 0 ||
+            max_len <= AVTP_H264_FU_HEADER_LEN) {
+        return -EINVAL;
+    }
+
+    pos = *offset;
+    if (pos >= nal_len) {
+        return 0;
+    }
+
+    if (pos == 0 && nal_len <= max_len) {
+        frag->header_len = 0;
+        frag->last = 1;
+        frag->data = nal;
+        frag->data_len = nal_len;
+        *offset = nal_len;
+        return 1;
+    }
+
+    /* The NAL unit header is carried in the FU indicator and header, so the
+     * first fragment starts after it.
+     */
+    if (pos == 0) {
+        pos = 1;
+    }
+
+    room = max_len - AVTP_H264_FU_HEADER_LEN;
+    frag->header[0] = FU_INDICATOR(nal[0]);
+    frag->header[1] = NAL_TYPE(nal[0]);
+    if (pos == 1) {
+        frag->header[1] |= FU_START;
+    }
+    frag->header_len = AVTP_H264_FU_HEADER_LEN;
+    frag->data = nal + pos;
+    frag->data_len = nal_len - pos < room ? nal_len - pos : room;
+    frag->last = pos + frag->data_len == nal_len;
+    if (frag->last) {
+        frag->header[1] |= FU_END;
+    }
+
+    *offset = pos + frag->data_len;
+    return 1;
+}
+
+void Avtp_H264_ReassemblerInit(Avtp_H264_Reassembler_t* r, uint8_t* buf,
+                               size_t size)
+{
+    if (r != NULL) {
+        memset(r, 0, sizeof(*r));
+        r->buf = buf;
+        r->size = size;
+    }
+}
+
+void Avtp_H264_ReassemblerSetBuffer(Avtp_H264_Reassembler_t* r, uint8_t* buf,
+                                    size_t size)
+{
+    if (r != NULL) {
+        if (r->in_progress) {
+            r->stats.dropped_nal_units++;
+        }
+        r->buf = buf;
+        r->size = size;
+        r->len = 0;
+        r->in_progress = 0;
+    }
+}
+
+static void DropNal(Avtp_H264_Reassembler_t* r)
+{
+    if (r->in_progress) {
+        r->stats.dropped_nal_units++;
+        r->in_progress = 0;
+    }
+}
+
+int Avtp_H264_Reassemble(Avtp_H264_Reassembler_t* r, uint8_t seq_num,
+                         uint8_t m, const uint8_t* payload, size_t len,
+                         const uint8_t** nal, size_t* nal_len)
+{
+    uint8_t fu_header;
+
+    if (r == NULL || payload == NULL || nal == NULL || nal_len == NULL) {
+        return -EINVAL;
+    }
+
+    if (r->seq_valid && seq_num == (uint8_t)(r->expected_seq - 1)) {
+        /* Duplicate of the previous PDU */
+        return 0;
+    }
+    if (r->seq_valid && seq_num != r->expected_seq) {
+        r->stats.lost_pdus += (uint8_t)(seq_num - r->expected_seq);
+        DropNal(r);
+    }
+    r->seq_valid = 1;
+    r->expected_seq = seq_num + 1;
+
+    if (len == 0) {
+        DropNal(r);
+        return 0;
+    }
+
+    if (NAL_TYPE(payload[0]) != AVTP_H264_NAL_TYPE_FU_A) {
+        DropNal(r);
+        r->stats.nal_units++;
+        *nal = payload;
+        *nal_len = len;
+        return 1;
+    }
+
+    if (len <= AVTP_H264_FU_HEADER_LEN) {
+        DropNal(r);
+        return 0;
+    }
+
+    fu_header = payload[1];
+    payload += AVTP_H264_FU_HEADER_LEN;
+    len -= AVTP_H264_FU_HEADER_LEN;
+
+    if (fu_header & FU_START) {
+        DropNal(r);
+        if (r->buf == NULL || r->size < 1) {
+            r->stats.dropped_nal_units++;
+            return 0;
+        }
+        /* Rebuild the NAL unit header from FU indicator and FU header */
+        r->buf[0] = (payload[-AVTP_H264_FU_HEADER_LEN] & 0xE0) |
+                    NAL_TYPE(fu_header);
+        r->len = 1;
+        r->in_progress = 1;
+    } else if (!r->in_progress) {
+        /* Start of the NAL unit was lost */
+        return 0;
+    }
+
+    if (len > r->size - r->len) {
+        DropNal(r);
+        return 0;
+    }
+    memcpy(r->buf + r->len, payload, len);
+    r->len += len;
+
+    if (!(fu_header & FU_END)) {
+        /* The M bit marks the last PDU of an access unit, which must end a
+         * NAL unit.
+         */
+        if (m) {
+            DropNal(r);
+        }
+        return 0;
+    }
+
+    r->in_progress = 0;
+    r->stats.nal_units++;
+    r->stats.fragmented++;
+    *nal = r->buf;
+    *nal_len = r->len;
+    return 1;
+}
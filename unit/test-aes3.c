@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <errno.h>
+#include <string.h>
+
+#include "avtp/aaf/Aes3.h"
+#include "avtp/aaf/PcmSamples.h"
+
+#define MAX_CHANNELS        8
+#define MAX_FRAMES          600
+#define MAX_SAMPLES         (MAX_CHANNELS * MAX_FRAMES)
+
+static const Avtp_PcmIsa_t isas[] = {
+    AVTP_PCM_ISA_SCALAR, AVTP_PCM_ISA_SSSE3, AVTP_PCM_ISA_AVX2, AVTP_PCM_ISA_NEON
+};
+static const uint16_t channel_counts[] = { 1, 2, 3, 8 };
+
+static int32_t samples[MAX_SAMPLES];
+static int32_t decoded[MAX_SAMPLES];
+static uint8_t payload[MAX_SAMPLES * 4];
+static uint8_t channel_status[MAX_CHANNELS * AVTP_AES3_BLOCK_LEN];
+static uint8_t user_data[MAX_CHANNELS * AVTP_AES3_BLOCK_LEN];
+static uint8_t cs_out[MAX_CHANNELS * AVTP_AES3_BLOCK_LEN];
+static uint8_t ud_out[MAX_CHANNELS * AVTP_AES3_BLOCK_LEN];
+static uint8_t work[AVTP_AES3_DECODER_WORK_SIZE(MAX_CHANNELS)];
+
+static void fill_blocks(uint16_t channels)
+{
+    for (uint16_t c = 0; c < channels; c++) {
+        uint8_t* cs = channel_status + c * AVTP_AES3_BLOCK_LEN;
+        for (int i = 0; i < AVTP_AES3_BLOCK_LEN; i++) {
+            cs[i] = (uint8_t) (c * 31 + i * 7 + 1);
+            user_data[c * AVTP_AES3_BLOCK_LEN + i] = (uint8_t) (c * 13 + i * 29);
+        }
+        cs[0] |= 1;     // Professional format, with CRCC
+        cs[AVTP_AES3_BLOCK_LEN - 1] = Avtp_Aes3_CalcCrc(cs);
+    }
+}
+
+/* Checks a subframe against the layout documented in Aes3.h */
+static void check_subframe(const uint8_t* word, int32_t sample, uint16_t c,
+                           int frame)
+{
+    uint32_t w = (uint32_t) word[0] << 24 | word[1] << 16 | word[2] << 8 | word[3];
+    uint8_t pre = c & 1 ? AVTP_AES3_PREAMBLE_Y :
+                  frame == 0 ? AVTP_AES3_PREAMBLE_Z : AVTP_AES3_PREAMBLE_X;
+    const uint8_t* cs = channel_status + c * AVTP_AES3_BLOCK_LEN;
+    const uint8_t* ud = user_data + c * AVTP_AES3_BLOCK_LEN;
+
+    assert_int_equal(w >> 28, pre);
+    assert_int_equal((w >> 4) & 0xFFFFFF, ((uint32_t) sample >> 8) & 0xFFFFFF);
+    assert_int_equal((w >> 3) & 1, 1);
+    assert_int_equal((w >> 2) & 1, (ud[frame / 8] >> (frame % 8)) & 1);
+    assert_int_equal((w >> 1) & 1, (cs[frame / 8] >> (frame % 8)) & 1);
+    assert_int_equal(__builtin_parity(w & 0x0FFFFFFF), 0);
+}
+
+static void aes3_round_trip(void **state)
+{
+    for (size_t i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+        if (Avtp_Aes3_SelectIsa(isas[i]) < 0) {
+            continue;
+        }
+        assert_int_equal(Avtp_Aes3_GetIsa(), isas[i]);
+
+        for (size_t c = 0; c < sizeof(channel_counts) / sizeof(channel_counts[0]); c++) {
+            uint16_t channels = channel_counts[c];
+            Avtp_Aes3Encoder_t enc;
+            Avtp_Aes3Decoder_t dec;
+            size_t n, blocks = 0;
+
+            fill_blocks(channels);
+            for (size_t s = 0; s < MAX_FRAMES * channels; s++) {
+                samples[s] = (int32_t) (s * 2654435761u);
+            }
+
+            assert_int_equal(Avtp_Aes3_InitEncoder(&enc, channels,
+                                channel_status, user_data), 0);
+            assert_int_equal(Avtp_Aes3_InitDecoder(&dec, channels, work,
+                                cs_out, ud_out), 0);
+            enc.validity = 1;
+
+            // Odd packet sizes make the blocks span packets
+            for (size_t f = 0; f < MAX_FRAMES; f += n) {
+                int res;
+
+                n = MAX_FRAMES - f < 7 ? MAX_FRAMES - f : 7;
+                assert_int_equal(Avtp_Aes3_Encode(&enc, payload + f * channels * 4,
+                                    samples + f * channels, n), n * channels * 4);
+                res = Avtp_Aes3_Decode(&dec, decoded + f * channels,
+                                       payload + f * channels * 4, n);
+                assert_true(res >= 0);
+                blocks += res;
+            }
+
+            for (size_t s = 0; s < MAX_FRAMES * channels; s++) {
+                check_subframe(payload + s * 4, samples[s], s % channels,
+                               (s / channels) % AVTP_AES3_BLOCK_FRAMES);
+                assert_int_equal(decoded[s], samples[s] & (int32_t) 0xFFFFFF00);
+            }
+
+            assert_int_equal(blocks, MAX_FRAMES / AVTP_AES3_BLOCK_FRAMES);
+            assert_int_equal(dec.blocks, blocks);
+            assert_memory_equal(cs_out, channel_status, channels * AVTP_AES3_BLOCK_LEN);
+            assert_memory_equal(ud_out, user_data, channels * AVTP_AES3_BLOCK_LEN);
+            assert_int_equal(dec.parity_errors, 0);
+            assert_int_equal(dec.crc_errors, 0);
+            assert_int_equal(dec.sync_errors, 0);
+            assert_int_equal(dec.invalid, MAX_FRAMES * channels);
+        }
+    }
+
+    assert_int_equal(Avtp_Aes3_SelectIsa(AVTP_PCM_ISA_AUTO), 0);
+
+    // The PCM sample conversion selects its instruction set separately
+    Avtp_PcmIsa_t isa = Avtp_Aes3_GetIsa();
+    assert_int_equal(Avtp_PcmSamples_SelectIsa(AVTP_PCM_ISA_SCALAR), 0);
+    assert_int_equal(Avtp_Aes3_GetIsa(), isa);
+    assert_int_equal(Avtp_PcmSamples_SelectIsa(AVTP_PCM_ISA_AUTO), 0);
+}
+
+static void aes3_errors(void **state)
+{
+    Avtp_Aes3Encoder_t enc;
+    Avtp_Aes3Decoder_t dec;
+    size_t frames = 2 * AVTP_AES3_BLOCK_FRAMES;
+
+    fill_blocks(2);
+    channel_status[5] ^= 0x10;      // Corrupt the first block's CRC
+    memset(samples, 0x5A, sizeof(samples));
+
+    assert_int_equal(Avtp_Aes3_InitEncoder(&enc, 2, channel_status, NULL), 0);
+    Avtp_Aes3_Encode(&enc, payload, samples, frames);
+    assert_int_equal(Avtp_Aes3_InitDecoder(&dec, 2, work, cs_out, NULL), 0);
+
+    // Flip one audio bit of a subframe
+    payload[40 * 4 + 2] ^= 0x01;
+    // Decoding starts in the middle of a block and waits for a Z preamble
+    assert_int_equal(Avtp_Aes3_Decode(&dec, decoded, payload + 8 * 2 * 4, frames - 8), 1);
+    assert_int_equal(dec.parity_errors, 1);
+    assert_int_equal(dec.crc_errors, 1);
+    assert_int_equal(dec.sync_errors, 0);
+
+    // A Z preamble in the middle of a block is a sync error
+    assert_int_equal(Avtp_Aes3_InitDecoder(&dec, 2, work, cs_out, NULL), 0);
+    Avtp_Aes3_Decode(&dec, decoded, payload, 10);
+    Avtp_Aes3_Decode(&dec, decoded, payload, 10);
+    assert_int_equal(dec.sync_errors, 1);
+}
+
+static void aes3_crc(void **state)
+{
+    uint8_t block[AVTP_AES3_BLOCK_LEN] = {0};
+
+    // Any single bit error changes the CRCC
+    block[0] = 0x01;
+    block[AVTP_AES3_BLOCK_LEN - 1] = Avtp_Aes3_CalcCrc(block);
+    assert_int_not_equal(block[AVTP_AES3_BLOCK_LEN - 1], 0);
+    block[1] ^= 1;
+    assert_int_not_equal(Avtp_Aes3_CalcCrc(block), block[AVTP_AES3_BLOCK_LEN - 1]);
+}
+
+static void aes3_invalid(void **state)
+{
+    Avtp_Aes3Encoder_t enc;
+    Avtp_Aes3Decoder_t dec;
+
+    assert_int_equal(Avtp_Aes3_InitEncoder(&enc, 0, channel_status, NULL), -EINVAL);
+    assert_int_equal(Avtp_Aes3_InitEncoder(&enc, 2, NULL, NULL), -EINVAL);
+    assert_int_equal(Avtp_Aes3_InitEncoder(&enc, 1024, channel_status, NULL), -EINVAL);
+    assert_int_equal(Avtp_Aes3_InitDecoder(&dec, 2, NULL, cs_out, NULL), -EINVAL);
+    assert_int_equal(Avtp_Aes3_InitEncoder(&enc, 2, channel_status, NULL), 0);
+    assert_int_equal(Avtp_Aes3_Encode(&enc, NULL, samples, 1), -EINVAL);
+    assert_int_equal(Avtp_Aes3_InitDecoder(&dec, 2, work, cs_out, NULL), 0);
+    assert_int_equal(Avtp_Aes3_Decode(&dec, decoded, NULL, 1), -EINVAL);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(aes3_round_trip),
+        cmocka_unit_test(aes3_errors),
+        cmocka_unit_test(aes3_crc),
+        cmocka_unit_test(aes3_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
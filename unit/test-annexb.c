@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <errno.h>
+#include <string.h>
+
+#include "avtp/cvf/AnnexB.h"
+
+#define MAX_NALS        64
+#define MAX_NAL_LEN     100
+#define STREAM_LEN      (MAX_NALS * (MAX_NAL_LEN + 4) + 16)
+
+static const Avtp_AnnexBIsa_t isas[] = {
+    AVTP_ANNEXB_ISA_SCALAR,
+    AVTP_ANNEXB_ISA_SSE2,
+    AVTP_ANNEXB_ISA_AVX2,
+    AVTP_ANNEXB_ISA_NEON,
+};
+
+static uint32_t seed = 1;
+
+static uint8_t rand_byte(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+static size_t find_reference(const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i + 2 < len; i++) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            return i;
+        }
+    }
+    return len;
+}
+
+static void annexb_find_start_code(void **state)
+{
+    uint8_t buf[200];
+
+    for (size_t i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+        if (Avtp_AnnexB_SelectIsa(isas[i]) < 0) {
+            continue;
+        }
+        assert_int_equal(Avtp_AnnexB_GetIsa(), isas[i]);
+        for (int round = 0; round < 2000; round++) {
+            size_t len = rand_byte() % sizeof(buf);
+
+            /* Mostly zeros and ones, so near matches are common */
+            for (size_t j = 0; j < len; j++) {
+                uint8_t b = rand_byte();
+                buf[j] = b < 160 ? 0 : b < 200 ? 1 : b;
+            }
+            /* Search from an unaligned offset */
+            for (size_t off = 0; off < 3 && off <= len; off++) {
+                assert_int_equal(Avtp_AnnexB_FindStartCode(buf + off, len - off),
+                                 find_reference(buf + off, len - off));
+            }
+        }
+    }
+    Avtp_AnnexB_SelectIsa(AVTP_ANNEXB_ISA_AUTO);
+
+    assert_int_equal(Avtp_AnnexB_FindStartCode(NULL, 10), 10);
+}
+
+/* Builds a stream of NAL units of random length, returns its length */
+static size_t make_stream(uint8_t* stream, uint8_t nals[][MAX_NAL_LEN],
+                          size_t* lens, int count)
+{
+    size_t len = 0;
+
+    /* Leading bytes before the first start code are discarded */
+    stream[len++] = 0x42;
+    stream[len++] = 0x00;
+
+    for (int i = 0; i < count; i++) {
+        if (rand_byte() & 1) {
+            stream[len++] = 0x00;
+        }
+        stream[len++] = 0x00;
+        stream[len++] = 0x00;
+        stream[len++] = 0x01;
+
+        lens[i] = 1 + rand_byte() % MAX_NAL_LEN;
+        for (size_t j = 0; j < lens[i]; j++) {
+            /* No zero bytes, as emulation prevention would ensure */
+            nals[i][j] = 1 + rand_byte() % 255;
+        }
+        memcpy(stream + len, nals[i], lens[i]);
+        len += lens[i];
+    }
+    return len;
+}
+
+static void annexb_reader(void **state)
+{
+    static uint8_t stream[STREAM_LEN];
+    static uint8_t nals[MAX_NALS][MAX_NAL_LEN];
+    size_t lens[MAX_NALS];
+    uint8_t ring[256];
+    Avtp_AnnexB_Reader_t r;
+    Avtp_AnnexB_Nal_t nal;
+    size_t stream_len, written = 0;
+    int count = 0, wrapped = 0, res;
+
+    stream_len = make_stream(stream, nals, lens, MAX_NALS);
+    assert_int_equal(Avtp_AnnexB_Init(&r, ring, sizeof(ring)), 0);
+
+    while (count < MAX_NALS) {
+        int flush = written == stream_len;
+        uint8_t* ptr;
+        size_t space = Avtp_AnnexB_GetWriteSpace(&r, &ptr);
+        size_t n = rand_byte() % 64;
+
+        if (n > space) {
+            n = space;
+        }
+        if (n > stream_len - written) {
+            n = stream_len - written;
+        }
+        memcpy(ptr, stream + written, n);
+        Avtp_AnnexB_Commit(&r, n);
+        written += n;
+
+        while ((res = Avtp_AnnexB_NextNal(&r, flush, &nal)) == 1) {
+            assert_true(count < MAX_NALS);
+            assert_int_equal(nal.len + nal.wrap_len, lens[count]);
+            assert_memory_equal(nal.data, nals[count], nal.len);
+            if (nal.wrap_len > 0) {
+                assert_true(nal.wrap_data == ring);
+                assert_memory_equal(nal.wrap_data, nals[count] + nal.len,
+                                    nal.wrap_len);
+                wrapped++;
+            }
+            count++;
+        }
+        assert_int_equal(res, 0);
+        if (flush) {
+            break;
+        }
+    }
+    assert_int_equal(count, MAX_NALS);
+    assert_true(wrapped > 0);
+}
+
+static void annexb_reader_full(void **state)
+{
+    uint8_t ring[64];
+    uint8_t* ptr;
+    Avtp_AnnexB_Reader_t r;
+    Avtp_AnnexB_Nal_t nal;
+    size_t space;
+
+    assert_int_equal(Avtp_AnnexB_Init(&r, ring, sizeof(ring)), 0);
+
+    space = Avtp_AnnexB_GetWriteSpace(&r, &ptr);
+    assert_int_equal(space, sizeof(ring));
+    memset(ptr, 0x55, space);
+    memcpy(ptr, "\x00\x00\x01", 3);
+    Avtp_AnnexB_Commit(&r, space);
+
+    assert_int_equal(Avtp_AnnexB_NextNal(&r, 0, &nal), -ENOSPC);
+    assert_int_equal(Avtp_AnnexB_NextNal(&r, 1, &nal), 1);
+    assert_int_equal(nal.len, sizeof(ring) - 3);
+    assert_int_equal(Avtp_AnnexB_NextNal(&r, 1, &nal), 0);
+    assert_int_equal(Avtp_AnnexB_GetWriteSpace(&r, &ptr), sizeof(ring));
+}
+
+static void annexb_invalid(void **state)
+{
+    uint8_t ring[64];
+    Avtp_AnnexB_Reader_t r;
+    Avtp_AnnexB_Nal_t nal;
+
+    assert_int_equal(Avtp_AnnexB_Init(NULL, ring, sizeof(ring)), -EINVAL);
+    assert_int_equal(Avtp_AnnexB_Init(&r, NULL, sizeof(ring)), -EINVAL);
+    assert_int_equal(Avtp_AnnexB_Init(&r, ring, 48), -EINVAL);
+    assert_int_equal(Avtp_AnnexB_NextNal(NULL, 0, &nal), -EINVAL);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(annexb_find_start_code),
+        cmocka_unit_test(annexb_reader),
+        cmocka_unit_test(annexb_reader_full),
+        cmocka_unit_test(annexb_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
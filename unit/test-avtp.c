@@ -33,6 +33,7 @@
 #include <errno.h>
 
 #include "avtp/CommonHeader.h"
+#include "avtp/Utils.h"
 
 static void get_field_null_pdu(void **state)
 {
@@ -136,6 +137,19 @@ static void set_field_version(void **state)
     assert_true(ntohl(pdu.subtype_data) == 0x00500000);
 }
 
+static void expand_timestamp(void **state)
+{
+    uint64_t ref = 0x1234FFFFFF00ULL;
+
+    assert_true(Avtp_ExpandTimestamp(0xFFFFFF00, ref) == ref);
+    // Timestamps after the reference wrapping the 32-bit range
+    assert_true(Avtp_ExpandTimestamp(0x00000100, ref) == 0x123500000100ULL);
+    // Timestamps before the reference
+    assert_true(Avtp_ExpandTimestamp(0xFFFFFE00, ref) == ref - 0x100);
+    assert_true(Avtp_ExpandTimestamp(0x7FFFFF00, ref) == ref - 0x80000000ULL);
+    assert_true(Avtp_ExpandTimestamp(0x00000100, 0x100) == 0x100);
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -148,6 +162,7 @@ int main(void)
         cmocka_unit_test(set_field_invalid_field),
         cmocka_unit_test(set_field_subtype),
         cmocka_unit_test(set_field_version),
+        cmocka_unit_test(expand_timestamp),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+
+#include "avtp/Byteorder.h"
+
+#define MAX_ELEMENTS    100
+
+static uint8_t src_buf[MAX_ELEMENTS * 8 + 1];
+static uint8_t dst_buf[MAX_ELEMENTS * 8 + 1];
+
+static void fill_source(void)
+{
+    for (size_t i = 0; i < sizeof(src_buf); i++) {
+        src_buf[i] = (uint8_t) (i * 7 + 3);
+    }
+}
+
+static void bswap_array16(void **state)
+{
+    fill_source();
+
+    // Cover the SIMD blocks, the scalar tail and misaligned buffers
+    for (size_t count = 0; count <= MAX_ELEMENTS; count++) {
+        for (size_t offset = 0; offset < 2; offset++) {
+            memset(dst_buf, 0, sizeof(dst_buf));
+            Avtp_BswapArray16(dst_buf + offset, src_buf + offset, count);
+            for (size_t i = 0; i < count; i++) {
+                uint16_t in, out;
+                memcpy(&in, src_buf + offset + i * 2, sizeof(in));
+                memcpy(&out, dst_buf + offset + i * 2, sizeof(out));
+                assert_int_equal(out, Avtp_Bswap16(in));
+            }
+            assert_int_equal(dst_buf[offset + count * 2], 0);
+        }
+    }
+}
+
+static void bswap_array32(void **state)
+{
+    fill_source();
+
+    for (size_t count = 0; count <= MAX_ELEMENTS; count++) {
+        for (size_t offset = 0; offset < 2; offset++) {
+            memset(dst_buf, 0, sizeof(dst_buf));
+            Avtp_BswapArray32(dst_buf + offset, src_buf + offset, count);
+            for (size_t i = 0; i < count; i++) {
+                uint32_t in, out;
+                memcpy(&in, src_buf + offset + i * 4, sizeof(in));
+                memcpy(&out, dst_buf + offset + i * 4, sizeof(out));
+                assert_int_equal(out, Avtp_Bswap32(in));
+            }
+            assert_int_equal(dst_buf[offset + count * 4], 0);
+        }
+    }
+}
+
+static void bswap_array64(void **state)
+{
+    fill_source();
+
+    for (size_t count = 0; count <= MAX_ELEMENTS; count++) {
+        for (size_t offset = 0; offset < 2; offset++) {
+            memset(dst_buf, 0, sizeof(dst_buf));
+            Avtp_BswapArray64(dst_buf + offset, src_buf + offset, count);
+            for (size_t i = 0; i < count; i++) {
+                uint64_t in, out;
+                memcpy(&in, src_buf + offset + i * 8, sizeof(in));
+                memcpy(&out, dst_buf + offset + i * 8, sizeof(out));
+                assert_true(out == Avtp_Bswap64(in));
+            }
+            if (count * 8 + offset < sizeof(dst_buf)) {
+                assert_int_equal(dst_buf[offset + count * 8], 0);
+            }
+        }
+    }
+}
+
+static void bswap_array_in_place(void **state)
+{
+    uint32_t values[37];
+    for (size_t i = 0; i < 37; i++) {
+        values[i] = 0x01020304u + (uint32_t) i;
+    }
+
+    Avtp_BswapArray32(values, values, 37);
+    for (size_t i = 0; i < 37; i++) {
+        assert_int_equal(values[i], Avtp_Bswap32(0x01020304u + (uint32_t) i));
+    }
+
+    Avtp_CpuToBeArray32(values, values, 37);
+    Avtp_BeToCpuArray32(values, values, 37);
+    assert_int_equal(values[36], Avtp_Bswap32(0x01020304u + 36));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(bswap_array16),
+        cmocka_unit_test(bswap_array32),
+        cmocka_unit_test(bswap_array64),
+        cmocka_unit_test(bswap_array_in_place),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -32,6 +32,7 @@
 #include <arpa/inet.h>
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
 
 #include "avtp/CommonHeader.h"
 #include "avtp/Crf.h"
@@ -419,6 +420,64 @@ static void crf_pdu_init(void **state)
     assert_true(pdu.packet_info == 0);
 }
 
+static void crf_set_get_timestamps(void **state)
+{
+    static uint8_t buf[AVTP_CRF_HEADER_LEN + 200 * 8];
+    Avtp_Crf_t* pdu = (Avtp_Crf_t*) buf;
+    uint64_t ts[200];
+
+    Avtp_Crf_Init(pdu);
+    Avtp_Crf_SetTimestampInterval(pdu, 160);
+
+    // More timestamps than fit a single conversion chunk
+    assert_int_equal(Avtp_Crf_SetTimestamps(pdu, 0x0102030405060708, 3333333, 200), 0);
+    assert_int_equal(Avtp_Crf_GetCrfDataLength(pdu), 200 * 8);
+    assert_int_equal(pdu->payload[0], 0x01);
+    assert_int_equal(pdu->payload[7], 0x08);
+    assert_int_equal(Avtp_Crf_GetTimestamps(pdu, ts, 200), 200);
+    for (int i = 0; i < 200; i++) {
+        assert_true(ts[i] == 0x0102030405060708 + i * 3333333ULL);
+    }
+
+    for (int i = 0; i < 7; i++) {
+        ts[i] = UINT64_MAX - i;
+    }
+    assert_int_equal(Avtp_Crf_SetTimestampArray(pdu, ts, 7), 0);
+    assert_int_equal(Avtp_Crf_GetCrfDataLength(pdu), 7 * 8);
+    memset(ts, 0, sizeof(ts));
+    assert_int_equal(Avtp_Crf_GetTimestamps(pdu, ts, 7), 7);
+    for (int i = 0; i < 7; i++) {
+        assert_true(ts[i] == UINT64_MAX - i);
+    }
+}
+
+static void crf_timestamps_invalid(void **state)
+{
+    static uint8_t buf[AVTP_CRF_HEADER_LEN + 8 * 8];
+    Avtp_Crf_t* pdu = (Avtp_Crf_t*) buf;
+    uint64_t ts[8] = { 0 };
+
+    Avtp_Crf_Init(pdu);
+    assert_int_equal(Avtp_Crf_SetTimestamps(pdu, 0, 1, 8), -EINVAL);
+    assert_int_equal(Avtp_Crf_SetTimestampArray(pdu, ts, 8), -EINVAL);
+
+    Avtp_Crf_SetTimestampInterval(pdu, 160);
+    assert_int_equal(Avtp_Crf_SetTimestamps(NULL, 0, 1, 8), -EINVAL);
+    assert_int_equal(Avtp_Crf_SetTimestamps(pdu, 0, 1, 0), -EINVAL);
+    assert_int_equal(Avtp_Crf_SetTimestamps(pdu, 0, 1, AVTP_CRF_MAX_TIMESTAMPS + 1), -EINVAL);
+    assert_int_equal(Avtp_Crf_SetTimestampArray(pdu, NULL, 8), -EINVAL);
+
+    assert_int_equal(Avtp_Crf_SetTimestamps(pdu, 0, 1, 8), 0);
+    assert_int_equal(Avtp_Crf_GetTimestamps(pdu, ts, 7), -EINVAL);
+    Avtp_Crf_SetCrfDataLength(pdu, 12);
+    assert_int_equal(Avtp_Crf_GetTimestamps(pdu, ts, 8), -EINVAL);
+    Avtp_Crf_SetCrfDataLength(pdu, 0);
+    assert_int_equal(Avtp_Crf_GetTimestamps(pdu, ts, 8), -EINVAL);
+    Avtp_Crf_SetCrfDataLength(pdu, 64);
+    Avtp_Crf_SetTimestampInterval(pdu, 0);
+    assert_int_equal(Avtp_Crf_GetTimestamps(pdu, ts, 8), -EINVAL);
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -451,6 +510,8 @@ int main(void)
         cmocka_unit_test(crf_set_field_timestamp_interval),
         cmocka_unit_test(crf_pdu_init_null_pdu),
         cmocka_unit_test(crf_pdu_init),
+        cmocka_unit_test(crf_set_get_timestamps),
+        cmocka_unit_test(crf_timestamps_invalid),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -528,6 +528,204 @@ static void cvf_set_field_h264_timestamp(void **state)
     assert_true(ntohl(*(uint32_t*)(&pdu.header)) == 0x80C0FFEE);
 }
 
+/**** Tests for H.264 fragmentation ****/
+
+#define NAL_LEN     1000
+
+static void fill_nal(uint8_t* nal, size_t len)
+{
+    nal[0] = 0x65; /* NRI 3, IDR slice */
+    for (size_t i = 1; i < len; i++) {
+        nal[i] = i * 7;
+    }
+}
+
+/* Splits nal into PDU payloads, returns the number of PDUs */
+static int fragment(const uint8_t* nal, size_t len, size_t max_len,
+                    uint8_t payloads[][NAL_LEN], size_t* lens, uint8_t* m)
+{
+    Avtp_H264_Fragment_t frag;
+    size_t offset = 0;
+    int n = 0;
+
+    while (Avtp_H264_NextFragment(nal, len, &offset, max_len, &frag) == 1) {
+        assert_true(frag.header_len + frag.data_len <= max_len);
+        memcpy(payloads[n], frag.header, frag.header_len);
+        memcpy(payloads[n] + frag.header_len, frag.data, frag.data_len);
+        lens[n] = frag.header_len + frag.data_len;
+        m[n] = frag.last;
+        n++;
+    }
+    assert_int_equal(offset, len);
+    return n;
+}
+
+static void h264_fragment_single(void **state)
+{
+    uint8_t nal[100];
+    Avtp_H264_Fragment_t frag;
+    size_t offset = 0;
+
+    fill_nal(nal, sizeof(nal));
+
+    assert_int_equal(Avtp_H264_NextFragment(nal, sizeof(nal), &offset, 100,
+                                            &frag), 1);
+    assert_int_equal(frag.header_len, 0);
+    assert_true(frag.data == nal);
+    assert_int_equal(frag.data_len, sizeof(nal));
+    assert_true(frag.last);
+    assert_int_equal(Avtp_H264_NextFragment(nal, sizeof(nal), &offset, 100,
+                                            &frag), 0);
+}
+
+static void h264_fragment_fu_a(void **state)
+{
+    uint8_t nal[NAL_LEN];
+    uint8_t payloads[8][NAL_LEN];
+    size_t lens[8];
+    uint8_t m[8];
+    int n;
+
+    fill_nal(nal, sizeof(nal));
+
+    /* 999 bytes after the NAL header, 298 per fragment */
+    n = fragment(nal, sizeof(nal), 300, payloads, lens, m);
+    assert_int_equal(n, 4);
+    for (int i = 0; i < n; i++) {
+        assert_int_equal(payloads[i][0], 0x60 | AVTP_H264_NAL_TYPE_FU_A);
+        assert_int_equal(payloads[i][1] & 0x1F, 5);
+        assert_int_equal(!!(payloads[i][1] & 0x80), i == 0);
+        assert_int_equal(!!(payloads[i][1] & 0x40), i == n - 1);
+        assert_int_equal(m[i], i == n - 1);
+    }
+    assert_int_equal(lens[3], 999 - 3 * 298 + 2);
+    assert_memory_equal(payloads[0] + 2, nal + 1, 298);
+}
+
+static void h264_fragment_invalid(void **state)
+{
+    uint8_t nal[10] = { 0x65 };
+    Avtp_H264_Fragment_t frag;
+    size_t offset = 0;
+
+    assert_int_equal(Avtp_H264_NextFragment(NULL, 10, &offset, 100, &frag),
+                     -EINVAL);
+    assert_int_equal(Avtp_H264_NextFragment(nal, 0, &offset, 100, &frag),
+                     -EINVAL);
+    assert_int_equal(Avtp_H264_NextFragment(nal, 10, &offset, 2, &frag),
+                     -EINVAL);
+}
+
+static void h264_reassemble(void **state)
+{
+    uint8_t nal[NAL_LEN], buf[NAL_LEN];
+    uint8_t payloads[8][NAL_LEN];
+    size_t lens[8];
+    uint8_t m[8];
+    Avtp_H264_Reassembler_t r;
+    const uint8_t* out;
+    size_t out_len;
+    int n;
+
+    fill_nal(nal, sizeof(nal));
+    Avtp_H264_ReassemblerInit(&r, buf, sizeof(buf));
+
+    /* Single NAL unit packets are returned in place */
+    assert_int_equal(Avtp_H264_Reassemble(&r, 10, 1, nal, 100, &out,
+                                          &out_len), 1);
+    assert_true(out == nal);
+    assert_int_equal(out_len, 100);
+
+    n = fragment(nal, sizeof(nal), 300, payloads, lens, m);
+    for (int i = 0; i < n; i++) {
+        int res = Avtp_H264_Reassemble(&r, 11 + i, m[i], payloads[i], lens[i],
+                                       &out, &out_len);
+        assert_int_equal(res, i == n - 1);
+    }
+    assert_true(out == buf);
+    assert_int_equal(out_len, sizeof(nal));
+    assert_memory_equal(out, nal, sizeof(nal));
+    assert_int_equal(r.stats.nal_units, 2);
+    assert_int_equal(r.stats.fragmented, 1);
+    assert_int_equal(r.stats.lost_pdus, 0);
+}
+
+static void h264_reassemble_loss(void **state)
+{
+    uint8_t nal[NAL_LEN], buf[NAL_LEN];
+    uint8_t payloads[8][NAL_LEN];
+    size_t lens[8];
+    uint8_t m[8];
+    Avtp_H264_Reassembler_t r;
+    const uint8_t* out;
+    size_t out_len;
+    uint8_t seq = 254;
+    int n;
+
+    fill_nal(nal, sizeof(nal));
+    Avtp_H264_ReassemblerInit(&r, buf, sizeof(buf));
+    n = fragment(nal, sizeof(nal), 300, payloads, lens, m);
+
+    /* Losing a middle fragment drops the NAL unit */
+    for (int i = 0; i < n; i++) {
+        if (i == 1) {
+            seq++;
+            continue;
+        }
+        assert_int_equal(Avtp_H264_Reassemble(&r, seq++, m[i], payloads[i],
+                                              lens[i], &out, &out_len), 0);
+    }
+    assert_int_equal(r.stats.lost_pdus, 1);
+    assert_int_equal(r.stats.dropped_nal_units, 1);
+
+    /* A repeated PDU is ignored, the next NAL unit is received */
+    for (int i = 0; i < n; i++) {
+        int res = Avtp_H264_Reassemble(&r, seq, m[i], payloads[i], lens[i],
+                                       &out, &out_len);
+        assert_int_equal(res, i == n - 1);
+        assert_int_equal(Avtp_H264_Reassemble(&r, seq, m[i], payloads[i],
+                                              lens[i], &out, &out_len), 0);
+        seq++;
+    }
+    assert_memory_equal(out, nal, sizeof(nal));
+
+    /* The M bit on a fragment that does not end the NAL unit drops it */
+    assert_int_equal(Avtp_H264_Reassemble(&r, seq++, 0, payloads[0], lens[0],
+                                          &out, &out_len), 0);
+    assert_int_equal(Avtp_H264_Reassemble(&r, seq++, 1, payloads[1], lens[1],
+                                          &out, &out_len), 0);
+    assert_int_equal(Avtp_H264_Reassemble(&r, seq++, 0, payloads[2], lens[2],
+                                          &out, &out_len), 0);
+    assert_int_equal(Avtp_H264_Reassemble(&r, seq++, 1, payloads[3], lens[3],
+                                          &out, &out_len), 0);
+    assert_int_equal(r.stats.dropped_nal_units, 2);
+    assert_int_equal(r.stats.lost_pdus, 1);
+}
+
+static void h264_reassemble_overflow(void **state)
+{
+    uint8_t nal[NAL_LEN], buf[500];
+    uint8_t payloads[8][NAL_LEN];
+    size_t lens[8];
+    uint8_t m[8];
+    Avtp_H264_Reassembler_t r;
+    const uint8_t* out;
+    size_t out_len;
+    int n;
+
+    fill_nal(nal, sizeof(nal));
+    Avtp_H264_ReassemblerInit(&r, buf, sizeof(buf));
+    n = fragment(nal, sizeof(nal), 300, payloads, lens, m);
+
+    for (int i = 0; i < n; i++) {
+        assert_int_equal(Avtp_H264_Reassemble(&r, i, m[i], payloads[i],
+                                              lens[i], &out, &out_len), 0);
+    }
+    assert_int_equal(r.stats.dropped_nal_units, 1);
+    assert_int_equal(Avtp_H264_Reassemble(NULL, 0, 0, nal, 10, &out,
+                                          &out_len), -EINVAL);
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -566,6 +764,12 @@ int main(void)
         cmocka_unit_test(cvf_set_field_h264_timestamp),
         cmocka_unit_test(cvf_pdu_init_null_pdu),
         cmocka_unit_test(cvf_pdu_init),
+        cmocka_unit_test(h264_fragment_single),
+        cmocka_unit_test(h264_fragment_fu_a),
+        cmocka_unit_test(h264_fragment_invalid),
+        cmocka_unit_test(h264_reassemble),
+        cmocka_unit_test(h264_reassemble_loss),
+        cmocka_unit_test(h264_reassemble_overflow),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
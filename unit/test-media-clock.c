@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <errno.h>
+#include <string.h>
+
+#include "avtp/MediaClock.h"
+#include "avtp/Byteorder.h"
+
+#define SAMPLE_RATE             48000
+#define TIMESTAMP_INTERVAL      160
+#define TIMESTAMPS_PER_PDU      6
+#define JITTER_NS               2000
+
+/* Talker media clock 50 ppm slower than nominal */
+#define TRUE_PERIOD             (1e9 / SAMPLE_RATE * (1.0 + 50e-6))
+
+/* First timestamp close to the wraparound of the 64 bit time */
+#define START_TIME              (UINT64_MAX - 1000000000ULL)
+
+static uint8_t pdu_buf[AVTP_CRF_HEADER_LEN + TIMESTAMPS_PER_PDU * 8];
+static uint32_t seed = 1;
+
+static uint64_t true_edge(int64_t edge)
+{
+    return START_TIME + (uint64_t) (int64_t) (edge * TRUE_PERIOD);
+}
+
+static int64_t jitter(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (int64_t) (seed >> 16) % (2 * JITTER_NS + 1) - JITTER_NS;
+}
+
+/* Builds the CRF PDU carrying timestamps number first to first + 5 */
+static Avtp_Crf_t* make_pdu(int64_t first, int64_t offset)
+{
+    Avtp_Crf_t* pdu = (Avtp_Crf_t*) pdu_buf;
+
+    Avtp_Crf_Init(pdu);
+    Avtp_Crf_SetType(pdu, AVTP_CRF_TYPE_AUDIO_SAMPLE);
+    Avtp_Crf_SetPull(pdu, AVTP_CRF_PULL_MULT_BY_1);
+    Avtp_Crf_SetBaseFrequency(pdu, SAMPLE_RATE);
+    Avtp_Crf_SetTimestampInterval(pdu, TIMESTAMP_INTERVAL);
+    Avtp_Crf_SetCrfDataLength(pdu, TIMESTAMPS_PER_PDU * 8);
+    for (int i = 0; i < TIMESTAMPS_PER_PDU; i++) {
+        uint64_t ts = true_edge((first + i) * TIMESTAMP_INTERVAL) + jitter() + offset;
+        ts = Avtp_CpuToBe64(ts);
+        memcpy(pdu->payload + i * 8, &ts, 8);
+    }
+    return pdu;
+}
+
+static int64_t edge_error(Avtp_MediaClock_t* clk, int64_t edge, uint32_t divider,
+                          int64_t expected)
+{
+    uint64_t t;
+
+    // Half a period ahead, so the prediction may be off either way
+    t = true_edge(edge) - (uint64_t) (TRUE_PERIOD / 2);
+    assert_int_equal(Avtp_MediaClock_NextEdge(clk, t, divider, &t), 0);
+    return (int64_t) (t - true_edge(expected));
+}
+
+static void media_clock_recovery(void **state)
+{
+    Avtp_MediaClock_t clk;
+    int64_t ts = 0, err;
+
+    assert_int_equal(Avtp_MediaClock_Init(&clk, AVTP_MEDIA_CLOCK_DEFAULT_BANDWIDTH), 0);
+
+    // 10 seconds of CRF stream
+    for (; ts < 3000; ts += TIMESTAMPS_PER_PDU) {
+        assert_int_equal(Avtp_MediaClock_ProcessPdu(&clk, make_pdu(ts, 0)), 0);
+    }
+    assert_true(clk.locked);
+    assert_int_equal(clk.timestamps, 3000);
+    assert_int_equal(clk.relocks, 0);
+    assert_true(clk.period > TRUE_PERIOD - 0.01 && clk.period < TRUE_PERIOD + 0.01);
+
+    // Predicted edges, some of them skipped by the divider
+    int64_t edge = ts * TIMESTAMP_INTERVAL;
+    err = edge_error(&clk, edge, 1, edge);
+    assert_true(err > -JITTER_NS / 2 && err < JITTER_NS / 2);
+    err = edge_error(&clk, edge + 2, 6, edge + 6);
+    assert_true(err > -JITTER_NS / 2 && err < JITTER_NS / 2);
+    err = edge_error(&clk, edge + 6 * 1000, 6, edge + 6 * 1000);
+    assert_true(err > -JITTER_NS / 2 && err < JITTER_NS / 2);
+
+    // Duplicated PDUs are ignored
+    double period = clk.period;
+    assert_int_equal(Avtp_MediaClock_ProcessPdu(&clk, make_pdu(ts - 6, 0)), 0);
+    assert_int_equal(clk.stale, TIMESTAMPS_PER_PDU);
+    assert_true(clk.period == period);
+
+    // Lost PDUs are bridged
+    ts += 10 * TIMESTAMPS_PER_PDU;
+    for (int i = 0; i < 10; i++, ts += TIMESTAMPS_PER_PDU) {
+        assert_int_equal(Avtp_MediaClock_ProcessPdu(&clk, make_pdu(ts, 0)), 0);
+    }
+    assert_int_equal(clk.relocks, 0);
+    err = edge_error(&clk, ts * TIMESTAMP_INTERVAL, 1, ts * TIMESTAMP_INTERVAL);
+    assert_true(err > -JITTER_NS / 2 && err < JITTER_NS / 2);
+
+    // A phase jump restarts the loop on the new phase
+    assert_int_equal(Avtp_MediaClock_ProcessPdu(&clk, make_pdu(ts, 1000000)), 0);
+    assert_int_equal(clk.relocks, 1);
+    assert_true(clk.locked);
+    uint64_t t = true_edge(ts * TIMESTAMP_INTERVAL) + 1000000;
+    assert_int_equal(Avtp_MediaClock_NextEdge(&clk, t - 10000, 1, &t), 0);
+    err = t - (true_edge(ts * TIMESTAMP_INTERVAL) + 1000000);
+    assert_true(err > -2 * JITTER_NS && err < 2 * JITTER_NS);
+
+    // As does the tu field
+    Avtp_Crf_t* pdu = make_pdu(ts + 6, 1000000);
+    Avtp_Crf_EnableTu(pdu);
+    assert_int_equal(Avtp_MediaClock_ProcessPdu(&clk, pdu), 0);
+    assert_int_equal(clk.relocks, 1);
+    assert_true(clk.edge == 5 * TIMESTAMP_INTERVAL);
+}
+
+static void media_clock_align(void **state)
+{
+    Avtp_MediaClock_t clk;
+    int64_t edge, ts, phase;
+    uint64_t t;
+
+    assert_int_equal(Avtp_MediaClock_Init(&clk, AVTP_MEDIA_CLOCK_DEFAULT_BANDWIDTH), 0);
+    assert_int_equal(Avtp_MediaClock_Align(&clk, 0, &t, &phase), -EAGAIN);
+
+    // 2 seconds, across the wraparound of the 64 bit time
+    for (ts = 0; ts < 600; ts += TIMESTAMPS_PER_PDU) {
+        assert_int_equal(Avtp_MediaClock_ProcessPdu(&clk, make_pdu(ts, 0)), 0);
+    }
+
+    // Presentation times around the last timestamp, before the wraparound
+    // of both the 64 and 32 bit time and 2 ms into the future
+    static const int64_t edges[] = { 160 * 120, 160 * 300, 160 * 600 + 96 };
+    static const int64_t offsets[] = { -5000, 0, 4000 };
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        for (size_t j = 0; j < sizeof(offsets) / sizeof(offsets[0]); j++) {
+            edge = edges[i];
+            assert_int_equal(Avtp_MediaClock_Align(&clk,
+                                (uint32_t) (true_edge(edge) + offsets[j]),
+                                &t, &phase), 0);
+            assert_true((int64_t) (t - true_edge(edge)) > -JITTER_NS &&
+                        (int64_t) (t - true_edge(edge)) < JITTER_NS);
+            assert_true(phase > offsets[j] - JITTER_NS && phase < offsets[j] + JITTER_NS);
+            assert_true((int64_t) (t + phase - true_edge(edge)) == offsets[j]);
+        }
+    }
+
+    // Half a period off snaps to either neighbour
+    assert_int_equal(Avtp_MediaClock_Align(&clk,
+                        (uint32_t) (true_edge(edge) + (uint64_t) (TRUE_PERIOD / 2)),
+                        NULL, &phase), 0);
+    assert_true(phase >= -TRUE_PERIOD / 2 - 1 && phase <= TRUE_PERIOD / 2 + 1);
+}
+
+static void media_clock_pull(void **state)
+{
+    Avtp_MediaClock_t clk;
+
+    assert_int_equal(Avtp_MediaClock_Init(&clk, AVTP_MEDIA_CLOCK_DEFAULT_BANDWIDTH), 0);
+    assert_int_equal(Avtp_MediaClock_Configure(&clk, 48000,
+                        AVTP_CRF_PULL_MULT_BY_1_OVER_1_001, 160), 0);
+    assert_true(clk.nominal_period > 20854.1 && clk.nominal_period < 20854.2);
+    assert_int_equal(Avtp_MediaClock_Configure(&clk, 48000,
+                        AVTP_CRF_PULL_MULT_BY_1_OVER_8, 160), 0);
+    assert_true(clk.nominal_period > 166666.6 && clk.nominal_period < 166666.7);
+
+    // The configuration of the stream is picked up from the PDU
+    Avtp_Crf_t* pdu = make_pdu(0, 0);
+    Avtp_Crf_SetBaseFrequency(pdu, 44100);
+    Avtp_Crf_SetPull(pdu, AVTP_CRF_PULL_MULT_BY_25_OVER_24);
+    assert_int_equal(Avtp_MediaClock_ProcessPdu(&clk, pdu), 0);
+    assert_int_equal(clk.base_frequency, 44100);
+    assert_int_equal(clk.pull, AVTP_CRF_PULL_MULT_BY_25_OVER_24);
+    assert_true(clk.nominal_period > 21768.7 && clk.nominal_period < 21768.8);
+}
+
+static void media_clock_invalid(void **state)
+{
+    Avtp_MediaClock_t clk;
+    uint64_t t;
+
+    assert_int_equal(Avtp_MediaClock_Init(&clk, 0.0), -EINVAL);
+    assert_int_equal(Avtp_MediaClock_Init(&clk, 1.0), 0);
+    assert_int_equal(Avtp_MediaClock_AddTimestamp(&clk, 0), -EINVAL);
+    assert_int_equal(Avtp_MediaClock_Configure(&clk, 0, 0, 160), -EINVAL);
+    assert_int_equal(Avtp_MediaClock_Configure(&clk, 48000, 6, 160), -EINVAL);
+    assert_int_equal(Avtp_MediaClock_Configure(&clk, 48000, 0, 0), -EINVAL);
+    assert_int_equal(Avtp_MediaClock_Configure(&clk, 48000, 0, 160), 0);
+    assert_int_equal(Avtp_MediaClock_NextEdge(&clk, 0, 1, &t), -EAGAIN);
+    assert_int_equal(Avtp_MediaClock_AddTimestamp(&clk, 0), 0);
+    assert_int_equal(Avtp_MediaClock_NextEdge(&clk, 0, 0, &t), -EINVAL);
+
+    // Loop bandwidth too high for one timestamp every 3.3 ms
+    assert_int_equal(Avtp_MediaClock_Init(&clk, 100.0), 0);
+    assert_int_equal(Avtp_MediaClock_Configure(&clk, 48000, 0, 160), -EINVAL);
+
+    Avtp_Crf_t* pdu = make_pdu(0, 0);
+    Avtp_Crf_SetCrfDataLength(pdu, 12);
+    assert_int_equal(Avtp_MediaClock_ProcessPdu(&clk, pdu), -EINVAL);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(media_clock_recovery),
+        cmocka_unit_test(media_clock_align),
+        cmocka_unit_test(media_clock_pull),
+        cmocka_unit_test(media_clock_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2024, COVESA
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of COVESA nor the names of its contributors may be
+ *      used to endorse or promote products derived from this software without
+ *      specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#include "avtp/aaf/PcmSamples.h"
+
+#define MAX_CHANNELS        8
+#define MAX_FRAMES          300
+#define MAX_SAMPLES         (MAX_CHANNELS * MAX_FRAMES)
+
+static const Avtp_PcmIsa_t isas[] = {
+    AVTP_PCM_ISA_SCALAR, AVTP_PCM_ISA_SSSE3, AVTP_PCM_ISA_AVX2, AVTP_PCM_ISA_NEON
+};
+static const Avtp_AafFormat_t formats[] = {
+    AVTP_AAF_FORMAT_INT_16BIT, AVTP_AAF_FORMAT_INT_24BIT,
+    AVTP_AAF_FORMAT_INT_32BIT, AVTP_AAF_FORMAT_FLOAT_32BIT
+};
+static const Avtp_PcmSampleType_t types[] = {
+    AVTP_PCM_SAMPLE_INT16, AVTP_PCM_SAMPLE_INT32, AVTP_PCM_SAMPLE_FLOAT
+};
+static const uint16_t channel_counts[] = { 1, 2, 3, 8 };
+static const size_t frame_counts[] = { 0, 1, 5, 17, 100, 300 };
+
+static uint32_t host[MAX_SAMPLES];
+static uint8_t payload[MAX_SAMPLES * 4 + 1];
+static uint8_t expected[MAX_SAMPLES * 4];
+static uint32_t planes[MAX_CHANNELS][MAX_FRAMES];
+
+static int32_t ref_float_to_int(float f)
+{
+    if (!(f >= -1.0f)) {
+        f = -1.0f;
+    } else if (f > 0x1.fffffep-1f) {
+        f = 0x1.fffffep-1f;
+    }
+    return (int32_t) (f * 2147483648.0f);
+}
+
+static float ref_int_to_float(int32_t v)
+{
+    return (float) v * (1.0f / 2147483648.0f);
+}
+
+static void fill_host(Avtp_PcmSampleType_t type, size_t n)
+{
+    static const float special[] = {
+        0.0f, -1.0f, 1.0f, 0.5f, -0.25f, 1.5f, -2.0f, INFINITY, -INFINITY
+    };
+    uint32_t seed = 12345;
+
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        if (type == AVTP_PCM_SAMPLE_INT16) {
+            ((uint16_t*) host)[i] = i < 4 ? (uint16_t[]){0, 0x7fff, 0x8000, 0xffff}[i] : seed >> 16;
+        } else if (type == AVTP_PCM_SAMPLE_INT32) {
+            host[i] = i < 4 ? (uint32_t[]){0, 0x7fffffff, 0x80000000, 0xffffffff}[i] : seed;
+        } else {
+            float f = i < 9 ? special[i] : ((int32_t) seed) / 1.5e9f;
+            memcpy(&host[i], &f, sizeof(f));
+        }
+    }
+}
+
+static int32_t ref_host_to_int(Avtp_PcmSampleType_t type, size_t i)
+{
+    float f;
+
+    if (type == AVTP_PCM_SAMPLE_INT16) {
+        return (int32_t) ((uint32_t) ((uint16_t*) host)[i] << 16);
+    } else if (type == AVTP_PCM_SAMPLE_INT32) {
+        return (int32_t) host[i];
+    }
+    memcpy(&f, &host[i], sizeof(f));
+    return ref_float_to_int(f);
+}
+
+static void ref_pack(Avtp_AafFormat_t format, uint8_t bit_depth,
+                     Avtp_PcmSampleType_t type, size_t n)
+{
+    uint32_t v, mask;
+    float f;
+
+    for (size_t i = 0; i < n; i++) {
+        if (format == AVTP_AAF_FORMAT_FLOAT_32BIT) {
+            if (type == AVTP_PCM_SAMPLE_FLOAT) {
+                memcpy(&v, &host[i], sizeof(v));
+            } else {
+                f = ref_int_to_float(ref_host_to_int(type, i));
+                memcpy(&v, &f, sizeof(v));
+            }
+            mask = UINT32_MAX;
+        } else {
+            v = ref_host_to_int(type, i);
+            mask = UINT32_MAX << (32 - bit_depth);
+            if (format == AVTP_AAF_FORMAT_INT_16BIT) {
+                mask = UINT32_MAX << (16 - bit_depth) << 16;
+            }
+        }
+        v &= mask;
+        if (format == AVTP_AAF_FORMAT_INT_16BIT) {
+            expected[i * 2] = v >> 24;
+            expected[i * 2 + 1] = v >> 16;
+        } else if (format == AVTP_AAF_FORMAT_INT_24BIT) {
+            expected[i * 3] = v >> 24;
+            expected[i * 3 + 1] = v >> 16;
+            expected[i * 3 + 2] = v >> 8;
+        } else {
+            expected[i * 4] = v >> 24;
+            expected[i * 4 + 1] = v >> 16;
+            expected[i * 4 + 2] = v >> 8;
+            expected[i * 4 + 3] = v;
+        }
+    }
+}
+
+/* Reference conversion of payload sample i into the host sample type */
+static uint32_t ref_unpack(Avtp_AafFormat_t format, Avtp_PcmSampleType_t type, size_t i)
+{
+    uint32_t v = 0;
+    int32_t s;
+    float f;
+
+    if (format == AVTP_AAF_FORMAT_INT_16BIT) {
+        v = (uint32_t) payload[i * 2] << 24 | (uint32_t) payload[i * 2 + 1] << 16;
+    } else if (format == AVTP_AAF_FORMAT_INT_24BIT) {
+        v = (uint32_t) payload[i * 3] << 24 | (uint32_t) payload[i * 3 + 1] << 16 |
+            (uint32_t) payload[i * 3 + 2] << 8;
+    } else {
+        v = (uint32_t) payload[i * 4] << 24 | (uint32_t) payload[i * 4 + 1] << 16 |
+            (uint32_t) payload[i * 4 + 2] << 8 | payload[i * 4 + 3];
+    }
+
+    if (format == AVTP_AAF_FORMAT_FLOAT_32BIT) {
+        if (type == AVTP_PCM_SAMPLE_FLOAT) {
+            return v;
+        }
+        memcpy(&f, &v, sizeof(f));
+        s = ref_float_to_int(f);
+    } else {
+        s = (int32_t) v;
+    }
+
+    if (type == AVTP_PCM_SAMPLE_INT16) {
+        return (uint16_t) ((uint32_t) s >> 16);
+    } else if (type == AVTP_PCM_SAMPLE_INT32) {
+        return (uint32_t) s;
+    }
+    f = ref_int_to_float(s);
+    memcpy(&v, &f, sizeof(v));
+    return v;
+}
+
+static uint32_t get_host(Avtp_PcmSampleType_t type, const void* buf, size_t i)
+{
+    if (type == AVTP_PCM_SAMPLE_INT16) {
+        return ((const uint16_t*) buf)[i];
+    }
+    return ((const uint32_t*) buf)[i];
+}
+
+static void check_conversions(Avtp_AafFormat_t format, uint8_t bit_depth,
+                              Avtp_PcmSampleType_t type, uint16_t channels,
+                              size_t frames)
+{
+    size_t n = channels * frames;
+    uint8_t size = Avtp_PcmSamples_GetSampleSize(format);
+    const void* src_planes[MAX_CHANNELS];
+    void* dst_planes[MAX_CHANNELS];
+
+    fill_host(type, n);
+    ref_pack(format, bit_depth, type, n);
+
+    // Interleaved
+    memset(payload, 0xaa, sizeof(payload));
+    assert_int_equal(Avtp_PcmSamples_PackInterleaved(payload, format, bit_depth,
+                        host, type, channels, frames), n * size);
+    assert_memory_equal(payload, expected, n * size);
+    assert_int_equal(payload[n * size], 0xaa);
+
+    static uint32_t out[MAX_SAMPLES + 1];
+    memset(out, 0xaa, sizeof(out));
+    assert_int_equal(Avtp_PcmSamples_UnpackInterleaved(out, type, payload, format,
+                        channels, frames), n * size);
+    for (size_t i = 0; i < n; i++) {
+        assert_int_equal(get_host(type, out, i), ref_unpack(format, type, i));
+    }
+    assert_int_equal(get_host(type, out, n), type == AVTP_PCM_SAMPLE_INT16 ? 0xaaaa : 0xaaaaaaaa);
+
+    // Planar
+    for (uint16_t c = 0; c < channels; c++) {
+        for (size_t f = 0; f < frames; f++) {
+            if (type == AVTP_PCM_SAMPLE_INT16) {
+                ((uint16_t*) planes[c])[f] = ((uint16_t*) host)[f * channels + c];
+            } else {
+                planes[c][f] = host[f * channels + c];
+            }
+        }
+        src_planes[c] = planes[c];
+        dst_planes[c] = planes[c];
+    }
+    memset(payload, 0xaa, sizeof(payload));
+    assert_int_equal(Avtp_PcmSamples_PackPlanar(payload, format, bit_depth,
+                        src_planes, type, channels, frames), n * size);
+    assert_memory_equal(payload, expected, n * size);
+
+    memset(planes, 0, sizeof(planes));
+    assert_int_equal(Avtp_PcmSamples_UnpackPlanar(dst_planes, type, payload, format,
+                        channels, frames), n * size);
+    for (uint16_t c = 0; c < channels; c++) {
+        for (size_t f = 0; f < frames; f++) {
+            assert_int_equal(get_host(type, planes[c], f),
+                             ref_unpack(format, type, f * channels + c));
+        }
+    }
+}
+
+static void pcm_samples_convert(void **state)
+{
+    for (size_t a = 0; a < sizeof(isas) / sizeof(isas[0]); a++) {
+        if (Avtp_PcmSamples_SelectIsa(isas[a]) < 0) {
+            continue;
+        }
+        assert_int_equal(Avtp_PcmSamples_GetIsa(), isas[a]);
+
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+            uint8_t bits = Avtp_PcmSamples_GetSampleSize(formats[f]) * 8;
+            for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+                for (size_t c = 0; c < sizeof(channel_counts) / sizeof(channel_counts[0]); c++) {
+                    for (size_t n = 0; n < sizeof(frame_counts) / sizeof(frame_counts[0]); n++) {
+                        check_conversions(formats[f], bits, types[t],
+                                          channel_counts[c], frame_counts[n]);
+                    }
+                }
+            }
+        }
+    }
+
+    assert_int_equal(Avtp_PcmSamples_SelectIsa(AVTP_PCM_ISA_AUTO), 0);
+}
+
+static void pcm_samples_bit_depth(void **state)
+{
+    for (size_t a = 0; a < sizeof(isas) / sizeof(isas[0]); a++) {
+        if (Avtp_PcmSamples_SelectIsa(isas[a]) < 0) {
+            continue;
+        }
+
+        // Unused LSBs are cleared
+        check_conversions(AVTP_AAF_FORMAT_INT_16BIT, 12, AVTP_PCM_SAMPLE_INT16, 2, 100);
+        check_conversions(AVTP_AAF_FORMAT_INT_24BIT, 20, AVTP_PCM_SAMPLE_INT32, 2, 100);
+        check_conversions(AVTP_AAF_FORMAT_INT_32BIT, 24, AVTP_PCM_SAMPLE_FLOAT, 3, 100);
+    }
+
+    assert_int_equal(Avtp_PcmSamples_SelectIsa(AVTP_PCM_ISA_AUTO), 0);
+}
+
+static void check_channels(Avtp_AafFormat_t format, Avtp_PcmSampleType_t type,
+                           size_t frames)
+{
+    static const uint16_t unpack_map[] = { 7, 2, 2, 0 };
+    static const uint16_t pack_map[] = { 6, 1, 3 };
+    static uint8_t pdu_buf[AVTP_PCM_HEADER_LEN + MAX_SAMPLES * 4];
+    Avtp_Pcm_t* pdu = (Avtp_Pcm_t*) pdu_buf;
+    size_t n = MAX_CHANNELS * frames;
+    uint8_t bit_depth = Avtp_PcmSamples_GetSampleSize(format) * 8;
+    uint8_t size = bit_depth / 8;
+    const void* src_planes[MAX_CHANNELS];
+    void* dst_planes[MAX_CHANNELS];
+
+    fill_host(type, n);
+    ref_pack(format, bit_depth, type, n);
+
+    // Extraction of a subset, with a channel selected twice
+    memcpy(payload, expected, n * size);
+    memset(planes, 0, sizeof(planes));
+    for (size_t i = 0; i < 4; i++) {
+        dst_planes[i] = planes[i];
+    }
+    assert_int_equal(Avtp_PcmSamples_UnpackChannels(dst_planes, type, payload, format,
+                        MAX_CHANNELS, unpack_map, 4, frames), n * size);
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t f = 0; f < frames; f++) {
+            assert_int_equal(get_host(type, planes[i], f),
+                             ref_unpack(format, type, f * MAX_CHANNELS + unpack_map[i]));
+        }
+    }
+
+    // Same through the PDU header
+    Avtp_Pcm_Init(pdu);
+    Avtp_Pcm_SetFormat(pdu, format);
+    Avtp_Pcm_SetBitDepth(pdu, bit_depth);
+    Avtp_Pcm_SetChannelsPerFrame(pdu, MAX_CHANNELS);
+    Avtp_Pcm_SetStreamDataLength(pdu, n * size);
+    memcpy(pdu->payload, expected, n * size);
+    memset(planes, 0, sizeof(planes));
+    assert_int_equal(Avtp_PcmSamples_ExtractChannels(pdu, dst_planes, type,
+                        unpack_map, 4), frames);
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t f = 0; f < frames; f++) {
+            assert_int_equal(get_host(type, planes[i], f),
+                             ref_unpack(format, type, f * MAX_CHANNELS + unpack_map[i]));
+        }
+    }
+
+    // Insertion leaves the unmapped channels untouched
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t f = 0; f < frames; f++) {
+            if (type == AVTP_PCM_SAMPLE_INT16) {
+                ((uint16_t*) planes[i])[f] = ((uint16_t*) host)[f * MAX_CHANNELS + pack_map[i]];
+            } else {
+                planes[i][f] = host[f * MAX_CHANNELS + pack_map[i]];
+            }
+        }
+        src_planes[i] = planes[i];
+    }
+    memset(payload, 0xaa, sizeof(payload));
+    assert_int_equal(Avtp_PcmSamples_PackChannels(payload, format, bit_depth, src_planes,
+                        type, MAX_CHANNELS, pack_map, 3, frames), n * size);
+    for (size_t i = 0; i < n; i++) {
+        uint16_t c = i % MAX_CHANNELS;
+        int mapped = c == 6 || c == 1 || c == 3;
+        for (uint8_t b = 0; b < size; b++) {
+            assert_int_equal(payload[i * size + b], mapped ? expected[i * size + b] : 0xaa);
+        }
+    }
+    assert_int_equal(payload[n * size], 0xaa);
+
+    memset(pdu->payload, 0xaa, n * size);
+    assert_int_equal(Avtp_PcmSamples_InsertChannels(pdu, src_planes, type, pack_map, 3,
+                        frames), n * size);
+    assert_memory_equal(pdu->payload, payload, n * size);
+}
+
+static void pcm_samples_channels(void **state)
+{
+    for (size_t a = 0; a < sizeof(isas) / sizeof(isas[0]); a++) {
+        if (Avtp_PcmSamples_SelectIsa(isas[a]) < 0) {
+            continue;
+        }
+
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+            for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+                for (size_t n = 0; n < sizeof(frame_counts) / sizeof(frame_counts[0]); n++) {
+                    check_channels(formats[f], types[t], frame_counts[n]);
+                }
+            }
+        }
+    }
+
+    assert_int_equal(Avtp_PcmSamples_SelectIsa(AVTP_PCM_ISA_AUTO), 0);
+}
+
+static void pcm_samples_invalid(void **state)
+{
+    uint16_t in[8] = {0};
+
+    assert_int_equal(Avtp_PcmSamples_GetSampleSize(AVTP_AAF_FORMAT_AES3_32BIT), 0);
+    assert_int_equal(Avtp_PcmSamples_PackInterleaved(payload, AVTP_AAF_FORMAT_USER,
+                        16, in, AVTP_PCM_SAMPLE_INT16, 2, 4), -EINVAL);
+    assert_int_equal(Avtp_PcmSamples_PackInterleaved(payload, AVTP_AAF_FORMAT_INT_16BIT,
+                        24, in, AVTP_PCM_SAMPLE_INT16, 2, 4), -EINVAL);
+    assert_int_equal(Avtp_PcmSamples_PackInterleaved(payload, AVTP_AAF_FORMAT_INT_24BIT,
+                        32, in, AVTP_PCM_SAMPLE_INT16, 2, 4), -EINVAL);
+    assert_int_equal(Avtp_PcmSamples_PackInterleaved(payload, AVTP_AAF_FORMAT_FLOAT_32BIT,
+                        24, in, AVTP_PCM_SAMPLE_INT16, 2, 4), -EINVAL);
+    assert_int_equal(Avtp_PcmSamples_PackInterleaved(payload, AVTP_AAF_FORMAT_INT_16BIT,
+                        16, in, AVTP_PCM_SAMPLE_INT16, 0, 4), -EINVAL);
+    assert_int_equal(Avtp_PcmSamples_UnpackInterleaved(in, 7, payload,
+                        AVTP_AAF_FORMAT_INT_16BIT, 2, 4), -EINVAL);
+    assert_int_equal(Avtp_PcmSamples_UnpackPlanar(NULL, AVTP_PCM_SAMPLE_INT16, payload,
+                        AVTP_AAF_FORMAT_INT_16BIT, 2, 4), -EINVAL);
+
+    const uint16_t map[] = { 0, 2 };
+    void* dst[] = { in, in + 4 };
+    assert_int_equal(Avtp_PcmSamples_UnpackChannels(dst, AVTP_PCM_SAMPLE_INT16, payload,
+                        AVTP_AAF_FORMAT_INT_16BIT, 2, map, 2, 4), -EINVAL);
+    assert_int_equal(Avtp_PcmSamples_UnpackChannels(dst, AVTP_PCM_SAMPLE_INT16, payload,
+                        AVTP_AAF_FORMAT_INT_16BIT, 3, map, 0, 4), -EINVAL);
+    assert_int_equal(Avtp_PcmSamples_PackChannels(payload, AVTP_AAF_FORMAT_INT_16BIT, 16,
+                        (const void* const*) dst, AVTP_PCM_SAMPLE_INT16, 3, NULL, 2, 4),
+                     -EINVAL);
+    assert_int_equal(Avtp_PcmSamples_ExtractChannels(NULL, dst, AVTP_PCM_SAMPLE_INT16,
+                        map, 2), -EINVAL);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(pcm_samples_convert),
+        cmocka_unit_test(pcm_samples_bit_depth),
+        cmocka_unit_test(pcm_samples_channels),
+        cmocka_unit_test(pcm_samples_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
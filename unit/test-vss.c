@@ -38,6 +38,7 @@
 #include <stdio.h>
 
 #include "avtp/acf/custom/Vss.h"
+#include "avtp/acf/custom/VssBrief.h"
 #include "avtp/acf/AcfCommon.h"
 
 #define MAX_PDU_SIZE        1500
@@ -77,6 +78,48 @@ static void vss_pad(void **state) {
     }
 }
 
+static void vss_pad_multiple_msgs(void **state) {
+
+    uint8_t pdu[MAX_PDU_SIZE];
+    Avtp_Vss_t* vss_pdu = (Avtp_Vss_t*) pdu;
+
+    // Padding must only touch the bytes right behind the message
+    memset(pdu, 0xff, sizeof(pdu));
+    Avtp_Vss_Init(vss_pdu);
+    Avtp_Vss_Pad(vss_pdu, AVTP_VSS_FIXED_HEADER_LEN + 1);
+
+    uint8_t exp_pad[] = {0, 0, 0};
+    assert_memory_equal(pdu + AVTP_VSS_FIXED_HEADER_LEN + 1, exp_pad, 3);
+    assert_int_equal(pdu[AVTP_VSS_FIXED_HEADER_LEN + 4], 0xff);
+}
+
+static void vss_data_length(void **state) {
+
+    VssData_t data = {
+        .data_float = 1.0
+    };
+    assert_int_equal(Avtp_Vss_CalcVssDataLength(VSS_FLOAT, &data), 4);
+    assert_int_equal(Avtp_Vss_CalcVssDataLength(VSS_BOOL, &data), 1);
+    assert_int_equal(Avtp_Vss_CalcVssDataLength(VSS_INT64, &data), 8);
+
+    char str[] = "Hello";
+    VssDataString_t vss_str = {
+        .data = str,
+        .data_length = strlen(str)
+    };
+    data.data_string = &vss_str;
+    assert_int_equal(Avtp_Vss_CalcVssDataLength(VSS_STRING, &data), 7);
+
+    double double_arr_value[] = {1.2, -1.2};
+    VssDataDoubleArray_t vss_data_double_arr = {
+        .data = double_arr_value,
+        .data_length = 16
+    };
+    data.data_double_array = &vss_data_double_arr;
+    assert_int_equal(Avtp_Vss_CalcVssDataLength(VSS_DOUBLE_ARRAY, &data), 18);
+    assert_int_equal(Avtp_Vss_CalcVssDataLength(0x7f, &data), 0);
+}
+
 static void vss_static_path(void **state) {
 
     uint8_t pdu[MAX_PDU_SIZE];
@@ -1068,11 +1111,328 @@ static void vss_data_string_array(void **state) {
 
 }
 
+static void vss_data_view(void **state) {
+
+    uint8_t pdu[MAX_PDU_SIZE];
+    Avtp_Vss_t* vss_pdu = (Avtp_Vss_t*) pdu;
+    char path[] = "Vehicle.Speed";
+    uint32_t path_length = strlen(path);
+
+    VssPath_t path_id = {
+        .vss_interop_path.path = path,
+        .vss_interop_path.path_length = path_length
+    };
+    Avtp_Vss_SetAddrMode(vss_pdu, VSS_INTEROP_MODE);
+    Avtp_Vss_SetVssPath(vss_pdu, &path_id);
+
+    VssPath_t path_view;
+    Avtp_Vss_GetVssPathView(vss_pdu, &path_view);
+    assert_int_equal(path_view.vss_interop_path.path_length, 13);
+    assert_ptr_equal(path_view.vss_interop_path.path, pdu + AVTP_VSS_FIXED_HEADER_LEN + 2);
+    assert_memory_equal(path_view.vss_interop_path.path, path, 13);
+
+    // Numeric arrays are returned in network byte-order and converted lazily
+    float float_arr_value[] = {1.2, -1.2, 1.3, -1.3, 1.5};
+    VssDataFloatArray_t vss_data_float_arr = {
+        .data = float_arr_value,
+        .data_length = 20
+    };
+    VssData_t data = {
+        .data_float_array = &vss_data_float_arr
+    };
+    Avtp_Vss_SetDatatype(vss_pdu, VSS_FLOAT_ARRAY);
+    Avtp_Vss_SetVssData(vss_pdu, &data);
+
+    VssDataView_t view;
+    assert_int_equal(Avtp_Vss_GetVssDataView(vss_pdu, &view), 0);
+    assert_int_equal(view.datatype, VSS_FLOAT_ARRAY);
+    assert_ptr_equal(view.data, pdu + AVTP_VSS_FIXED_HEADER_LEN + 17);
+    assert_int_equal(view.data_length, 20);
+    assert_int_equal(view.count, 5);
+    assert_int_equal(view.element_size, 4);
+    assert_int_equal(view.big_endian, 1);
+
+    uint32_t raw = (uint32_t) Avtp_Vss_GetViewElement(&view, 1);
+    float value;
+    memcpy(&value, &raw, sizeof(value));
+    assert_true(value == float_arr_value[1]);
+
+    float float_arr_value_recv[5];
+    assert_int_equal(Avtp_Vss_CopyViewData(&view, float_arr_value_recv, 5), 5);
+    assert_memory_equal(float_arr_value_recv, float_arr_value, 20);
+    assert_int_equal(Avtp_Vss_CopyViewData(&view, float_arr_value_recv, 2), 2);
+
+    // Scalars have no length field
+    Avtp_Vss_SetDatatype(vss_pdu, VSS_UINT16);
+    data.data_uint16 = 0x1234;
+    Avtp_Vss_SetVssData(vss_pdu, &data);
+    assert_int_equal(Avtp_Vss_GetVssDataView(vss_pdu, &view), 0);
+    assert_ptr_equal(view.data, pdu + AVTP_VSS_FIXED_HEADER_LEN + 15);
+    assert_int_equal(view.count, 1);
+    assert_int_equal(Avtp_Vss_GetViewElement(&view, 0), 0x1234);
+
+    // String arrays are iterated in place
+    char str1[] = "Hello";
+    char str2[] = "World";
+    VssDataString_t vss_str1 = {
+        .data = str1,
+        .data_length = strlen(str1)
+    };
+    VssDataString_t vss_str2 = {
+        .data = str2,
+        .data_length = strlen(str2)
+    };
+    VssDataString_t* arr[] = {&vss_str1, &vss_str2};
+    uint8_t buffer[strlen(str1) + strlen(str2) + 4];
+    VssDataStringArray_t vss_str_array = {
+        .data = buffer
+    };
+    Avtp_Vss_SerializeStringArray(&vss_str_array, arr, 2);
+    data.data_string_array = &vss_str_array;
+    Avtp_Vss_SetDatatype(vss_pdu, VSS_STRING_ARRAY);
+    Avtp_Vss_SetVssData(vss_pdu, &data);
+
+    assert_int_equal(Avtp_Vss_GetVssDataView(vss_pdu, &view), 0);
+    assert_int_equal(view.data_length, 14);
+    assert_int_equal(view.count, 2);
+
+    uint16_t offset = 0;
+    VssDataString_t str;
+    assert_int_equal(Avtp_Vss_NextStringView(&view, &offset, &str), 1);
+    assert_int_equal(str.data_length, 5);
+    assert_memory_equal(str.data, str1, 5);
+    assert_int_equal(Avtp_Vss_NextStringView(&view, &offset, &str), 1);
+    assert_ptr_equal(str.data, pdu + AVTP_VSS_FIXED_HEADER_LEN + 17 + 9);
+    assert_memory_equal(str.data, str2, 5);
+    assert_int_equal(Avtp_Vss_NextStringView(&view, &offset, &str), 0);
+
+    Avtp_Vss_SetDatatype(vss_pdu, 0x7f);
+    assert_int_equal(Avtp_Vss_GetVssDataView(vss_pdu, &view), -EINVAL);
+}
+
+static void vss_parse(void **state) {
+
+    uint8_t pdu[MAX_PDU_SIZE];
+    Avtp_Vss_t* vss_pdu = (Avtp_Vss_t*) pdu;
+    char path[] = "Vehicle.Speed";
+    Avtp_VssLayout_t layout;
+
+    VssPath_t path_id = {
+        .vss_interop_path.path = path,
+        .vss_interop_path.path_length = strlen(path)
+    };
+    int32_t int32_arr_value[] = {-1, 2, -3};
+    VssDataInt32Array_t vss_data_int32_arr = {
+        .data = int32_arr_value,
+        .data_length = sizeof(int32_arr_value)
+    };
+    VssData_t data = {
+        .data_int32_array = &vss_data_int32_arr
+    };
+
+    Avtp_Vss_Init(vss_pdu);
+    Avtp_Vss_EnableMtv(vss_pdu);
+    Avtp_Vss_SetAddrMode(vss_pdu, VSS_INTEROP_MODE);
+    Avtp_Vss_SetOpCode(vss_pdu, PUBLISH_CURRENT_VALUE);
+    Avtp_Vss_SetDatatype(vss_pdu, VSS_INT32_ARRAY);
+    Avtp_Vss_SetMsgTimestamp(vss_pdu, 0x0123456789abcdef);
+    Avtp_Vss_SetVssPath(vss_pdu, &path_id);
+    Avtp_Vss_SetVssData(vss_pdu, &data);
+
+    // 12 byte header + 15 byte path + 14 byte data + 3 byte padding
+    uint16_t vss_length = AVTP_VSS_FIXED_HEADER_LEN + 15 + 14;
+    Avtp_Vss_Pad(vss_pdu, vss_length);
+
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, sizeof(pdu), &layout), 0);
+    assert_ptr_equal(layout.pdu, pdu);
+    assert_int_equal(layout.msg_length, 44);
+    assert_int_equal(layout.header_length, AVTP_VSS_FIXED_HEADER_LEN);
+    assert_int_equal(layout.mtv, 1);
+    assert_int_equal(layout.addr_mode, VSS_INTEROP_MODE);
+    assert_int_equal(layout.op, PUBLISH_CURRENT_VALUE);
+    assert_int_equal(layout.datatype, VSS_INT32_ARRAY);
+    assert_int_equal(layout.msg_timestamp, 0x0123456789abcdef);
+    assert_int_equal(layout.path_offset, AVTP_VSS_FIXED_HEADER_LEN);
+    assert_int_equal(layout.path_length, 15);
+    assert_int_equal(layout.data_offset, AVTP_VSS_FIXED_HEADER_LEN + 15);
+    assert_int_equal(layout.data_length, 14);
+
+    VssPath_t path_recv;
+    Avtp_VssLayout_GetVssPath(&layout, &path_recv);
+    assert_int_equal(path_recv.vss_interop_path.path_length, strlen(path));
+    assert_memory_equal(path_recv.vss_interop_path.path, path, strlen(path));
+
+    VssDataView_t view;
+    Avtp_VssLayout_GetVssDataView(&layout, &view);
+    assert_int_equal(view.count, 3);
+    assert_int_equal((int32_t) Avtp_Vss_GetViewElement(&view, 2), -3);
+
+    int32_t int32_arr_value_recv[3];
+    VssDataInt32Array_t vss_data_int32_arr_recv = {
+        .data = int32_arr_value_recv
+    };
+    VssData_t data_recv = {
+        .data_int32_array = &vss_data_int32_arr_recv
+    };
+    Avtp_VssLayout_GetVssData(&layout, &data_recv);
+    assert_int_equal(vss_data_int32_arr_recv.data_length, sizeof(int32_arr_value));
+    assert_memory_equal(int32_arr_value_recv, int32_arr_value, sizeof(int32_arr_value));
+
+    // The message must fit into the buffer
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, 40, &layout), -EINVAL);
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, 8, &layout), -EINVAL);
+
+    // The data must fit into the message
+    Avtp_Vss_SetField(vss_pdu, AVTP_VSS_FIELD_ACF_MSG_LENGTH, 9);
+    Avtp_Vss_SetField(vss_pdu, AVTP_VSS_FIELD_PAD, 0);
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, sizeof(pdu), &layout), -EINVAL);
+    Avtp_Vss_Pad(vss_pdu, vss_length);
+
+    // The path must fit into the message
+    path_id.vss_interop_path.path_length = 200;
+    Avtp_Vss_SetVssPath(vss_pdu, &path_id);
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, sizeof(pdu), &layout), -EINVAL);
+
+    // Static IDs have a fixed path length
+    path_id.vss_static_id_path = 0xdeadbeef;
+    Avtp_Vss_SetAddrMode(vss_pdu, VSS_STATIC_ID_MODE);
+    Avtp_Vss_SetVssPath(vss_pdu, &path_id);
+    Avtp_Vss_SetDatatype(vss_pdu, VSS_UINT8);
+    data.data_uint8 = 42;
+    Avtp_Vss_SetVssData(vss_pdu, &data);
+    Avtp_Vss_Pad(vss_pdu, AVTP_VSS_FIXED_HEADER_LEN + 4 + 1);
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, sizeof(pdu), &layout), 0);
+    assert_int_equal(layout.msg_length, 20);
+    assert_int_equal(layout.data_offset, AVTP_VSS_FIXED_HEADER_LEN + 4);
+    assert_int_equal(layout.data_length, 1);
+    Avtp_VssLayout_GetVssPath(&layout, &path_recv);
+    assert_int_equal(path_recv.vss_static_id_path, 0xdeadbeef);
+    Avtp_VssLayout_GetVssData(&layout, &data_recv);
+    assert_int_equal(data_recv.data_uint8, 42);
+
+    // Unknown datatypes and other message types are rejected
+    Avtp_Vss_SetDatatype(vss_pdu, 0x7f);
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, sizeof(pdu), &layout), -EINVAL);
+    Avtp_Vss_SetDatatype(vss_pdu, VSS_UINT8);
+    Avtp_Vss_SetField(vss_pdu, AVTP_VSS_FIELD_ACF_MSG_TYPE, AVTP_ACF_TYPE_CAN);
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, sizeof(pdu), &layout), -EINVAL);
+}
+
+static void vss_parse_length_overflow(void **state) {
+
+    uint8_t pdu[MAX_PDU_SIZE];
+    Avtp_Vss_t* vss_pdu = (Avtp_Vss_t*) pdu;
+    Avtp_VssLayout_t layout;
+    char path[] = "Vehicle.Speed";
+    char string_value[] = "abc";
+
+    VssPath_t path_id = {
+        .vss_interop_path.path = path,
+        .vss_interop_path.path_length = strlen(path)
+    };
+    VssDataString_t vss_data_string = {
+        .data = string_value,
+        .data_length = strlen(string_value)
+    };
+    VssData_t data = {
+        .data_string = &vss_data_string
+    };
+
+    memset(pdu, 0, sizeof(pdu));
+    Avtp_Vss_Init(vss_pdu);
+    Avtp_Vss_SetAddrMode(vss_pdu, VSS_INTEROP_MODE);
+    Avtp_Vss_SetOpCode(vss_pdu, PUBLISH_CURRENT_VALUE);
+    Avtp_Vss_SetDatatype(vss_pdu, VSS_STRING);
+    Avtp_Vss_SetVssPath(vss_pdu, &path_id);
+    Avtp_Vss_SetVssData(vss_pdu, &data);
+    Avtp_Vss_Pad(vss_pdu, AVTP_VSS_FIXED_HEADER_LEN + 15 + 5);
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, sizeof(pdu), &layout), 0);
+
+    // 2 + 0xFFFF does not fit into 16 bit and must not wrap around to 1
+    pdu[AVTP_VSS_FIXED_HEADER_LEN] = 0xff;
+    pdu[AVTP_VSS_FIXED_HEADER_LEN + 1] = 0xff;
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, sizeof(pdu), &layout), -EINVAL);
+    Avtp_Vss_SetVssPath(vss_pdu, &path_id);
+
+    pdu[AVTP_VSS_FIXED_HEADER_LEN + 15] = 0xff;
+    pdu[AVTP_VSS_FIXED_HEADER_LEN + 15 + 1] = 0xff;
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, sizeof(pdu), &layout), -EINVAL);
+    Avtp_Vss_SetVssData(vss_pdu, &data);
+
+    // The accessors use the validated lengths of the layout
+    assert_int_equal(Avtp_Vss_Parse(vss_pdu, sizeof(pdu), &layout), 0);
+    VssPath_t path_recv;
+    Avtp_VssLayout_GetVssPath(&layout, &path_recv);
+    assert_int_equal(path_recv.vss_interop_path.path_length, strlen(path));
+    VssDataView_t view;
+    Avtp_VssLayout_GetVssDataView(&layout, &view);
+    assert_int_equal(view.data_length, strlen(string_value));
+    assert_memory_equal(view.data, string_value, strlen(string_value));
+}
+
+static void vss_brief_parse(void **state) {
+
+    uint8_t pdu[MAX_PDU_SIZE];
+    Avtp_VssBrief_t* vss_brief_pdu = (Avtp_VssBrief_t*) pdu;
+    Avtp_VssLayout_t layout;
+    char path[] = "Vehicle.Speed";
+
+    VssPath_t path_id = {
+        .vss_interop_path.path = path,
+        .vss_interop_path.path_length = strlen(path)
+    };
+    VssData_t data = {
+        .data_float = 42.5
+    };
+
+    Avtp_VssBrief_Init(vss_brief_pdu);
+    Avtp_VssBrief_SetField(vss_brief_pdu, AVTP_VSS_BRIEF_FIELD_MTV, 1);
+    Avtp_VssBrief_SetField(vss_brief_pdu, AVTP_VSS_BRIEF_FIELD_ADDR_MODE, VSS_INTEROP_MODE);
+    Avtp_VssBrief_SetField(vss_brief_pdu, AVTP_VSS_BRIEF_FIELD_VSS_OP, PUBLISH_CURRENT_VALUE);
+    Avtp_VssBrief_SetField(vss_brief_pdu, AVTP_VSS_BRIEF_FIELD_VSS_DATATYPE, VSS_FLOAT);
+    Avtp_VssBrief_SetVssPath(vss_brief_pdu, &path_id);
+    Avtp_VssBrief_SetVssData(vss_brief_pdu, &data);
+
+    // 4 byte header + 15 byte path + 4 byte data + 1 byte padding
+    Avtp_VssBrief_Pad(vss_brief_pdu, AVTP_VSS_BRIEF_HEADER_LEN + 15 + 4);
+    assert_int_equal(Avtp_VssBrief_GetField(vss_brief_pdu,
+                        AVTP_VSS_BRIEF_FIELD_ACF_MSG_LENGTH), 6);
+    assert_int_equal(Avtp_VssBrief_GetField(vss_brief_pdu,
+                        AVTP_VSS_BRIEF_FIELD_PAD), 1);
+
+    // VSS Brief messages are decoded through the same layout as VSS
+    assert_int_equal(Avtp_VssBrief_Parse(vss_brief_pdu, sizeof(pdu), &layout), 0);
+    assert_int_equal(Avtp_VssBrief_GetField(vss_brief_pdu,
+                        AVTP_VSS_BRIEF_FIELD_ACF_MSG_TYPE), AVTP_ACF_TYPE_VSS);
+    assert_int_equal(layout.header_length, AVTP_VSS_BRIEF_HEADER_LEN);
+    assert_int_equal(layout.msg_length, 24);
+    assert_int_equal(layout.mtv, 1);
+    assert_int_equal(layout.msg_timestamp, 0);
+    assert_int_equal(layout.addr_mode, VSS_INTEROP_MODE);
+    assert_int_equal(layout.datatype, VSS_FLOAT);
+    assert_int_equal(layout.path_offset, AVTP_VSS_BRIEF_HEADER_LEN);
+    assert_int_equal(layout.data_offset, AVTP_VSS_BRIEF_HEADER_LEN + 15);
+
+    VssPath_t path_recv;
+    Avtp_VssLayout_GetVssPath(&layout, &path_recv);
+    assert_memory_equal(path_recv.vss_interop_path.path, path, strlen(path));
+
+    VssData_t data_recv;
+    Avtp_VssLayout_GetVssData(&layout, &data_recv);
+    assert_true(data_recv.data_float == 42.5);
+
+    // A VSS Brief header is shorter than a VSS header
+    assert_int_equal(Avtp_VssBrief_Parse(vss_brief_pdu, 20, &layout), -EINVAL);
+    assert_int_equal(Avtp_VssBrief_Parse(vss_brief_pdu, 3, &layout), -EINVAL);
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(vss_init),
         cmocka_unit_test(vss_pad),
+        cmocka_unit_test(vss_pad_multiple_msgs),
+        cmocka_unit_test(vss_data_length),
         cmocka_unit_test(vss_static_path),
         cmocka_unit_test(vss_interop_path),
         cmocka_unit_test(vss_data_uint8),
@@ -1099,6 +1459,10 @@ int main(void)
         cmocka_unit_test(vss_data_float_array),
         cmocka_unit_test(vss_data_double_array),
         cmocka_unit_test(vss_data_string_array),
+        cmocka_unit_test(vss_data_view),
+        cmocka_unit_test(vss_parse),
+        cmocka_unit_test(vss_parse_length_overflow),
+        cmocka_unit_test(vss_brief_parse),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);